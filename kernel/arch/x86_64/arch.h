@@ -0,0 +1,49 @@
+#ifndef ARCH_X86_64_H
+#define ARCH_X86_64_H
+
+#include <stdint.h>
+
+// Seletores da GDT de 64 bits. A ordem dados/código de usuário é a que
+// o SYSRET exige: CS = base + 16 e SS = base + 8, com base = 0x10
+#define GDT_KERNEL_CODE 0x08
+#define GDT_KERNEL_DATA 0x10
+#define GDT_USER_DATA   0x18
+#define GDT_USER_CODE   0x20
+#define GDT_TSS         0x28
+
+// MSRs do modo longo
+#define MSR_EFER   0xC0000080
+#define MSR_STAR   0xC0000081
+#define MSR_LSTAR  0xC0000082
+#define MSR_SFMASK 0xC0000084
+
+#define EFER_SCE 0x001          // SYSCALL/SYSRET
+#define EFER_NXE 0x800          // Bit NX nas entradas de página
+
+// Números das chamadas de sistema (RAX); argumentos em RDI, RSI, RDX, R10
+#define SYS_READ   0
+#define SYS_WRITE  1
+#define SYS_OPEN   2
+#define SYS_CLOSE  3
+#define SYS_PREAD  4
+#define SYS_PWRITE 5
+#define SYS_LSEEK  6
+#define SYS_FSYNC  7
+#define SYS_YIELD  8
+#define SYS_COUNT  9
+
+static inline uint64_t rdmsr(uint32_t msr) {
+    uint32_t low, high;
+    asm volatile("rdmsr" : "=a"(low), "=d"(high) : "c"(msr));
+    return low | ((uint64_t)high << 32);
+}
+
+static inline void wrmsr(uint32_t msr, uint64_t value) {
+    asm volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+// Pilha do kernel usada por interrupções vindas do anel 3 e pelo SYSCALL
+void tss_set_kernel_stack(uintptr_t rsp0);
+void syscall_init(void);
+
+#endif
@@ -0,0 +1,131 @@
+; cpu.asm - Funções de baixo nível para CPU (x86_64)
+;
+; Argumentos chegam pela System V ABI: RDI, RSI, RDX, RCX, R8, R9
+
+bits 64
+
+global gdt_flush     ; Permite que C chame gdt_flush()
+global idt_load      ; Permite que C chame idt_load()
+global bench_trap    ; Vetor de teste do benchmark de traps
+global switch_context
+global syscall_entry
+global user_enter
+
+extern tss
+extern syscall_dispatch
+
+section .text
+
+gdt_flush:
+    lgdt [rdi]        ; Carrega a nova GDT
+
+    mov ax, 0x10      ; 0x10 é o offset no GDT para nosso segmento de dados
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Não existe jmp far imediato no modo longo: recarrega CS com retfq
+    pop rax
+    push qword 0x08   ; 0x08 é o offset para o segmento de código
+    push rax
+    retfq
+
+idt_load:
+    lidt [rdi]        ; Carrega a IDT
+    ret
+
+; Retorna imediatamente: mede só a entrada e a saída de uma interrupção
+bench_trap:
+    iretq
+
+; switch_context(uintptr_t *old_rsp, uintptr_t new_rsp)
+; Empilha os registradores preservados pela ABI, guarda RSP em *old_rsp e
+; retoma a outra pilha, cujo topo tem o mesmo formato (process_create
+; monta um quadro inicial com zeros e o ponto de entrada)
+switch_context:
+    push rbx
+    push rbp
+    push r12
+    push r13
+    push r14
+    push r15
+    mov [rdi], rsp
+    mov rsp, rsi
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rbp
+    pop rbx
+    ret
+
+; Entrada do SYSCALL: RCX = RIP de retorno, R11 = RFLAGS, RAX = número.
+; O SYSCALL não troca de pilha; usa-se tss.rsp0 como no retorno de
+; interrupções do anel 3. SFMASK já desligou IF, então o RSP do usuário
+; pode ficar numa variável até estar na pilha do kernel
+syscall_entry:
+    mov [rel user_rsp], rsp
+    mov rsp, [rel tss + 4]
+    push qword [rel user_rsp]
+    push rcx
+    push r11
+    push rdi
+    push rsi
+    push rdx
+    push r8
+    push r9
+    push r10
+
+    ; syscall_dispatch(a1, a2, a3, a4, número); nove pushes desalinham a
+    ; pilha em 8 bytes
+    sub rsp, 8
+    mov rcx, r10
+    mov r8, rax
+    call syscall_dispatch
+    add rsp, 8
+
+    pop r10
+    pop r9
+    pop r8
+    pop rdx
+    pop rsi
+    pop rdi
+    pop r11
+    pop rcx
+    pop rsp
+    o64 sysret
+
+; user_enter(uintptr_t entry, uintptr_t stack)
+; Desce para o anel 3 com um quadro de iretq: SS e RSP do usuário, RFLAGS
+; com IF ligado, CS e RIP. Os registradores são zerados para não vazar
+; valores do kernel
+user_enter:
+    push qword 0x1B   ; GDT_USER_DATA | RPL 3
+    push rsi
+    pushfq
+    or qword [rsp], 0x200
+    push qword 0x23   ; GDT_USER_CODE | RPL 3
+    push rdi
+    xor eax, eax
+    xor ebx, ebx
+    xor ecx, ecx
+    xor edx, edx
+    xor esi, esi
+    xor edi, edi
+    xor ebp, ebp
+    xor r8, r8
+    xor r9, r9
+    xor r10, r10
+    xor r11, r11
+    xor r12, r12
+    xor r13, r13
+    xor r14, r14
+    xor r15, r15
+    iretq
+
+section .bss
+align 8
+user_rsp:
+    resq 1
@@ -0,0 +1,224 @@
+; entry.asm - Ponto de entrada do kernel de 64 bits
+;
+; Como no i386, _start fica em 0x100000 e recebe EAX = magic e EBX =
+; multiboot_info_t em modo protegido de 32 bits, vindo do estágio 2 ou de
+; um carregador Multiboot. O resto do kernel é ligado em -2GB
+; (KERNEL_VMA), então o cabeçalho usa os campos de endereço do Multiboot
+; (bit 16) em vez do formato ELF, e os carregadores recebem kernel.bin.
+;
+; O código abaixo monta tabelas de boot com páginas de 2MB (identidade
+; dos primeiros 4GB, a mesma janela no mapa direto e o primeiro 1GB em
+; -2GB), entra no modo longo e salta para a metade alta. vmm_init()
+; substitui essas tabelas pelas definitivas.
+
+MBOOT_PAGE_ALIGN    equ 1 << 0
+MBOOT_MEM_INFO      equ 1 << 1
+MBOOT_AOUT_KLUDGE   equ 1 << 16
+MBOOT_HEADER_MAGIC  equ 0x1BADB002
+MBOOT_HEADER_FLAGS  equ MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO | MBOOT_AOUT_KLUDGE
+MBOOT_CHECKSUM      equ -(MBOOT_HEADER_MAGIC + MBOOT_HEADER_FLAGS)
+
+KERNEL_STACK_SIZE   equ 16384
+
+PTE_PRESENT         equ 0x001
+PTE_WRITE           equ 0x002
+PDE_LARGE           equ 0x080
+
+global _start
+extern kernel_main
+extern __load_end
+extern __bss_start_phys
+extern __bss_end_phys
+
+section .multiboot progbits alloc exec nowrite align=4
+bits 32
+_start:
+    jmp start32
+
+; Cabeçalho Multiboot (precisa estar nos primeiros 8KB, alinhado a 4)
+align 4
+multiboot_header:
+    dd MBOOT_HEADER_MAGIC
+    dd MBOOT_HEADER_FLAGS
+    dd MBOOT_CHECKSUM
+    dd multiboot_header     ; header_addr
+    dd _start               ; load_addr
+    dd __load_end           ; load_end_addr
+    dd __bss_end_phys       ; bss_end_addr
+    dd start32              ; entry_addr
+
+section .boot progbits alloc exec nowrite align=16
+bits 32
+start32:
+    cli
+    cld
+    mov esi, eax            ; magic
+    mov ebp, ebx            ; multiboot_info_t
+    mov esp, boot_stack_top
+
+    ; Zerar a BSS (o estágio 2 carrega apenas a imagem plana) e as tabelas
+    xor eax, eax
+    mov edi, __bss_start_phys
+    mov ecx, __bss_end_phys
+    sub ecx, edi
+    shr ecx, 2
+    rep stosd
+    mov edi, boot_pml4
+    mov ecx, BOOT_TABLES_SIZE / 4
+    rep stosd
+
+    ; CPUID existe se o bit ID de EFLAGS puder ser alterado
+    pushfd
+    pop eax
+    mov ecx, eax
+    xor eax, 1 << 21
+    push eax
+    popfd
+    pushfd
+    pop eax
+    push ecx
+    popfd
+    xor eax, ecx
+    jz .no_long_mode
+
+    ; Modo longo: CPUID 0x80000001, EDX bit 29 (bit 20 = NX)
+    mov eax, 0x80000000
+    cpuid
+    cmp eax, 0x80000001
+    jb .no_long_mode
+    mov eax, 0x80000001
+    cpuid
+    test edx, 1 << 29
+    jz .no_long_mode
+    mov ebx, edx
+
+    ; PML4: identidade (0) e mapa direto (256) dividem a PDPT baixa;
+    ; a entrada 511 cobre os últimos 512GB, onde fica o kernel
+    mov eax, boot_pdpt_low + PTE_PRESENT + PTE_WRITE
+    mov [boot_pml4], eax
+    mov [boot_pml4 + 256 * 8], eax
+    mov eax, boot_pdpt_high + PTE_PRESENT + PTE_WRITE
+    mov [boot_pml4 + 511 * 8], eax
+
+    ; PDPT baixa: quatro PDs, 4GB
+    mov eax, boot_pd + PTE_PRESENT + PTE_WRITE
+    mov edi, boot_pdpt_low
+    mov ecx, 4
+.fill_pdpt:
+    mov [edi], eax
+    add eax, 4096
+    add edi, 8
+    loop .fill_pdpt
+
+    ; -2GB (entrada 510 da PDPT alta) = primeiro 1GB físico
+    mov dword [boot_pdpt_high + 510 * 8], boot_pd + PTE_PRESENT + PTE_WRITE
+
+    ; PDs: 2048 páginas de 2MB
+    mov edi, boot_pd
+    mov eax, PTE_PRESENT | PTE_WRITE | PDE_LARGE
+    mov ecx, 2048
+.fill_pd:
+    mov [edi], eax
+    add eax, 0x200000
+    add edi, 8
+    loop .fill_pd
+
+    ; PAE, tabelas, EFER.LME (e NXE se houver) e paginação
+    mov eax, cr4
+    or eax, 1 << 5
+    mov cr4, eax
+    mov eax, boot_pml4
+    mov cr3, eax
+    mov ecx, 0xC0000080
+    rdmsr
+    or eax, 1 << 8
+    test ebx, 1 << 20
+    jz .no_nx
+    or eax, 1 << 11
+.no_nx:
+    wrmsr
+    mov eax, cr0
+    or eax, (1 << 31) | 1
+    mov cr0, eax
+
+    lgdt [boot_gdt_ptr]
+    jmp 0x08:long_mode_start
+
+; Sem modo longo não há como seguir: avisa direto na memória de vídeo
+.no_long_mode:
+    mov esi, no_long_mode_msg
+    mov edi, 0xB8000
+    mov ah, 0x4F
+.print:
+    lodsb
+    test al, al
+    jz .hang
+    stosw
+    jmp .print
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+bits 64
+long_mode_start:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+
+    ; Até aqui o código roda pela identidade; o resto do kernel está em -2GB
+    mov rax, higher_half
+    jmp rax
+
+; GDT mínima de boot (gdt_init() instala a definitiva com TSS)
+align 8
+boot_gdt:
+    dq 0
+    dq 0x00AF9A000000FFFF   ; 0x08: código de 64 bits
+    dq 0x00CF92000000FFFF   ; 0x10: dados
+boot_gdt_ptr:
+    dw boot_gdt_ptr - boot_gdt - 1
+    dd boot_gdt
+
+no_long_mode_msg:
+    db "KakatsOS: CPU sem suporte a modo longo (x86_64)", 0
+
+section .text
+bits 64
+higher_half:
+    mov rsp, stack_top
+
+    ; kernel_main(magic, mbi); o mbi é físico e a identidade continua valendo
+    mov edi, esi
+    mov esi, ebp
+    xor ebp, ebp            ; Fim das cadeias de quadros (profiler)
+    call kernel_main
+
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+; Tabelas de boot e pilha de 32 bits, no endereço físico (ver link.ld)
+section .boot.bss nobits alloc noexec write align=4096
+boot_pml4:
+    resb 4096
+boot_pdpt_low:
+    resb 4096
+boot_pdpt_high:
+    resb 4096
+boot_pd:
+    resb 4 * 4096
+BOOT_TABLES_SIZE equ $ - boot_pml4
+boot_stack:
+    resb 4096
+boot_stack_top:
+
+section .bss
+align 16
+stack_bottom:
+    resb KERNEL_STACK_SIZE
+stack_top:
@@ -0,0 +1,78 @@
+#include <stdint.h>
+#include <string.h>
+#include "../../memory/gdt.h"
+#include "arch.h"
+
+// TSS de 64 bits: só rsp0 (pilha do kernel ao entrar do anel 3) é usado
+struct tss_entry {
+    uint32_t reserved0;
+    uint64_t rsp0;
+    uint64_t rsp1;
+    uint64_t rsp2;
+    uint64_t reserved1;
+    uint64_t ist[7];
+    uint64_t reserved2;
+    uint16_t reserved3;
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+// Nulo, código/dados do kernel, dados/código de usuário e o TSS, que
+// ocupa duas entradas (base de 64 bits)
+struct gdt_entry gdt[7];
+struct gdt_ptr gp;
+struct tss_entry tss;
+
+// Pilha usada por SYSCALL e interrupções do anel 3 até o escalonador
+// trocar rsp0 por processo
+static uint8_t ring0_stack[16384] __attribute__((aligned(16)));
+
+extern void gdt_flush(uintptr_t);
+
+void gdt_set_gate(int num, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran) {
+    gdt[num].base_low = (base & 0xFFFF);
+    gdt[num].base_middle = (base >> 16) & 0xFF;
+    gdt[num].base_high = (base >> 24) & 0xFF;
+
+    gdt[num].limit_low = (limit & 0xFFFF);
+    gdt[num].granularity = ((limit >> 16) & 0x0F);
+
+    gdt[num].granularity |= (gran & 0xF0);
+    gdt[num].access = access;
+}
+
+void tss_set_kernel_stack(uintptr_t rsp0) {
+    tss.rsp0 = rsp0;
+}
+
+void gdt_init(void) {
+    gp.limit = (sizeof(struct gdt_entry) * 7) - 1;
+    gp.base = (uintptr_t)&gdt;
+
+    // NULL descriptor
+    gdt_set_gate(0, 0, 0, 0, 0);
+
+    // Code Segment (L = 1: código de 64 bits; base e limite são ignorados)
+    gdt_set_gate(1, 0, 0xFFFFFFFF, 0x9A, 0xAF);
+
+    // Data Segment
+    gdt_set_gate(2, 0, 0xFFFFFFFF, 0x92, 0xCF);
+
+    // User Data Segment
+    gdt_set_gate(3, 0, 0xFFFFFFFF, 0xF2, 0xCF);
+
+    // User Code Segment
+    gdt_set_gate(4, 0, 0xFFFFFFFF, 0xFA, 0xAF);
+
+    // TSS disponível (tipo 0x9); a segunda entrada guarda base[63:32]
+    uintptr_t base = (uintptr_t)&tss;
+    memset(&tss, 0, sizeof(tss));
+    tss.iomap_base = sizeof(tss);
+    tss.rsp0 = (uintptr_t)ring0_stack + sizeof(ring0_stack);
+    gdt_set_gate(5, base & 0xFFFFFFFF, sizeof(tss) - 1, 0x89, 0x00);
+    memset(&gdt[6], 0, sizeof(struct gdt_entry));
+    gdt[6].limit_low = (base >> 32) & 0xFFFF;
+    gdt[6].base_low = (base >> 48) & 0xFFFF;
+
+    gdt_flush((uintptr_t)&gp);
+    asm volatile("ltr %w0" : : "r"(GDT_TSS));
+}
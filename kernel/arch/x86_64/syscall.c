@@ -0,0 +1,93 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "arch.h"
+#include "vfs.h"
+#include "scheduler.h"
+#include "console.h"
+
+extern void syscall_entry(void);
+
+typedef int64_t (*syscall_fn_t)(uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4);
+
+static int64_t sys_read(uint64_t fd, uint64_t buffer, uint64_t size, uint64_t unused) {
+    (void)unused;
+    return vfs_read((int)fd, (void*)buffer, size);
+}
+
+static int64_t sys_write(uint64_t fd, uint64_t buffer, uint64_t size, uint64_t unused) {
+    (void)unused;
+    return vfs_write((int)fd, (const void*)buffer, size);
+}
+
+static int64_t sys_open(uint64_t path, uint64_t flags, uint64_t unused1, uint64_t unused2) {
+    (void)unused1;
+    (void)unused2;
+    return vfs_open((const char*)path, (int)flags);
+}
+
+static int64_t sys_close(uint64_t fd, uint64_t unused1, uint64_t unused2, uint64_t unused3) {
+    (void)unused1;
+    (void)unused2;
+    (void)unused3;
+    return vfs_close((int)fd);
+}
+
+static int64_t sys_pread(uint64_t fd, uint64_t buffer, uint64_t size, uint64_t offset) {
+    return vfs_pread((int)fd, (void*)buffer, size, (uint32_t)offset);
+}
+
+static int64_t sys_pwrite(uint64_t fd, uint64_t buffer, uint64_t size, uint64_t offset) {
+    return vfs_pwrite((int)fd, (const void*)buffer, size, (uint32_t)offset);
+}
+
+static int64_t sys_lseek(uint64_t fd, uint64_t offset, uint64_t whence, uint64_t unused) {
+    (void)unused;
+    return vfs_lseek((int)fd, (int)offset, (int)whence);
+}
+
+static int64_t sys_fsync(uint64_t fd, uint64_t unused1, uint64_t unused2, uint64_t unused3) {
+    (void)unused1;
+    (void)unused2;
+    (void)unused3;
+    return vfs_fsync((int)fd);
+}
+
+static int64_t sys_yield(uint64_t unused1, uint64_t unused2, uint64_t unused3, uint64_t unused4) {
+    (void)unused1;
+    (void)unused2;
+    (void)unused3;
+    (void)unused4;
+    scheduler_schedule();
+    return 0;
+}
+
+static const syscall_fn_t syscall_table[SYS_COUNT] = {
+    [SYS_READ] = sys_read,
+    [SYS_WRITE] = sys_write,
+    [SYS_OPEN] = sys_open,
+    [SYS_CLOSE] = sys_close,
+    [SYS_PREAD] = sys_pread,
+    [SYS_PWRITE] = sys_pwrite,
+    [SYS_LSEEK] = sys_lseek,
+    [SYS_FSYNC] = sys_fsync,
+    [SYS_YIELD] = sys_yield,
+};
+
+// Chamado por syscall_entry (cpu.asm) já na pilha do kernel
+int64_t syscall_dispatch(uint64_t a1, uint64_t a2, uint64_t a3, uint64_t a4, uint64_t number) {
+    if(number >= SYS_COUNT) {
+        return -1;
+    }
+    return syscall_table[number](a1, a2, a3, a4);
+}
+
+// Habilita SYSCALL/SYSRET: STAR[47:32] dá CS/SS do kernel e STAR[63:48]
+// a base dos seletores de usuário; SFMASK desliga IF, DF e TF na entrada
+void syscall_init() {
+    wrmsr(MSR_EFER, rdmsr(MSR_EFER) | EFER_SCE);
+    wrmsr(MSR_STAR, ((uint64_t)GDT_KERNEL_DATA << 48) | ((uint64_t)GDT_KERNEL_CODE << 32));
+    wrmsr(MSR_LSTAR, (uintptr_t)syscall_entry);
+    wrmsr(MSR_SFMASK, 0x700);
+    
+    console_write("syscall: SYSCALL/SYSRET habilitados\n");
+}
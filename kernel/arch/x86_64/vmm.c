@@ -0,0 +1,244 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "io.h"
+#include "vmm.h"
+#include "pmm.h"
+#include "mmap.h"
+#include "console.h"
+#include "percpu.h"
+
+#define PAGE_FAULT_VECTOR 14
+
+// Paginação de 4 níveis: PML4 -> PDPT -> PD -> PT, 512 entradas cada
+#define PML4_INDEX(virt) (((virt) >> 39) & 0x1FF)
+#define PDPT_INDEX(virt) (((virt) >> 30) & 0x1FF)
+#define PD_INDEX(virt)   (((virt) >> 21) & 0x1FF)
+#define PT_INDEX(virt)   (((virt) >> 12) & 0x1FF)
+
+#define LARGE_PAGE_SIZE 0x200000ULL        // Página de 2MB (PS no PD)
+#define GIGABYTE        0x40000000ULL
+
+// PML4 do kernel; tudo fora da região de processos é copiado para todo
+// espaço de endereçamento novo
+static uint64_t *kernel_pml4;
+
+// Próximo endereço livre de vmm_alloc_pages
+static uintptr_t heap_next = KERNEL_HEAP_START;
+
+// Tabelas são acessadas pelo mapa direto
+static inline uint64_t *vmm_table(uint64_t entry) {
+    return PHYS_TO_VIRT(PTE_ADDR(entry));
+}
+
+static inline uint64_t *vmm_current_pml4() {
+    uintptr_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    return vmm_table(cr3);
+}
+
+static inline void vmm_invlpg(uintptr_t virt) {
+    asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+}
+
+// Aloca uma página física zerada para uma tabela; retorna o endereço físico
+static uintptr_t vmm_alloc_table() {
+    void *table = pmm_alloc_page();
+    if(table) {
+        memset(PHYS_TO_VIRT(table), 0, PAGE_SIZE);
+    }
+    return (uintptr_t)table;
+}
+
+// Entrada do próximo nível; create = alocar a tabela que falta
+static uint64_t *vmm_next_level(uint64_t *table, uint32_t index, int create) {
+    if(!(table[index] & PTE_PRESENT)) {
+        if(!create) {
+            return NULL;
+        }
+        
+        uintptr_t next = vmm_alloc_table();
+        if(!next) {
+            return NULL;
+        }
+        
+        // Permissões finais ficam na PTE
+        table[index] = next | PTE_PRESENT | PTE_WRITE | PTE_USER;
+    } else if(table[index] & PDE_LARGE) {
+        return NULL; // Página de 2MB do mapa do kernel
+    }
+    return vmm_table(table[index]);
+}
+
+// Retorna a PTE de virt no espaço atual; create = alocar as tabelas
+static uint64_t *vmm_walk(uintptr_t virt, int create) {
+    uint64_t *pdpt = vmm_next_level(vmm_current_pml4(), PML4_INDEX(virt), create);
+    if(!pdpt) {
+        return NULL;
+    }
+    uint64_t *pd = vmm_next_level(pdpt, PDPT_INDEX(virt), create);
+    if(!pd) {
+        return NULL;
+    }
+    uint64_t *pt = vmm_next_level(pd, PD_INDEX(virt), create);
+    if(!pt) {
+        return NULL;
+    }
+    return &pt[PT_INDEX(virt)];
+}
+
+// Mapeia uma página no espaço de endereçamento atual
+int vmm_map_page(uintptr_t virt, uintptr_t phys, uintptr_t flags) {
+    uint64_t *pte = vmm_walk(virt, 1);
+    if(!pte) {
+        return -1;
+    }
+    
+    *pte = PTE_ADDR(phys) | (flags & ~PTE_ADDR_MASK) | PTE_PRESENT;
+    vmm_invlpg(virt);
+    return 0;
+}
+
+// Desfaz o mapeamento de uma página; retorna a PTE anterior (0 se vazia)
+uintptr_t vmm_unmap_page(uintptr_t virt) {
+    uint64_t *pte = vmm_walk(virt, 0);
+    if(!pte || !(*pte & PTE_PRESENT)) {
+        return 0;
+    }
+    
+    uint64_t old = *pte;
+    *pte = 0;
+    vmm_invlpg(virt);
+    return old;
+}
+
+// Retorna a PTE de uma página (0 se não mapeada)
+uintptr_t vmm_get_pte(uintptr_t virt) {
+    uint64_t *pte = vmm_walk(virt, 0);
+    return pte ? *pte : 0;
+}
+
+// Limpa bits de uma PTE presente (ex.: PTE_DIRTY depois do msync)
+void vmm_clear_pte_flags(uintptr_t virt, uintptr_t flags) {
+    uint64_t *pte = vmm_walk(virt, 0);
+    if(pte && (*pte & PTE_PRESENT)) {
+        *pte &= ~flags;
+        vmm_invlpg(virt);
+    }
+}
+
+// Cria uma PML4 que compartilha as entradas do kernel
+uintptr_t vmm_create_address_space() {
+    uintptr_t pml4 = vmm_alloc_table();
+    if(!pml4) {
+        return 0;
+    }
+    
+    uint64_t *entries = PHYS_TO_VIRT(pml4);
+    for(uint32_t i = 0; i < 512; i++) {
+        if(i < PML4_INDEX(USER_MMAP_START) || i > PML4_INDEX(USER_MMAP_END)) {
+            entries[i] = kernel_pml4[i];
+        }
+    }
+    
+    return pml4;
+}
+
+// Aloca páginas contíguas no heap virtual do kernel
+void *vmm_alloc_pages(uint32_t count) {
+    if(count == 0 || count > (KERNEL_HEAP_END - heap_next) / PAGE_SIZE) {
+        return NULL;
+    }
+    
+    uintptr_t base = heap_next;
+    for(uint32_t i = 0; i < count; i++) {
+        void *page = pmm_alloc_page();
+        if(!page) {
+            // Desfazer o que já foi mapeado
+            while(i-- > 0) {
+                pmm_free_page((void*)PTE_ADDR(vmm_unmap_page(base + i * PAGE_SIZE)));
+            }
+            return NULL;
+        }
+        vmm_map_page(base + i * PAGE_SIZE, (uintptr_t)page, PTE_WRITE);
+    }
+    
+    heap_next += (uintptr_t)count * PAGE_SIZE;
+    return (void*)base;
+}
+
+// Handler de page fault: regiões mapeadas são populadas sob demanda
+static void vmm_page_fault(registers_t *regs) {
+    this_cpu()->page_faults++;
+    
+    uintptr_t addr;
+    asm volatile("mov %%cr2, %0" : "=r"(addr));
+    
+    if(mmap_fault(addr, regs->err_code) == 0) {
+        return;
+    }
+    
+    console_write("Page fault em 0x");
+    console_write_hex(addr >> 32);
+    console_write_hex(addr & 0xFFFFFFFF);
+    console_write(" (erro 0x");
+    console_write_hex(regs->err_code);
+    console_write(")\n");
+    
+    asm volatile("cli");
+    for(;;) {
+        asm volatile("hlt");
+    }
+}
+
+// Mapeia a memória física [0, end) com páginas de 2MB na identidade; o
+// mapa direto reaproveita as mesmas PDPTs na metade alta
+static void vmm_map_physical(uint64_t end) {
+    for(uint64_t phys = 0; phys < end; phys += GIGABYTE) {
+        uint64_t *pdpt = vmm_next_level(kernel_pml4, PML4_INDEX(phys), 1);
+        uint64_t *pd = pdpt ? vmm_next_level(pdpt, PDPT_INDEX(phys), 1) : NULL;
+        if(!pd) {
+            break;
+        }
+        for(uint32_t i = 0; i < 512; i++) {
+            pd[i] = (phys + i * LARGE_PAGE_SIZE) | PDE_LARGE | PTE_PRESENT | PTE_WRITE;
+        }
+    }
+    
+    // Entradas de tabela intermediárias não devem ser de usuário aqui
+    for(uint32_t i = 0; i <= PML4_INDEX(end - 1); i++) {
+        kernel_pml4[i] &= ~(uint64_t)PTE_USER;
+        kernel_pml4[PML4_INDEX(DIRECT_MAP_BASE) + i] = kernel_pml4[i];
+    }
+}
+
+// Inicializa a paginação de 4 níveis: identidade e mapa direto de toda a
+// memória física, a imagem do kernel nos últimos 2GB e a PDPT do heap
+// compartilhada por todos os espaços de endereçamento. As tabelas de
+// boot de entry.asm (identidade dos primeiros 4GB) valem até o cr3 novo
+void vmm_init() {
+    kernel_pml4 = PHYS_TO_VIRT(vmm_alloc_table());
+    
+    // Pelo menos 4GB: a janela de MMIO dos dispositivos PCI fica abaixo
+    uint64_t end = (uint64_t)pmm_total_pages() * PAGE_SIZE;
+    if(end < 4 * GIGABYTE) {
+        end = 4 * GIGABYTE;
+    }
+    end = (end + GIGABYTE - 1) & ~(GIGABYTE - 1);
+    vmm_map_physical(end);
+    
+    // Imagem do kernel: -2GB apontam para o primeiro 1GB físico
+    uint64_t *pdpt = vmm_next_level(kernel_pml4, PML4_INDEX(KERNEL_VIRT_BASE), 1);
+    uint64_t *low_pdpt = vmm_table(kernel_pml4[0]);
+    pdpt[PDPT_INDEX(KERNEL_VIRT_BASE)] = low_pdpt[0];
+    kernel_pml4[PML4_INDEX(KERNEL_VIRT_BASE)] &= ~(uint64_t)PTE_USER;
+    
+    // PDPT do heap pré-alocada: uma entrada de PML4 cobre os 512GB
+    vmm_next_level(kernel_pml4, PML4_INDEX(KERNEL_HEAP_START), 1);
+    kernel_pml4[PML4_INDEX(KERNEL_HEAP_START)] &= ~(uint64_t)PTE_USER;
+    
+    register_interrupt_handler(PAGE_FAULT_VECTOR, vmm_page_fault);
+    
+    // A paginação já está ligada (modo longo); só trocar a PML4
+    asm volatile("mov %0, %%cr3" : : "r"((uintptr_t)kernel_pml4 - DIRECT_MAP_BASE) : "memory");
+}
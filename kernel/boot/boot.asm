@@ -1,8 +1,17 @@
-; boot.asm - Bootloader for KakatsOS
+; boot.asm - Bootloader for KakatsOS (estágio 1)
+;
+; Carrega o estágio 2 (boot/stage2.asm) logo após o MBR usando as
+; extensões LBA do int 13h (AH=42h) e salta para ele.
 
 BITS 16
 org 0x7C00
 
+%define STAGE2_ADDR    0x7E00
+%define STAGE2_LBA     1
+%ifndef STAGE2_SECTORS
+%define STAGE2_SECTORS 8
+%endif
+
 start:
     ; Configura o segmento de dados
     cli
@@ -11,6 +20,10 @@ start:
     mov es, ax
     mov ss, ax
     mov sp, 0x7C00
+    sti
+
+    ; Guarda a unidade de boot passada pela BIOS
+    mov [boot_drive], dl
 
     ; Configura o modo de vídeo
     mov ah, 0x00
@@ -19,47 +32,62 @@ start:
 
     ; Mensagem de Boas-vindas
     mov si, welcome_msg
-print_char:
-    lodsb
-    cmp al, 0
-    je load_kernel
-    mov ah, 0x0E
-    int 0x10
-    jmp print_char
+    call print_string
 
-load_kernel:
-    ; Carrega o kernel (assume que está no segundo setor)
-    mov ax, 0x0000
-    mov es, ax
-    mov bx, 0x8000  ; Carrega o kernel para o endereço 0x8000:0000
-    mov ah, 0x02
-    mov al, 0x01    ; Número de setores a serem lidos
-    mov ch, 0x00    ; Trilha
-    mov cl, 0x02    ; Setor (segundo setor)
-    mov dh, 0x00    ; Cabeça
-    mov dl, 0x80    ; Unidade (primeiro disco)
+    ; Verifica suporte às extensões do int 13h
+    mov ah, 0x41
+    mov bx, 0x55AA
+    mov dl, [boot_drive]
+    int 0x13
+    jc disk_error
+    cmp bx, 0xAA55
+    jne disk_error
+
+load_stage2:
+    ; Lê o estágio 2 com um único pacote DAP
+    mov si, dap
+    mov ah, 0x42
+    mov dl, [boot_drive]
     int 0x13
     jc disk_error
 
-    ; Salta para o kernel
-    jmp 0x8000:0000
+    ; Salta para o estágio 2 (DL = unidade de boot)
+    mov dl, [boot_drive]
+    jmp 0x0000:STAGE2_ADDR
 
 disk_error:
     ; Mensagem de erro
     mov si, error_msg
-print_error:
+    call print_string
+
+halt:
+    hlt
+    jmp halt
+
+; Imprime a string terminada em zero apontada por SI
+print_string:
     lodsb
     cmp al, 0
-    je halt
+    je .done
     mov ah, 0x0E
     int 0x10
-    jmp print_error
+    jmp print_string
+.done:
+    ret
 
-halt:
-    hlt
-    jmp halt
+; Disk Address Packet para o estágio 2
+align 4
+dap:
+    db 0x10                 ; Tamanho do pacote
+    db 0
+    dw STAGE2_SECTORS       ; Número de setores
+    dw STAGE2_ADDR          ; Offset de destino
+    dw 0x0000               ; Segmento de destino
+    dq STAGE2_LBA           ; LBA inicial
+
+boot_drive db 0x80
 
-welcome_msg db 'KakatsOS Bootloader', 0
+welcome_msg db 'KakatsOS Bootloader', 13, 10, 0
 error_msg db 'Erro ao carregar o kernel', 0
 
 times 510-($-$$) db 0
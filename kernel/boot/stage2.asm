@@ -0,0 +1,334 @@
+; stage2.asm - Segundo estágio do bootloader do KakatsOS
+;
+; Carregado pelo boot.asm em 0x7E00. Habilita a linha A20, coleta o mapa
+; de memória (E820) no formato Multiboot, lê o kernel em blocos de 64
+; setores com int 13h AH=42h e copia cada bloco para 0x100000 usando
+; unreal mode. Por fim entra em modo protegido e salta para o kernel com
+; EAX = 0x2BADB002 e EBX = multiboot_info_t, como faria um carregador
+; Multiboot.
+
+BITS 16
+org 0x7E00
+
+%ifndef STAGE2_SECTORS
+%define STAGE2_SECTORS 8
+%endif
+%ifndef KERNEL_SECTORS
+%error "KERNEL_SECTORS deve ser definido (-DKERNEL_SECTORS=n)"
+%endif
+
+%define KERNEL_LBA      (1 + STAGE2_SECTORS)
+%define KERNEL_ADDR     0x100000
+%define CHUNK_SECTORS   64
+%define BOUNCE_SEG      0x1000          ; Buffer temporário em 0x10000 (32KB)
+%define BOUNCE_ADDR     0x10000
+
+%define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+%define MBI_ADDR        0x9000          ; multiboot_info_t
+%define MMAP_ADDR       0x9100          ; Entradas memory_map_t
+%define MMAP_MAX        32
+%define MMAP_ENTRY_SIZE 24
+
+stage2_start:
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    mov [boot_drive], dl
+
+    mov si, stage2_msg
+    call print_string
+
+    call enable_a20
+    jc a20_error
+
+    call detect_memory
+
+    ; Início da medição do tempo de carga
+    rdtsc
+    mov [tsc_start], eax
+    mov [tsc_start + 4], edx
+
+    mov dword [kernel_lba], KERNEL_LBA
+    mov dword [load_dest], KERNEL_ADDR
+    mov word [remaining], KERNEL_SECTORS
+
+.load_loop:
+    mov cx, [remaining]
+    test cx, cx
+    jz .load_done
+    cmp cx, CHUNK_SECTORS
+    jbe .chunk_ok
+    mov cx, CHUNK_SECTORS
+.chunk_ok:
+    ; Lê o bloco para o buffer temporário
+    mov [dap_count], cx
+    mov eax, [kernel_lba]
+    mov [dap_lba], eax
+    mov si, dap
+    mov ah, 0x42
+    mov dl, [boot_drive]
+    int 0x13
+    jc disk_error
+
+    ; A BIOS pode ter saído do unreal mode; reentrar antes de copiar
+    xor ax, ax
+    mov ds, ax
+    mov es, ax
+    call enter_unreal
+
+    ; Copia o bloco para a memória alta
+    movzx ecx, word [dap_count]
+    shl ecx, 7                          ; setores * 512 / 4
+    mov esi, BOUNCE_ADDR
+    mov edi, [load_dest]
+    cld
+    a32 rep movsd
+    mov [load_dest], edi
+
+    movzx eax, word [dap_count]
+    add [kernel_lba], eax
+    sub [remaining], ax
+    jmp .load_loop
+
+.load_done:
+    ; Relatório do tempo de carga em ciclos do TSC
+    rdtsc
+    sub eax, [tsc_start]
+    sbb edx, [tsc_start + 4]
+    push eax
+    push edx
+    mov si, loaded_msg
+    call print_string
+    pop eax
+    call print_hex32
+    pop eax
+    call print_hex32
+    mov si, cycles_msg
+    call print_string
+
+    ; Entra em modo protegido
+    cli
+    lgdt [gdt_desc]
+    mov eax, cr0
+    or al, 1
+    mov cr0, eax
+    jmp 0x08:protected_entry
+
+disk_error:
+    mov si, disk_error_msg
+    call print_string
+    jmp halt
+
+a20_error:
+    mov si, a20_error_msg
+    call print_string
+
+halt:
+    hlt
+    jmp halt
+
+; Habilita a linha A20 (BIOS, porta 0x92 e controlador de teclado)
+; CF = 1 em caso de falha
+enable_a20:
+    call check_a20
+    jnc .done
+
+    mov ax, 0x2401
+    int 0x15
+    call check_a20
+    jnc .done
+
+    ; Fast A20 (porta 0x92), sem tocar no bit de reset
+    in al, 0x92
+    test al, 2
+    jnz .kbc
+    or al, 2
+    and al, 0xFE
+    out 0x92, al
+    call check_a20
+    jnc .done
+
+.kbc:
+    ; Controlador de teclado: comando 0xD1 (escrever porta de saída)
+    call kbc_wait
+    mov al, 0xD1
+    out 0x64, al
+    call kbc_wait
+    mov al, 0xDF
+    out 0x60, al
+    call kbc_wait
+    call check_a20
+.done:
+    ret
+
+kbc_wait:
+    in al, 0x64
+    test al, 2
+    jnz kbc_wait
+    ret
+
+; Verifica se a A20 está habilitada comparando 0000:0500 e FFFF:0510
+; CF = 0 se habilitada
+check_a20:
+    push ds
+    push es
+    xor ax, ax
+    mov ds, ax
+    not ax
+    mov es, ax
+    mov al, [ds:0x0500]
+    push ax
+    mov al, [es:0x0510]
+    push ax
+    mov byte [ds:0x0500], 0x00
+    mov byte [es:0x0510], 0xFF
+    cmp byte [ds:0x0500], 0xFF
+    pop ax
+    mov [es:0x0510], al
+    pop ax
+    mov [ds:0x0500], al
+    pop es
+    pop ds
+    je .disabled
+    clc
+    ret
+.disabled:
+    stc
+    ret
+
+; Monta o mapa de memória Multiboot a partir do int 15h E820
+detect_memory:
+    mov di, MMAP_ADDR + 4
+    xor ebx, ebx
+    xor bp, bp
+.next:
+    mov eax, 0xE820
+    mov edx, 0x534D4150                 ; 'SMAP'
+    mov ecx, 20
+    int 0x15
+    jc .done
+    cmp eax, 0x534D4150
+    jne .done
+    mov dword [di - 4], 20              ; Campo size do memory_map_t
+    add di, MMAP_ENTRY_SIZE
+    inc bp
+    test ebx, ebx
+    jz .done
+    cmp bp, MMAP_MAX
+    jb .next
+.done:
+    ; Preenche multiboot_info_t (apenas o mapa de memória é válido)
+    mov di, MBI_ADDR
+    mov cx, 52 / 2
+    xor ax, ax
+    rep stosw
+    mov dword [MBI_ADDR], 1 << 6        ; flags: mmap_* válidos
+    mov ax, bp
+    mov cx, MMAP_ENTRY_SIZE
+    mul cx
+    mov [MBI_ADDR + 44], ax             ; mmap_length
+    mov dword [MBI_ADDR + 48], MMAP_ADDR ; mmap_addr
+    ret
+
+; Carrega DS e ES com limite de 4GB e volta ao modo real
+enter_unreal:
+    cli
+    push ds
+    push es
+    lgdt [gdt_desc]
+    mov eax, cr0
+    or al, 1
+    mov cr0, eax
+    jmp $ + 2
+    mov bx, 0x10
+    mov ds, bx
+    mov es, bx
+    and al, 0xFE
+    mov cr0, eax
+    pop es
+    pop ds
+    sti
+    ret
+
+; Imprime a string terminada em zero apontada por SI
+print_string:
+    lodsb
+    cmp al, 0
+    je .done
+    mov ah, 0x0E
+    int 0x10
+    jmp print_string
+.done:
+    ret
+
+; Imprime EAX em hexadecimal
+print_hex32:
+    mov cx, 8
+.digit:
+    rol eax, 4
+    push eax
+    and al, 0x0F
+    add al, '0'
+    cmp al, '9'
+    jbe .print
+    add al, 7
+.print:
+    mov ah, 0x0E
+    int 0x10
+    pop eax
+    loop .digit
+    ret
+
+BITS 32
+protected_entry:
+    mov ax, 0x10
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    mov ss, ax
+    mov esp, 0x90000
+
+    ; Salta para o ponto de entrada do kernel (_start em 0x100000)
+    mov eax, MULTIBOOT_BOOTLOADER_MAGIC
+    mov ebx, MBI_ADDR
+    mov ecx, KERNEL_ADDR
+    jmp ecx
+
+; GDT plana (mesmos seletores usados por gdt.c)
+align 8
+gdt:
+    dq 0
+    dq 0x00CF9A000000FFFF               ; Código: base 0, limite 4GB
+    dq 0x00CF92000000FFFF               ; Dados: base 0, limite 4GB
+gdt_end:
+
+gdt_desc:
+    dw gdt_end - gdt - 1
+    dd gdt
+
+; Disk Address Packet reutilizado para cada bloco do kernel
+align 4
+dap:
+    db 0x10
+    db 0
+dap_count:
+    dw 0
+    dw 0x0000                           ; Offset de destino
+    dw BOUNCE_SEG                       ; Segmento de destino
+dap_lba:
+    dq 0
+
+boot_drive db 0x80
+remaining dw 0
+kernel_lba dd 0
+load_dest dd 0
+tsc_start dq 0
+
+stage2_msg db 'Estagio 2: carregando kernel', 13, 10, 0
+loaded_msg db 'Kernel carregado em 0x', 0
+cycles_msg db ' ciclos', 13, 10, 0
+disk_error_msg db 'Erro ao carregar o kernel', 0
+a20_error_msg db 'Erro ao habilitar A20', 0
+
+times (STAGE2_SECTORS * 512)-($-$$) db 0
@@ -0,0 +1,423 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "bench.h"
+#include "serial.h"
+#include "console.h"
+#include "scheduler.h"
+#include "idt.h"
+#include "vfs.h"
+#include "pmm.h"
+#include "pipe.h"
+#include "ipc.h"
+#include "mmap.h"
+#include "io.h"
+#include "tsc.h"
+#include "block.h"
+#include "io_ring.h"
+#include "klib.h"
+
+// Vetor de interrupção livre usado para medir a ida e volta de um trap
+// (não há chamadas de sistema ainda; é o piso do custo de uma)
+#define BENCH_TRAP_VECTOR 0x81
+
+#define BENCH_FILE "/bench-vfs"
+#define BENCH_FILE_PAGES 16
+
+// Leituras de 4KB no primeiro disco, em lotes plugados
+#define BENCH_BLOCK_BATCH 32
+#define BENCH_BLOCK_SECTORS (4096 / BLOCK_SECTOR_SIZE)
+
+// Arquivo lido pelo io_ring, grande o bastante para não caber num lote
+#define BENCH_RING_FILE "/io-ring-bench"
+#define BENCH_RING_PAGES 256
+#define BENCH_RING_BATCH 32
+
+extern void bench_trap(void);
+
+// Registro, executado na ordem de registro
+static bench_t benches[BENCH_MAX];
+static uint32_t bench_count = 0;
+
+int bench_register(const char *name, bench_fn_t fn, uint32_t shift) {
+    if(bench_count >= BENCH_MAX) {
+        return -1;
+    }
+    
+    bench_t *bench = &benches[bench_count++];
+    bench->name = name;
+    bench->fn = fn;
+    bench->shift = shift;
+    return 0;
+}
+
+static void bench_pmm(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        void *page = pmm_alloc_page();
+        if(page) {
+            pmm_free_page(page);
+        }
+    }
+}
+
+// Aloca 64 páginas antes de liberar: exercita a busca no bitmap
+static void bench_pmm_batch(uint32_t iterations) {
+    void *pages[64];
+    for(uint32_t i = 0; i < iterations; i += 64) {
+        for(int j = 0; j < 64; j++) {
+            pages[j] = pmm_alloc_page();
+        }
+        for(int j = 0; j < 64; j++) {
+            if(pages[j]) {
+                pmm_free_page(pages[j]);
+            }
+        }
+    }
+}
+
+// Parceiro da troca de contexto: devolve a CPU até o fim do benchmark
+static volatile int switch_stop = 0;
+static uint32_t switch_partner = 0;
+
+static void bench_switch_task() {
+    while(!switch_stop) {
+        scheduler_schedule();
+    }
+    
+    for(;;) {
+        scheduler_block();
+        asm volatile("hlt");
+    }
+}
+
+// Cada iteração é uma ida e volta: atual -> parceiro -> atual
+static void bench_switch(uint32_t iterations) {
+    if(!switch_partner) {
+        switch_partner = process_create(bench_switch_task, 0);
+        if(!switch_partner) {
+            return;
+        }
+    }
+    for(uint32_t i = 0; i < iterations; i++) {
+        scheduler_schedule();
+    }
+}
+
+static void bench_trap_roundtrip(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        asm volatile("int %0" : : "i"(BENCH_TRAP_VECTOR) : "memory");
+    }
+}
+
+static void bench_vfs_open(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        int fd = vfs_open(BENCH_FILE, O_RDONLY);
+        if(fd >= 0) {
+            vfs_close(fd);
+        }
+    }
+}
+
+static uint8_t bench_buffer[4096];
+
+static void bench_vfs_read(uint32_t iterations) {
+    int fd = vfs_open(BENCH_FILE, O_RDONLY);
+    if(fd < 0) {
+        return;
+    }
+    for(uint32_t i = 0; i < iterations; i++) {
+        vfs_pread(fd, bench_buffer, sizeof(bench_buffer), (i % BENCH_FILE_PAGES) * 4096);
+    }
+    vfs_close(fd);
+}
+
+static void bench_vfs_write(uint32_t iterations) {
+    int fd = vfs_open(BENCH_FILE, O_RDWR);
+    if(fd < 0) {
+        return;
+    }
+    for(uint32_t i = 0; i < iterations; i++) {
+        vfs_pwrite(fd, bench_buffer, sizeof(bench_buffer), (i % BENCH_FILE_PAGES) * 4096);
+    }
+    vfs_close(fd);
+}
+
+// Ida e volta de 4KB pelo mesmo pipe (sem dormir: O_NONBLOCK)
+static int bench_pipe_fds[2] = { -1, -1 };
+
+static void bench_pipe(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        vfs_write(bench_pipe_fds[1], bench_buffer, sizeof(bench_buffer));
+        vfs_read(bench_pipe_fds[0], bench_buffer, sizeof(bench_buffer));
+    }
+}
+
+// Mensagem com 64KB fora de linha: a região recebida é reenviada, então
+// cada iteração só move 16 PTEs de um lugar para outro
+static int bench_ipc_channel = -1;
+static ipc_msg_t bench_msg;
+
+static void bench_ipc(uint32_t iterations) {
+    if(bench_ipc_channel < 0) {
+        return;
+    }
+    if(!bench_msg.ool) {
+        bench_msg.ool_len = 16 * PAGE_SIZE;
+        bench_msg.ool = vfs_mmap(NULL, bench_msg.ool_len, PROT_READ | PROT_WRITE,
+                                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if(bench_msg.ool == MAP_FAILED) {
+            bench_msg.ool = NULL;
+            return;
+        }
+        for(uint32_t p = 0; p < 16; p++) {
+            mmap_fault((uintptr_t)bench_msg.ool + p * PAGE_SIZE, PF_WRITE | PF_USER);
+        }
+    }
+    for(uint32_t i = 0; i < iterations; i++) {
+        ipc_send(bench_ipc_channel, &bench_msg, IPC_NONBLOCK);
+        ipc_receive(bench_ipc_channel, &bench_msg, IPC_NONBLOCK);
+    }
+}
+
+// Linha de 64 caracteres no console VGA (inclui a rolagem da tela)
+static void bench_console(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        console_write("bench: 0123456789abcdef0123456789abcdef0123456789abcdef01234\n");
+    }
+}
+
+// Páginas de destino e disco lido (o primeiro registrado, ATA ou virtio)
+static block_device_t *bench_disk = NULL;
+static void *bench_block_pages[BENCH_BLOCK_BATCH];
+static bio_t bench_bios[BENCH_BLOCK_BATCH];
+static uint32_t bench_disk_pages = 0;
+static uint32_t bench_block_next = 0;       // Continua de uma rodada para a outra
+static uint32_t bench_block_seed = 12345;
+
+// Uma iteração é uma página; o elevador funde as sequenciais em requisições
+// de vários segmentos, as aleatórias medem o custo por E/S no driver
+static void bench_block_read(uint32_t iterations, int random) {
+    uint32_t done = 0;
+    
+    while(done < iterations) {
+        uint32_t batch = 0;
+        
+        block_plug(bench_disk);
+        while(done < iterations && batch < BENCH_BLOCK_BATCH) {
+            uint32_t page;
+            if(random) {
+                bench_block_seed = bench_block_seed * 1103515245 + 12345;   // LCG
+                page = (bench_block_seed >> 8) % bench_disk_pages;
+            } else {
+                page = bench_block_next;
+                bench_block_next = (bench_block_next + 1) % bench_disk_pages;
+            }
+            
+            bio_t *bio = &bench_bios[batch];
+            bio->op = BLOCK_READ;
+            bio->sector = (uint64_t)page * BENCH_BLOCK_SECTORS;
+            bio->count = BENCH_BLOCK_SECTORS;
+            bio->buffer = bench_block_pages[batch];
+            bio->end_io = NULL;
+            block_submit(bench_disk, bio);
+            done++;
+            batch++;
+        }
+        block_unplug(bench_disk);
+        
+        for(uint32_t i = 0; i < batch; i++) {
+            block_wait(&bench_bios[i]);
+        }
+    }
+}
+
+static void bench_block_seq(uint32_t iterations) {
+    bench_block_read(iterations, 0);
+}
+
+static void bench_block_random(uint32_t iterations) {
+    bench_block_read(iterations, 1);
+}
+
+// Primeiro disco e as páginas de destino; 0 se há o que medir
+static int bench_block_setup() {
+    bench_disk = block_get_index(0);
+    if(!bench_disk) {
+        return -1;
+    }
+    
+    bench_disk_pages = bench_disk->sector_count >> 32 ? 0xFFFFFFFFu :
+                       (uint32_t)bench_disk->sector_count / BENCH_BLOCK_SECTORS;
+    if(bench_disk_pages == 0) {
+        return -1;
+    }
+    
+    for(int i = 0; i < BENCH_BLOCK_BATCH; i++) {
+        bench_block_pages[i] = pmm_alloc_page();
+        if(!bench_block_pages[i]) {
+            while(i-- > 0) {
+                pmm_free_page(bench_block_pages[i]);
+            }
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Leituras de 4KB pelo anel em lotes de BENCH_RING_BATCH; compare com
+// vfs_pread_4k, que faz uma chamada por leitura
+static int bench_ring_fd = -1;
+static io_ring_t *bench_ring = NULL;
+static io_ring_t *bench_ring_sqpoll = NULL;
+
+static void bench_ring_read(io_ring_t *ring, uint32_t iterations) {
+    uint32_t issued = 0;
+    
+    if(!ring) {
+        return;
+    }
+    while(issued < iterations) {
+        uint32_t batch = 0;
+        io_sqe_t *sqe;
+        while(issued < iterations && batch < BENCH_RING_BATCH &&
+              (sqe = io_ring_get_sqe(ring)) != NULL) {
+            sqe->opcode = IORING_OP_READ;
+            sqe->fd = bench_ring_fd;
+            sqe->offset = ((issued * 7) % BENCH_RING_PAGES) * 4096;
+            sqe->buffer = bench_buffer;
+            sqe->length = sizeof(bench_buffer);
+            sqe->user_data = issued;
+            issued++;
+            batch++;
+        }
+        
+        io_ring_submit_and_wait(ring, batch);
+        while(io_ring_peek_cqe(ring) != NULL) {
+            io_ring_cqe_seen(ring);
+        }
+    }
+}
+
+static void bench_ring_batch(uint32_t iterations) {
+    bench_ring_read(bench_ring, iterations);
+}
+
+static void bench_ring_sqpoll_read(uint32_t iterations) {
+    bench_ring_read(bench_ring_sqpoll, iterations);
+}
+
+// Registra os benchmarks do kernel e prepara o que eles usam
+void bench_init() {
+    serial_init();
+    idt_set_gate(BENCH_TRAP_VECTOR, (uintptr_t)bench_trap, 0x08, 0x8E);
+    
+    int fd = vfs_open(BENCH_FILE, O_CREAT | O_RDWR | O_TRUNC);
+    if(fd >= 0) {
+        for(uint32_t i = 0; i < BENCH_FILE_PAGES; i++) {
+            vfs_write(fd, bench_buffer, sizeof(bench_buffer));
+        }
+        vfs_close(fd);
+    }
+    
+    vfs_pipe_files(scheduler_current_files(), bench_pipe_fds, O_NONBLOCK);
+    bench_ipc_channel = ipc_channel_create();
+    
+    bench_ring_fd = vfs_open(BENCH_RING_FILE, O_CREAT | O_RDWR | O_TRUNC);
+    if(bench_ring_fd >= 0) {
+        for(uint32_t i = 0; i < BENCH_RING_PAGES; i++) {
+            vfs_write(bench_ring_fd, bench_buffer, sizeof(bench_buffer));
+        }
+        bench_ring = io_ring_setup(BENCH_RING_BATCH, 0);
+        bench_ring_sqpoll = io_ring_setup(BENCH_RING_BATCH, IORING_SETUP_SQPOLL);
+    }
+    
+    bench_register("pmm_alloc_free", bench_pmm, 14);
+    bench_register("pmm_alloc_free_batch64", bench_pmm_batch, 14);
+    bench_register("context_switch_roundtrip", bench_switch, 12);
+    bench_register("trap_roundtrip", bench_trap_roundtrip, 14);
+    bench_register("vfs_open_close", bench_vfs_open, 12);
+    bench_register("vfs_pread_4k", bench_vfs_read, 12);
+    bench_register("vfs_pwrite_4k", bench_vfs_write, 12);
+    bench_register("pipe_write_read_4k", bench_pipe, 12);
+    bench_register("ipc_send_receive_64k", bench_ipc, 12);
+    bench_register("console_write_64", bench_console, 8);
+    if(bench_ring) {
+        bench_register("io_ring_read_4k", bench_ring_batch, 12);
+    }
+    if(bench_ring_sqpoll) {
+        bench_register("io_ring_read_4k_sqpoll", bench_ring_sqpoll_read, 12);
+    }
+    if(bench_block_setup() == 0) {
+        bench_register("block_read_seq_4k", bench_block_seq, 10);
+        bench_register("block_read_random_4k", bench_block_random, 10);
+    }
+    klib_bench_register();
+}
+
+// Encerra o QEMU pelo isa-debug-exit; sem o dispositivo, apenas para
+void bench_exit(uint8_t code) {
+    outb(BENCH_EXIT_PORT, code);
+    for(;;) {
+        asm volatile("cli; hlt");
+    }
+}
+
+// Uma linha por benchmark, em ciclos por iteração:
+// BENCH name=<nome> iters=<n> rounds=<r> min=<c> median=<c> max=<c>
+static void bench_report(bench_t *bench, uint64_t *cycles) {
+    // Ordenação por inserção das rodadas
+    for(int i = 1; i < BENCH_ROUNDS; i++) {
+        uint64_t value = cycles[i];
+        int j = i - 1;
+        while(j >= 0 && cycles[j] > value) {
+            cycles[j + 1] = cycles[j];
+            j--;
+        }
+        cycles[j + 1] = value;
+    }
+    
+    serial_write("BENCH name=");
+    serial_write(bench->name);
+    serial_write(" iters=");
+    serial_write_dec(1u << bench->shift);
+    serial_write(" rounds=");
+    serial_write_dec(BENCH_ROUNDS);
+    serial_write(" min=");
+    serial_write_dec(cycles[0] >> bench->shift);
+    serial_write(" median=");
+    serial_write_dec(cycles[BENCH_ROUNDS / 2] >> bench->shift);
+    serial_write(" max=");
+    serial_write_dec(cycles[BENCH_ROUNDS - 1] >> bench->shift);
+    serial_write("\n");
+}
+
+// Executa o registro inteiro, imprime os resultados na serial e sai do QEMU
+void bench_run_all() {
+    uint64_t cycles[BENCH_ROUNDS];
+    
+    bench_init();
+    serial_write("BENCH-BEGIN count=");
+    serial_write_dec(bench_count);
+    serial_write("\n");
+    
+    for(uint32_t i = 0; i < bench_count; i++) {
+        bench_t *bench = &benches[i];
+        
+        // Uma rodada de aquecimento (caches, páginas do arquivo)
+        bench->fn(1u << bench->shift);
+        for(int round = 0; round < BENCH_ROUNDS; round++) {
+            uint64_t start = rdtsc();
+            bench->fn(1u << bench->shift);
+            cycles[round] = rdtsc() - start;
+        }
+        bench_report(bench, cycles);
+    }
+    
+    switch_stop = 1;
+    vfs_truncate(BENCH_FILE, 0);
+    if(bench_ring_fd >= 0) {
+        vfs_close(bench_ring_fd);
+        vfs_truncate(BENCH_RING_FILE, 0);
+    }
+    serial_write("BENCH-END\n");
+    bench_exit(0);
+}
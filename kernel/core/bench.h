@@ -0,0 +1,28 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+
+#define BENCH_MAX    32
+#define BENCH_ROUNDS 5      // Rodadas por benchmark; reporta mínimo e mediana
+
+// Porta do dispositivo isa-debug-exit do QEMU: escrever v encerra o QEMU
+// com código (v << 1) | 1
+#define BENCH_EXIT_PORT 0xF4
+
+// Executa a operação medida 'iterations' vezes
+typedef void (*bench_fn_t)(uint32_t iterations);
+
+// Entrada do registro de benchmarks
+typedef struct bench {
+    const char *name;
+    bench_fn_t fn;
+    uint32_t shift;     // 1 << shift iterações por rodada
+} bench_t;
+
+int bench_register(const char *name, bench_fn_t fn, uint32_t shift);
+void bench_init(void);
+void bench_run_all(void);
+void bench_exit(uint8_t code);
+
+#endif
@@ -2,6 +2,8 @@
 
 global gdt_flush     ; Permite que C chame gdt_flush()
 global idt_load      ; Permite que C chame idt_load()
+global bench_trap    ; Vetor de teste do benchmark de traps
+global user_enter    ; Primeira entrada no anel 3 (exec)
 
 gdt_flush:
     mov eax, [esp+4]  ; Pega o ponteiro do parâmetro
@@ -20,4 +22,34 @@ gdt_flush:
 idt_load:
     mov eax, [esp+4]  ; Pega o ponteiro do parâmetro
     lidt [eax]        ; Carrega a IDT
-    ret
\ No newline at end of file
+    ret
+
+; Retorna imediatamente: mede só a entrada e a saída de uma interrupção
+bench_trap:
+    iret
+
+; user_enter(uint32_t entry, uint32_t stack)
+; Desce para o anel 3 com um quadro de iret: SS e ESP do usuário, EFLAGS
+; com IF ligado, CS e EIP. Não volta; a pilha do kernel fica para o TSS
+user_enter:
+    mov ecx, [esp+4]
+    mov edx, [esp+8]
+    mov ax, 0x23      ; Dados de usuário (0x20 | RPL 3)
+    mov ds, ax
+    mov es, ax
+    mov fs, ax
+    mov gs, ax
+    push dword 0x23
+    push edx
+    pushfd
+    or dword [esp], 0x200
+    push dword 0x1B   ; Código de usuário (0x18 | RPL 3)
+    push ecx
+    xor eax, eax
+    xor ebx, ebx
+    xor ecx, ecx
+    xor edx, edx
+    xor esi, esi
+    xor edi, edi
+    xor ebp, ebp
+    iret
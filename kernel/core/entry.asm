@@ -0,0 +1,62 @@
+; entry.asm - Ponto de entrada do kernel
+;
+; _start fica em 0x100000 (início de .multiboot, ver link.ld), então serve
+; tanto para o estágio 2 do bootloader quanto para carregadores Multiboot
+; (QEMU -kernel, GRUB). Ambos entregam EAX = magic e EBX = multiboot_info_t.
+
+MBOOT_PAGE_ALIGN    equ 1 << 0
+MBOOT_MEM_INFO      equ 1 << 1
+MBOOT_HEADER_MAGIC  equ 0x1BADB002
+MBOOT_HEADER_FLAGS  equ MBOOT_PAGE_ALIGN | MBOOT_MEM_INFO
+MBOOT_CHECKSUM      equ -(MBOOT_HEADER_MAGIC + MBOOT_HEADER_FLAGS)
+
+KERNEL_STACK_SIZE   equ 16384
+
+global _start
+extern kernel_main
+extern __bss_start
+extern __bss_end
+
+section .multiboot progbits alloc exec nowrite align=4
+_start:
+    jmp start32
+
+; Cabeçalho Multiboot (precisa estar nos primeiros 8KB, alinhado a 4)
+align 4
+multiboot_header:
+    dd MBOOT_HEADER_MAGIC
+    dd MBOOT_HEADER_FLAGS
+    dd MBOOT_CHECKSUM
+
+section .text
+start32:
+    cli
+    mov esp, stack_top
+
+    ; Zerar a BSS (o estágio 2 carrega apenas a imagem plana)
+    mov edx, eax
+    mov edi, __bss_start
+    mov ecx, __bss_end
+    sub ecx, edi
+    shr ecx, 2
+    xor eax, eax
+    cld
+    rep stosd
+
+    ; kernel_main(magic, mbi); EBP zerado encerra as cadeias de quadros
+    ; percorridas pelo profiler
+    xor ebp, ebp
+    push ebx
+    push edx
+    call kernel_main
+
+.hang:
+    cli
+    hlt
+    jmp .hang
+
+section .bss
+align 16
+stack_bottom:
+    resb KERNEL_STACK_SIZE
+stack_top:
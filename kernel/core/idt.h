@@ -3,20 +3,29 @@
 
 #include <stdint.h>
 
+// No x86_64 os portões têm 16 bytes: endereço de 64 bits e índice da IST
 struct idt_entry {
     uint16_t base_lo;
     uint16_t sel;
+#ifdef __x86_64__
+    uint8_t ist;
+#else
     uint8_t always0;
+#endif
     uint8_t flags;
     uint16_t base_hi;
+#ifdef __x86_64__
+    uint32_t base_upper;
+    uint32_t reserved;
+#endif
 } __attribute__((packed));
 
 struct idt_ptr {
     uint16_t limit;
-    uint32_t base;
+    uintptr_t base;
 } __attribute__((packed));
 
 void idt_init(void);
-void idt_set_gate(uint8_t num, uint32_t base, uint16_t sel, uint8_t flags);
+void idt_set_gate(uint8_t num, uintptr_t base, uint16_t sel, uint8_t flags);
 
 #endif
\ No newline at end of file
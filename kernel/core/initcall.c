@@ -0,0 +1,162 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "initcall.h"
+#include "console.h"
+#include "scheduler.h"
+#include "tsc.h"
+
+#define MAX_INITCALLS 32
+
+// Tabela de inicialização, executada na ordem de registro
+static initcall_t initcalls[MAX_INITCALLS];
+static uint32_t initcall_count = 0;
+
+// TSC no início do boot (primeiro initcall_run)
+static uint64_t boot_start = 0;
+
+// Registra uma função de inicialização
+int initcall_register(const char *name, initcall_fn_t fn, uint32_t flags, uint64_t budget) {
+    if(initcall_count >= MAX_INITCALLS) {
+        return -1; // Sem slots disponíveis
+    }
+    
+    initcall_t *call = &initcalls[initcall_count++];
+    call->name = name;
+    call->fn = fn;
+    call->flags = flags;
+    call->budget = budget;
+    call->start = 0;
+    call->end = 0;
+    call->done = 0;
+    
+    return 0;
+}
+
+// Executa uma entrada medindo o TSC na entrada e na saída
+static void initcall_invoke(initcall_t *call) {
+    call->start = rdtsc();
+    call->fn();
+    call->end = rdtsc();
+    call->done = 1;
+}
+
+// Executa todas as entradas não adiadas
+void initcall_run() {
+    boot_start = rdtsc();
+    
+    for(uint32_t i = 0; i < initcall_count; i++) {
+        if(!(initcalls[i].flags & INITCALL_DEFERRED)) {
+            initcall_invoke(&initcalls[i]);
+        }
+    }
+}
+
+// Executa as entradas adiadas que ainda não rodaram
+void initcall_run_deferred() {
+    for(uint32_t i = 0; i < initcall_count; i++) {
+        if((initcalls[i].flags & INITCALL_DEFERRED) && !initcalls[i].done) {
+            initcall_invoke(&initcalls[i]);
+        }
+    }
+}
+
+// Processo que executa as entradas adiadas e depois dorme para sempre
+static void initcall_deferred_task() {
+    initcall_run_deferred();
+    initcall_report();
+    
+    for(;;) {
+        scheduler_block();
+        asm volatile("hlt");
+    }
+}
+
+// Cria o processo das entradas adiadas; como o escalonador é round-robin,
+// ele roda depois dos processos criados antes dele
+void initcall_start_deferred() {
+    if(process_create(initcall_deferred_task, 0) == 0) {
+        // Sem processos disponíveis: executar agora mesmo
+        initcall_run_deferred();
+    }
+}
+
+// Ciclos gastos por uma entrada
+static uint64_t initcall_cycles(const initcall_t *call) {
+    return call->done ? call->end - call->start : 0;
+}
+
+// Soma dos ciclos de todas as entradas executadas
+uint64_t initcall_total_cycles() {
+    uint64_t total = 0;
+    for(uint32_t i = 0; i < initcall_count; i++) {
+        total += initcall_cycles(&initcalls[i]);
+    }
+    return total;
+}
+
+// Número de entradas que estouraram o orçamento
+int initcall_over_budget() {
+    int over = 0;
+    for(uint32_t i = 0; i < initcall_count; i++) {
+        if(initcalls[i].budget && initcall_cycles(&initcalls[i]) > initcalls[i].budget) {
+            over++;
+        }
+    }
+    return over;
+}
+
+// Calcula part * 100 / total sem divisão de 64 bits
+static uint32_t initcall_percent(uint64_t part, uint64_t total) {
+    while(total > 0x00FFFFFF) {
+        part >>= 1;
+        total >>= 1;
+    }
+    if(total == 0) {
+        return 0;
+    }
+    return ((uint32_t)part * 100) / (uint32_t)total;
+}
+
+// Imprime o relatório de boot ordenado pelo custo (maior primeiro)
+void initcall_report() {
+    uint8_t order[MAX_INITCALLS];
+    uint64_t total = initcall_total_cycles();
+    
+    // Ordenação por inserção dos índices
+    for(uint32_t i = 0; i < initcall_count; i++) {
+        uint32_t j = i;
+        while(j > 0 && initcall_cycles(&initcalls[order[j - 1]]) < initcall_cycles(&initcalls[i])) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = i;
+    }
+    
+    console_write("Boot: ");
+    console_write_dec(total);
+    console_write(" ciclos em initcalls\n");
+    
+    for(uint32_t i = 0; i < initcall_count; i++) {
+        initcall_t *call = &initcalls[order[i]];
+        uint64_t cycles = initcall_cycles(call);
+        
+        console_write("  ");
+        console_write(call->name);
+        console_write(": ");
+        if(!call->done) {
+            console_write("pendente\n");
+            continue;
+        }
+        console_write_dec(cycles);
+        console_write(" ciclos (");
+        console_write_dec(initcall_percent(cycles, total));
+        console_write("%)");
+        if(call->flags & INITCALL_DEFERRED) {
+            console_write(" [adiado]");
+        }
+        if(call->budget && cycles > call->budget) {
+            console_write(" ACIMA DO ORCAMENTO");
+        }
+        console_putchar('\n');
+    }
+}
@@ -0,0 +1,31 @@
+#ifndef INITCALL_H
+#define INITCALL_H
+
+#include <stdint.h>
+
+// Flags de registro
+#define INITCALL_DEFERRED 0x01  // Roda depois que o primeiro processo começa
+
+// Função de inicialização de um subsistema
+typedef void (*initcall_fn_t)(void);
+
+// Entrada da tabela de inicialização
+typedef struct initcall {
+    const char *name;
+    initcall_fn_t fn;
+    uint32_t flags;
+    uint64_t budget;    // Orçamento em ciclos (0 = sem limite)
+    uint64_t start;     // TSC na entrada
+    uint64_t end;       // TSC na saída
+    int done;
+} initcall_t;
+
+int initcall_register(const char *name, initcall_fn_t fn, uint32_t flags, uint64_t budget);
+void initcall_run(void);
+void initcall_run_deferred(void);
+void initcall_start_deferred(void);
+void initcall_report(void);
+uint64_t initcall_total_cycles(void);
+int initcall_over_budget(void);
+
+#endif
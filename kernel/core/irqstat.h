@@ -0,0 +1,22 @@
+#ifndef IRQSTAT_H
+#define IRQSTAT_H
+
+#include <stdint.h>
+#include "percpu.h"
+#include "trace.h"
+
+// Marcam o início e o fim de um handler de IRQ: contam a interrupção na
+// CPU atual (lida por /proc/interrupts) e geram os tracepoints. Ficam em
+// cada handler porque o despachante comum de interrupções não faz nada disso
+static inline void irq_enter(uint32_t irq) {
+    if(irq < NR_IRQS) {
+        this_cpu()->irqs[irq]++;
+    }
+    TRACE(TRACE_IRQ_ENTER, irq, 0);
+}
+
+static inline void irq_exit(uint32_t irq) {
+    TRACE(TRACE_IRQ_EXIT, irq, 0);
+}
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef PERCPU_H
+#define PERCPU_H
+
+#include <stdint.h>
+
+// Só o processador de boot roda por enquanto; o estado por CPU já é
+// indexado por cpu_id() para quando os APs forem acordados
+#define MAX_CPUS 8
+
+// Linhas de IRQ do PIC (vetores 32 a 47)
+#define NR_IRQS 16
+
+// Estado de cada processador
+typedef struct cpu {
+    uint32_t id;
+    volatile uint32_t preempt_count;    // > 0: sem preempção (spinlocks, RCU)
+    volatile uint32_t rcu_qs;           // Último período de graça reconhecido
+    
+    // Contadores lidos pelo procfs; só a própria CPU escreve neles
+    uint32_t ticks;                     // Ticks do timer
+    uint32_t context_switches;
+    uint32_t page_faults;               // Vetor 14
+    uint32_t irqs[NR_IRQS];
+} cpu_t;
+
+extern cpu_t cpus[MAX_CPUS];
+extern uint32_t cpu_count;
+
+static inline uint32_t cpu_id(void) {
+    return 0;
+}
+
+static inline cpu_t *this_cpu(void) {
+    return &cpus[cpu_id()];
+}
+
+#endif
@@ -0,0 +1,265 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "profile.h"
+#include "spinlock.h"
+#include "tsc.h"
+#ifndef KERNEL_HOSTED
+#include "io.h"
+#include "rtc.h"
+#include "serial.h"
+#endif
+
+// Cadeia agregada: endereços do interrompido para os chamadores
+typedef struct profile_chain {
+    uint32_t hash;
+    uint32_t count;     // 0 = posição livre
+    uint32_t depth;
+    uintptr_t pcs[PROFILE_MAX_DEPTH];
+} profile_chain_t;
+
+// Tabela de uma CPU; só a própria CPU escreve nela
+typedef struct profile_table {
+    profile_chain_t *chains;
+    uint32_t used;
+    uint64_t samples;
+    uint64_t dropped;
+    uint64_t overhead_cycles;
+    uint64_t max_sample_cycles;
+} profile_table_t;
+
+static profile_table_t tables[MAX_CPUS];
+static volatile int profile_enabled = 0;
+static uint32_t profile_hz = 0;
+static uint32_t profile_depth = PROFILE_MAX_DEPTH;
+
+// Faixa do código: endereços de retorno fora dela encerram a cadeia. No
+// build hospedado o binário é PIE e o dump leva o deslocamento de carga
+#ifdef KERNEL_HOSTED
+extern char __executable_start[], etext[];
+#define PROFILE_TEXT_START ((uintptr_t)__executable_start)
+#define PROFILE_TEXT_END   ((uintptr_t)etext)
+#define PROFILE_RELOC      ((uintptr_t)__executable_start)
+#else
+extern char __text_start[], __text_end[];
+#define PROFILE_TEXT_START ((uintptr_t)__text_start)
+#define PROFILE_TEXT_END   ((uintptr_t)__text_end)
+#define PROFILE_RELOC      0
+#endif
+
+// Maior quadro aceito e maior distância entre a amostra e um quadro do
+// interrompido: as pilhas do kernel têm 8KB (16KB a de boot)
+#define PROFILE_FRAME_MAX 4096
+#define PROFILE_STACK_MAX 16384
+
+void profile_init() {
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        if(!tables[i].chains) {
+            tables[i].chains = malloc(PROFILE_CHAINS * sizeof(profile_chain_t));
+        }
+    }
+    profile_reset();
+}
+
+// Descarta as amostras (a amostragem continua se estiver ligada)
+void profile_reset() {
+    uintptr_t flags = irq_save();
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        profile_table_t *table = &tables[i];
+        if(table->chains) {
+            memset(table->chains, 0, PROFILE_CHAINS * sizeof(profile_chain_t));
+        }
+        table->used = 0;
+        table->samples = table->dropped = 0;
+        table->overhead_cycles = table->max_sample_cycles = 0;
+    }
+    irq_restore(flags);
+}
+
+static inline int profile_in_text(uintptr_t pc) {
+    return pc >= PROFILE_TEXT_START && pc < PROFILE_TEXT_END;
+}
+
+// Percorre os frame pointers: [fp] é o fp do chamador e [fp + 1] o
+// endereço de retorno. O handler roda na pilha do interrompido, então cada
+// quadro precisa estar acima de pcs (que está nela) e a menos de
+// PROFILE_STACK_MAX dele, acima do quadro anterior e perto dele, e cada
+// retorno dentro do código; sem isso a cadeia termina (código sem frame
+// pointer usando ebp/rbp como registro comum, base da pilha)
+#ifdef KERNEL_HOSTED
+__attribute__((no_sanitize_address))
+#endif
+static uint32_t profile_walk(uintptr_t ip, uintptr_t fp, uintptr_t *pcs, uint32_t max) {
+    uint32_t depth = 0;
+    uintptr_t base = (uintptr_t)pcs;
+    
+    pcs[depth++] = ip;
+    while(depth < max && fp > base && !(fp & (sizeof(uintptr_t) - 1)) && fp - base < PROFILE_STACK_MAX) {
+        uintptr_t *frame = (uintptr_t*)fp;
+        uintptr_t next = frame[0];
+        uintptr_t ret = frame[1];
+        if(!profile_in_text(ret)) {
+            break;
+        }
+        pcs[depth++] = ret;
+        
+        if(next <= fp || next - fp > PROFILE_FRAME_MAX) {
+            break;
+        }
+        fp = next;
+    }
+    
+    return depth;
+}
+
+static inline uint32_t profile_hash(const uintptr_t *pcs, uint32_t depth) {
+    uint32_t hash = 2166136261u;
+    for(uint32_t i = 0; i < depth; i++) {
+        hash ^= (uint32_t)pcs[i] ^ (uint32_t)((uint64_t)pcs[i] >> 32);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Chamado com interrupções desligadas (handler do RTC ou SIGPROF no build
+// hospedado)
+void profile_sample(uintptr_t ip, uintptr_t fp) {
+    if(!profile_enabled) {
+        return;
+    }
+    
+    uint64_t start = rdtsc();
+    profile_table_t *table = &tables[cpu_id()];
+    if(!table->chains) {
+        return;
+    }
+    
+    uintptr_t pcs[PROFILE_MAX_DEPTH];
+    uint32_t depth = profile_walk(ip, fp, pcs, profile_depth);
+    uint32_t hash = profile_hash(pcs, depth);
+    
+    // Endereçamento aberto com sondagem linear limitada
+    table->samples++;
+    profile_chain_t *chain = NULL;
+    for(uint32_t probe = 0; probe < PROFILE_MAX_PROBES; probe++) {
+        profile_chain_t *slot = &table->chains[(hash + probe) & (PROFILE_CHAINS - 1)];
+        if(slot->count == 0) {
+            slot->hash = hash;
+            slot->depth = depth;
+            memcpy(slot->pcs, pcs, depth * sizeof(uintptr_t));
+            table->used++;
+            chain = slot;
+            break;
+        }
+        if(slot->hash == hash && slot->depth == depth &&
+           memcmp(slot->pcs, pcs, depth * sizeof(uintptr_t)) == 0) {
+            chain = slot;
+            break;
+        }
+    }
+    
+    if(chain) {
+        chain->count++;
+    } else {
+        table->dropped++;
+    }
+    
+    uint64_t cycles = rdtsc() - start;
+    table->overhead_cycles += cycles;
+    if(cycles > table->max_sample_cycles) {
+        table->max_sample_cycles = cycles;
+    }
+}
+
+#ifndef KERNEL_HOSTED
+// No modo usuário não há quadros do kernel para seguir
+static void profile_tick(registers_t *regs) {
+#ifdef __x86_64__
+    profile_sample(regs->rip, (regs->cs & 3) ? 0 : regs->rbp);
+#else
+    profile_sample(regs->eip, (regs->cs & 3) ? 0 : regs->ebp);
+#endif
+}
+#endif
+
+uint32_t profile_start(uint32_t hz, uint32_t depth) {
+    if(!tables[cpu_id()].chains) {
+        return 0;
+    }
+    
+    profile_depth = (depth == 0 || depth > PROFILE_MAX_DEPTH) ? PROFILE_MAX_DEPTH : depth;
+    profile_enabled = 1;
+#ifdef KERNEL_HOSTED
+    profile_hz = hz;    // O build hospedado gera as amostras (host/stubs.c)
+#else
+    profile_hz = rtc_start_periodic(hz, profile_tick);
+#endif
+    return profile_hz;
+}
+
+void profile_stop() {
+#ifndef KERNEL_HOSTED
+    rtc_stop_periodic();
+#endif
+    profile_enabled = 0;
+}
+
+// Gera o dump com a amostragem pausada
+void profile_dump(profile_write_fn_t write, void *ctx) {
+    int enabled = profile_enabled;
+    profile_enabled = 0;
+    
+    profile_header_t header;
+    memset(&header, 0, sizeof(header));
+    header.magic = PROFILE_MAGIC;
+    header.version = PROFILE_VERSION;
+    header.max_depth = PROFILE_MAX_DEPTH;
+    header.hz = profile_hz;
+    header.cpu_count = cpu_count;
+    header.reloc = PROFILE_RELOC;
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        header.samples += tables[i].samples;
+        header.dropped += tables[i].dropped;
+        header.overhead_cycles += tables[i].overhead_cycles;
+        if(tables[i].max_sample_cycles > header.max_sample_cycles) {
+            header.max_sample_cycles = tables[i].max_sample_cycles;
+        }
+    }
+    write(&header, sizeof(header), ctx);
+    
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        profile_table_t *table = &tables[i];
+        profile_cpu_header_t cpu = { i, table->chains ? table->used : 0 };
+        write(&cpu, sizeof(cpu), ctx);
+        
+        for(uint32_t j = 0; j < PROFILE_CHAINS && cpu.chains; j++) {
+            profile_chain_t *chain = &table->chains[j];
+            if(chain->count == 0) {
+                continue;
+            }
+            
+            profile_chain_header_t chain_header = { chain->count, chain->depth };
+            write(&chain_header, sizeof(chain_header), ctx);
+            for(uint32_t k = 0; k < chain->depth; k++) {
+                uint64_t pc = chain->pcs[k];
+                write(&pc, sizeof(pc), ctx);
+            }
+        }
+    }
+    
+    profile_enabled = enabled;
+}
+
+#ifndef KERNEL_HOSTED
+static void profile_write_serial(const void *data, size_t len, void *ctx) {
+    (void)ctx;
+    serial_write_hex_lines("PROF ", data, len);
+}
+
+void profile_dump_serial() {
+    serial_init();
+    serial_write("PROF-BEGIN\n");
+    profile_dump(profile_write_serial, NULL);
+    serial_write("PROF-END\n");
+}
+#endif
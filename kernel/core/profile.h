@@ -0,0 +1,70 @@
+#ifndef PROFILE_H
+#define PROFILE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Profiler por amostragem: a cada interrupção do RTC guarda o endereço
+// interrompido e a cadeia de chamadas (percorrendo os frame pointers) numa
+// tabela hash por CPU, alocada em profile_init(); nada é alocado na
+// interrupção. O custo por amostra é limitado pela profundidade e pelas
+// sondagens da tabela. tools/kprof.c simboliza o dump com a tabela de
+// símbolos do kernel.elf e gera pilhas "dobradas" para flame graphs
+
+#define PROFILE_MAX_DEPTH   16      // Quadros por amostra (endereço interrompido incluso)
+#define PROFILE_CHAINS      2048    // Cadeias distintas por CPU (potência de 2)
+#define PROFILE_MAX_PROBES  8       // Sondagens antes de descartar a amostra
+#define PROFILE_DEFAULT_HZ  1024
+
+// Dump: cabeçalho, e para cada CPU um profile_cpu_header_t seguido de
+// chains registros (profile_chain_header_t e depth endereços de 64 bits,
+// do endereço interrompido para os chamadores)
+#define PROFILE_MAGIC   0x4652504Bu // "KPRF"
+#define PROFILE_VERSION 1
+
+typedef struct profile_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t max_depth;
+    uint32_t hz;
+    uint32_t cpu_count;
+    uint64_t reloc;             // Endereço em execução - endereço no ELF
+    uint64_t samples;
+    uint64_t dropped;           // Tabela cheia
+    uint64_t overhead_cycles;   // Ciclos gastos dentro de profile_sample()
+    uint64_t max_sample_cycles;
+} profile_header_t;
+
+typedef struct profile_cpu_header {
+    uint32_t cpu;
+    uint32_t chains;
+} profile_cpu_header_t;
+
+typedef struct profile_chain_header {
+    uint32_t count;
+    uint32_t depth;
+} profile_chain_header_t;
+
+#ifndef PROFILE_DECODER
+
+void profile_init(void);
+
+// Amostragem a hz (arredondado para a frequência do RTC mais próxima por
+// baixo) com até depth quadros; retorna a frequência usada ou 0
+uint32_t profile_start(uint32_t hz, uint32_t depth);
+void profile_stop(void);
+void profile_reset(void);
+
+// Registra uma amostra: ip é o endereço interrompido e fp o frame
+// pointer naquele ponto (0 = sem pilha, como no modo usuário)
+void profile_sample(uintptr_t ip, uintptr_t fp);
+
+typedef void (*profile_write_fn_t)(const void *data, size_t len, void *ctx);
+void profile_dump(profile_write_fn_t write, void *ctx);
+
+// Dump na serial: linhas "PROF <hex>" entre PROF-BEGIN e PROF-END
+void profile_dump_serial(void);
+
+#endif
+
+#endif
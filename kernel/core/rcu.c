@@ -0,0 +1,143 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "rcu.h"
+#include "scheduler.h"
+
+// Períodos de graça são numerados: rcu_gp_seq é o último iniciado e
+// rcu_gp_done o último concluído (iguais = nenhum em andamento). Cada CPU
+// guarda em rcu_qs o último período em que passou por um estado quiescente
+static volatile uint32_t rcu_gp_seq = 0;
+static volatile uint32_t rcu_gp_done = 0;
+static uint32_t rcu_gp_wanted = 0;          // Período pedido por callbacks
+
+// Callbacks esperando, em ordem de período de graça
+static rcu_head_t *rcu_pending = NULL;
+static rcu_head_t **rcu_pending_tail = &rcu_pending;
+
+static spinlock_t rcu_lock;
+static int rcu_lock_ready = 0;
+static rcu_stats_t rcu_stats;
+
+// a já passou (ou é) b, com contadores que dão a volta
+static inline int rcu_seq_ge(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) >= 0;
+}
+
+// rcu_note_context_switch roda no tick do timer: o lock desliga interrupções
+static uintptr_t rcu_lock_acquire() {
+    if(!rcu_lock_ready) {
+        spin_lock_init(&rcu_lock, "rcu");
+        rcu_lock_ready = 1;
+    }
+    return spin_lock_irqsave(&rcu_lock);
+}
+
+// Período que cobre leitores em andamento agora; inicia um se preciso.
+// Chamado com rcu_lock
+static uint32_t rcu_request_gp() {
+    if(rcu_gp_seq == rcu_gp_done) {
+        rcu_gp_seq = rcu_gp_seq + 1;
+        return rcu_gp_seq;
+    }
+    
+    // Algumas CPUs já podem ter reconhecido o período atual
+    uint32_t gp = rcu_gp_seq + 1;
+    if(rcu_seq_ge(gp, rcu_gp_wanted)) {
+        rcu_gp_wanted = gp;
+    }
+    return gp;
+}
+
+void rcu_note_context_switch() {
+    cpu_t *cpu = this_cpu();
+    uint32_t seq = __atomic_load_n(&rcu_gp_seq, __ATOMIC_ACQUIRE);
+    if(cpu->rcu_qs == seq) {
+        return;
+    }
+    
+    uintptr_t flags = rcu_lock_acquire();
+    cpu->rcu_qs = rcu_gp_seq;
+    
+    if(rcu_gp_seq != rcu_gp_done) {
+        int complete = 1;
+        for(uint32_t i = 0; i < cpu_count; i++) {
+            if(cpus[i].rcu_qs != rcu_gp_seq) {
+                complete = 0;
+                break;
+            }
+        }
+        
+        if(complete) {
+            rcu_gp_done = rcu_gp_seq;
+            rcu_stats.grace_periods++;
+            
+            // Callbacks que chegaram durante o período precisam de outro
+            if(!rcu_seq_ge(rcu_gp_done, rcu_gp_wanted)) {
+                rcu_gp_seq = rcu_gp_seq + 1;
+            }
+        }
+    }
+    spin_unlock_irqrestore(&rcu_lock, flags);
+}
+
+// Executa os callbacks cujo período terminou. Fora do tick: os callbacks
+// liberam memória e podem tomar locks sem irqsave
+static void rcu_process_callbacks() {
+    uintptr_t flags = rcu_lock_acquire();
+    rcu_head_t *ready = NULL;
+    rcu_head_t **tail = &ready;
+    while(rcu_pending && rcu_seq_ge(rcu_gp_done, rcu_pending->gp)) {
+        *tail = rcu_pending;
+        tail = &rcu_pending->next;
+        rcu_pending = rcu_pending->next;
+        rcu_stats.pending--;
+    }
+    *tail = NULL;
+    if(!rcu_pending) {
+        rcu_pending_tail = &rcu_pending;
+    }
+    spin_unlock_irqrestore(&rcu_lock, flags);
+    
+    while(ready) {
+        rcu_head_t *head = ready;
+        ready = ready->next;
+        head->fn(head);
+        __atomic_fetch_add(&rcu_stats.callbacks, 1, __ATOMIC_RELAXED);
+    }
+}
+
+void call_rcu(rcu_head_t *head, void (*fn)(rcu_head_t *head)) {
+    head->fn = fn;
+    head->next = NULL;
+    
+    uintptr_t flags = rcu_lock_acquire();
+    head->gp = rcu_request_gp();
+    *rcu_pending_tail = head;
+    rcu_pending_tail = &head->next;
+    rcu_stats.pending++;
+    spin_unlock_irqrestore(&rcu_lock, flags);
+    
+    // Aproveita para liberar o que já venceu
+    rcu_process_callbacks();
+}
+
+void synchronize_rcu() {
+    uintptr_t flags = rcu_lock_acquire();
+    uint32_t target = rcu_request_gp();
+    spin_unlock_irqrestore(&rcu_lock, flags);
+    
+    // Quem chama não está numa seção de leitura: já é um estado quiescente
+    rcu_note_context_switch();
+    while(!rcu_seq_ge(rcu_gp_done, target)) {
+        scheduler_schedule();
+        rcu_note_context_switch();
+    }
+    
+    rcu_process_callbacks();
+}
+
+void rcu_get_stats(rcu_stats_t *stats) {
+    uintptr_t flags = rcu_lock_acquire();
+    *stats = rcu_stats;
+    spin_unlock_irqrestore(&rcu_lock, flags);
+}
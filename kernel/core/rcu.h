@@ -0,0 +1,49 @@
+#ifndef RCU_H
+#define RCU_H
+
+#include <stdint.h>
+#include "spinlock.h"
+
+// RCU: leitores não escrevem nada compartilhado (só o preempt_count da
+// própria CPU); escritores publicam a versão nova com rcu_assign_pointer e
+// liberam a antiga depois de um período de graça, quando toda CPU passou
+// por uma troca de contexto (estado quiescente) e nenhum leitor antigo
+// pode mais estar segurando o ponteiro
+
+typedef struct rcu_head {
+    struct rcu_head *next;
+    void (*fn)(struct rcu_head *head);
+    uint32_t gp;                // Período de graça que precisa terminar
+} rcu_head_t;
+
+typedef struct rcu_stats {
+    uint64_t grace_periods;     // Períodos de graça concluídos
+    uint64_t callbacks;         // Callbacks executados
+    uint32_t pending;           // Callbacks esperando
+} rcu_stats_t;
+
+// Seção de leitura: não pode dormir (a troca de contexto é o estado
+// quiescente)
+static inline void rcu_read_lock(void) {
+    preempt_disable();
+}
+
+static inline void rcu_read_unlock(void) {
+    preempt_enable();
+}
+
+#define rcu_dereference(p) __atomic_load_n(&(p), __ATOMIC_ACQUIRE)
+#define rcu_assign_pointer(p, v) __atomic_store_n(&(p), (v), __ATOMIC_RELEASE)
+
+// Chamado pelo escalonador a cada troca de contexto
+void rcu_note_context_switch(void);
+
+// Agenda fn(head) para depois do período de graça atual
+void call_rcu(rcu_head_t *head, void (*fn)(rcu_head_t *head));
+
+// Espera um período de graça completo (dorme; não usar com locks)
+void synchronize_rcu(void);
+
+void rcu_get_stats(rcu_stats_t *stats);
+
+#endif
@@ -0,0 +1,216 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "spinlock.h"
+#include "console.h"
+#include "tsc.h"
+
+cpu_t cpus[MAX_CPUS];
+uint32_t cpu_count = 1;
+
+// Locks inicializados, na ordem de inicialização
+static lock_stats_t *lock_registry = NULL;
+
+static void lock_stats_init(lock_stats_t *stats, const char *name) {
+    lock_stats_t *next = stats->next;
+    int registered = stats->registered;
+    
+    memset(stats, 0, sizeof(*stats));
+    stats->name = name;
+    
+    // Sem nome: lock de um objeto alocado (ex.: tabela de descritores),
+    // que pode ser liberado; fica fora do registro
+    if(!name) {
+        return;
+    }
+    
+    // Reinicializar um lock não o registra de novo
+    if(registered) {
+        stats->next = next;
+        stats->registered = 1;
+        return;
+    }
+    stats->next = lock_registry;
+    stats->registered = 1;
+    lock_registry = stats;
+}
+
+// Marca o início da posse; roda já com o lock
+static inline void lock_stats_acquired(lock_stats_t *stats, uint64_t wait_start) {
+    uint64_t now = rdtsc();
+    stats->acquisitions++;
+    if(wait_start) {
+        stats->contended++;
+        stats->wait_cycles += now - wait_start;
+    }
+    stats->acquired_at = now;
+}
+
+// Contabiliza a posse; roda ainda com o lock
+static inline void lock_stats_released(lock_stats_t *stats) {
+    uint64_t held = rdtsc() - stats->acquired_at;
+    stats->hold_cycles += held;
+    if(held > stats->max_hold_cycles) {
+        stats->max_hold_cycles = held;
+    }
+}
+
+void spin_lock_init(spinlock_t *lock, const char *name) {
+    lock->owner = 0;
+    lock->next = 0;
+    lock_stats_init(&lock->stats, name);
+}
+
+void spin_lock(spinlock_t *lock) {
+    preempt_disable();
+    
+    uint16_t ticket = __atomic_fetch_add(&lock->next, 1, __ATOMIC_ACQUIRE);
+    uint64_t wait_start = 0;
+    if(__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+        wait_start = rdtsc();
+        while(__atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE) != ticket) {
+            cpu_relax();
+        }
+    }
+    
+    lock_stats_acquired(&lock->stats, wait_start);
+}
+
+// Pega o lock só se ninguém tiver bilhete: next == owner
+int spin_trylock(spinlock_t *lock) {
+    preempt_disable();
+    
+    uint16_t owner = __atomic_load_n(&lock->owner, __ATOMIC_ACQUIRE);
+    uint16_t expected = owner;
+    if(!__atomic_compare_exchange_n(&lock->next, &expected, (uint16_t)(owner + 1), 0,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        preempt_enable();
+        return 0;
+    }
+    
+    lock_stats_acquired(&lock->stats, 0);
+    return 1;
+}
+
+void spin_unlock(spinlock_t *lock) {
+    lock_stats_released(&lock->stats);
+    
+    // Só o dono escreve owner: a soma não precisa ser atômica
+    __atomic_store_n(&lock->owner, (uint16_t)(lock->owner + 1), __ATOMIC_RELEASE);
+    preempt_enable();
+}
+
+uintptr_t spin_lock_irqsave(spinlock_t *lock) {
+    uintptr_t flags = irq_save();
+    spin_lock(lock);
+    return flags;
+}
+
+void spin_unlock_irqrestore(spinlock_t *lock, uintptr_t flags) {
+    spin_unlock(lock);
+    irq_restore(flags);
+}
+
+void rwlock_init(rwlock_t *lock, const char *name) {
+    lock->value = 0;
+    lock_stats_init(&lock->stats, name);
+}
+
+void read_lock(rwlock_t *lock) {
+    preempt_disable();
+    
+    uint64_t wait_start = 0;
+    uint32_t value = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+    for(;;) {
+        if(!(value & RWLOCK_WRITER)) {
+            if(__atomic_compare_exchange_n(&lock->value, &value, value + 1, 1,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue; // value foi recarregado pela falha
+        }
+        if(!wait_start) {
+            wait_start = rdtsc();
+        }
+        cpu_relax();
+        value = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+    }
+    
+    // Leitores concorrentes: contadores atualizados atomicamente
+    __atomic_fetch_add(&lock->stats.acquisitions, 1, __ATOMIC_RELAXED);
+    if(wait_start) {
+        __atomic_fetch_add(&lock->stats.contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&lock->stats.wait_cycles, rdtsc() - wait_start, __ATOMIC_RELAXED);
+    }
+}
+
+void read_unlock(rwlock_t *lock) {
+    __atomic_fetch_sub(&lock->value, 1, __ATOMIC_RELEASE);
+    preempt_enable();
+}
+
+// Marca o bit de escritor (barrando leitores novos) e espera os atuais saírem
+void write_lock(rwlock_t *lock) {
+    preempt_disable();
+    
+    uint64_t wait_start = 0;
+    uint32_t value = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+    for(;;) {
+        if(!(value & RWLOCK_WRITER)) {
+            if(__atomic_compare_exchange_n(&lock->value, &value, value | RWLOCK_WRITER, 1,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+                break;
+            }
+            continue;
+        }
+        if(!wait_start) {
+            wait_start = rdtsc();
+        }
+        cpu_relax();
+        value = __atomic_load_n(&lock->value, __ATOMIC_RELAXED);
+    }
+    
+    while(__atomic_load_n(&lock->value, __ATOMIC_ACQUIRE) != RWLOCK_WRITER) {
+        if(!wait_start) {
+            wait_start = rdtsc();
+        }
+        cpu_relax();
+    }
+    
+    lock_stats_acquired(&lock->stats, wait_start);
+}
+
+void write_unlock(rwlock_t *lock) {
+    lock_stats_released(&lock->stats);
+    __atomic_store_n(&lock->value, 0, __ATOMIC_RELEASE);
+    preempt_enable();
+}
+
+lock_stats_t *lock_stats_first() {
+    return lock_registry;
+}
+
+// Uma linha por lock usado: aquisições, esperas e ciclos totais/máximo
+// (sem divisão de 64 bits no i386; médias ficam para quem lê). Para
+// depuração; os mesmos números estão em /proc/locks
+void lock_stats_report() {
+    console_write("Locks (ciclos):\n");
+    for(lock_stats_t *stats = lock_registry; stats; stats = stats->next) {
+        if(stats->acquisitions == 0) {
+            continue;
+        }
+        console_write("  ");
+        console_write(stats->name);
+        console_write(": ");
+        console_write_dec(stats->acquisitions);
+        console_write(" aquisicoes, ");
+        console_write_dec(stats->contended);
+        console_write(" com espera (");
+        console_write_dec(stats->wait_cycles);
+        console_write(" esperando), posse ");
+        console_write_dec(stats->hold_cycles);
+        console_write(", maxima ");
+        console_write_dec(stats->max_hold_cycles);
+        console_write("\n");
+    }
+}
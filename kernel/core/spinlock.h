@@ -0,0 +1,104 @@
+#ifndef SPINLOCK_H
+#define SPINLOCK_H
+
+#include <stdint.h>
+#include "percpu.h"
+
+// Estatísticas de um lock, em ciclos do TSC
+typedef struct lock_stats {
+    const char *name;
+    uint64_t acquisitions;
+    uint64_t contended;         // Aquisições que precisaram esperar
+    uint64_t wait_cycles;       // Total esperando o lock
+    uint64_t hold_cycles;       // Total com o lock (só escritores no rwlock)
+    uint64_t max_hold_cycles;
+    uint64_t acquired_at;       // TSC da aquisição atual
+    struct lock_stats *next;    // Registro usado por lock_stats_report()
+    int registered;
+} lock_stats_t;
+
+// Spinlock de bilhetes: cada CPU pega um bilhete em next e espera owner
+// chegar nele, então o lock é entregue em ordem de chegada
+typedef struct spinlock {
+    volatile uint16_t owner;    // Bilhete sendo atendido
+    volatile uint16_t next;     // Próximo bilhete a ser entregue
+    lock_stats_t stats;
+} spinlock_t;
+
+// Lock leitor-escritor: o bit alto marca um escritor dentro ou esperando
+// (novos leitores aguardam, evitando inanição do escritor); o resto
+// conta os leitores ativos
+#define RWLOCK_WRITER 0x80000000u
+
+typedef struct rwlock {
+    volatile uint32_t value;
+    lock_stats_t stats;
+} rwlock_t;
+
+#define barrier() asm volatile("" : : : "memory")
+
+static inline void cpu_relax(void) {
+    asm volatile("pause" : : : "memory");
+}
+
+// Preempção desligada enquanto houver locks ou seções RCU na CPU: o
+// escalonador adia a troca para o próximo tick
+static inline void preempt_disable(void) {
+    this_cpu()->preempt_count++;
+    barrier();
+}
+
+static inline void preempt_enable(void) {
+    barrier();
+    this_cpu()->preempt_count--;
+}
+
+static inline int preemptible(void) {
+    return this_cpu()->preempt_count == 0;
+}
+
+// Desabilita interrupções preservando o estado anterior (IF em EFLAGS);
+// no build hospedado não há interrupções de verdade
+#ifdef KERNEL_HOSTED
+static inline uintptr_t irq_save(void) {
+    return 0;
+}
+
+static inline void irq_restore(uintptr_t flags) {
+    (void)flags;
+}
+#else
+static inline uintptr_t irq_save(void) {
+    uintptr_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uintptr_t flags) {
+    if(flags & 0x200) {
+        asm volatile("sti" : : : "memory");
+    }
+}
+#endif
+
+// name aparece em lock_stats_report(); NULL = não registrar
+void spin_lock_init(spinlock_t *lock, const char *name);
+void spin_lock(spinlock_t *lock);
+int spin_trylock(spinlock_t *lock);
+void spin_unlock(spinlock_t *lock);
+
+// Variantes para dados também tocados por handlers de interrupção
+uintptr_t spin_lock_irqsave(spinlock_t *lock);
+void spin_unlock_irqrestore(spinlock_t *lock, uintptr_t flags);
+
+void rwlock_init(rwlock_t *lock, const char *name);
+void read_lock(rwlock_t *lock);
+void read_unlock(rwlock_t *lock);
+void write_lock(rwlock_t *lock);
+void write_unlock(rwlock_t *lock);
+
+// Tempo de posse e contenção de todos os locks inicializados
+void lock_stats_report(void);
+lock_stats_t *lock_stats_first(void);
+
+#endif
@@ -0,0 +1,153 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "trace.h"
+#include "spinlock.h"
+#include "scheduler.h"
+#include "vfs.h"
+#include "tsc.h"
+#ifndef KERNEL_HOSTED
+#include "serial.h"
+#endif
+
+// Anel de uma CPU; só a própria CPU escreve nele
+typedef struct trace_buffer {
+    trace_record_t *records;
+    uint32_t head;      // Próxima posição a escrever
+    uint32_t count;     // Registros válidos (até TRACE_BUFFER_RECORDS)
+    uint32_t lost;      // Sobrescritos desde o último reset
+} trace_buffer_t;
+
+volatile uint32_t trace_mask = 0;
+
+static trace_buffer_t buffers[MAX_CPUS];
+
+// Aloca os anéis; os eventos continuam desligados até trace_start()
+void trace_init() {
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        if(!buffers[i].records) {
+            buffers[i].records = malloc(TRACE_BUFFER_RECORDS * sizeof(trace_record_t));
+        }
+        buffers[i].head = buffers[i].count = buffers[i].lost = 0;
+    }
+}
+
+// Caminho lento do TRACE(): só roda com o evento ligado. Interrupções
+// desligadas porque os tracepoints de IRQ podem interromper um registro
+void trace_record(uint32_t event, uint32_t arg0, uint32_t arg1) {
+    uintptr_t flags = irq_save();
+    trace_buffer_t *buffer = &buffers[cpu_id()];
+    if(!buffer->records) {
+        irq_restore(flags);
+        return;
+    }
+    
+    trace_record_t *record = &buffer->records[buffer->head];
+    record->tsc = rdtsc();
+    record->event = event;
+    record->cpu = cpu_id();
+    record->task = scheduler_current();
+    record->arg0 = arg0;
+    record->arg1 = arg1;
+    
+    buffer->head = (buffer->head + 1) & (TRACE_BUFFER_RECORDS - 1);
+    if(buffer->count < TRACE_BUFFER_RECORDS) {
+        buffer->count++;
+    } else {
+        buffer->lost++;
+    }
+    irq_restore(flags);
+}
+
+void trace_start(uint32_t mask) {
+    trace_mask = mask & TRACE_ALL;
+}
+
+void trace_stop() {
+    trace_mask = 0;
+}
+
+// Descarta o que foi gravado (o conjunto de eventos ligados não muda)
+void trace_reset() {
+    uintptr_t flags = irq_save();
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        buffers[i].head = buffers[i].count = buffers[i].lost = 0;
+    }
+    irq_restore(flags);
+}
+
+// Gera o dump com os eventos pausados, para que os anéis não mudem no
+// meio (o próprio dump passaria pelos tracepoints do VFS)
+void trace_dump(trace_write_fn_t write, void *ctx) {
+    uint32_t mask = trace_mask;
+    trace_mask = 0;
+    
+    trace_header_t header;
+    header.magic = TRACE_MAGIC;
+    header.version = TRACE_VERSION;
+    header.record_size = sizeof(trace_record_t);
+    header.cpu_count = cpu_count;
+    header.event_count = TRACE_EVENT_COUNT;
+    write(&header, sizeof(header), ctx);
+    
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        trace_buffer_t *buffer = &buffers[i];
+        trace_cpu_header_t cpu;
+        cpu.cpu = i;
+        cpu.count = buffer->records ? buffer->count : 0;
+        cpu.lost = buffer->lost;
+        cpu.reserved = 0;
+        write(&cpu, sizeof(cpu), ctx);
+        
+        // Do mais antigo ao mais novo: no máximo dois trechos do anel
+        uint32_t first = (buffer->head - cpu.count) & (TRACE_BUFFER_RECORDS - 1);
+        uint32_t part = TRACE_BUFFER_RECORDS - first;
+        if(part > cpu.count) {
+            part = cpu.count;
+        }
+        if(part) {
+            write(&buffer->records[first], part * sizeof(trace_record_t), ctx);
+        }
+        if(cpu.count > part) {
+            write(buffer->records, (cpu.count - part) * sizeof(trace_record_t), ctx);
+        }
+    }
+    
+    trace_mask = mask;
+}
+
+static void trace_write_file(const void *data, size_t len, void *ctx) {
+    int *fd = ctx;
+    if(*fd >= 0 && vfs_write(*fd, data, len) != (int)len) {
+        vfs_close(*fd);
+        *fd = -1;
+    }
+}
+
+int trace_dump_file(const char *path) {
+    int fd = vfs_open(path, O_CREAT | O_WRONLY | O_TRUNC);
+    if(fd < 0) {
+        return -1;
+    }
+    
+    trace_dump(trace_write_file, &fd);
+    if(fd < 0) {
+        return -1; // Falha na escrita (o descritor já foi fechado)
+    }
+    vfs_close(fd);
+    return 0;
+}
+
+#ifndef KERNEL_HOSTED
+static void trace_write_serial(const void *data, size_t len, void *ctx) {
+    (void)ctx;
+    serial_write_hex_lines("TRACE ", data, len);
+}
+
+void trace_dump_serial() {
+    serial_init();
+    serial_write("TRACE-BEGIN\n");
+    trace_dump(trace_write_serial, NULL);
+    serial_write("TRACE-END\n");
+}
+#endif
@@ -0,0 +1,92 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Tracepoints estáticos: cada ponto instrumentado testa um bit de
+// trace_mask (uma leitura e um desvio quando desligado) e, ligado, grava
+// um registro binário de tamanho fixo no anel da CPU atual. O formato do
+// dump é lido por tools/tracedec.c, que monta a linha do tempo
+
+// Eventos; arg0/arg1 de cada um entre parênteses
+#define TRACE_SCHED_SWITCH   0  // (slot anterior, slot novo)
+#define TRACE_PROCESS_CREATE 1  // (slot, pid)
+#define TRACE_IRQ_ENTER      2  // (irq, 0)
+#define TRACE_IRQ_EXIT       3  // (irq, 0)
+#define TRACE_PMM_ALLOC      4  // (primeira página, quantidade)
+#define TRACE_PMM_FREE       5  // (primeira página, quantidade)
+#define TRACE_VFS_OPEN       6  // (fd ou erro, inode)
+#define TRACE_VFS_READ       7  // (inode, tamanho pedido)
+#define TRACE_VFS_READ_END   8  // (inode, bytes lidos ou erro)
+#define TRACE_VFS_WRITE      9  // (inode, tamanho pedido)
+#define TRACE_VFS_WRITE_END  10 // (inode, bytes escritos ou erro)
+#define TRACE_EVENT_COUNT    11
+
+#define TRACE_ALL ((1u << TRACE_EVENT_COUNT) - 1)
+
+// Registros por CPU (potência de 2); quando o anel enche, os mais antigos
+// são sobrescritos e contados em lost
+#define TRACE_BUFFER_RECORDS 8192
+
+typedef struct trace_record {
+    uint64_t tsc;
+    uint16_t event;
+    uint16_t cpu;
+    uint32_t task;      // Slot do processo em execução
+    uint32_t arg0;
+    uint32_t arg1;
+} trace_record_t;
+
+_Static_assert(sizeof(trace_record_t) == 24, "formato do dump mudou");
+
+// Dump: cabeçalho, e para cada CPU um trace_cpu_header_t seguido de count
+// registros do mais antigo ao mais novo
+#define TRACE_MAGIC   0x4352544Bu   // "KTRC"
+#define TRACE_VERSION 1
+
+typedef struct trace_header {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t cpu_count;
+    uint32_t event_count;
+} trace_header_t;
+
+typedef struct trace_cpu_header {
+    uint32_t cpu;
+    uint32_t count;
+    uint32_t lost;
+    uint32_t reserved;
+} trace_cpu_header_t;
+
+#ifndef TRACE_DECODER
+
+// Eventos ligados (bit 1 << evento)
+extern volatile uint32_t trace_mask;
+
+void trace_record(uint32_t event, uint32_t arg0, uint32_t arg1);
+
+#define TRACE(event, arg0, arg1) do { \
+    if(__builtin_expect(trace_mask & (1u << (event)), 0)) { \
+        trace_record((event), (uint32_t)(arg0), (uint32_t)(arg1)); \
+    } \
+} while(0)
+
+void trace_init(void);
+void trace_start(uint32_t mask);
+void trace_stop(void);
+void trace_reset(void);
+
+// Serializa os anéis; write recebe o dump em pedaços
+typedef void (*trace_write_fn_t)(const void *data, size_t len, void *ctx);
+void trace_dump(trace_write_fn_t write, void *ctx);
+
+// Dump em um arquivo do VFS ou na serial (linhas "TRACE <hex>" entre
+// TRACE-BEGIN e TRACE-END)
+int trace_dump_file(const char *path);
+void trace_dump_serial(void);
+
+#endif
+
+#endif
@@ -0,0 +1,480 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "io.h"
+#include "ata.h"
+#include "block.h"
+#include "pci.h"
+#include "pmm.h"
+#include "console.h"
+#include "irqstat.h"
+
+// Registradores do canal (offset a partir da base de E/S)
+#define ATA_REG_DATA     0
+#define ATA_REG_ERROR    1
+#define ATA_REG_SECCOUNT 2
+#define ATA_REG_LBA0     3
+#define ATA_REG_LBA1     4
+#define ATA_REG_LBA2     5
+#define ATA_REG_DRIVE    6
+#define ATA_REG_STATUS   7
+#define ATA_REG_COMMAND  7
+
+// Registrador de controle (porta ctrl)
+#define ATA_CTRL_NIEN 0x02      // Desabilita a IRQ do dispositivo
+
+// Status
+#define ATA_SR_ERR  0x01
+#define ATA_SR_DRQ  0x08
+#define ATA_SR_DF   0x20
+#define ATA_SR_DRDY 0x40
+#define ATA_SR_BSY  0x80
+
+// Comandos
+#define ATA_CMD_READ_PIO      0x20
+#define ATA_CMD_READ_PIO_EXT  0x24
+#define ATA_CMD_WRITE_PIO     0x30
+#define ATA_CMD_WRITE_PIO_EXT 0x34
+#define ATA_CMD_READ_DMA      0xC8
+#define ATA_CMD_READ_DMA_EXT  0x25
+#define ATA_CMD_WRITE_DMA     0xCA
+#define ATA_CMD_WRITE_DMA_EXT 0x35
+#define ATA_CMD_FLUSH         0xE7
+#define ATA_CMD_FLUSH_EXT     0xEA
+#define ATA_CMD_IDENTIFY      0xEC
+
+// Bus master IDE (PIIX): registradores por canal
+#define BM_COMMAND 0
+#define BM_STATUS  2
+#define BM_PRDT    4
+#define BM_CMD_START 0x01
+#define BM_CMD_READ  0x08       // Dispositivo -> memória
+#define BM_SR_ACTIVE 0x01
+#define BM_SR_ERROR  0x02
+#define BM_SR_IRQ    0x04
+
+#define ATA_PRD_EOT     0x8000
+#define ATA_PRD_ENTRIES (4096 / sizeof(ata_prd_t))
+#define ATA_DMA_LIMIT   0x100000000ULL  // PRDs e BM_PRDT só têm 32 bits
+#define ATA_LBA28_MAX   0x0FFFFFFF
+
+// Entrada da tabela PRD (Physical Region Descriptor)
+typedef struct ata_prd {
+    uint32_t address;
+    uint16_t bytes;             // 0 = 64KB
+    uint16_t flags;
+} __attribute__((packed)) ata_prd_t;
+
+struct ata_channel;
+
+typedef struct ata_drive {
+    block_device_t dev;
+    struct ata_channel *channel;
+    uint8_t slave;
+    uint8_t lba48;
+    uint8_t use_dma;
+    uint8_t present;
+} ata_drive_t;
+
+typedef struct ata_channel {
+    uint16_t io;
+    uint16_t ctrl;
+    uint16_t bmide;             // 0 = sem bus master
+    uint8_t irq;
+    ata_prd_t *prdt;            // Uma página, alinhada e sem cruzar 64KB
+    ata_drive_t *active_drive;
+    block_request_t *active;
+    // Requisições esperando o canal (uma por drive)
+    ata_drive_t *waiting_drive[2];
+    block_request_t *waiting[2];
+} ata_channel_t;
+
+static ata_channel_t channels[2] = {
+    { .io = 0x1F0, .ctrl = 0x3F6, .irq = 14 },
+    { .io = 0x170, .ctrl = 0x376, .irq = 15 },
+};
+static ata_drive_t drives[4];
+
+static const char *drive_names[4] = { "hda", "hdb", "hdc", "hdd" };
+
+// Espera ~400ns lendo o status alternativo
+static void ata_delay(ata_channel_t *channel) {
+    for(int i = 0; i < 4; i++) {
+        inb(channel->ctrl);
+    }
+}
+
+// Espera BSY baixar; retorna o status final (ou 0xFF em timeout)
+static uint8_t ata_wait_idle(ata_channel_t *channel) {
+    for(uint32_t i = 0; i < 1000000; i++) {
+        uint8_t status = inb(channel->io + ATA_REG_STATUS);
+        if(!(status & ATA_SR_BSY)) {
+            return status;
+        }
+    }
+    return 0xFF;
+}
+
+// Espera DRQ (dados prontos); -1 em erro
+static int ata_wait_drq(ata_channel_t *channel) {
+    uint8_t status = ata_wait_idle(channel);
+    if(status == 0xFF || (status & (ATA_SR_ERR | ATA_SR_DF)) || !(status & ATA_SR_DRQ)) {
+        return -1;
+    }
+    return 0;
+}
+
+// Seleciona o drive e programa LBA e contagem de setores
+static void ata_setup(ata_drive_t *drive, uint64_t sector, uint32_t count, int lba48) {
+    ata_channel_t *channel = drive->channel;
+    uint16_t io = channel->io;
+    
+    if(lba48) {
+        outb(io + ATA_REG_DRIVE, 0x40 | (drive->slave << 4));
+        ata_delay(channel);
+        outb(io + ATA_REG_SECCOUNT, (count >> 8) & 0xFF);
+        outb(io + ATA_REG_LBA0, (sector >> 24) & 0xFF);
+        outb(io + ATA_REG_LBA1, (sector >> 32) & 0xFF);
+        outb(io + ATA_REG_LBA2, (sector >> 40) & 0xFF);
+    } else {
+        outb(io + ATA_REG_DRIVE, 0xE0 | (drive->slave << 4) | ((sector >> 24) & 0x0F));
+        ata_delay(channel);
+    }
+    
+    outb(io + ATA_REG_SECCOUNT, count & 0xFF);
+    outb(io + ATA_REG_LBA0, sector & 0xFF);
+    outb(io + ATA_REG_LBA1, (sector >> 8) & 0xFF);
+    outb(io + ATA_REG_LBA2, (sector >> 16) & 0xFF);
+}
+
+static int ata_needs_lba48(block_request_t *request) {
+    return request->sector + request->count > ATA_LBA28_MAX || request->count > 256;
+}
+
+// Transferência PIO com polling (sem IRQ); completa antes de retornar
+static int ata_pio_transfer(ata_drive_t *drive, block_request_t *request) {
+    ata_channel_t *channel = drive->channel;
+    uint16_t io = channel->io;
+    int lba48 = ata_needs_lba48(request);
+    if(lba48 && !drive->lba48) {
+        return -1;
+    }
+    
+    outb(channel->ctrl, ATA_CTRL_NIEN);
+    if(ata_wait_idle(channel) == 0xFF) {
+        return -1;
+    }
+    ata_setup(drive, request->sector, request->count, lba48);
+    
+    int write = request->op == BLOCK_WRITE;
+    uint8_t command = write ? (lba48 ? ATA_CMD_WRITE_PIO_EXT : ATA_CMD_WRITE_PIO)
+                            : (lba48 ? ATA_CMD_READ_PIO_EXT : ATA_CMD_READ_PIO);
+    outb(io + ATA_REG_COMMAND, command);
+    
+    for(bio_t *bio = request->bio_head; bio; bio = bio->next) {
+        uint16_t *buffer = bio->buffer;
+        for(uint32_t i = 0; i < bio->count; i++) {
+            ata_delay(channel);
+            if(ata_wait_drq(channel) != 0) {
+                return -1;
+            }
+            
+            if(write) {
+                asm volatile("rep outsw" : "+S"(buffer) : "c"(256), "d"(io + ATA_REG_DATA) : "memory");
+            } else {
+                asm volatile("rep insw" : "+D"(buffer) : "c"(256), "d"(io + ATA_REG_DATA) : "memory");
+            }
+        }
+    }
+    
+    if(write) {
+        outb(io + ATA_REG_COMMAND, lba48 ? ATA_CMD_FLUSH_EXT : ATA_CMD_FLUSH);
+    }
+    
+    uint8_t status = ata_wait_idle(channel);
+    return (status == 0xFF || (status & (ATA_SR_ERR | ATA_SR_DF))) ? -1 : 0;
+}
+
+// Monta a tabela PRD dos bios da requisição; -1 se não couber ou se um
+// buffer estiver acima de 4GB (a requisição vai por PIO)
+static int ata_build_prdt(ata_channel_t *channel, block_request_t *request) {
+    uint32_t entry = 0;
+    
+    for(bio_t *bio = request->bio_head; bio; bio = bio->next) {
+        uint32_t remaining = bio->count * BLOCK_SECTOR_SIZE;
+        if((uint64_t)(uintptr_t)bio->buffer + remaining > ATA_DMA_LIMIT) {
+            return -1;
+        }
+        uint32_t address = (uint32_t)(uintptr_t)bio->buffer;
+        
+        if(address & 1) {
+            return -1; // PRD exige alinhamento de 2 bytes
+        }
+        
+        // Cada entrada não pode cruzar um limite de 64KB
+        while(remaining > 0) {
+            if(entry >= ATA_PRD_ENTRIES) {
+                return -1;
+            }
+            
+            uint32_t chunk = 0x10000 - (address & 0xFFFF);
+            if(chunk > remaining) {
+                chunk = remaining;
+            }
+            
+            channel->prdt[entry].address = address;
+            channel->prdt[entry].bytes = chunk & 0xFFFF;
+            channel->prdt[entry].flags = 0;
+            entry++;
+            
+            address += chunk;
+            remaining -= chunk;
+        }
+    }
+    
+    channel->prdt[entry - 1].flags = ATA_PRD_EOT;
+    return 0;
+}
+
+// Inicia uma transferência DMA; a conclusão chega pela IRQ
+static int ata_dma_start(ata_drive_t *drive, block_request_t *request) {
+    ata_channel_t *channel = drive->channel;
+    uint16_t bm = channel->bmide;
+    int lba48 = ata_needs_lba48(request);
+    if((lba48 && !drive->lba48) || ata_build_prdt(channel, request) != 0) {
+        return -1;
+    }
+    
+    int write = request->op == BLOCK_WRITE;
+    
+    outb(bm + BM_COMMAND, 0);
+    outl(bm + BM_PRDT, (uint32_t)(uintptr_t)channel->prdt);
+    outb(bm + BM_STATUS, inb(bm + BM_STATUS) | BM_SR_IRQ | BM_SR_ERROR);
+    outb(bm + BM_COMMAND, write ? 0 : BM_CMD_READ);
+    
+    outb(channel->ctrl, 0);
+    if(ata_wait_idle(channel) == 0xFF) {
+        return -1;
+    }
+    ata_setup(drive, request->sector, request->count, lba48);
+    
+    uint8_t command = write ? (lba48 ? ATA_CMD_WRITE_DMA_EXT : ATA_CMD_WRITE_DMA)
+                            : (lba48 ? ATA_CMD_READ_DMA_EXT : ATA_CMD_READ_DMA);
+    outb(channel->io + ATA_REG_COMMAND, command);
+    outb(bm + BM_COMMAND, (write ? 0 : BM_CMD_READ) | BM_CMD_START);
+    return 0;
+}
+
+// Executa uma requisição no canal (que deve estar livre)
+static void ata_issue(ata_drive_t *drive, block_request_t *request) {
+    ata_channel_t *channel = drive->channel;
+    
+    if(drive->use_dma) {
+        channel->active_drive = drive;
+        channel->active = request;
+        if(ata_dma_start(drive, request) == 0) {
+            return;
+        }
+        channel->active_drive = NULL;
+        channel->active = NULL;
+    }
+    
+    // Fallback: PIO síncrono
+    int status = ata_pio_transfer(drive, request);
+    block_complete(&drive->dev, request, status);
+}
+
+// Inicia a próxima requisição à espera do canal, se houver
+static void ata_start_waiting(ata_channel_t *channel) {
+    for(int i = 0; i < 2 && !channel->active; i++) {
+        if(channel->waiting[i]) {
+            ata_drive_t *drive = channel->waiting_drive[i];
+            block_request_t *request = channel->waiting[i];
+            channel->waiting[i] = NULL;
+            channel->waiting_drive[i] = NULL;
+            ata_issue(drive, request);
+        }
+    }
+}
+
+// Operação start da camada de bloco
+static int ata_start(block_device_t *dev, block_request_t *request) {
+    ata_drive_t *drive = dev->private;
+    ata_channel_t *channel = drive->channel;
+    
+    // Os dois drives do canal compartilham os registradores
+    if(channel->active) {
+        channel->waiting[drive->slave] = request;
+        channel->waiting_drive[drive->slave] = drive;
+        return 0;
+    }
+    
+    ata_issue(drive, request);
+    return 0;
+}
+
+// Conclusão de DMA
+static void ata_channel_irq(ata_channel_t *channel) {
+    uint16_t bm = channel->bmide;
+    if(!bm || !channel->active) {
+        inb(channel->io + ATA_REG_STATUS); // Reconhecer a IRQ
+        return;
+    }
+    
+    uint8_t bm_status = inb(bm + BM_STATUS);
+    if(!(bm_status & BM_SR_IRQ)) {
+        return; // Não é nossa
+    }
+    
+    outb(bm + BM_COMMAND, 0);
+    uint8_t status = inb(channel->io + ATA_REG_STATUS);
+    outb(bm + BM_STATUS, BM_SR_IRQ | BM_SR_ERROR);
+    
+    ata_drive_t *drive = channel->active_drive;
+    block_request_t *request = channel->active;
+    channel->active = NULL;
+    channel->active_drive = NULL;
+    
+    if((bm_status & BM_SR_ERROR) || (status & (ATA_SR_ERR | ATA_SR_DF))) {
+        // DMA falhou: refazer em PIO e não usar mais DMA neste drive
+        drive->use_dma = 0;
+        block_complete(&drive->dev, request, ata_pio_transfer(drive, request));
+    } else {
+        block_complete(&drive->dev, request, 0);
+    }
+    
+    ata_start_waiting(channel);
+}
+
+static void ata_primary_irq(registers_t *regs) {
+    (void)regs;
+    irq_enter(channels[0].irq);
+    ata_channel_irq(&channels[0]);
+    irq_exit(channels[0].irq);
+}
+
+static void ata_secondary_irq(registers_t *regs) {
+    (void)regs;
+    irq_enter(channels[1].irq);
+    ata_channel_irq(&channels[1]);
+    irq_exit(channels[1].irq);
+}
+
+static const block_ops_t ata_block_ops = {
+    .start = ata_start
+};
+
+// IDENTIFY DEVICE; retorna 0 se um disco ATA responder
+static int ata_identify(ata_drive_t *drive, uint16_t *info) {
+    ata_channel_t *channel = drive->channel;
+    uint16_t io = channel->io;
+    
+    outb(channel->ctrl, ATA_CTRL_NIEN);
+    outb(io + ATA_REG_DRIVE, 0xA0 | (drive->slave << 4));
+    ata_delay(channel);
+    outb(io + ATA_REG_SECCOUNT, 0);
+    outb(io + ATA_REG_LBA0, 0);
+    outb(io + ATA_REG_LBA1, 0);
+    outb(io + ATA_REG_LBA2, 0);
+    outb(io + ATA_REG_COMMAND, ATA_CMD_IDENTIFY);
+    
+    if(inb(io + ATA_REG_STATUS) == 0) {
+        return -1; // Nenhum dispositivo
+    }
+    if(ata_wait_idle(channel) == 0xFF) {
+        return -1;
+    }
+    
+    // ATAPI/SATA sinalizam pela assinatura em LBA1/LBA2
+    if(inb(io + ATA_REG_LBA1) || inb(io + ATA_REG_LBA2)) {
+        return -1;
+    }
+    if(ata_wait_drq(channel) != 0) {
+        return -1;
+    }
+    
+    asm volatile("rep insw" : "+D"(info) : "c"(256), "d"(io + ATA_REG_DATA) : "memory");
+    return 0;
+}
+
+// Procura o controlador PIIX para obter a base do bus master
+static void ata_probe_busmaster() {
+    pci_device_t *ide = pci_find_class(0x01, 0x01);
+    if(!ide) {
+        return;
+    }
+    
+    uint32_t bar4 = ide->bar[4];
+    if(!(bar4 & 1)) {
+        return; // Esperamos BAR de E/S
+    }
+    
+    pci_enable(ide, PCI_COMMAND_IO | PCI_COMMAND_MASTER);
+    
+    uint16_t base = bar4 & 0xFFFC;
+    channels[0].bmide = base;
+    channels[1].bmide = base + 8;
+}
+
+// Detecta discos nos dois canais e os registra como dispositivos de bloco
+void ata_init() {
+    uint16_t info[256];
+    
+    ata_probe_busmaster();
+    
+    for(int c = 0; c < 2; c++) {
+        ata_channel_t *channel = &channels[c];
+        channel->active = NULL;
+        channel->active_drive = NULL;
+        
+        if(channel->bmide) {
+            channel->prdt = pmm_alloc_page();
+            if(channel->prdt && (uint64_t)(uintptr_t)channel->prdt + 4096 > ATA_DMA_LIMIT) {
+                pmm_free_page(channel->prdt);
+                channel->prdt = NULL;
+            }
+            if(!channel->prdt) {
+                channel->bmide = 0;
+            }
+        }
+        
+        for(int d = 0; d < 2; d++) {
+            ata_drive_t *drive = &drives[c * 2 + d];
+            drive->channel = channel;
+            drive->slave = d;
+            drive->present = 0;
+            
+            if(ata_identify(drive, info) != 0) {
+                continue;
+            }
+            
+            drive->present = 1;
+            drive->lba48 = (info[83] >> 10) & 1;
+            drive->use_dma = channel->bmide != 0 && ((info[49] >> 8) & 1);
+            
+            block_device_t *dev = &drive->dev;
+            strcpy(dev->name, drive_names[c * 2 + d]);
+            if(drive->lba48) {
+                dev->sector_count = (uint64_t)info[100] | ((uint64_t)info[101] << 16) |
+                                    ((uint64_t)info[102] << 32) | ((uint64_t)info[103] << 48);
+            } else {
+                dev->sector_count = (uint32_t)info[60] | ((uint32_t)info[61] << 16);
+            }
+            dev->max_sectors = BLOCK_MAX_SECTORS;
+            dev->ops = &ata_block_ops;
+            dev->private = drive;
+            block_register(dev);
+            
+            console_write("ata: ");
+            console_write(dev->name);
+            console_write(" ");
+            console_write_dec(dev->sector_count >> 11);
+            console_write(drive->use_dma ? " MB, DMA\n" : " MB, PIO\n");
+        }
+        
+        // Interrupções só importam para DMA; PIO faz polling
+        outb(channel->ctrl, 0);
+        register_interrupt_handler(IRQ(channel->irq), c == 0 ? ata_primary_irq : ata_secondary_irq);
+        pic_unmask_irq(channel->irq);
+    }
+}
@@ -0,0 +1,7 @@
+#ifndef ATA_H
+#define ATA_H
+
+// Discos ATA/IDE nos canais legados, com DMA via bus master PIIX
+void ata_init(void);
+
+#endif
@@ -0,0 +1,299 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "block.h"
+#include "pmm.h"
+#include "spinlock.h"
+
+#define BLOCK_BATCH 32      // bios em voo por vez em block_read
+#define BLOCK_PAGE_SECTORS (4096 / BLOCK_SECTOR_SIZE)
+
+static block_device_t *devices[BLOCK_MAX_DEVICES];
+static int device_count = 0;
+
+// Registra um dispositivo de bloco
+int block_register(block_device_t *dev) {
+    if(device_count >= BLOCK_MAX_DEVICES) {
+        return -1;
+    }
+    
+    dev->queue = NULL;
+    dev->inflight = 0;
+    dev->head_sector = 0;
+    dev->plugged = 0;
+    dev->dispatching = 0;
+    dev->reads = dev->writes = 0;
+    dev->sectors_read = dev->sectors_written = 0;
+    dev->merges = dev->requests = 0;
+    if(dev->max_sectors == 0 || dev->max_sectors > BLOCK_MAX_SECTORS) {
+        dev->max_sectors = BLOCK_MAX_SECTORS;
+    }
+    if(dev->max_segments == 0 || dev->max_segments > BLOCK_MAX_SEGMENTS) {
+        dev->max_segments = BLOCK_MAX_SEGMENTS;
+    }
+    if(dev->queue_depth == 0) {
+        dev->queue_depth = 1;
+    }
+    
+    devices[device_count++] = dev;
+    return 0;
+}
+
+// Procura um dispositivo pelo nome (ex.: "hda")
+block_device_t *block_get(const char *name) {
+    for(int i = 0; i < device_count; i++) {
+        if(strcmp(devices[i]->name, name) == 0) {
+            return devices[i];
+        }
+    }
+    return NULL;
+}
+
+block_device_t *block_get_index(int index) {
+    return (index >= 0 && index < device_count) ? devices[index] : NULL;
+}
+
+// Tenta juntar o bio a uma requisição adjacente já na fila
+static int block_merge(block_device_t *dev, bio_t *bio) {
+    for(block_request_t *request = dev->queue; request; request = request->next) {
+        if(request->op != bio->op || request->segments >= dev->max_segments ||
+           request->count + bio->count > dev->max_sectors) {
+            continue;
+        }
+        
+        // Fusão no fim: o bio começa onde a requisição termina
+        if(request->sector + request->count == bio->sector) {
+            bio->next = NULL;
+            request->bio_tail->next = bio;
+            request->bio_tail = bio;
+            request->count += bio->count;
+            request->segments++;
+            return 1;
+        }
+        
+        // Fusão no início
+        if(bio->sector + bio->count == request->sector) {
+            bio->next = request->bio_head;
+            request->bio_head = bio;
+            request->sector = bio->sector;
+            request->count += bio->count;
+            request->segments++;
+            return 1;
+        }
+    }
+    
+    return 0;
+}
+
+// Insere uma requisição mantendo a fila ordenada por setor
+static void block_enqueue(block_device_t *dev, block_request_t *request) {
+    block_request_t **link = &dev->queue;
+    while(*link && (*link)->sector < request->sector) {
+        link = &(*link)->next;
+    }
+    request->next = *link;
+    *link = request;
+}
+
+// Retira a próxima requisição na ordem C-LOOK: a primeira à frente da
+// cabeça; ao chegar ao fim, volta para o menor setor
+static block_request_t *block_next_request(block_device_t *dev) {
+    block_request_t **link = &dev->queue;
+    while(*link && (*link)->sector < dev->head_sector) {
+        link = &(*link)->next;
+    }
+    if(!*link) {
+        link = &dev->queue;
+    }
+    
+    block_request_t *request = *link;
+    if(request) {
+        *link = request->next;
+        request->next = NULL;
+    }
+    return request;
+}
+
+// Entrega requisições ao driver enquanto houver espaço na fila dele
+static void block_dispatch(block_device_t *dev) {
+    if(dev->dispatching) {
+        return;
+    }
+    dev->dispatching = 1;
+    
+    int started = 0;
+    while(dev->inflight < dev->queue_depth && !dev->plugged && dev->queue) {
+        block_request_t *request = block_next_request(dev);
+        
+        // Contabilizar antes de entregar: um driver que termina dentro de
+        // start (PIO) já passou a requisição a block_complete, que a libera
+        uint64_t head_sector = dev->head_sector;
+        dev->inflight++;
+        dev->head_sector = request->sector + request->count;
+        dev->requests++;
+        
+        int result = dev->ops->start(dev, request);
+        if(result == BLOCK_BUSY) {
+            dev->inflight--;
+            dev->head_sector = head_sector;
+            dev->requests--;
+            block_enqueue(dev, request);
+            break;
+        }
+        started++;
+        
+        if(result != 0) {
+            block_complete(dev, request, -1);
+        }
+    }
+    
+    if(started && dev->ops->commit) {
+        dev->ops->commit(dev);
+    }
+    
+    dev->dispatching = 0;
+}
+
+// Envia um bio; ele é fundido a uma requisição adjacente quando possível
+void block_submit(block_device_t *dev, bio_t *bio) {
+    bio->done = 0;
+    bio->status = 0;
+    bio->next = NULL;
+    
+    if(bio->count == 0 || bio->sector + bio->count > dev->sector_count ||
+       (bio->op == BLOCK_WRITE && dev->read_only)) {
+        bio->status = -1;
+        bio->done = 1;
+        if(bio->end_io) {
+            bio->end_io(bio);
+        }
+        return;
+    }
+    
+    uintptr_t flags = irq_save();
+    
+    if(block_merge(dev, bio)) {
+        dev->merges++;
+    } else {
+        block_request_t *request = malloc(sizeof(block_request_t));
+        if(!request) {
+            irq_restore(flags);
+            bio->status = -1;
+            bio->done = 1;
+            if(bio->end_io) {
+                bio->end_io(bio);
+            }
+            return;
+        }
+        
+        request->op = bio->op;
+        request->sector = bio->sector;
+        request->count = bio->count;
+        request->segments = 1;
+        request->bio_head = request->bio_tail = bio;
+        block_enqueue(dev, request);
+    }
+    
+    block_dispatch(dev);
+    irq_restore(flags);
+}
+
+// Segura a fila para que bios enviados em sequência possam ser fundidos
+void block_plug(block_device_t *dev) {
+    dev->plugged = 1;
+}
+
+// Libera a fila e começa a despachar
+void block_unplug(block_device_t *dev) {
+    uintptr_t flags = irq_save();
+    dev->plugged = 0;
+    block_dispatch(dev);
+    irq_restore(flags);
+}
+
+// Chamado pelo driver (normalmente na IRQ) quando uma requisição termina
+void block_complete(block_device_t *dev, block_request_t *request, int status) {
+    if(request->op == BLOCK_READ) {
+        dev->reads++;
+        dev->sectors_read += request->count;
+    } else {
+        dev->writes++;
+        dev->sectors_written += request->count;
+    }
+    
+    bio_t *bio = request->bio_head;
+    while(bio) {
+        bio_t *next = bio->next;
+        bio->status = status;
+        bio->done = 1;
+        if(bio->end_io) {
+            bio->end_io(bio);
+        }
+        bio = next;
+    }
+    
+    dev->inflight--;
+    free(request);
+    
+    block_dispatch(dev);
+}
+
+// Espera a conclusão de um bio (dorme até a próxima interrupção)
+void block_wait(bio_t *bio) {
+    while(!bio->done) {
+        // sti;hlt é atômico: a IRQ de conclusão não se perde
+        asm volatile("cli");
+        if(!bio->done) {
+            asm volatile("sti; hlt");
+        } else {
+            asm volatile("sti");
+        }
+    }
+}
+
+// Envia count setores em bios de até max_sectors e espera todos
+static int block_transfer(block_device_t *dev, uint32_t op, uint64_t sector,
+                          uint32_t count, uint8_t *buffer) {
+    bio_t bios[BLOCK_BATCH];
+    int result = 0;
+    
+    while(count > 0) {
+        int batch = 0;
+        
+        block_plug(dev);
+        while(count > 0 && batch < BLOCK_BATCH) {
+            uint32_t chunk = count < dev->max_sectors ? count : dev->max_sectors;
+            bio_t *bio = &bios[batch++];
+            bio->op = op;
+            bio->sector = sector;
+            bio->count = chunk;
+            bio->buffer = buffer;
+            bio->end_io = NULL;
+            block_submit(dev, bio);
+            
+            sector += chunk;
+            buffer += chunk * BLOCK_SECTOR_SIZE;
+            count -= chunk;
+        }
+        block_unplug(dev);
+        
+        for(int i = 0; i < batch; i++) {
+            block_wait(&bios[i]);
+            if(bios[i].status != 0) {
+                result = -1;
+            }
+        }
+    }
+    
+    return result;
+}
+
+// Leitura síncrona
+int block_read(block_device_t *dev, uint64_t sector, uint32_t count, void *buffer) {
+    return block_transfer(dev, BLOCK_READ, sector, count, buffer);
+}
+
+// Escrita síncrona
+int block_write(block_device_t *dev, uint64_t sector, uint32_t count, const void *buffer) {
+    return block_transfer(dev, BLOCK_WRITE, sector, count, (uint8_t*)buffer);
+}
@@ -0,0 +1,93 @@
+#ifndef BLOCK_H
+#define BLOCK_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define BLOCK_SECTOR_SIZE   512
+#define BLOCK_MAX_DEVICES   8
+#define BLOCK_MAX_SECTORS   256     // Maior requisição após fusões (128KB)
+#define BLOCK_MAX_SEGMENTS  32      // Segmentos (bios) por requisição
+
+// Operações
+#define BLOCK_READ  0
+#define BLOCK_WRITE 1
+
+// Retorno de start quando o driver não tem espaço: a requisição volta
+// para a fila e é reenviada na próxima conclusão
+#define BLOCK_BUSY 1
+
+// Pedido de E/S de quem chama: sector..sector+count para/de buffer
+typedef struct bio {
+    uint32_t op;
+    uint64_t sector;
+    uint32_t count;
+    void *buffer;               // Endereço físico (mapeamento identidade)
+    volatile int done;
+    volatile int status;        // 0 = sucesso
+    void (*end_io)(struct bio *bio);    // Opcional; chamada na conclusão
+    void *private;
+    struct bio *next;           // Próximo segmento da mesma requisição
+} bio_t;
+
+// Requisição enviada ao driver: bios contíguos no disco, fundidos
+typedef struct block_request {
+    uint32_t op;
+    uint64_t sector;
+    uint32_t count;
+    uint32_t segments;
+    bio_t *bio_head;
+    bio_t *bio_tail;
+    struct block_request *next; // Fila ordenada por setor
+} block_request_t;
+
+struct block_device;
+
+typedef struct block_ops {
+    // Inicia uma requisição; o driver chama block_complete() ao terminar
+    int (*start)(struct block_device *dev, block_request_t *request);
+    // Opcional: chamada uma vez após um lote de start (ex.: notificar o
+    // dispositivo uma vez por lote em vez de por requisição)
+    void (*commit)(struct block_device *dev);
+} block_ops_t;
+
+typedef struct block_device {
+    char name[16];
+    uint64_t sector_count;
+    uint32_t max_sectors;       // Limite do driver por requisição
+    uint32_t max_segments;      // Limite do driver de bios por requisição
+    uint32_t queue_depth;       // Requisições simultâneas no driver
+    int read_only;              // Escritas falham (mídia protegida)
+    const block_ops_t *ops;
+    void *private;
+
+    // Fila do elevador (C-LOOK)
+    block_request_t *queue;
+    uint32_t inflight;          // Requisições em andamento no driver
+    uint64_t head_sector;       // Posição após a última requisição iniciada
+    int plugged;                // Acumulando requisições para fundir
+    int dispatching;            // Evita recursão quando o driver completa na hora
+
+    // Estatísticas
+    uint64_t reads;
+    uint64_t writes;
+    uint64_t sectors_read;
+    uint64_t sectors_written;
+    uint64_t merges;
+    uint64_t requests;
+} block_device_t;
+
+int block_register(block_device_t *dev);
+block_device_t *block_get(const char *name);
+block_device_t *block_get_index(int index);
+
+void block_submit(block_device_t *dev, bio_t *bio);
+void block_plug(block_device_t *dev);
+void block_unplug(block_device_t *dev);
+void block_complete(block_device_t *dev, block_request_t *request, int status);
+void block_wait(bio_t *bio);
+
+int block_read(block_device_t *dev, uint64_t sector, uint32_t count, void *buffer);
+int block_write(block_device_t *dev, uint64_t sector, uint32_t count, const void *buffer);
+
+#endif
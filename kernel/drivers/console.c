@@ -158,3 +158,35 @@ void console_clear() {
     cursor_y = 0;
     update_cursor();
 }
+
+// Escreve um número em decimal (sem divisão de 64 bits, que exigiria libgcc)
+void console_write_dec(uint64_t value) {
+    static const uint64_t powers[] = {
+        10000000000000000000ULL, 1000000000000000000ULL, 100000000000000000ULL,
+        10000000000000000ULL, 1000000000000000ULL, 100000000000000ULL,
+        10000000000000ULL, 1000000000000ULL, 100000000000ULL, 10000000000ULL,
+        1000000000ULL, 100000000ULL, 10000000ULL, 1000000ULL, 100000ULL,
+        10000ULL, 1000ULL, 100ULL, 10ULL, 1ULL
+    };
+    int started = 0;
+    
+    for(unsigned i = 0; i < sizeof(powers) / sizeof(powers[0]); i++) {
+        char digit = '0';
+        while(value >= powers[i]) {
+            value -= powers[i];
+            digit++;
+        }
+        if(digit != '0' || started || powers[i] == 1) {
+            console_putchar(digit);
+            started = 1;
+        }
+    }
+}
+
+// Escreve um número em hexadecimal
+void console_write_hex(uint32_t value) {
+    console_write("0x");
+    for(int shift = 28; shift >= 0; shift -= 4) {
+        console_putchar("0123456789ABCDEF"[(value >> shift) & 0xF]);
+    }
+}
@@ -0,0 +1,14 @@
+#ifndef CONSOLE_H
+#define CONSOLE_H
+
+#include <stdint.h>
+#include "io.h"
+
+void console_init(void);
+void console_putchar(char c);
+void console_write(const char *str);
+void console_write_dec(uint64_t value);
+void console_write_hex(uint32_t value);
+void console_clear(void);
+
+#endif
@@ -2,6 +2,9 @@
 #include "io.h"
 #include "keyboard.h"
 #include "idt.h"
+#include "scheduler.h"
+#include "tsc.h"
+#include "irqstat.h"
 
 #define KEYBOARD_DATA_PORT 0x60
 #define KEYBOARD_STATUS_PORT 0x64
@@ -9,8 +12,12 @@
 
 #define KEYBOARD_IRQ 1
 
+// Prefixos de scancode estendido
+#define SCANCODE_EXTENDED 0xE0
+#define SCANCODE_PAUSE 0xE1
+
 // Mapeamento de scancode para ASCII (layout US)
-static const char scancode_to_ascii[] = {
+static const char keymap_us[128] = {
     0, 0, '1', '2', '3', '4', '5', '6', '7', '8', '9', '0', '-', '=', '\b',
     '\t', 'q', 'w', 'e', 'r', 't', 'y', 'u', 'i', 'o', 'p', '[', ']', '\n',
     0, 'a', 's', 'd', 'f', 'g', 'h', 'j', 'k', 'l', ';', '\'', '`',
@@ -19,142 +26,233 @@ static const char scancode_to_ascii[] = {
     '-', 0, 0, 0, '+', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
 };
 
-// Buffer circular para armazenar teclas pressionadas
-#define KEYBOARD_BUFFER_SIZE 128
-static char keyboard_buffer[KEYBOARD_BUFFER_SIZE];
-static int buffer_head = 0;
-static int buffer_tail = 0;
+// Mapeamento com Shift pressionado (layout US)
+static const char keymap_us_shift[128] = {
+    0, 0, '!', '@', '#', '$', '%', '^', '&', '*', '(', ')', '_', '+', '\b',
+    '\t', 'Q', 'W', 'E', 'R', 'T', 'Y', 'U', 'I', 'O', 'P', '{', '}', '\n',
+    0, 'A', 'S', 'D', 'F', 'G', 'H', 'J', 'K', 'L', ':', '"', '~',
+    0, '|', 'Z', 'X', 'C', 'V', 'B', 'N', 'M', '<', '>', '?', 0,
+    '*', 0, ' ', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+    '-', 0, 0, 0, '+', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0
+};
+
+// Anel SPSC de eventos: produtor = IRQ, consumidor = leitor
+// Índices crescem livremente e são mascarados (tamanho potência de 2)
+#define KBD_RING_SIZE 256
+#define KBD_RING_MASK (KBD_RING_SIZE - 1)
+static kbd_event_t kbd_ring[KBD_RING_SIZE];
+static volatile uint32_t kbd_head = 0;     // Escrito apenas pela IRQ
+static volatile uint32_t kbd_tail = 0;     // Escrito apenas pelo leitor
+static volatile uint32_t kbd_overflows = 0;
+
+// Processo bloqueado esperando teclas (-1 = nenhum)
+static volatile int32_t kbd_waiter = -1;
 
-// Flags de estado do teclado
-static int shift_pressed = 0;
-static int ctrl_pressed = 0;
-static int alt_pressed = 0;
-static int caps_lock = 0;
+// Estado do decodificador (acessado apenas pelo leitor)
+static uint8_t kbd_modifiers = 0;
+static int kbd_extended = 0;
+static int kbd_pause_skip = 0;
 
-// Adiciona um caractere ao buffer
-static void keyboard_buffer_put(char c) {
-    int next_head = (buffer_head + 1) % KEYBOARD_BUFFER_SIZE;
+// Barreira de compilador; x86 não reordena stores entre si
+#define kbd_barrier() asm volatile("" ::: "memory")
+
+// Handler de interrupção do teclado: lê a porta e publica no anel
+static void keyboard_handler(registers_t *regs) {
+    (void)regs;
+    irq_enter(KEYBOARD_IRQ);
+    uint8_t scancode = inb(KEYBOARD_DATA_PORT);
+    uint32_t head = kbd_head;
+    
+    // Anel cheio: descartar e contabilizar
+    if(head - kbd_tail >= KBD_RING_SIZE) {
+        kbd_overflows++;
+        irq_exit(KEYBOARD_IRQ);
+        return;
+    }
     
-    // Verificar se o buffer está cheio
-    if(next_head != buffer_tail) {
-        keyboard_buffer[buffer_head] = c;
-        buffer_head = next_head;
+    kbd_event_t *event = &kbd_ring[head & KBD_RING_MASK];
+    event->scancode = scancode;
+    event->timestamp = rdtsc();
+    kbd_barrier();
+    kbd_head = head + 1;
+    
+    if(kbd_waiter >= 0) {
+        scheduler_wake((uint32_t)kbd_waiter);
     }
+    irq_exit(KEYBOARD_IRQ);
 }
 
-// Retira um caractere do buffer
-char keyboard_buffer_get() {
-    // Verificar se o buffer está vazio
-    if(buffer_head == buffer_tail) {
+// Atualiza os modificadores a partir de um keycode
+static void keyboard_update_modifiers(uint8_t keycode, int released) {
+    uint8_t mod = 0;
+    
+    switch(keycode) {
+        case 0x2A: case 0x36:       mod = KBD_MOD_SHIFT; break; // Shifts
+        case 0x1D: case KEY_RCTRL:  mod = KBD_MOD_CTRL; break;
+        case 0x38: case KEY_RALT:   mod = KBD_MOD_ALT; break;
+        case 0x3A:                  // Caps Lock alterna ao pressionar
+            if(!released) {
+                kbd_modifiers ^= KBD_MOD_CAPS;
+            }
+            return;
+        default:
+            return;
+    }
+    
+    if(released) {
+        kbd_modifiers &= ~mod;
+    } else {
+        kbd_modifiers |= mod;
+    }
+}
+
+// Decodifica o próximo byte bruto do anel
+// Retorna 1 se produziu um evento completo, 0 se era prefixo
+static int keyboard_decode(kbd_event_t *event) {
+    uint8_t scancode = event->scancode;
+    
+    // Pause envia E1 1D 45 E1 9D C5; ignorar a sequência
+    if(kbd_pause_skip > 0) {
+        kbd_pause_skip--;
+        return 0;
+    }
+    if(scancode == SCANCODE_PAUSE) {
+        kbd_pause_skip = 2;
+        return 0;
+    }
+    if(scancode == SCANCODE_EXTENDED) {
+        kbd_extended = 1;
         return 0;
     }
     
-    char c = keyboard_buffer[buffer_tail];
-    buffer_tail = (buffer_tail + 1) % KEYBOARD_BUFFER_SIZE;
-    return c;
+    event->flags = 0;
+    event->keycode = scancode & 0x7F;
+    if(scancode & 0x80) {
+        event->flags |= KBD_EVENT_RELEASE;
+    }
+    if(kbd_extended) {
+        event->flags |= KBD_EVENT_EXTENDED;
+        event->keycode = KEY_EXTENDED(event->keycode);
+        kbd_extended = 0;
+    }
+    
+    keyboard_update_modifiers(event->keycode, event->flags & KBD_EVENT_RELEASE);
+    event->modifiers = kbd_modifiers;
+    return 1;
 }
 
-// Verifica se há caracteres no buffer
-int keyboard_buffer_available() {
-    return buffer_head != buffer_tail;
+// Verifica se há bytes pendentes no anel
+int keyboard_event_available() {
+    return kbd_head != kbd_tail;
 }
 
-// Handler de interrupção do teclado
-static void keyboard_handler(registers_t *regs) {
-    uint8_t scancode = inb(KEYBOARD_DATA_PORT);
-    
-    // Verificar se é uma tecla pressionada ou liberada
-    if(scancode & 0x80) {
-        // Tecla liberada (bit 7 = 1)
-        scancode &= 0x7F; // Remover bit 7
+// Espera até que haja algo no anel, bloqueando o processo atual
+static void keyboard_wait() {
+    while(!keyboard_event_available()) {
+        asm volatile("cli");
+        kbd_waiter = (int32_t)scheduler_current();
         
-        // Atualizar flags de estado
-        if(scancode == 0x2A || scancode == 0x36) { // Left or Right Shift
-            shift_pressed = 0;
-        } else if(scancode == 0x1D) { // Ctrl
-            ctrl_pressed = 0;
-        } else if(scancode == 0x38) { // Alt
-            alt_pressed = 0;
+        // Verificar novamente com interrupções desabilitadas
+        if(!keyboard_event_available()) {
+            scheduler_block();
+            
+            // Nenhum outro processo pronto: esperar pela próxima IRQ
+            // (sti;hlt é atômico, então não perdemos o despertar)
+            if(!keyboard_event_available()) {
+                asm volatile("sti; hlt");
+            }
         }
-    } else {
-        // Tecla pressionada
         
-        // Atualizar flags de estado
-        if(scancode == 0x2A || scancode == 0x36) { // Left or Right Shift
-            shift_pressed = 1;
-            return;
-        } else if(scancode == 0x1D) { // Ctrl
-            ctrl_pressed = 1;
-            return;
-        } else if(scancode == 0x38) { // Alt
-            alt_pressed = 1;
-            return;
-        } else if(scancode == 0x3A) { // Caps Lock
-            caps_lock = !caps_lock;
-            return;
-        }
+        kbd_waiter = -1;
+        asm volatile("sti");
+    }
+}
+
+// Lê o próximo evento de teclado (bloqueante)
+int keyboard_read_event(kbd_event_t *event) {
+    for(;;) {
+        keyboard_wait();
         
-        // Converter scancode para ASCII
-        if(scancode < sizeof(scancode_to_ascii)) {
-            char c = scancode_to_ascii[scancode];
-            
-            // Aplicar modificadores
-            if(c >= 'a' && c <= 'z') {
-                if((shift_pressed && !caps_lock) || (!shift_pressed && caps_lock)) {
-                    c = c - 'a' + 'A'; // Converter para maiúscula
-                }
-            } else if(shift_pressed) {
-                // Mapear caracteres especiais com Shift
-                switch(c) {
-                    case '1': c = '!'; break;
-                    case '2': c = '@'; break;
-                    case '3': c = '#'; break;
-                    case '4': c = '$'; break;
-                    case '5': c = '%'; break;
-                    case '6': c = '^'; break;
-                    case '7': c = '&'; break;
-                    case '8': c = '*'; break;
-                    case '9': c = '('; break;
-                    case '0': c = ')'; break;
-                    case '-': c = '_'; break;
-                    case '=': c = '+'; break;
-                    case '[': c = '{'; break;
-                    case ']': c = '}'; break;
-                    case '\\': c = '|'; break;
-                    case ';': c = ':'; break;
-                    case '\'': c = '"'; break;
-                    case ',': c = '<'; break;
-                    case '.': c = '>'; break;
-                    case '/': c = '?'; break;
-                    case '`': c = '~'; break;
-                }
-            }
-            
-            // Processar combinações de teclas com Ctrl
-            if(ctrl_pressed) {
-                if(c >= 'a' && c <= 'z') {
-                    c = c - 'a' + 1; // Ctrl+A = 1, Ctrl+B = 2, etc.
-                }
-            }
-            
-            // Adicionar ao buffer se for um caractere válido
-            if(c != 0) {
-                keyboard_buffer_put(c);
-            }
+        uint32_t tail = kbd_tail;
+        *event = kbd_ring[tail & KBD_RING_MASK];
+        kbd_barrier();
+        kbd_tail = tail + 1;
+        
+        if(keyboard_decode(event)) {
+            return 0;
+        }
+    }
+}
+
+// Converte um evento em caractere ASCII (0 se não imprimível)
+char keyboard_event_to_ascii(const kbd_event_t *event) {
+    if(event->flags & KBD_EVENT_RELEASE) {
+        return 0;
+    }
+    
+    // Teclas estendidas com equivalente ASCII
+    if(event->flags & KBD_EVENT_EXTENDED) {
+        if(event->keycode == KEY_KP_ENTER) return '\n';
+        if(event->keycode == KEY_KP_SLASH) return '/';
+        return 0;
+    }
+    
+    char c = keymap_us[event->keycode];
+    int shift = (event->modifiers & KBD_MOD_SHIFT) != 0;
+    
+    // Caps Lock inverte o Shift apenas para letras
+    if(c >= 'a' && c <= 'z' && (event->modifiers & KBD_MOD_CAPS)) {
+        shift = !shift;
+    }
+    if(shift) {
+        c = keymap_us_shift[event->keycode];
+    }
+    
+    // Ctrl+A = 1, Ctrl+B = 2, etc.
+    if((event->modifiers & KBD_MOD_CTRL) && c >= 'a' && c <= 'z') {
+        c = c - 'a' + 1;
+    }
+    
+    return c;
+}
+
+// Retira um caractere do anel (bloqueante)
+char keyboard_buffer_get() {
+    kbd_event_t event;
+    
+    for(;;) {
+        keyboard_read_event(&event);
+        char c = keyboard_event_to_ascii(&event);
+        if(c != 0) {
+            return c;
         }
     }
 }
 
+// Verifica se há eventos no anel
+int keyboard_buffer_available() {
+    return keyboard_event_available();
+}
+
+// Número de bytes descartados por anel cheio
+uint32_t keyboard_overflow_count() {
+    return kbd_overflows;
+}
+
 // Inicializa o driver de teclado
 void keyboard_init() {
-    // Registrar handler de interrupção
-    register_interrupt_handler(IRQ(KEYBOARD_IRQ), keyboard_handler);
+    // Limpar anel
+    kbd_head = kbd_tail = 0;
+    kbd_overflows = 0;
+    kbd_waiter = -1;
     
-    // Limpar buffer
-    buffer_head = buffer_tail = 0;
+    // Resetar estado do decodificador
+    kbd_modifiers = 0;
+    kbd_extended = 0;
+    kbd_pause_skip = 0;
     
-    // Resetar flags
-    shift_pressed = ctrl_pressed = alt_pressed = caps_lock = 0;
+    // Registrar handler de interrupção
+    register_interrupt_handler(IRQ(KEYBOARD_IRQ), keyboard_handler);
     
     // Habilitar interrupções do teclado
     pic_unmask_irq(KEYBOARD_IRQ);
@@ -167,10 +265,6 @@ void keyboard_read_line(char *buffer, int max_length) {
     
     while(i < max_length - 1) {
         // Esperar por um caractere
-        while(!keyboard_buffer_available()) {
-            asm volatile("hlt");
-        }
-        
         c = keyboard_buffer_get();
         
         // Enter finaliza a linha
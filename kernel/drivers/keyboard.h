@@ -0,0 +1,52 @@
+#ifndef KEYBOARD_H
+#define KEYBOARD_H
+
+#include <stdint.h>
+
+// Modificadores ativos no momento do evento
+#define KBD_MOD_SHIFT 0x01
+#define KBD_MOD_CTRL  0x02
+#define KBD_MOD_ALT   0x04
+#define KBD_MOD_CAPS  0x08
+
+// Flags do evento
+#define KBD_EVENT_RELEASE  0x01
+#define KBD_EVENT_EXTENDED 0x02
+
+// Keycodes de teclas estendidas (prefixo 0xE0): scancode | 0x80
+#define KEY_EXTENDED(sc) ((uint8_t)((sc) | 0x80))
+#define KEY_KP_ENTER  KEY_EXTENDED(0x1C)
+#define KEY_RCTRL     KEY_EXTENDED(0x1D)
+#define KEY_KP_SLASH  KEY_EXTENDED(0x35)
+#define KEY_RALT      KEY_EXTENDED(0x38)
+#define KEY_HOME      KEY_EXTENDED(0x47)
+#define KEY_UP        KEY_EXTENDED(0x48)
+#define KEY_PAGE_UP   KEY_EXTENDED(0x49)
+#define KEY_LEFT      KEY_EXTENDED(0x4B)
+#define KEY_RIGHT     KEY_EXTENDED(0x4D)
+#define KEY_END       KEY_EXTENDED(0x4F)
+#define KEY_DOWN      KEY_EXTENDED(0x50)
+#define KEY_PAGE_DOWN KEY_EXTENDED(0x51)
+#define KEY_INSERT    KEY_EXTENDED(0x52)
+#define KEY_DELETE    KEY_EXTENDED(0x53)
+
+// Evento de teclado (16 bytes)
+typedef struct kbd_event {
+    uint8_t scancode;   // Byte bruto lido da porta de dados
+    uint8_t keycode;    // Tecla decodificada (ver KEY_*)
+    uint8_t modifiers;  // KBD_MOD_*
+    uint8_t flags;      // KBD_EVENT_*
+    uint32_t reserved;
+    uint64_t timestamp; // TSC no momento da interrupção
+} kbd_event_t;
+
+void keyboard_init(void);
+int keyboard_read_event(kbd_event_t *event);
+int keyboard_event_available(void);
+char keyboard_event_to_ascii(const kbd_event_t *event);
+char keyboard_buffer_get(void);
+int keyboard_buffer_available(void);
+void keyboard_read_line(char *buffer, int max_length);
+uint32_t keyboard_overflow_count(void);
+
+#endif
@@ -0,0 +1,125 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "io.h"
+#include "pci.h"
+#include "console.h"
+
+#define PCI_CONFIG_ADDRESS 0xCF8
+#define PCI_CONFIG_DATA    0xCFC
+
+static pci_device_t devices[PCI_MAX_DEVICES];
+static int device_count = 0;
+
+// Seleciona um registrador (mecanismo de configuração #1)
+static inline void pci_select(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
+    uint32_t address = 0x80000000u | ((uint32_t)bus << 16) | ((uint32_t)slot << 11) |
+                       ((uint32_t)func << 8) | (offset & 0xFC);
+    outl(PCI_CONFIG_ADDRESS, address);
+}
+
+uint32_t pci_read32(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
+    pci_select(bus, slot, func, offset);
+    return inl(PCI_CONFIG_DATA);
+}
+
+uint16_t pci_read16(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
+    return pci_read32(bus, slot, func, offset) >> ((offset & 2) * 8);
+}
+
+uint8_t pci_read8(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
+    return pci_read32(bus, slot, func, offset) >> ((offset & 3) * 8);
+}
+
+void pci_write32(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t value) {
+    pci_select(bus, slot, func, offset);
+    outl(PCI_CONFIG_DATA, value);
+}
+
+void pci_write16(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint16_t value) {
+    uint32_t shift = (offset & 2) * 8;
+    uint32_t old = pci_read32(bus, slot, func, offset);
+    old = (old & ~(0xFFFFu << shift)) | ((uint32_t)value << shift);
+    pci_write32(bus, slot, func, offset, old);
+}
+
+// Registra uma função presente
+static void pci_add(uint8_t bus, uint8_t slot, uint8_t func) {
+    if(device_count >= PCI_MAX_DEVICES) {
+        return;
+    }
+    
+    pci_device_t *dev = &devices[device_count++];
+    dev->bus = bus;
+    dev->slot = slot;
+    dev->func = func;
+    dev->vendor = pci_read16(bus, slot, func, PCI_VENDOR_ID);
+    dev->device = pci_read16(bus, slot, func, PCI_DEVICE_ID);
+    dev->subsystem = pci_read16(bus, slot, func, PCI_SUBSYSTEM_ID);
+    dev->class = pci_read8(bus, slot, func, PCI_CLASS);
+    dev->subclass = pci_read8(bus, slot, func, PCI_SUBCLASS);
+    dev->prog_if = pci_read8(bus, slot, func, PCI_CLASS_PROG);
+    dev->irq = pci_read8(bus, slot, func, PCI_INTERRUPT_LINE);
+    for(int i = 0; i < 6; i++) {
+        dev->bar[i] = pci_read32(bus, slot, func, PCI_BAR0 + i * 4);
+    }
+}
+
+// Enumera todas as funções de todos os barramentos
+void pci_init() {
+    device_count = 0;
+    
+    for(uint32_t bus = 0; bus < 256; bus++) {
+        for(uint8_t slot = 0; slot < 32; slot++) {
+            if(pci_read16(bus, slot, 0, PCI_VENDOR_ID) == 0xFFFF) {
+                continue; // Slot vazio
+            }
+            
+            // Dispositivos multifunção têm o bit 7 do header type
+            uint8_t functions = (pci_read8(bus, slot, 0, PCI_HEADER_TYPE) & 0x80) ? 8 : 1;
+            for(uint8_t func = 0; func < functions; func++) {
+                if(pci_read16(bus, slot, func, PCI_VENDOR_ID) != 0xFFFF) {
+                    pci_add(bus, slot, func);
+                }
+            }
+        }
+    }
+    
+    console_write("pci: ");
+    console_write_dec(device_count);
+    console_write(" dispositivos\n");
+}
+
+int pci_device_count() {
+    return device_count;
+}
+
+pci_device_t *pci_get_device(int index) {
+    return (index >= 0 && index < device_count) ? &devices[index] : NULL;
+}
+
+// Procura (vendor, device) a partir do dispositivo seguinte a from
+pci_device_t *pci_find_device(uint16_t vendor, uint16_t device, pci_device_t *from) {
+    int start = from ? (int)(from - devices) + 1 : 0;
+    for(int i = start; i < device_count; i++) {
+        if(devices[i].vendor == vendor && devices[i].device == device) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+// Procura a primeira função com a classe/subclasse dada
+pci_device_t *pci_find_class(uint8_t class, uint8_t subclass) {
+    for(int i = 0; i < device_count; i++) {
+        if(devices[i].class == class && devices[i].subclass == subclass) {
+            return &devices[i];
+        }
+    }
+    return NULL;
+}
+
+// Liga decodificação de E/S/memória e bus mastering
+void pci_enable(pci_device_t *dev, uint16_t flags) {
+    uint16_t command = pci_read16(dev->bus, dev->slot, dev->func, PCI_COMMAND);
+    pci_write16(dev->bus, dev->slot, dev->func, PCI_COMMAND, command | flags);
+}
@@ -0,0 +1,56 @@
+#ifndef PCI_H
+#define PCI_H
+
+#include <stdint.h>
+
+// Registradores do espaço de configuração
+#define PCI_VENDOR_ID   0x00
+#define PCI_DEVICE_ID   0x02
+#define PCI_COMMAND     0x04
+#define PCI_STATUS      0x06
+#define PCI_CLASS_PROG  0x09
+#define PCI_SUBCLASS    0x0A
+#define PCI_CLASS       0x0B
+#define PCI_HEADER_TYPE 0x0E
+#define PCI_BAR0        0x10
+#define PCI_BAR4        0x20
+#define PCI_SUBSYSTEM_ID   0x2E
+#define PCI_CAPABILITIES   0x34
+#define PCI_INTERRUPT_LINE 0x3C
+
+// Bits do registrador de comando
+#define PCI_COMMAND_IO     0x1
+#define PCI_COMMAND_MEMORY 0x2
+#define PCI_COMMAND_MASTER 0x4
+
+#define PCI_MAX_DEVICES 64
+
+// Função PCI encontrada na enumeração
+typedef struct pci_device {
+    uint8_t bus;
+    uint8_t slot;
+    uint8_t func;
+    uint8_t irq;
+    uint16_t vendor;
+    uint16_t device;
+    uint16_t subsystem;
+    uint8_t class;
+    uint8_t subclass;
+    uint8_t prog_if;
+    uint32_t bar[6];
+} pci_device_t;
+
+void pci_init(void);
+int pci_device_count(void);
+pci_device_t *pci_get_device(int index);
+pci_device_t *pci_find_device(uint16_t vendor, uint16_t device, pci_device_t *from);
+void pci_enable(pci_device_t *dev, uint16_t flags);
+
+uint32_t pci_read32(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
+uint16_t pci_read16(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
+uint8_t pci_read8(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset);
+void pci_write32(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint32_t value);
+void pci_write16(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset, uint16_t value);
+pci_device_t *pci_find_class(uint8_t class, uint8_t subclass);
+
+#endif
@@ -0,0 +1,74 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "io.h"
+#include "idt.h"
+#include "rtc.h"
+#include "spinlock.h"
+#include "irqstat.h"
+
+// Registradores do RTC, acessados pelo índice da CMOS
+#define CMOS_INDEX 0x70
+#define CMOS_DATA  0x71
+
+#define RTC_REG_A 0x0A      // Bits 0-3: divisor da interrupção periódica
+#define RTC_REG_B 0x0B
+#define RTC_REG_C 0x0C      // Causa da interrupção; precisa ser lido a cada IRQ
+
+#define RTC_B_PERIODIC 0x40
+
+#define RTC_IRQ 8
+
+static rtc_handler_t rtc_handler = NULL;
+static int rtc_registered = 0;
+
+static uint8_t cmos_read(uint8_t reg) {
+    outb(CMOS_INDEX, reg);
+    return inb(CMOS_DATA);
+}
+
+static void cmos_write(uint8_t reg, uint8_t value) {
+    outb(CMOS_INDEX, reg);
+    outb(CMOS_DATA, value);
+}
+
+static void rtc_irq(registers_t *regs) {
+    irq_enter(RTC_IRQ);
+    
+    // Sem a leitura de C o RTC não gera a próxima interrupção
+    cmos_read(RTC_REG_C);
+    if(rtc_handler) {
+        rtc_handler(regs);
+    }
+    
+    irq_exit(RTC_IRQ);
+}
+
+// Frequência = 32768 >> (rate - 1), com rate de 3 (8192 Hz) a 15 (2 Hz)
+uint32_t rtc_start_periodic(uint32_t hz, rtc_handler_t handler) {
+    uint32_t rate = 3;
+    while(rate < 15 && (32768u >> (rate - 1)) > hz) {
+        rate++;
+    }
+    
+    if(!rtc_registered) {
+        register_interrupt_handler(IRQ(RTC_IRQ), rtc_irq);
+        rtc_registered = 1;
+    }
+    
+    uintptr_t flags = irq_save();
+    rtc_handler = handler;
+    cmos_write(RTC_REG_A, (cmos_read(RTC_REG_A) & 0xF0) | rate);
+    cmos_write(RTC_REG_B, cmos_read(RTC_REG_B) | RTC_B_PERIODIC);
+    cmos_read(RTC_REG_C);
+    irq_restore(flags);
+    
+    pic_unmask_irq(RTC_IRQ);
+    return 32768u >> (rate - 1);
+}
+
+void rtc_stop_periodic() {
+    uintptr_t flags = irq_save();
+    cmos_write(RTC_REG_B, cmos_read(RTC_REG_B) & ~RTC_B_PERIODIC);
+    rtc_handler = NULL;
+    irq_restore(flags);
+}
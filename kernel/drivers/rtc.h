@@ -0,0 +1,15 @@
+#ifndef RTC_H
+#define RTC_H
+
+#include <stdint.h>
+#include "io.h"
+
+// Interrupção periódica do RTC (IRQ 8), independente do PIT do escalonador
+typedef void (*rtc_handler_t)(registers_t *regs);
+
+// Frequências possíveis: potências de 2 de 2 a 8192 Hz; retorna a usada
+// (a maior que não passa de hz)
+uint32_t rtc_start_periodic(uint32_t hz, rtc_handler_t handler);
+void rtc_stop_periodic(void);
+
+#endif
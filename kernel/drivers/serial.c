@@ -0,0 +1,90 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "serial.h"
+#include "io.h"
+
+// Registradores do 16550 (deslocamentos a partir da porta base)
+#define SERIAL_DATA        0
+#define SERIAL_INT_ENABLE  1
+#define SERIAL_FIFO_CTRL   2
+#define SERIAL_LINE_CTRL   3
+#define SERIAL_MODEM_CTRL  4
+#define SERIAL_LINE_STATUS 5
+
+#define SERIAL_LSR_THR_EMPTY 0x20
+
+static int serial_ready = 0;
+
+// 38400 baud, 8N1, FIFO ligado, sem interrupções (saída por polling)
+void serial_init() {
+    outb(SERIAL_COM1 + SERIAL_INT_ENABLE, 0x00);
+    outb(SERIAL_COM1 + SERIAL_LINE_CTRL, 0x80);     // DLAB para o divisor
+    outb(SERIAL_COM1 + SERIAL_DATA, 3);             // 115200 / 3
+    outb(SERIAL_COM1 + SERIAL_INT_ENABLE, 0);
+    outb(SERIAL_COM1 + SERIAL_LINE_CTRL, 0x03);     // 8 bits, sem paridade, 1 stop
+    outb(SERIAL_COM1 + SERIAL_FIFO_CTRL, 0xC7);     // FIFO de 14 bytes, limpo
+    outb(SERIAL_COM1 + SERIAL_MODEM_CTRL, 0x03);    // DTR e RTS
+    
+    // Sem UART a porta flutua em 0xFF
+    serial_ready = inb(SERIAL_COM1 + SERIAL_LINE_STATUS) != 0xFF;
+}
+
+void serial_putchar(char c) {
+    if(!serial_ready) {
+        return;
+    }
+    if(c == '\n') {
+        serial_putchar('\r');
+    }
+    while(!(inb(SERIAL_COM1 + SERIAL_LINE_STATUS) & SERIAL_LSR_THR_EMPTY));
+    outb(SERIAL_COM1 + SERIAL_DATA, c);
+}
+
+void serial_write(const char *str) {
+    while(*str) {
+        serial_putchar(*str++);
+    }
+}
+
+// Dados binários em linhas "<prefix><hex>" de até 32 bytes, para dumps
+// lidos por ferramentas do anfitrião (trace, profiler)
+void serial_write_hex_lines(const char *prefix, const void *data, size_t len) {
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t *bytes = data;
+    
+    while(len > 0) {
+        size_t chunk = len < 32 ? len : 32;
+        serial_write(prefix);
+        for(size_t i = 0; i < chunk; i++) {
+            serial_putchar(digits[bytes[i] >> 4]);
+            serial_putchar(digits[bytes[i] & 0xF]);
+        }
+        serial_putchar('\n');
+        bytes += chunk;
+        len -= chunk;
+    }
+}
+
+// Decimal sem divisão de 64 bits, como em console_write_dec()
+void serial_write_dec(uint64_t value) {
+    static const uint64_t powers[] = {
+        10000000000000000000ULL, 1000000000000000000ULL, 100000000000000000ULL,
+        10000000000000000ULL, 1000000000000000ULL, 100000000000000ULL,
+        10000000000000ULL, 1000000000000ULL, 100000000000ULL, 10000000000ULL,
+        1000000000ULL, 100000000ULL, 10000000ULL, 1000000ULL, 100000ULL,
+        10000ULL, 1000ULL, 100ULL, 10ULL, 1ULL
+    };
+    int started = 0;
+    
+    for(unsigned i = 0; i < sizeof(powers) / sizeof(powers[0]); i++) {
+        char digit = '0';
+        while(value >= powers[i]) {
+            value -= powers[i];
+            digit++;
+        }
+        if(digit != '0' || started || powers[i] == 1) {
+            serial_putchar(digit);
+            started = 1;
+        }
+    }
+}
@@ -0,0 +1,16 @@
+#ifndef SERIAL_H
+#define SERIAL_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Porta serial COM1 (16550), usada para saída legível por máquina
+#define SERIAL_COM1 0x3F8
+
+void serial_init(void);
+void serial_putchar(char c);
+void serial_write(const char *str);
+void serial_write_dec(uint64_t value);
+void serial_write_hex_lines(const char *prefix, const void *data, size_t len);
+
+#endif
@@ -0,0 +1,178 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "io.h"
+#include "virtio.h"
+#include "pmm.h"
+
+#define VIRTQ_ALIGN 4096
+
+// Barreira completa: o dispositivo (outro thread no host) lê os anéis
+#ifdef __x86_64__
+#define virtio_mb() asm volatile("lock; addl $0, (%%rsp)" : : : "memory")
+#else
+#define virtio_mb() asm volatile("lock; addl $0, (%%esp)" : : : "memory")
+#endif
+#define virtio_wmb() asm volatile("" : : : "memory")
+
+static inline uint32_t virtq_align(uint32_t size) {
+    return (size + VIRTQ_ALIGN - 1) & ~(VIRTQ_ALIGN - 1);
+}
+
+// used_event fica logo após o anel avail; avail_event após o anel used
+static inline volatile uint16_t *virtq_used_event(virtqueue_t *vq) {
+    return &vq->avail->ring[vq->size];
+}
+
+static inline volatile uint16_t *virtq_avail_event(virtqueue_t *vq) {
+    return (volatile uint16_t*)&vq->used->ring[vq->size];
+}
+
+// Configura a fila index do dispositivo (layout legado, alinhado a 4KB)
+int virtq_init(virtqueue_t *vq, uint16_t io, uint16_t index, int event_idx) {
+    outw(io + VIRTIO_PCI_QUEUE_SEL, index);
+    uint16_t size = inw(io + VIRTIO_PCI_QUEUE_SIZE);
+    if(size == 0 || inl(io + VIRTIO_PCI_QUEUE_PFN) != 0) {
+        return -1; // Fila inexistente ou já em uso
+    }
+    
+    uint32_t avail_size = sizeof(virtq_desc_t) * size + sizeof(uint16_t) * (3 + size);
+    uint32_t used_offset = virtq_align(avail_size);
+    uint32_t total = used_offset + virtq_align(sizeof(uint16_t) * 3 + sizeof(virtq_used_elem_t) * size);
+    
+    vq->pages = total / VIRTQ_ALIGN;
+    vq->mem = pmm_alloc_contiguous(vq->pages);
+    if(!vq->mem) {
+        return -1;
+    }
+    vq->cookies = malloc(sizeof(void*) * size);
+    if(!vq->cookies) {
+        pmm_free_contiguous(vq->mem, vq->pages);
+        vq->mem = NULL;
+        return -1;
+    }
+    memset(vq->mem, 0, total);
+    
+    vq->io = io;
+    vq->index = index;
+    vq->size = size;
+    vq->event_idx = event_idx;
+    vq->desc = vq->mem;
+    vq->avail = (virtq_avail_t*)((uint8_t*)vq->mem + sizeof(virtq_desc_t) * size);
+    vq->used = (virtq_used_t*)((uint8_t*)vq->mem + used_offset);
+    vq->last_used = 0;
+    vq->last_kick = 0;
+    vq->kicks = vq->kicks_saved = 0;
+    
+    // Todos os descritores na lista livre
+    for(uint16_t i = 0; i < size; i++) {
+        vq->desc[i].next = i + 1;
+        vq->cookies[i] = NULL;
+    }
+    vq->free_head = 0;
+    vq->num_free = size;
+    
+    outl(io + VIRTIO_PCI_QUEUE_PFN, (uint32_t)((uintptr_t)vq->mem / VIRTQ_ALIGN));
+    return 0;
+}
+
+// Publica uma cadeia de buffers; o dispositivo só é avisado em virtq_kick()
+int virtq_add(virtqueue_t *vq, const virtq_buf_t *bufs, int count, void *cookie) {
+    if(count <= 0 || vq->num_free < count) {
+        return -1;
+    }
+    
+    uint16_t head = vq->free_head;
+    uint16_t index = head;
+    uint16_t last = head;
+    
+    for(int i = 0; i < count; i++) {
+        virtq_desc_t *desc = &vq->desc[index];
+        desc->addr = bufs[i].addr;
+        desc->len = bufs[i].len;
+        desc->flags = bufs[i].write ? VIRTQ_DESC_F_WRITE : 0;
+        if(i + 1 < count) {
+            desc->flags |= VIRTQ_DESC_F_NEXT;
+        }
+        last = index;
+        index = desc->next;
+    }
+    
+    vq->free_head = vq->desc[last].next;
+    vq->num_free -= count;
+    vq->cookies[head] = cookie;
+    
+    // A entrada só fica visível depois de os descritores estarem escritos
+    vq->avail->ring[vq->avail->idx % vq->size] = head;
+    virtio_wmb();
+    vq->avail->idx++;
+    return head;
+}
+
+// Notifica o dispositivo sobre tudo publicado desde a última notificação,
+// a menos que ele tenha pedido para não ser notificado
+void virtq_kick(virtqueue_t *vq) {
+    uint16_t new_idx = vq->avail->idx;
+    uint16_t old_idx = vq->last_kick;
+    if(new_idx == old_idx) {
+        return;
+    }
+    
+    virtio_mb();
+    vq->last_kick = new_idx;
+    
+    int notify;
+    if(vq->event_idx) {
+        uint16_t event = *virtq_avail_event(vq);
+        notify = (uint16_t)(new_idx - event - 1) < (uint16_t)(new_idx - old_idx);
+    } else {
+        notify = !(vq->used->flags & VIRTQ_USED_F_NO_NOTIFY);
+    }
+    
+    if(notify) {
+        outw(vq->io + VIRTIO_PCI_QUEUE_NOTIFY, vq->index);
+        vq->kicks++;
+    } else {
+        vq->kicks_saved++;
+    }
+}
+
+// Retira a próxima cadeia concluída; retorna o cookie (NULL se não houver)
+void *virtq_get_used(virtqueue_t *vq, uint32_t *len) {
+    if(vq->last_used == *(volatile uint16_t*)&vq->used->idx) {
+        return NULL;
+    }
+    virtio_mb();
+    
+    virtq_used_elem_t *elem = &vq->used->ring[vq->last_used % vq->size];
+    uint16_t head = elem->id;
+    if(len) {
+        *len = elem->len;
+    }
+    vq->last_used++;
+    
+    // Devolver a cadeia à lista livre
+    uint16_t index = head;
+    uint16_t count = 1;
+    while(vq->desc[index].flags & VIRTQ_DESC_F_NEXT) {
+        index = vq->desc[index].next;
+        count++;
+    }
+    vq->desc[index].next = vq->free_head;
+    vq->free_head = head;
+    vq->num_free += count;
+    
+    void *cookie = vq->cookies[head];
+    vq->cookies[head] = NULL;
+    return cookie;
+}
+
+// Pede a próxima interrupção só depois de batch conclusões (com EVENT_IDX).
+// Retorna 1 se já houver entradas usadas para consumir
+int virtq_enable_cb(virtqueue_t *vq, uint16_t batch) {
+    if(vq->event_idx) {
+        *virtq_used_event(vq) = vq->last_used + (batch ? batch - 1 : 0);
+    }
+    virtio_mb();
+    return vq->last_used != *(volatile uint16_t*)&vq->used->idx;
+}
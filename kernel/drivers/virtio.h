@@ -0,0 +1,92 @@
+#ifndef VIRTIO_H
+#define VIRTIO_H
+
+#include <stdint.h>
+
+#define VIRTIO_PCI_VENDOR 0x1AF4
+
+// Interface PCI legada (BAR0 de E/S)
+#define VIRTIO_PCI_HOST_FEATURES  0x00
+#define VIRTIO_PCI_GUEST_FEATURES 0x04
+#define VIRTIO_PCI_QUEUE_PFN      0x08
+#define VIRTIO_PCI_QUEUE_SIZE     0x0C
+#define VIRTIO_PCI_QUEUE_SEL      0x0E
+#define VIRTIO_PCI_QUEUE_NOTIFY   0x10
+#define VIRTIO_PCI_STATUS         0x12
+#define VIRTIO_PCI_ISR            0x13
+#define VIRTIO_PCI_CONFIG         0x14    // Sem MSI-X
+
+// Status do dispositivo
+#define VIRTIO_STATUS_ACKNOWLEDGE 0x01
+#define VIRTIO_STATUS_DRIVER      0x02
+#define VIRTIO_STATUS_DRIVER_OK   0x04
+#define VIRTIO_STATUS_FAILED      0x80
+
+#define VIRTIO_ISR_QUEUE 0x01
+
+#define VIRTIO_RING_F_EVENT_IDX (1u << 29)
+
+// Descritores
+#define VIRTQ_DESC_F_NEXT  0x1
+#define VIRTQ_DESC_F_WRITE 0x2      // Dispositivo escreve no buffer
+
+#define VIRTQ_USED_F_NO_NOTIFY 0x1
+
+typedef struct virtq_desc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} virtq_desc_t;
+
+typedef struct virtq_avail {
+    uint16_t flags;
+    uint16_t idx;
+    uint16_t ring[];            // Seguido de used_event
+} virtq_avail_t;
+
+typedef struct virtq_used_elem {
+    uint32_t id;
+    uint32_t len;
+} virtq_used_elem_t;
+
+typedef struct virtq_used {
+    uint16_t flags;
+    uint16_t idx;
+    virtq_used_elem_t ring[];   // Seguido de avail_event
+} virtq_used_t;
+
+// Buffer de uma cadeia de descritores
+typedef struct virtq_buf {
+    uint64_t addr;              // Endereço físico (descritores têm 64 bits)
+    uint32_t len;
+    int write;                  // Dispositivo escreve (ex.: dados de leitura)
+} virtq_buf_t;
+
+// Fila virtual dividida (split virtqueue)
+typedef struct virtqueue {
+    uint16_t io;                // Base de E/S do dispositivo
+    uint16_t index;
+    uint16_t size;
+    uint16_t free_head;         // Lista de descritores livres
+    uint16_t num_free;
+    uint16_t last_used;         // Próxima entrada do anel used a consumir
+    uint16_t last_kick;         // avail->idx na última notificação
+    int event_idx;
+    virtq_desc_t *desc;
+    virtq_avail_t *avail;
+    virtq_used_t *used;
+    void **cookies;             // Por descritor cabeça
+    void *mem;
+    uint32_t pages;
+    uint32_t kicks;             // Notificações enviadas
+    uint32_t kicks_saved;       // Suprimidas pelo dispositivo
+} virtqueue_t;
+
+int virtq_init(virtqueue_t *vq, uint16_t io, uint16_t index, int event_idx);
+int virtq_add(virtqueue_t *vq, const virtq_buf_t *bufs, int count, void *cookie);
+void virtq_kick(virtqueue_t *vq);
+void *virtq_get_used(virtqueue_t *vq, uint32_t *len);
+int virtq_enable_cb(virtqueue_t *vq, uint16_t batch);
+
+#endif
@@ -0,0 +1,235 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "io.h"
+#include "virtio.h"
+#include "virtio_blk.h"
+#include "block.h"
+#include "pci.h"
+#include "pmm.h"
+#include "console.h"
+#include "irqstat.h"
+
+#define VIRTIO_BLK_DEVICE_LEGACY 0x1001     // Dispositivo transicional
+
+#define VIRTIO_BLK_MAX_DEVICES 4
+
+// Funcionalidades
+#define VIRTIO_BLK_F_SEG_MAX  (1u << 2)
+#define VIRTIO_BLK_F_RO       (1u << 5)
+#define VIRTIO_BLK_F_BLK_SIZE (1u << 6)
+#define VIRTIO_BLK_F_FLUSH    (1u << 9)
+
+// Configuração do dispositivo (a partir de VIRTIO_PCI_CONFIG)
+#define VIRTIO_BLK_CFG_CAPACITY 0
+#define VIRTIO_BLK_CFG_SEG_MAX  12
+
+// Tipos de requisição
+#define VIRTIO_BLK_T_IN  0
+#define VIRTIO_BLK_T_OUT 1
+
+#define VIRTIO_BLK_S_OK 0
+
+typedef struct virtio_blk_header {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} __attribute__((packed)) virtio_blk_header_t;
+
+// Cabeçalho e status de uma requisição, indexado pelo descritor cabeça
+typedef struct virtio_blk_slot {
+    virtio_blk_header_t header;
+    block_request_t *request;
+    uint8_t status;             // Escrito pelo dispositivo
+    uint8_t pad[11];
+} __attribute__((packed)) virtio_blk_slot_t;
+
+typedef struct virtio_blk {
+    block_device_t dev;
+    pci_device_t *pci;
+    uint16_t io;
+    uint32_t features;
+    virtqueue_t vq;
+    virtio_blk_slot_t *slots;
+    uint32_t interrupts;
+    uint32_t completions;
+} virtio_blk_t;
+
+static virtio_blk_t disks[VIRTIO_BLK_MAX_DEVICES];
+static int disk_count = 0;
+
+// Operação start: publica cabeçalho, segmentos e status sem notificar
+static int virtio_blk_start(block_device_t *dev, block_request_t *request) {
+    virtio_blk_t *disk = dev->private;
+    virtqueue_t *vq = &disk->vq;
+    virtq_buf_t bufs[BLOCK_MAX_SEGMENTS + 2];
+    int count = 0;
+    
+    if(request->op == BLOCK_WRITE && dev->read_only) {
+        return -1;
+    }
+    if(vq->num_free < request->segments + 2) {
+        return BLOCK_BUSY;
+    }
+    
+    // O slot é o do descritor cabeça que virtq_add vai usar
+    virtio_blk_slot_t *slot = &disk->slots[vq->free_head];
+    slot->header.type = request->op == BLOCK_WRITE ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    slot->header.reserved = 0;
+    slot->header.sector = request->sector;
+    slot->request = request;
+    slot->status = 0xFF;
+    
+    bufs[count].addr = (uintptr_t)&slot->header;
+    bufs[count].len = sizeof(virtio_blk_header_t);
+    bufs[count].write = 0;
+    count++;
+    
+    for(bio_t *bio = request->bio_head; bio; bio = bio->next) {
+        bufs[count].addr = (uintptr_t)bio->buffer;
+        bufs[count].len = bio->count * BLOCK_SECTOR_SIZE;
+        bufs[count].write = request->op == BLOCK_READ;
+        count++;
+    }
+    
+    bufs[count].addr = (uintptr_t)&slot->status;
+    bufs[count].len = 1;
+    bufs[count].write = 1;
+    count++;
+    
+    return virtq_add(vq, bufs, count, slot) < 0 ? -1 : 0;
+}
+
+// Operação commit: uma notificação por lote de requisições
+static void virtio_blk_commit(block_device_t *dev) {
+    virtio_blk_t *disk = dev->private;
+    virtq_kick(&disk->vq);
+}
+
+static const block_ops_t virtio_blk_ops = {
+    .start = virtio_blk_start,
+    .commit = virtio_blk_commit
+};
+
+// Conclui todas as requisições prontas; com EVENT_IDX a próxima IRQ só
+// vem quando tudo que está em voo terminar
+static void virtio_blk_complete(virtio_blk_t *disk) {
+    virtqueue_t *vq = &disk->vq;
+    
+    do {
+        virtio_blk_slot_t *slot;
+        while((slot = virtq_get_used(vq, NULL)) != NULL) {
+            int status = slot->status == VIRTIO_BLK_S_OK ? 0 : -1;
+            disk->completions++;
+            block_complete(&disk->dev, slot->request, status);
+        }
+    } while(virtq_enable_cb(vq, disk->dev.inflight));
+}
+
+static void virtio_blk_irq(registers_t *regs) {
+    (void)regs;
+    
+    // Com a INTx compartilhada, o evento leva a linha do primeiro disco
+    uint32_t irq = disk_count ? disks[0].pci->irq : 0;
+    irq_enter(irq);
+    
+    // IRQs INTx podem ser compartilhadas; ler o ISR reconhece a interrupção
+    for(int i = 0; i < disk_count; i++) {
+        virtio_blk_t *disk = &disks[i];
+        if(inb(disk->io + VIRTIO_PCI_ISR) & VIRTIO_ISR_QUEUE) {
+            disk->interrupts++;
+            virtio_blk_complete(disk);
+        }
+    }
+    
+    irq_exit(irq);
+}
+
+// Inicializa um dispositivo virtio-blk pela interface legada
+static int virtio_blk_probe(virtio_blk_t *disk, pci_device_t *pci) {
+    if(!(pci->bar[0] & 1)) {
+        return -1; // Interface legada usa BAR0 de E/S
+    }
+    
+    uint16_t io = pci->bar[0] & 0xFFFC;
+    disk->pci = pci;
+    disk->io = io;
+    pci_enable(pci, PCI_COMMAND_IO | PCI_COMMAND_MASTER);
+    
+    // Reset e negociação
+    outb(io + VIRTIO_PCI_STATUS, 0);
+    outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE);
+    outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+    
+    uint32_t host = inl(io + VIRTIO_PCI_HOST_FEATURES);
+    disk->features = host & (VIRTIO_BLK_F_SEG_MAX | VIRTIO_BLK_F_RO | VIRTIO_RING_F_EVENT_IDX);
+    outl(io + VIRTIO_PCI_GUEST_FEATURES, disk->features);
+    
+    if(virtq_init(&disk->vq, io, 0, (disk->features & VIRTIO_RING_F_EVENT_IDX) != 0) != 0) {
+        outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+    
+    uint32_t slot_pages = (disk->vq.size * sizeof(virtio_blk_slot_t) + 4095) / 4096;
+    disk->slots = pmm_alloc_contiguous(slot_pages);
+    if(!disk->slots) {
+        outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_FAILED);
+        return -1;
+    }
+    
+    uint16_t config = io + VIRTIO_PCI_CONFIG;
+    block_device_t *dev = &disk->dev;
+    dev->sector_count = (uint64_t)inl(config + VIRTIO_BLK_CFG_CAPACITY) |
+                        ((uint64_t)inl(config + VIRTIO_BLK_CFG_CAPACITY + 4) << 32);
+    
+    // Segmentos por requisição: limite do dispositivo e da fila
+    uint32_t segments = disk->vq.size - 2;
+    if(disk->features & VIRTIO_BLK_F_SEG_MAX) {
+        uint32_t seg_max = inl(config + VIRTIO_BLK_CFG_SEG_MAX);
+        if(seg_max && seg_max < segments) {
+            segments = seg_max;
+        }
+    }
+    
+    dev->name[0] = 'v';
+    dev->name[1] = 'd';
+    dev->name[2] = 'a' + disk_count;
+    dev->name[3] = '\0';
+    dev->max_segments = segments;
+    dev->max_sectors = BLOCK_MAX_SECTORS;
+    dev->queue_depth = disk->vq.size;   // Limitado de fato pelos descritores livres
+    dev->read_only = (disk->features & VIRTIO_BLK_F_RO) != 0;
+    dev->ops = &virtio_blk_ops;
+    dev->private = disk;
+    
+    outb(io + VIRTIO_PCI_STATUS, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER |
+                                 VIRTIO_STATUS_DRIVER_OK);
+    return 0;
+}
+
+// Procura dispositivos virtio-blk no barramento PCI
+void virtio_blk_init() {
+    pci_device_t *pci = NULL;
+    
+    while(disk_count < VIRTIO_BLK_MAX_DEVICES &&
+          (pci = pci_find_device(VIRTIO_PCI_VENDOR, VIRTIO_BLK_DEVICE_LEGACY, pci)) != NULL) {
+        virtio_blk_t *disk = &disks[disk_count];
+        if(virtio_blk_probe(disk, pci) != 0) {
+            continue;
+        }
+        
+        disk_count++;
+        block_register(&disk->dev);
+        register_interrupt_handler(IRQ(pci->irq), virtio_blk_irq);
+        pic_unmask_irq(pci->irq);
+        
+        console_write("virtio-blk: ");
+        console_write(disk->dev.name);
+        console_write(" ");
+        console_write_dec(disk->dev.sector_count >> 11);
+        console_write(" MB, fila de ");
+        console_write_dec(disk->vq.size);
+        console_write(disk->features & VIRTIO_RING_F_EVENT_IDX ? ", event idx" : "");
+        console_write(disk->dev.read_only ? ", somente leitura\n" : "\n");
+    }
+}
@@ -0,0 +1,7 @@
+#ifndef VIRTIO_BLK_H
+#define VIRTIO_BLK_H
+
+// Discos virtio-blk (interface PCI legada) com filas virtuais em lote
+void virtio_blk_init(void);
+
+#endif
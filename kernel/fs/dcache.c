@@ -0,0 +1,352 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vfs.h"
+#include "dcache.h"
+#include "spinlock.h"
+#include "rcu.h"
+
+#define DCACHE_BUCKETS 4096          // Potência de 2
+#define DCACHE_MAX_ENTRIES 16384     // Acima disso, despejar entradas sem uso
+
+// Tabela hash indexada por (pai, hash do nome)
+static dentry_t *dcache_table[DCACHE_BUCKETS];
+
+// Entradas sem referências, da mais recente (head) à mais antiga (tail)
+static dentry_t *lru_head = NULL;
+static dentry_t *lru_tail = NULL;
+
+// Tabela, LRU, contadores de referências e filhas
+static spinlock_t dcache_lock;
+
+// evictions e entries ficam sob dcache_lock; os contadores de busca são
+// por CPU para que dcache_lookup() não escreva em nada compartilhado
+static dcache_stats_t stats;
+static dcache_stats_t cpu_stats[MAX_CPUS];
+static dcache_stats_t stats_snapshot;
+
+// Inicializa o cache de dentries
+void dcache_init() {
+    for(int i = 0; i < DCACHE_BUCKETS; i++) {
+        dcache_table[i] = NULL;
+    }
+    
+    spin_lock_init(&dcache_lock, "dcache");
+    lru_head = lru_tail = NULL;
+    memset(&stats, 0, sizeof(stats));
+    memset(cpu_stats, 0, sizeof(cpu_stats));
+}
+
+// Calcula o bucket de (pai, hash)
+static inline uint32_t dcache_bucket(dentry_t *parent, uint32_t hash) {
+    uint32_t key = hash ^ (((uint32_t)(uintptr_t)parent >> 4) * 0x9E3779B1u);
+    return key & (DCACHE_BUCKETS - 1);
+}
+
+// Remove uma entrada da lista LRU
+static void lru_remove(dentry_t *dentry) {
+    if(dentry->lru_prev) {
+        dentry->lru_prev->lru_next = dentry->lru_next;
+    } else if(lru_head == dentry) {
+        lru_head = dentry->lru_next;
+    }
+    
+    if(dentry->lru_next) {
+        dentry->lru_next->lru_prev = dentry->lru_prev;
+    } else if(lru_tail == dentry) {
+        lru_tail = dentry->lru_prev;
+    }
+    
+    dentry->lru_prev = dentry->lru_next = NULL;
+}
+
+// Insere uma entrada no início da lista LRU
+static void lru_push(dentry_t *dentry) {
+    dentry->lru_prev = NULL;
+    dentry->lru_next = lru_head;
+    if(lru_head) {
+        lru_head->lru_prev = dentry;
+    }
+    lru_head = dentry;
+    if(!lru_tail) {
+        lru_tail = dentry;
+    }
+}
+
+static void dcache_free_rcu(rcu_head_t *head) {
+    free((dentry_t*)((uint8_t*)head - offsetof(dentry_t, rcu)));
+}
+
+// Remove uma entrada da tabela hash e a libera depois que os leitores
+// atuais saírem; hash_next continua válido para quem ainda a percorre.
+// Chamado com dcache_lock
+static void dcache_free(dentry_t *dentry) {
+    dentry_t **link = &dcache_table[dcache_bucket(dentry->parent, dentry->hash)];
+    while(*link && *link != dentry) {
+        link = &(*link)->hash_next;
+    }
+    if(*link) {
+        rcu_assign_pointer(*link, dentry->hash_next);
+    }
+    
+    lru_remove(dentry);
+    if(dentry->parent) {
+        dentry->parent->children--;
+    }
+    
+    dentry->dead = 1;
+    stats.entries--;
+    call_rcu(&dentry->rcu, dcache_free_rcu);
+}
+
+// Despeja entradas sem uso (e sem filhas) a partir do fim da LRU; as
+// usadas desde a última passada ganham uma segunda chance no início.
+// Chamado com dcache_lock
+static void dcache_shrink(uint32_t target) {
+    dentry_t *dentry = lru_tail;
+    
+    while(dentry && stats.entries > target) {
+        dentry_t *prev = dentry->lru_prev;
+        if(dentry->referenced) {
+            dentry->referenced = 0;
+            lru_remove(dentry);
+            lru_push(dentry);
+        } else if(dentry->refcount == 0 && dentry->children == 0 && dentry->parent) {
+            dcache_free(dentry);
+            stats.evictions++;
+        }
+        dentry = prev;
+    }
+}
+
+// Aloca uma dentry
+static dentry_t *dcache_new(dentry_t *parent, mountpoint_t *mount, const char *name,
+                            size_t len, uint32_t hash, vnode_t *node) {
+    dentry_t *dentry = malloc(sizeof(dentry_t) + len + 1);
+    if(!dentry) {
+        return NULL;
+    }
+    
+    dentry->parent = parent;
+    dentry->hash_next = NULL;
+    dentry->lru_prev = dentry->lru_next = NULL;
+    dentry->mount = mount;
+    dentry->mounted = NULL;
+    dentry->node = node;
+    dentry->hash = hash;
+    dentry->refcount = 0;
+    dentry->children = 0;
+    dentry->referenced = 0;
+    dentry->dead = 0;
+    dentry->anonymous = 0;
+    dentry->name_len = len;
+    memcpy(dentry->name, name, len);
+    dentry->name[len] = '\0';
+    
+    stats.entries++;
+    return dentry;
+}
+
+// Cria a dentry raiz de um ponto de montagem (não fica na tabela hash)
+dentry_t *dcache_alloc_root(mountpoint_t *mount, vnode_t *root) {
+    spin_lock(&dcache_lock);
+    dentry_t *dentry = dcache_new(NULL, mount, "/", 1, 0, root);
+    if(dentry) {
+        dentry->refcount = 1; // Referência do ponto de montagem
+    }
+    spin_unlock(&dcache_lock);
+    return dentry;
+}
+
+// Cria uma dentry fora da árvore para um nó sem nome (a referência
+// devolvida é do chamador)
+dentry_t *dcache_alloc_anon(mountpoint_t *mount, vnode_t *node) {
+    spin_lock(&dcache_lock);
+    dentry_t *dentry = dcache_new(NULL, mount, "", 0, 0, node);
+    if(dentry) {
+        dentry->refcount = 1;
+        dentry->anonymous = 1;
+    }
+    spin_unlock(&dcache_lock);
+    return dentry;
+}
+
+// Procura (pai, nome) na tabela, sem locks
+static dentry_t *dcache_find(dentry_t *parent, const char *name, size_t len, uint32_t hash) {
+    dentry_t *dentry = rcu_dereference(dcache_table[dcache_bucket(parent, hash)]);
+    
+    while(dentry) {
+        if(dentry->parent == parent && dentry->hash == hash &&
+           dentry->name_len == len && memcmp(dentry->name, name, len) == 0) {
+            return dentry;
+        }
+        dentry = rcu_dereference(dentry->hash_next);
+    }
+    return NULL;
+}
+
+// Procura (pai, nome) no cache; entradas negativas também são retornadas.
+// Chamado sob rcu_read_lock(): a LRU não é mexida, só o bit de uso
+// (escrito apenas se ainda não estiver marcado)
+dentry_t *dcache_lookup(dentry_t *parent, const char *name, size_t len, uint32_t hash) {
+    dentry_t *dentry = dcache_find(parent, name, len, hash);
+    dcache_stats_t *local = &cpu_stats[cpu_id()];
+    
+    if(!dentry) {
+        local->misses++;
+        return NULL;
+    }
+    
+    if(!dentry->referenced) {
+        dentry->referenced = 1;
+    }
+    if(rcu_dereference(dentry->node)) {
+        local->hits++;
+    } else {
+        local->negative_hits++;
+    }
+    return dentry;
+}
+
+// Adiciona (pai, nome) -> node ao cache; node == NULL cria entrada negativa.
+// Se outra CPU inseriu o mesmo nome enquanto o sistema de arquivos era
+// consultado, a entrada existente é retornada
+dentry_t *dcache_add(dentry_t *parent, const char *name, size_t len, uint32_t hash, vnode_t *node) {
+    spin_lock(&dcache_lock);
+    dentry_t *dentry = dcache_find(parent, name, len, hash);
+    if(dentry) {
+        spin_unlock(&dcache_lock);
+        return dentry;
+    }
+    
+    // Fixar o pai antes de despejar para que ele não seja escolhido
+    parent->children++;
+    if(stats.entries >= DCACHE_MAX_ENTRIES) {
+        dcache_shrink(DCACHE_MAX_ENTRIES - DCACHE_MAX_ENTRIES / 8);
+    }
+    
+    dentry = dcache_new(parent, parent->mount, name, len, hash, node);
+    if(!dentry) {
+        parent->children--;
+        spin_unlock(&dcache_lock);
+        return NULL;
+    }
+    
+    // Publicar só depois de inicializada
+    uint32_t bucket = dcache_bucket(parent, hash);
+    dentry->hash_next = dcache_table[bucket];
+    rcu_assign_pointer(dcache_table[bucket], dentry);
+    lru_push(dentry);
+    
+    spin_unlock(&dcache_lock);
+    return dentry;
+}
+
+// Transforma uma entrada negativa em positiva (após criar o arquivo)
+void dcache_instantiate(dentry_t *dentry, vnode_t *node) {
+    rcu_assign_pointer(dentry->node, node);
+}
+
+// Diz se alguma dentry da montagem ainda está em uso: referências além
+// da que o ponto de montagem tem na raiz (arquivos abertos, diretórios
+// de trabalho) ou nós mapeados por mmap
+int dcache_mount_busy(mountpoint_t *mount) {
+    int busy = 0;
+    
+    spin_lock(&dcache_lock);
+    if(mount->root && (mount->root->refcount > 1 ||
+                       (mount->root->node && mount->root->node->mmap_count))) {
+        busy = 1;
+    }
+    for(int i = 0; i < DCACHE_BUCKETS && !busy; i++) {
+        for(dentry_t *dentry = dcache_table[i]; dentry; dentry = dentry->hash_next) {
+            if(dentry->mount == mount &&
+               (dentry->refcount || (dentry->node && dentry->node->mmap_count))) {
+                busy = 1;
+                break;
+            }
+        }
+    }
+    spin_unlock(&dcache_lock);
+    return busy;
+}
+
+// Descarta todas as entradas de um ponto de montagem
+void dcache_prune_mount(mountpoint_t *mount) {
+    spin_lock(&dcache_lock);
+    
+    // Filhas antes dos pais: repetir até não haver mais progresso
+    int progress = 1;
+    while(progress) {
+        progress = 0;
+        for(int i = 0; i < DCACHE_BUCKETS; i++) {
+            dentry_t *dentry = dcache_table[i];
+            while(dentry) {
+                dentry_t *next = dentry->hash_next;
+                if(dentry->mount == mount && dentry->children == 0) {
+                    dcache_free(dentry);
+                    progress = 1;
+                }
+                dentry = next;
+            }
+        }
+    }
+    
+    // Por fim a raiz, que não fica na tabela hash
+    if(mount->root) {
+        dcache_free(mount->root);
+    }
+    spin_unlock(&dcache_lock);
+}
+
+// Obtém uma referência para uma dentry
+dentry_t *dget(dentry_t *dentry) {
+    spin_lock(&dcache_lock);
+    if(dentry->refcount++ == 0 && dentry->parent) {
+        lru_remove(dentry);
+    }
+    spin_unlock(&dcache_lock);
+    return dentry;
+}
+
+// Referência para uma entrada achada sob rcu_read_lock(); NULL se ela foi
+// despejada nesse meio tempo
+dentry_t *dget_rcu(dentry_t *dentry) {
+    spin_lock(&dcache_lock);
+    if(dentry->dead) {
+        spin_unlock(&dcache_lock);
+        return NULL;
+    }
+    if(dentry->refcount++ == 0 && dentry->parent) {
+        lru_remove(dentry);
+    }
+    spin_unlock(&dcache_lock);
+    return dentry;
+}
+
+// Libera uma referência; entradas sem uso voltam para a LRU e as
+// anônimas, que ninguém mais acha, são liberadas
+void dput(dentry_t *dentry) {
+    spin_lock(&dcache_lock);
+    if(dentry->refcount > 0 && --dentry->refcount == 0 && !dentry->dead) {
+        if(dentry->anonymous) {
+            dcache_free(dentry);
+        } else if(dentry->parent) {
+            lru_push(dentry);
+        }
+    }
+    spin_unlock(&dcache_lock);
+}
+
+// Retorna as estatísticas do cache (soma dos contadores por CPU)
+const dcache_stats_t *dcache_get_stats() {
+    spin_lock(&dcache_lock);
+    stats_snapshot = stats;
+    for(uint32_t i = 0; i < cpu_count; i++) {
+        stats_snapshot.hits += cpu_stats[i].hits;
+        stats_snapshot.negative_hits += cpu_stats[i].negative_hits;
+        stats_snapshot.misses += cpu_stats[i].misses;
+    }
+    spin_unlock(&dcache_lock);
+    return &stats_snapshot;
+}
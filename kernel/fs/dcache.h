@@ -0,0 +1,56 @@
+#ifndef DCACHE_H
+#define DCACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+#include "rcu.h"
+
+// Entrada do cache de diretórios: associa (pai, nome) a um vnode.
+// A tabela hash é lida sob rcu_read_lock() sem tomar locks; inserção,
+// remoção, LRU e contagem de referências ficam sob dcache_lock e as
+// entradas removidas só são liberadas depois de um período de graça
+typedef struct dentry {
+    struct dentry *parent;
+    struct dentry *hash_next;   // Próxima entrada no mesmo bucket
+    struct dentry *lru_prev;    // Lista LRU de entradas sem referências
+    struct dentry *lru_next;
+    mountpoint_t *mount;
+    mountpoint_t *mounted;      // Sistema montado sobre esta entrada
+    vnode_t *node;              // NULL = entrada negativa (nome não existe)
+    uint32_t hash;              // vfs_name_hash() do nome
+    uint32_t refcount;
+    uint32_t children;          // Filhas presentes no cache
+    uint8_t referenced;         // Usada desde a última passada da LRU
+    uint8_t dead;               // Fora da tabela, esperando o RCU
+    uint8_t anonymous;          // Sem nome (pipes): liberada no último dput
+    uint16_t name_len;
+    rcu_head_t rcu;
+    char name[];
+} dentry_t;
+
+// Estatísticas do cache
+typedef struct dcache_stats {
+    uint32_t hits;
+    uint32_t negative_hits;
+    uint32_t misses;
+    uint32_t evictions;
+    uint32_t entries;
+} dcache_stats_t;
+
+// dcache_lookup() exige rcu_read_lock(); a entrada só vale fora dele com
+// uma referência de dget_rcu()
+void dcache_init(void);
+dentry_t *dcache_alloc_root(mountpoint_t *mount, vnode_t *root);
+dentry_t *dcache_alloc_anon(mountpoint_t *mount, vnode_t *node);
+dentry_t *dcache_lookup(dentry_t *parent, const char *name, size_t len, uint32_t hash);
+dentry_t *dcache_add(dentry_t *parent, const char *name, size_t len, uint32_t hash, vnode_t *node);
+void dcache_instantiate(dentry_t *dentry, vnode_t *node);
+void dcache_prune_mount(mountpoint_t *mount);
+int dcache_mount_busy(mountpoint_t *mount);
+dentry_t *dget(dentry_t *dentry);
+dentry_t *dget_rcu(dentry_t *dentry);
+void dput(dentry_t *dentry);
+const dcache_stats_t *dcache_get_stats(void);
+
+#endif
@@ -0,0 +1,573 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vfs.h"
+#include "block.h"
+#include "pmm.h"
+#include "radix.h"
+
+#define EXT2_MAGIC          0xEF53
+#define EXT2_SUPERBLOCK     1024        // Offset em bytes no dispositivo
+#define EXT2_ROOT_INO       2
+#define EXT2_NDIR_BLOCKS    12
+#define EXT2_IND_BLOCK      12
+#define EXT2_DIND_BLOCK     13
+#define EXT2_TIND_BLOCK     14
+#define EXT2_N_BLOCKS       15
+#define EXT2_PAGE_SIZE      4096
+#define EXT2_PAGE_SECTORS   (EXT2_PAGE_SIZE / BLOCK_SECTOR_SIZE)
+#define EXT2_META_MAX       512         // Páginas de metadados em cache por montagem
+
+// Funcionalidades incompatíveis que sabemos ler
+#define EXT2_FEATURE_INCOMPAT_FILETYPE 0x0002
+#define EXT2_FEATURE_INCOMPAT_FLEX_BG  0x0200
+#define EXT2_FEATURE_INCOMPAT_SUPP (EXT2_FEATURE_INCOMPAT_FILETYPE | EXT2_FEATURE_INCOMPAT_FLEX_BG)
+
+// Superbloco (só os campos usados)
+typedef struct ext2_superblock {
+    uint32_t s_inodes_count;
+    uint32_t s_blocks_count;
+    uint32_t s_r_blocks_count;
+    uint32_t s_free_blocks_count;
+    uint32_t s_free_inodes_count;
+    uint32_t s_first_data_block;
+    uint32_t s_log_block_size;
+    uint32_t s_log_frag_size;
+    uint32_t s_blocks_per_group;
+    uint32_t s_frags_per_group;
+    uint32_t s_inodes_per_group;
+    uint32_t s_mtime;
+    uint32_t s_wtime;
+    uint16_t s_mnt_count;
+    uint16_t s_max_mnt_count;
+    uint16_t s_magic;
+    uint16_t s_state;
+    uint16_t s_errors;
+    uint16_t s_minor_rev_level;
+    uint32_t s_lastcheck;
+    uint32_t s_checkinterval;
+    uint32_t s_creator_os;
+    uint32_t s_rev_level;
+    uint16_t s_def_resuid;
+    uint16_t s_def_resgid;
+    uint32_t s_first_ino;
+    uint16_t s_inode_size;
+    uint16_t s_block_group_nr;
+    uint32_t s_feature_compat;
+    uint32_t s_feature_incompat;
+    uint32_t s_feature_ro_compat;
+} ext2_superblock_t;
+
+// Descritor de grupo de blocos
+typedef struct ext2_group_desc {
+    uint32_t bg_block_bitmap;
+    uint32_t bg_inode_bitmap;
+    uint32_t bg_inode_table;
+    uint16_t bg_free_blocks_count;
+    uint16_t bg_free_inodes_count;
+    uint16_t bg_used_dirs_count;
+    uint16_t bg_pad;
+    uint32_t bg_reserved[3];
+} ext2_group_desc_t;
+
+// Inode no disco (revisão 0; inodes maiores só acrescentam campos)
+typedef struct ext2_inode {
+    uint16_t i_mode;
+    uint16_t i_uid;
+    uint32_t i_size;
+    uint32_t i_atime;
+    uint32_t i_ctime;
+    uint32_t i_mtime;
+    uint32_t i_dtime;
+    uint16_t i_gid;
+    uint16_t i_links_count;
+    uint32_t i_blocks;
+    uint32_t i_flags;
+    uint32_t i_osd1;
+    uint32_t i_block[EXT2_N_BLOCKS];
+    uint32_t i_generation;
+    uint32_t i_file_acl;
+    uint32_t i_size_high;
+    uint32_t i_faddr;
+    uint8_t i_osd2[12];
+} ext2_inode_t;
+
+// Entrada de diretório
+typedef struct ext2_dir_entry {
+    uint32_t inode;         // 0 = entrada livre
+    uint16_t rec_len;
+    uint8_t name_len;
+    uint8_t file_type;
+    char name[];
+} ext2_dir_entry_t;
+
+// Sistema montado
+typedef struct ext2_fs {
+    block_device_t *dev;
+    uint32_t block_size;
+    uint32_t block_shift;           // log2(block_size)
+    uint32_t block_sectors;
+    uint32_t ptrs_per_block;
+    uint32_t blocks_count;
+    uint32_t inodes_per_group;
+    uint32_t inode_size;
+    uint32_t group_count;
+    ext2_group_desc_t *groups;      // Todos os descritores, lidos na montagem
+    radix_tree_t inodes;            // ino -> ext2_node_t
+    radix_tree_t meta;              // Página do dispositivo -> dados
+    uint32_t meta_pages;
+    uint32_t meta_clock;            // Próxima vítima ao despejar
+} ext2_fs_t;
+
+// Nó do ext2; os campos do inode necessários ficam copiados aqui
+typedef struct ext2_node {
+    vnode_t vnode;                  // Precisa ser o primeiro campo
+    ext2_fs_t *fs;
+    uint32_t block[EXT2_N_BLOCKS];
+    uint32_t open_count;
+    
+    // Última sequência contígua resolvida pelo mapa de blocos: leituras
+    // sequenciais não voltam a percorrer os blocos indiretos
+    uint32_t map_logical;
+    uint32_t map_physical;
+    uint32_t map_count;             // 0 = vazia
+} ext2_node_t;
+
+#define EXT2_NODE(v) ((ext2_node_t*)(v))
+
+// Retorna os dados de um bloco de metadados (diretórios, tabelas de
+// inodes e blocos indiretos), lendo a página de 4KB que o contém para o
+// cache. O ponteiro vale até a próxima chamada
+static uint8_t *ext2_bread(ext2_fs_t *fs, uint32_t block) {
+    if(block == 0 || block >= fs->blocks_count) {
+        return NULL;
+    }
+    
+    uint32_t page_shift = 12 - fs->block_shift;     // Blocos por página (log2)
+    uint32_t index = block >> page_shift;
+    uint32_t offset = (block & ((1u << page_shift) - 1)) << fs->block_shift;
+    
+    uint8_t *page = radix_lookup(&fs->meta, index);
+    if(page) {
+        return page + offset;
+    }
+    
+    // Cache cheio: despejar a próxima página em rodízio
+    if(fs->meta_pages >= EXT2_META_MAX) {
+        uint32_t victim;
+        void *old = radix_next(&fs->meta, fs->meta_clock, &victim);
+        if(!old) {
+            old = radix_next(&fs->meta, 0, &victim);
+        }
+        radix_delete(&fs->meta, victim);
+        pmm_free_page(old);
+        fs->meta_pages--;
+        fs->meta_clock = victim + 1;
+    }
+    
+    page = pmm_alloc_page();
+    if(!page) {
+        return NULL;
+    }
+    
+    // A última página pode passar do fim do dispositivo
+    uint64_t sector = (uint64_t)index * EXT2_PAGE_SECTORS;
+    uint32_t count = EXT2_PAGE_SECTORS;
+    if(sector + count > fs->dev->sector_count) {
+        count = (uint32_t)(fs->dev->sector_count - sector);
+        memset(page, 0, EXT2_PAGE_SIZE);
+    }
+    
+    if(block_read(fs->dev, sector, count, page) != 0 ||
+       radix_insert(&fs->meta, index, page) != 0) {
+        pmm_free_page(page);
+        return NULL;
+    }
+    fs->meta_pages++;
+    
+    return page + offset;
+}
+
+// Carrega um inode; cada inode tem um único nó enquanto montado
+static ext2_node_t *ext2_iget(ext2_fs_t *fs, uint32_t ino) {
+    ext2_node_t *node = radix_lookup(&fs->inodes, ino);
+    if(node) {
+        return node;
+    }
+    
+    uint32_t group = (ino - 1) / fs->inodes_per_group;
+    if(ino == 0 || group >= fs->group_count) {
+        return NULL;
+    }
+    
+    // Posição na tabela de inodes do grupo
+    uint32_t offset = ((ino - 1) % fs->inodes_per_group) * fs->inode_size;
+    uint32_t block = fs->groups[group].bg_inode_table + (offset >> fs->block_shift);
+    uint8_t *data = ext2_bread(fs, block);
+    if(!data) {
+        return NULL;
+    }
+    ext2_inode_t *raw = (ext2_inode_t*)(data + (offset & (fs->block_size - 1)));
+    
+    node = malloc(sizeof(ext2_node_t));
+    if(!node) {
+        return NULL;
+    }
+    
+    node->vnode.ino = ino;
+    node->vnode.mode = raw->i_mode;
+    node->vnode.size = raw->i_size;
+    node->vnode.mapping = NULL;
+    node->vnode.mmap_count = 0;
+    node->fs = fs;
+    memcpy(node->block, raw->i_block, sizeof(node->block));
+    node->open_count = 0;
+    node->map_count = 0;
+    
+    if(radix_insert(&fs->inodes, ino, node) != 0) {
+        free(node);
+        return NULL;
+    }
+    
+    return node;
+}
+
+// Traduz um bloco lógico do arquivo para o bloco no disco (0 = buraco).
+// run recebe quantos blocos seguintes são contíguos no disco
+static int ext2_bmap(ext2_node_t *node, uint32_t logical, uint32_t *physical, uint32_t *run) {
+    ext2_fs_t *fs = node->fs;
+    
+    // Dentro da última sequência resolvida
+    if(node->map_count && logical >= node->map_logical &&
+       logical - node->map_logical < node->map_count) {
+        uint32_t delta = logical - node->map_logical;
+        *physical = node->map_physical + delta;
+        *run = node->map_count - delta;
+        return 0;
+    }
+    
+    // Descer pelos níveis até a tabela de ponteiros que contém logical
+    uint32_t shift = fs->block_shift - 2;   // log2(ponteiros por bloco)
+    const uint32_t *table = node->block;
+    uint32_t length = EXT2_NDIR_BLOCKS;
+    uint32_t index = logical;
+    
+    if(logical >= EXT2_NDIR_BLOCKS) {
+        uint32_t rest = logical - EXT2_NDIR_BLOCKS;
+        uint32_t levels;
+        uint32_t root;
+        
+        if(rest < fs->ptrs_per_block) {
+            levels = 1;
+            root = node->block[EXT2_IND_BLOCK];
+        } else if((rest -= fs->ptrs_per_block) < (1u << (2 * shift))) {
+            levels = 2;
+            root = node->block[EXT2_DIND_BLOCK];
+        } else {
+            rest -= 1u << (2 * shift);
+            levels = 3;
+            root = node->block[EXT2_TIND_BLOCK];
+        }
+        
+        uint32_t block = root;
+        while(levels > 0) {
+            if(block == 0) {
+                *physical = 0; // Buraco em um nível indireto
+                *run = 1;
+                return 0;
+            }
+            
+            table = (const uint32_t*)ext2_bread(fs, block);
+            if(!table) {
+                return -1;
+            }
+            
+            levels--;
+            index = (rest >> (levels * shift)) & (fs->ptrs_per_block - 1);
+            block = table[index];
+        }
+        length = fs->ptrs_per_block;
+    }
+    
+    *physical = table[index];
+    *run = 1;
+    if(*physical == 0) {
+        return 0;
+    }
+    
+    // Estender enquanto os ponteiros da mesma tabela forem contíguos
+    while(index + *run < length && table[index + *run] == *physical + *run) {
+        (*run)++;
+    }
+    
+    node->map_logical = logical;
+    node->map_physical = *physical;
+    node->map_count = *run;
+    return 0;
+}
+
+// Lê uma página do arquivo direto para a página do cache; blocos
+// contíguos viram uma única leitura no dispositivo
+static int ext2_readpage(vnode_t *vnode, uint32_t index, void *page) {
+    ext2_node_t *node = EXT2_NODE(vnode);
+    ext2_fs_t *fs = node->fs;
+    
+    uint32_t start = index * EXT2_PAGE_SIZE;
+    if(start >= vnode->size) {
+        return 0;
+    }
+    uint32_t bytes = vnode->size - start;
+    if(bytes > EXT2_PAGE_SIZE) {
+        bytes = EXT2_PAGE_SIZE;
+    }
+    
+    uint32_t count = (bytes + fs->block_size - 1) >> fs->block_shift;
+    uint32_t logical = start >> fs->block_shift;
+    uint8_t *dst = page;
+    
+    for(uint32_t i = 0; i < count; ) {
+        uint32_t physical;
+        uint32_t run;
+        if(ext2_bmap(node, logical + i, &physical, &run) != 0) {
+            return -1;
+        }
+        if(run > count - i) {
+            run = count - i;
+        }
+        
+        if(physical == 0) {
+            memset(dst + (i << fs->block_shift), 0, run << fs->block_shift);
+        } else if(block_read(fs->dev, (uint64_t)physical * fs->block_sectors,
+                             run * fs->block_sectors, dst + (i << fs->block_shift)) != 0) {
+            return -1;
+        }
+        i += run;
+    }
+    
+    return bytes;
+}
+
+// Retorna a entrada de diretório em position (NULL no fim ou se corrompida);
+// entradas livres também são retornadas
+static ext2_dir_entry_t *ext2_dir_entry(ext2_node_t *dir, uint32_t position) {
+    ext2_fs_t *fs = dir->fs;
+    if(position >= dir->vnode.size) {
+        return NULL;
+    }
+    
+    uint32_t physical;
+    uint32_t run;
+    if(ext2_bmap(dir, position >> fs->block_shift, &physical, &run) != 0 || physical == 0) {
+        return NULL;
+    }
+    
+    uint8_t *block = ext2_bread(fs, physical);
+    if(!block) {
+        return NULL;
+    }
+    
+    uint32_t offset = position & (fs->block_size - 1);
+    ext2_dir_entry_t *entry = (ext2_dir_entry_t*)(block + offset);
+    if(entry->rec_len < 8 || (entry->rec_len & 3) || offset + entry->rec_len > fs->block_size ||
+       entry->name_len + 8u > entry->rec_len) {
+        return NULL;
+    }
+    
+    return entry;
+}
+
+// Procura um nome percorrendo as entradas do diretório
+static int ext2_lookup(vnode_t *vnode, const char *name, size_t len, vnode_t **result) {
+    ext2_node_t *dir = EXT2_NODE(vnode);
+    if(!S_ISDIR(vnode->mode) || len > VFS_NAME_MAX) {
+        return -1;
+    }
+    
+    uint32_t position = 0;
+    ext2_dir_entry_t *entry;
+    while((entry = ext2_dir_entry(dir, position)) != NULL) {
+        if(entry->inode && entry->name_len == len && memcmp(entry->name, name, len) == 0) {
+            ext2_node_t *node = ext2_iget(dir->fs, entry->inode);
+            if(!node) {
+                return -1;
+            }
+            *result = &node->vnode;
+            return 0;
+        }
+        position += entry->rec_len;
+    }
+    
+    return -1;
+}
+
+// Próxima entrada a partir de *position; 1 = entrada, 0 = fim
+static int ext2_readdir(vnode_t *vnode, uint32_t *position, struct dirent *dirent) {
+    ext2_node_t *dir = EXT2_NODE(vnode);
+    if(!S_ISDIR(vnode->mode)) {
+        return -1;
+    }
+    
+    ext2_dir_entry_t *entry;
+    while((entry = ext2_dir_entry(dir, *position)) != NULL) {
+        *position += entry->rec_len;
+        if(entry->inode) {
+            dirent->d_ino = entry->inode;
+            memcpy(dirent->d_name, entry->name, entry->name_len);
+            dirent->d_name[entry->name_len] = '\0';
+            return 1;
+        }
+    }
+    
+    return *position >= vnode->size ? 0 : -1;
+}
+
+// Abre um arquivo ou diretório, somente para leitura
+static int ext2_open(vnode_t *vnode, int flags) {
+    if(flags & (O_WRONLY | O_RDWR)) {
+        return -1;
+    }
+    
+    EXT2_NODE(vnode)->open_count++;
+    return 0;
+}
+
+// Fecha um arquivo; o último fechamento descarta o mapa de blocos
+static int ext2_close(vnode_t *vnode) {
+    ext2_node_t *node = EXT2_NODE(vnode);
+    if(node->open_count > 0 && --node->open_count == 0) {
+        node->map_count = 0;
+    }
+    
+    return 0;
+}
+
+// Retorna informações sobre um nó
+static int ext2_stat(vnode_t *node, struct stat *st) {
+    st->st_ino = node->ino;
+    st->st_mode = node->mode;
+    st->st_size = node->size;
+    return 0;
+}
+
+// Libera o cache de metadados, os nós e a montagem
+static void ext2_free_fs(ext2_fs_t *fs) {
+    uint32_t index;
+    void *item;
+    
+    while((item = radix_next(&fs->meta, 0, &index)) != NULL) {
+        radix_delete(&fs->meta, index);
+        pmm_free_page(item);
+    }
+    while((item = radix_next(&fs->inodes, 0, &index)) != NULL) {
+        radix_delete(&fs->inodes, index);
+        free(item);
+    }
+    
+    free(fs->groups);
+    free(fs);
+}
+
+// Monta um dispositivo de bloco (ex.: "hda"); a raiz é o inode 2
+static int ext2_mount(struct filesystem *fs_ops, const char *device, vnode_t **root) {
+    (void)fs_ops;
+    
+    block_device_t *dev = device ? block_get(device) : NULL;
+    if(!dev) {
+        return -1;
+    }
+    
+    // O superbloco fica nos primeiros 4KB
+    uint8_t *page = pmm_alloc_page();
+    if(!page) {
+        return -1;
+    }
+    if(block_read(dev, 0, EXT2_PAGE_SECTORS, page) != 0) {
+        pmm_free_page(page);
+        return -1;
+    }
+    
+    ext2_superblock_t sb;
+    memcpy(&sb, page + EXT2_SUPERBLOCK, sizeof(sb));
+    pmm_free_page(page);
+    
+    // Blocos de 1KB a 4KB; blocos maiores que uma página não são suportados
+    if(sb.s_magic != EXT2_MAGIC || sb.s_log_block_size > 2 ||
+       sb.s_blocks_per_group == 0 || sb.s_inodes_per_group == 0) {
+        return -1;
+    }
+    if(sb.s_rev_level > 0 && (sb.s_feature_incompat & ~EXT2_FEATURE_INCOMPAT_SUPP)) {
+        return -1; // Extents, compressão, journal pendente...
+    }
+    
+    ext2_fs_t *fs = malloc(sizeof(ext2_fs_t));
+    if(!fs) {
+        return -1;
+    }
+    
+    fs->dev = dev;
+    fs->block_shift = 10 + sb.s_log_block_size;
+    fs->block_size = 1u << fs->block_shift;
+    fs->block_sectors = fs->block_size / BLOCK_SECTOR_SIZE;
+    fs->ptrs_per_block = fs->block_size / sizeof(uint32_t);
+    fs->blocks_count = sb.s_blocks_count;
+    fs->inodes_per_group = sb.s_inodes_per_group;
+    fs->inode_size = sb.s_rev_level > 0 ? sb.s_inode_size : sizeof(ext2_inode_t);
+    fs->group_count = (sb.s_blocks_count - sb.s_first_data_block + sb.s_blocks_per_group - 1) /
+                      sb.s_blocks_per_group;
+    radix_init(&fs->inodes);
+    radix_init(&fs->meta);
+    fs->meta_pages = 0;
+    fs->meta_clock = 0;
+    fs->groups = NULL;
+    
+    if(fs->inode_size < sizeof(ext2_inode_t) || fs->inode_size > fs->block_size ||
+       (fs->inode_size & (fs->inode_size - 1))) {
+        ext2_free_fs(fs);
+        return -1;
+    }
+    
+    // Copiar todos os descritores de grupo (seguem o superbloco)
+    uint32_t per_block = fs->block_size / sizeof(ext2_group_desc_t);
+    fs->groups = malloc(fs->group_count * sizeof(ext2_group_desc_t));
+    if(!fs->groups) {
+        ext2_free_fs(fs);
+        return -1;
+    }
+    for(uint32_t i = 0; i < fs->group_count; i += per_block) {
+        uint8_t *data = ext2_bread(fs, sb.s_first_data_block + 1 + i / per_block);
+        if(!data) {
+            ext2_free_fs(fs);
+            return -1;
+        }
+        uint32_t count = fs->group_count - i < per_block ? fs->group_count - i : per_block;
+        memcpy(&fs->groups[i], data, count * sizeof(ext2_group_desc_t));
+    }
+    
+    ext2_node_t *node = ext2_iget(fs, EXT2_ROOT_INO);
+    if(!node || !S_ISDIR(node->vnode.mode)) {
+        ext2_free_fs(fs);
+        return -1;
+    }
+    
+    *root = &node->vnode;
+    return 0;
+}
+
+// Desmonta: todos os nós e páginas de metadados são liberados
+static int ext2_unmount(vnode_t *root) {
+    ext2_free_fs(EXT2_NODE(root)->fs);
+    return 0;
+}
+
+// Operações do ext2 (somente leitura; dados pelo cache de páginas)
+filesystem_t ext2_operations = {
+    .name = "ext2",
+    .mount = ext2_mount,
+    .unmount = ext2_unmount,
+    .lookup = ext2_lookup,
+    .open = ext2_open,
+    .close = ext2_close,
+    .stat = ext2_stat,
+    .readdir = ext2_readdir,
+    .readpage = ext2_readpage
+};
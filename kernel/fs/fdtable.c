@@ -0,0 +1,182 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "fdtable.h"
+
+#define FD_TABLE_INITIAL 32
+#define FD_TABLE_MAX (1 << 20)
+
+// Cria uma tabela vazia
+fd_table_t *fd_table_create() {
+    fd_table_t *table = malloc(sizeof(fd_table_t));
+    if(!table) {
+        return NULL;
+    }
+    
+    table->files = malloc(FD_TABLE_INITIAL * sizeof(struct file*));
+    table->bitmap = malloc(FD_TABLE_INITIAL / 32 * sizeof(uint32_t));
+    if(!table->files || !table->bitmap) {
+        free(table->files);
+        free(table->bitmap);
+        free(table);
+        return NULL;
+    }
+    
+    memset(table->files, 0, FD_TABLE_INITIAL * sizeof(struct file*));
+    memset(table->bitmap, 0, FD_TABLE_INITIAL / 32 * sizeof(uint32_t));
+    table->capacity = FD_TABLE_INITIAL;
+    table->next_fd = 0;
+    table->count = 0;
+    spin_lock_init(&table->lock, NULL);
+    
+    return table;
+}
+
+// Fecha todos os descritores e libera a tabela
+void fd_table_destroy(fd_table_t *table, void (*release)(struct file *file)) {
+    for(uint32_t fd = 0; fd < table->capacity; fd++) {
+        if(table->files[fd]) {
+            release(table->files[fd]);
+        }
+    }
+    
+    free(table->files);
+    free(table->bitmap);
+    free(table);
+}
+
+// Dobra a capacidade até que fd caiba
+static int fd_table_grow(fd_table_t *table, uint32_t fd) {
+    uint32_t capacity = table->capacity;
+    while(capacity <= fd) {
+        capacity *= 2;
+    }
+    if(capacity > FD_TABLE_MAX) {
+        return -1;
+    }
+    
+    struct file **files = realloc(table->files, capacity * sizeof(struct file*));
+    if(!files) {
+        return -1;
+    }
+    table->files = files;
+    
+    uint32_t *bitmap = realloc(table->bitmap, capacity / 32 * sizeof(uint32_t));
+    if(!bitmap) {
+        return -1;
+    }
+    table->bitmap = bitmap;
+    
+    memset(files + table->capacity, 0, (capacity - table->capacity) * sizeof(struct file*));
+    memset(bitmap + table->capacity / 32, 0, (capacity - table->capacity) / 32 * sizeof(uint32_t));
+    table->capacity = capacity;
+    
+    return 0;
+}
+
+// Encontra o primeiro bit zero a partir de start (capacity se não houver)
+static uint32_t fd_find_zero(fd_table_t *table, uint32_t start) {
+    uint32_t words = table->capacity / 32;
+    
+    for(uint32_t word = start / 32; word < words; word++) {
+        uint32_t free_bits = ~table->bitmap[word];
+        
+        // Ignorar bits abaixo de start na primeira palavra
+        if(word == start / 32) {
+            free_bits &= ~0u << (start % 32);
+        }
+        
+        if(free_bits) {
+            return word * 32 + __builtin_ctz(free_bits);
+        }
+    }
+    
+    return table->capacity;
+}
+
+// Ocupa um descritor
+static void fd_set(fd_table_t *table, uint32_t fd, struct file *file) {
+    table->bitmap[fd / 32] |= 1u << (fd % 32);
+    table->files[fd] = file;
+    table->count++;
+}
+
+// Aloca o menor descritor livre para file
+int fd_alloc(fd_table_t *table, struct file *file) {
+    spin_lock(&table->lock);
+    uint32_t fd = fd_find_zero(table, table->next_fd);
+    
+    if(fd >= table->capacity && fd_table_grow(table, fd) != 0) {
+        spin_unlock(&table->lock);
+        return -1; // Limite de descritores
+    }
+    
+    fd_set(table, fd, file);
+    table->next_fd = fd + 1;
+    spin_unlock(&table->lock);
+    return (int)fd;
+}
+
+// Instala file em um descritor específico (usado por dup2)
+// Retorna -1 se o descritor já estiver ocupado
+int fd_install(fd_table_t *table, int fd, struct file *file) {
+    if(fd < 0) {
+        return -1;
+    }
+    
+    spin_lock(&table->lock);
+    if((uint32_t)fd >= table->capacity && fd_table_grow(table, fd) != 0) {
+        spin_unlock(&table->lock);
+        return -1;
+    }
+    
+    if(table->files[fd]) {
+        spin_unlock(&table->lock);
+        return -1;
+    }
+    
+    fd_set(table, fd, file);
+    if((uint32_t)fd == table->next_fd) {
+        table->next_fd = fd + 1;
+    }
+    spin_unlock(&table->lock);
+    return fd;
+}
+
+// Arquivo de um descritor (NULL se inválido); chamado com o lock
+static struct file *fd_lookup(fd_table_t *table, int fd) {
+    if(fd < 0 || (uint32_t)fd >= table->capacity) {
+        return NULL;
+    }
+    
+    return table->files[fd];
+}
+
+// Retorna o arquivo de um descritor (NULL se inválido)
+struct file *fd_get(fd_table_t *table, int fd) {
+    spin_lock(&table->lock);
+    struct file *file = fd_lookup(table, fd);
+    spin_unlock(&table->lock);
+    return file;
+}
+
+// Libera um descritor e retorna o arquivo que ele referenciava
+struct file *fd_remove(fd_table_t *table, int fd) {
+    spin_lock(&table->lock);
+    struct file *file = fd_lookup(table, fd);
+    if(!file) {
+        spin_unlock(&table->lock);
+        return NULL;
+    }
+    
+    table->bitmap[fd / 32] &= ~(1u << (fd % 32));
+    table->files[fd] = NULL;
+    table->count--;
+    
+    if((uint32_t)fd < table->next_fd) {
+        table->next_fd = fd;
+    }
+    
+    spin_unlock(&table->lock);
+    return file;
+}
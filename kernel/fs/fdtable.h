@@ -0,0 +1,27 @@
+#ifndef FDTABLE_H
+#define FDTABLE_H
+
+#include <stdint.h>
+#include "spinlock.h"
+
+struct file;
+
+// Tabela de descritores de um processo; cresce sob demanda. io_ring usa
+// a tabela de outro processo, então todo acesso passa por lock
+typedef struct fd_table {
+    struct file **files;    // fd -> arquivo aberto (compartilhado via dup)
+    uint32_t *bitmap;       // 1 = descritor em uso
+    uint32_t capacity;      // Sempre múltiplo de 32
+    uint32_t next_fd;       // Nenhum descritor livre abaixo deste
+    uint32_t count;
+    spinlock_t lock;
+} fd_table_t;
+
+fd_table_t *fd_table_create(void);
+void fd_table_destroy(fd_table_t *table, void (*release)(struct file *file));
+int fd_alloc(fd_table_t *table, struct file *file);
+int fd_install(fd_table_t *table, int fd, struct file *file);
+struct file *fd_get(fd_table_t *table, int fd);
+struct file *fd_remove(fd_table_t *table, int fd);
+
+#endif
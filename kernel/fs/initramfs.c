@@ -0,0 +1,123 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vfs.h"
+#include "initramfs.h"
+#include "console.h"
+
+// Formato cpio "newc": cabeçalho ASCII de 110 bytes, nome e dados
+// alinhados a 4 bytes, terminado pela entrada "TRAILER!!!"
+#define CPIO_HEADER_SIZE 110
+#define CPIO_TRAILER     "TRAILER!!!"
+
+// Offsets dos campos (8 dígitos hexadecimais cada)
+#define CPIO_MODE     14
+#define CPIO_FILESIZE 54
+#define CPIO_NAMESIZE 94
+
+static inline uint32_t cpio_align(uint32_t offset) {
+    return (offset + 3) & ~3u;
+}
+
+// Lê um campo hexadecimal; retorna -1 se houver dígito inválido
+static int cpio_field(const char *field, uint32_t *value) {
+    uint32_t result = 0;
+    for(int i = 0; i < 8; i++) {
+        char c = field[i];
+        uint32_t digit;
+        if(c >= '0' && c <= '9') {
+            digit = c - '0';
+        } else if(c >= 'a' && c <= 'f') {
+            digit = c - 'a' + 10;
+        } else if(c >= 'A' && c <= 'F') {
+            digit = c - 'A' + 10;
+        } else {
+            return -1;
+        }
+        result = (result << 4) | digit;
+    }
+    
+    *value = result;
+    return 0;
+}
+
+// Cria diretórios e arquivos do arquivo cpio. Os arquivos não são
+// copiados: o ramfs lê direto do arquivo até a primeira escrita, então
+// archive precisa continuar na memória. Retorna o número de entradas
+int initramfs_unpack(const void *archive, uint32_t size) {
+    const char *base = archive;
+    uint32_t offset = 0;
+    int entries = 0;
+    
+    // Os arquivos vão para o ramfs montado em "/", não para outras instâncias
+    vnode_t *root = vfs_root_node("ramfs");
+    if(!root) {
+        return -1;
+    }
+    
+    while(offset + CPIO_HEADER_SIZE <= size) {
+        const char *header = base + offset;
+        uint32_t mode;
+        uint32_t file_size;
+        uint32_t name_size;
+        
+        if(memcmp(header, "070701", 6) != 0 && memcmp(header, "070702", 6) != 0) {
+            return -1; // Não é newc (070702 = newc com checksum)
+        }
+        if(cpio_field(header + CPIO_MODE, &mode) != 0 ||
+           cpio_field(header + CPIO_FILESIZE, &file_size) != 0 ||
+           cpio_field(header + CPIO_NAMESIZE, &name_size) != 0 || name_size == 0) {
+            return -1;
+        }
+        
+        // Nome (com o '\0' contado em name_size) e dados
+        uint32_t name = offset + CPIO_HEADER_SIZE;
+        uint32_t data = cpio_align(name + name_size);
+        if(name_size > size - name || data > size || file_size > size - data) {
+            return -1; // Truncado
+        }
+        
+        const char *path = base + name;
+        uint32_t len = name_size - 1;
+        if(len == sizeof(CPIO_TRAILER) - 1 && memcmp(path, CPIO_TRAILER, len) == 0) {
+            break;
+        }
+        
+        // Links simbólicos e dispositivos não existem no ramfs
+        if(S_ISDIR(mode) || S_ISREG(mode)) {
+            if(ramfs_create_image(root, path, len, mode & S_IFMT, base + data, file_size) != 0) {
+                console_write("initramfs: falha em ");
+                console_write(path);
+                console_write("\n");
+            } else {
+                entries++;
+            }
+        }
+        
+        offset = cpio_align(data + file_size);
+    }
+    
+    return entries;
+}
+
+// Procura o initramfs entre os módulos do bootloader (o primeiro)
+void initramfs_init(multiboot_info_t *mbi) {
+    if(!(mbi->flags & MULTIBOOT_INFO_MODS) || mbi->mods_count == 0) {
+        return;
+    }
+    
+    multiboot_module_t *module = (multiboot_module_t*)(uintptr_t)mbi->mods_addr;
+    uint32_t size = module->mod_end - module->mod_start;
+    
+    int entries = initramfs_unpack((const void*)(uintptr_t)module->mod_start, size);
+    if(entries < 0) {
+        console_write("initramfs: arquivo cpio invalido\n");
+        return;
+    }
+    
+    console_write("initramfs: ");
+    console_write_dec(entries);
+    console_write(" entradas, ");
+    console_write_dec(size / 1024);
+    console_write(" KB\n");
+}
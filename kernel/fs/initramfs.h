@@ -0,0 +1,11 @@
+#ifndef INITRAMFS_H
+#define INITRAMFS_H
+
+#include <stdint.h>
+#include "multiboot.h"
+
+// Desempacota o primeiro módulo Multiboot (cpio newc) no ramfs da raiz
+void initramfs_init(multiboot_info_t *mbi);
+int initramfs_unpack(const void *archive, uint32_t size);
+
+#endif
@@ -0,0 +1,369 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vfs.h"
+#include "io_ring.h"
+#include "scheduler.h"
+#include "pmm.h"
+#include "spinlock.h"
+
+#define IORING_SQPOLL_IDLE 1000     // Voltas sem trabalho antes de dormir
+#define IORING_ALIGN 64
+
+// Os índices são produzidos e consumidos por processos diferentes; a
+// entrada precisa estar escrita antes de o índice avançar
+#define io_ring_barrier() asm volatile("" : : : "memory")
+
+// Anéis ativos, atendidos por um único worker. rings_lock protege a
+// lista e as marcas busy; ele desliga interrupções (irqsave)
+static io_ring_t *rings = NULL;
+static spinlock_t rings_lock;
+static int rings_lock_ready = 0;
+static volatile int32_t worker_slot = -1;
+static volatile int worker_sleeping = 0;
+static int worker_started = 0;
+
+// Executa um pedido com a tabela de descritores do dono do anel
+static int32_t io_ring_execute(io_ring_t *ring, const io_sqe_t *sqe) {
+    switch(sqe->opcode) {
+        case IORING_OP_NOP:
+            return 0;
+        case IORING_OP_READ:
+            return vfs_read_files(ring->files, sqe->fd, sqe->buffer, sqe->length, sqe->offset);
+        case IORING_OP_WRITE:
+            return vfs_write_files(ring->files, sqe->fd, sqe->buffer, sqe->length, sqe->offset);
+        case IORING_OP_OPEN:
+            return vfs_open_files(ring->files, sqe->buffer, sqe->open_flags);
+        case IORING_OP_CLOSE:
+            return vfs_close_files(ring->files, sqe->fd);
+        case IORING_OP_FSYNC:
+            return vfs_fsync_files(ring->files, sqe->fd);
+        default:
+            return -1;
+    }
+}
+
+// Há submissões que podem ser consumidas (e espaço para concluí-las)
+static int io_ring_ready(io_ring_t *ring) {
+    return ring->sq_head != ring->sq_tail && ring->cq_tail - ring->cq_head <= ring->cq_mask;
+}
+
+// Consome todas as submissões publicadas de um anel; retorna quantas
+static uint32_t io_ring_process(io_ring_t *ring) {
+    uint32_t done = 0;
+    
+    while(io_ring_ready(ring)) {
+        io_ring_barrier();
+        
+        // Copiar: a aplicação pode reusar a entrada assim que sq_head avança
+        io_sqe_t sqe = ring->sqes[ring->sq_head & ring->sq_mask];
+        ring->sq_head++;
+        
+        int32_t result = io_ring_execute(ring, &sqe);
+        
+        io_cqe_t *cqe = &ring->cqes[ring->cq_tail & ring->cq_mask];
+        cqe->user_data = sqe.user_data;
+        cqe->result = result;
+        cqe->flags = 0;
+        io_ring_barrier();
+        ring->cq_tail++;
+        done++;
+        
+        // Acordar quem espera assim que o alvo for atingido
+        int32_t waiter = ring->waiter;
+        if(waiter >= 0 && ring->cq_tail - ring->cq_head >= ring->wait_target) {
+            scheduler_wake((uint32_t)waiter);
+        }
+    }
+    
+    ring->completed += done;
+    return done;
+}
+
+static uintptr_t rings_lock_acquire() {
+    if(!rings_lock_ready) {
+        spin_lock_init(&rings_lock, "io_ring");
+        rings_lock_ready = 1;
+    }
+    return spin_lock_irqsave(&rings_lock);
+}
+
+static int io_ring_pending() {
+    int pending = 0;
+    uintptr_t flags = rings_lock_acquire();
+    for(io_ring_t *ring = rings; ring && !pending; ring = ring->next) {
+        pending = io_ring_ready(ring);
+    }
+    spin_unlock_irqrestore(&rings_lock, flags);
+    return pending;
+}
+
+// Marca (ou limpa) o pedido de io_ring_enter nos anéis com SQPOLL
+static void io_ring_set_need_wakeup(int need) {
+    uintptr_t flags = rings_lock_acquire();
+    for(io_ring_t *ring = rings; ring; ring = ring->next) {
+        if(!(ring->setup_flags & IORING_SETUP_SQPOLL)) {
+            continue;
+        }
+        if(need) {
+            ring->sq_flags |= IORING_SQ_NEED_WAKEUP;
+        } else {
+            ring->sq_flags &= ~IORING_SQ_NEED_WAKEUP;
+        }
+    }
+    spin_unlock_irqrestore(&rings_lock, flags);
+}
+
+// Worker: atende todos os anéis; com SQPOLL continua procurando
+// submissões por um tempo antes de dormir, e a aplicação só precisa de
+// io_ring_enter quando vê IORING_SQ_NEED_WAKEUP
+static void io_ring_worker() {
+    worker_slot = (int32_t)scheduler_current();
+    uint32_t idle = 0;
+    
+    for(;;) {
+        uint32_t done = 0;
+        int polling = 0;
+        
+        // O worker é preemptível: o anel em que ele está fica marcado como
+        // ocupado, e a passagem para o próximo é feita sob rings_lock,
+        // para que io_ring_destroy não libere nenhum dos dois
+        uintptr_t flags = rings_lock_acquire();
+        io_ring_t *ring = rings;
+        if(ring) {
+            ring->busy = 1;
+        }
+        spin_unlock_irqrestore(&rings_lock, flags);
+        
+        while(ring) {
+            done += io_ring_process(ring);
+            polling |= ring->setup_flags & IORING_SETUP_SQPOLL;
+            
+            flags = rings_lock_acquire();
+            io_ring_t *next = ring->next;
+            if(next) {
+                next->busy = 1;
+            }
+            ring->busy = 0;
+            spin_unlock_irqrestore(&rings_lock, flags);
+            ring = next;
+        }
+        
+        if(done) {
+            idle = 0;
+            continue;
+        }
+        
+        // Ceder a CPU para as aplicações produzirem mais
+        if(polling && idle++ < IORING_SQPOLL_IDLE) {
+            scheduler_schedule();
+            continue;
+        }
+        idle = 0;
+        
+        io_ring_set_need_wakeup(1);
+        io_ring_barrier();
+        
+        flags = irq_save();
+        if(!io_ring_pending()) {
+            worker_sleeping = 1;
+            scheduler_block();
+            
+            // Nenhum outro processo pronto: esperar pela próxima interrupção
+            if(!io_ring_pending()) {
+                asm volatile("sti; hlt; cli");
+            }
+            worker_sleeping = 0;
+        }
+        irq_restore(flags);
+        
+        io_ring_set_need_wakeup(0);
+    }
+}
+
+// Cria um par de anéis para o processo atual; entries é arredondado
+// para potência de 2 e a fila de conclusão tem o dobro
+io_ring_t *io_ring_setup(uint32_t entries, uint32_t flags) {
+    if(entries == 0 || entries > IORING_MAX_ENTRIES) {
+        return NULL;
+    }
+    
+    uint32_t sq_size = 1;
+    while(sq_size < entries) {
+        sq_size <<= 1;
+    }
+    uint32_t cq_size = sq_size * 2;
+    
+    struct fd_table *files = scheduler_current_files();
+    if(!files) {
+        return NULL;
+    }
+    
+    // Cabeçalho e anéis em páginas físicas contíguas, para que possam ser
+    // mapeados no processo
+    uint32_t sq_offset = (sizeof(io_ring_t) + IORING_ALIGN - 1) & ~(IORING_ALIGN - 1);
+    uint32_t cq_offset = sq_offset + sq_size * sizeof(io_sqe_t);
+    uint32_t total = cq_offset + cq_size * sizeof(io_cqe_t);
+    uint32_t pages = (total + 4095) / 4096;
+    
+    uint8_t *mem = pmm_alloc_contiguous(pages);
+    if(!mem) {
+        return NULL;
+    }
+    memset(mem, 0, pages * 4096);
+    
+    io_ring_t *ring = (io_ring_t*)mem;
+    ring->sq_mask = sq_size - 1;
+    ring->cq_mask = cq_size - 1;
+    ring->sqes = (io_sqe_t*)(mem + sq_offset);
+    ring->cqes = (io_cqe_t*)(mem + cq_offset);
+    ring->setup_flags = flags;
+    ring->files = files;
+    ring->waiter = -1;
+    ring->mem = mem;
+    ring->pages = pages;
+    
+    // Sem o worker, io_ring_enter executa os pedidos na hora
+    if(!worker_started) {
+        worker_started = process_create(io_ring_worker, 0) != 0;
+    }
+    
+    uintptr_t irq_flags = rings_lock_acquire();
+    ring->next = rings;
+    rings = ring;
+    spin_unlock_irqrestore(&rings_lock, irq_flags);
+    
+    if(worker_sleeping) {
+        scheduler_wake((uint32_t)worker_slot);
+    }
+    
+    return ring;
+}
+
+// Espera as submissões pendentes e libera o anel. Cada submissão gera
+// exatamente uma conclusão, então tudo terminou quando cq_tail == sq_tail;
+// mas o worker ainda mexe no anel depois de avançar cq_tail, então ele só
+// é retirado da lista quando o worker não estiver dentro dele
+void io_ring_destroy(io_ring_t *ring) {
+    while(ring->cq_tail != ring->sq_tail) {
+        io_ring_enter(ring, ring->cq_tail - ring->cq_head + 1);
+        ring->cq_head = ring->cq_tail; // Conclusões descartadas
+    }
+    
+    uintptr_t flags;
+    for(;;) {
+        flags = rings_lock_acquire();
+        if(!ring->busy) {
+            break;
+        }
+        spin_unlock_irqrestore(&rings_lock, flags);
+        scheduler_schedule();
+    }
+    
+    io_ring_t **link = &rings;
+    while(*link && *link != ring) {
+        link = &(*link)->next;
+    }
+    if(*link) {
+        *link = ring->next;
+    }
+    spin_unlock_irqrestore(&rings_lock, flags);
+    
+    pmm_free_contiguous(ring->mem, ring->pages);
+}
+
+// Chamada do sistema: acorda o worker e espera até min_complete
+// conclusões não consumidas; retorna quantas há
+int io_ring_enter(io_ring_t *ring, uint32_t min_complete) {
+    ring->enters++;
+    
+    if(!worker_started) {
+        io_ring_process(ring);
+    } else if(worker_sleeping) {
+        ring->wakeups++;
+        scheduler_wake((uint32_t)worker_slot);
+    }
+    
+    if(min_complete > ring->cq_mask + 1) {
+        min_complete = ring->cq_mask + 1;
+    }
+    
+    while(ring->cq_tail - ring->cq_head < min_complete) {
+        uintptr_t flags = irq_save();
+        if(ring->cq_tail - ring->cq_head < min_complete) {
+            ring->wait_target = min_complete;
+            ring->waiter = (int32_t)scheduler_current();
+            scheduler_block();
+            
+            // Nenhum outro processo pronto: esperar pela próxima interrupção
+            if(ring->cq_tail - ring->cq_head < min_complete) {
+                asm volatile("sti; hlt; cli");
+            }
+            ring->waiter = -1;
+        }
+        irq_restore(flags);
+    }
+    
+    return ring->cq_tail - ring->cq_head;
+}
+
+// Próxima entrada livre do anel de submissão (NULL se cheio); só é
+// vista pelo kernel depois de io_ring_submit
+io_sqe_t *io_ring_get_sqe(io_ring_t *ring) {
+    if(ring->sqe_tail - ring->sq_head > ring->sq_mask) {
+        return NULL;
+    }
+    
+    io_sqe_t *sqe = &ring->sqes[ring->sqe_tail & ring->sq_mask];
+    ring->sqe_tail++;
+    memset(sqe, 0, sizeof(io_sqe_t));
+    return sqe;
+}
+
+// Publica as entradas preparadas de uma vez. Com SQPOLL o worker as
+// encontra sozinho e nenhuma chamada é feita enquanto ele estiver ativo
+int io_ring_submit(io_ring_t *ring) {
+    uint32_t count = ring->sqe_tail - ring->sq_tail;
+    if(count == 0) {
+        return 0;
+    }
+    
+    io_ring_barrier();
+    ring->sq_tail = ring->sqe_tail;
+    ring->submitted += count;
+    io_ring_barrier();
+    
+    if(!(ring->setup_flags & IORING_SETUP_SQPOLL) || (ring->sq_flags & IORING_SQ_NEED_WAKEUP)) {
+        io_ring_enter(ring, 0);
+    }
+    
+    return count;
+}
+
+// Publica e espera min_complete conclusões
+int io_ring_submit_and_wait(io_ring_t *ring, uint32_t min_complete) {
+    uint32_t count = ring->sqe_tail - ring->sq_tail;
+    io_ring_barrier();
+    ring->sq_tail = ring->sqe_tail;
+    ring->submitted += count;
+    io_ring_barrier();
+    
+    io_ring_enter(ring, min_complete);
+    return count;
+}
+
+// Próxima conclusão não consumida (NULL se não houver)
+io_cqe_t *io_ring_peek_cqe(io_ring_t *ring) {
+    if(ring->cq_head == ring->cq_tail) {
+        return NULL;
+    }
+    
+    io_ring_barrier();
+    return &ring->cqes[ring->cq_head & ring->cq_mask];
+}
+
+// Libera a entrada devolvida por io_ring_peek_cqe
+void io_ring_cqe_seen(io_ring_t *ring) {
+    io_ring_barrier();
+    ring->cq_head++;
+}
@@ -0,0 +1,87 @@
+#ifndef IO_RING_H
+#define IO_RING_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Operações
+#define IORING_OP_NOP   0
+#define IORING_OP_READ  1
+#define IORING_OP_WRITE 2
+#define IORING_OP_OPEN  3
+#define IORING_OP_CLOSE 4
+#define IORING_OP_FSYNC 5
+
+// Flags de io_ring_setup
+#define IORING_SETUP_SQPOLL 0x1     // O worker busca submissões sozinho
+
+// Flags de sq_flags
+#define IORING_SQ_NEED_WAKEUP 0x1   // Worker dormindo: chamar io_ring_enter
+
+#define IORING_MAX_ENTRIES 4096
+
+// Pedido no anel de submissão
+typedef struct io_sqe {
+    uint8_t opcode;
+    uint8_t reserved;
+    uint16_t flags;
+    int32_t fd;
+    uint32_t offset;            // VFS_OFFSET_CURRENT = posição do arquivo
+    void *buffer;               // Dados; caminho em IORING_OP_OPEN
+    uint32_t length;            // Bytes
+    int32_t open_flags;         // O_* de IORING_OP_OPEN
+    uint64_t user_data;         // Devolvido intacto na conclusão
+} io_sqe_t;
+
+// Resultado no anel de conclusão
+typedef struct io_cqe {
+    uint64_t user_data;
+    int32_t result;             // Retorno da operação da VFS
+    uint32_t flags;
+} io_cqe_t;
+
+// Par de anéis de um processo. A aplicação produz em sq_tail e consome
+// em cq_head; o kernel consome em sq_head e produz em cq_tail
+typedef struct io_ring {
+    volatile uint32_t sq_head;
+    volatile uint32_t sq_tail;
+    volatile uint32_t sq_flags;
+    uint32_t sq_mask;
+    volatile uint32_t cq_head;
+    volatile uint32_t cq_tail;
+    uint32_t cq_mask;
+    io_sqe_t *sqes;
+    io_cqe_t *cqes;
+
+    // Privado da aplicação: entradas preparadas ainda não publicadas
+    uint32_t sqe_tail;
+
+    // Privado do kernel
+    uint32_t setup_flags;
+    struct fd_table *files;     // Tabela do processo que criou o anel
+    volatile int32_t waiter;    // Slot esperando conclusões (-1 = nenhum)
+    volatile uint32_t wait_target;
+    void *mem;
+    uint32_t pages;
+    struct io_ring *next;
+    volatile uint32_t busy;     // Worker dentro do anel: não pode ser liberado
+
+    // Estatísticas
+    uint32_t submitted;
+    uint32_t completed;
+    uint32_t enters;
+    uint32_t wakeups;
+} io_ring_t;
+
+io_ring_t *io_ring_setup(uint32_t entries, uint32_t flags);
+void io_ring_destroy(io_ring_t *ring);
+int io_ring_enter(io_ring_t *ring, uint32_t min_complete);
+
+// Lado da aplicação
+io_sqe_t *io_ring_get_sqe(io_ring_t *ring);
+int io_ring_submit(io_ring_t *ring);
+int io_ring_submit_and_wait(io_ring_t *ring, uint32_t min_complete);
+io_cqe_t *io_ring_peek_cqe(io_ring_t *ring);
+void io_ring_cqe_seen(io_ring_t *ring);
+
+#endif
@@ -0,0 +1,357 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "pipe.h"
+#include "vfs.h"
+#include "dcache.h"
+#include "fdtable.h"
+#include "pmm.h"
+#include "scheduler.h"
+#include "spinlock.h"
+
+// Os dados vão do buffer do escritor direto para as páginas do anel e
+// delas para o buffer do leitor: uma cópia em cada sentido, sem cache de
+// páginas nem vnode de arquivo no meio. head e tail são contadores livres
+// (a posição no anel é o valor módulo PIPE_SIZE), então cheio e vazio não
+// se confundem
+
+typedef struct pipe {
+    uint8_t *pages[PIPE_PAGES];
+    volatile uint32_t head;         // Próximo byte a ler
+    volatile uint32_t tail;         // Próximo byte a escrever
+    volatile uint32_t readers;      // Lados de leitura abertos
+    volatile uint32_t writers;
+    uint32_t ends;                  // Lados ainda não liberados
+    spinlock_t lock;                // Cópias e contadores
+    wait_queue_t read_wait;         // Esperando dados
+    wait_queue_t write_wait;        // Esperando espaço
+} pipe_t;
+
+// Cada lado é um vnode próprio: close() sabe qual lado fechou
+typedef struct pipe_end {
+    vnode_t vnode;                  // Precisa ser o primeiro campo
+    pipe_t *pipe;
+    uint32_t writer;
+    uint32_t flags;                 // Da abertura (O_NONBLOCK)
+} pipe_end_t;
+
+#define PIPE_END(v) ((pipe_end_t*)(v))
+
+static pipe_stats_t stats;
+static uint32_t next_ino = 1;
+
+static inline uint32_t pipe_used(pipe_t *pipe) {
+    return pipe->tail - pipe->head;
+}
+
+// Condições de wait_event: há o que ler (ou nunca haverá) e há espaço
+// para need bytes (ou ninguém vai ler)
+static int pipe_readable(void *arg) {
+    pipe_t *pipe = arg;
+    return pipe_used(pipe) > 0 || pipe->writers == 0;
+}
+
+typedef struct pipe_space {
+    pipe_t *pipe;
+    uint32_t need;
+} pipe_space_t;
+
+static int pipe_writable(void *arg) {
+    pipe_space_t *space = arg;
+    return PIPE_SIZE - pipe_used(space->pipe) >= space->need || space->pipe->readers == 0;
+}
+
+// Copia entre o anel e um buffer a partir da posição pos, página a página
+static void pipe_copy(pipe_t *pipe, uint32_t pos, uint8_t *buffer, uint32_t len, int to_ring) {
+    while(len > 0) {
+        uint32_t offset = pos & (PAGE_SIZE - 1);
+        uint32_t chunk = PAGE_SIZE - offset;
+        if(chunk > len) {
+            chunk = len;
+        }
+        
+        uint8_t *page = pipe->pages[(pos >> PAGE_SHIFT) & (PIPE_PAGES - 1)] + offset;
+        if(to_ring) {
+            memcpy(page, buffer, chunk);
+        } else {
+            memcpy(buffer, page, chunk);
+        }
+        
+        pos += chunk;
+        buffer += chunk;
+        len -= chunk;
+    }
+}
+
+// Lê o que houver (até size); com o anel vazio espera por um escritor.
+// 0 = fim (nenhum escritor)
+static int pipe_read(vnode_t *node, uint32_t offset, void *buffer, size_t size) {
+    (void)offset;
+    pipe_end_t *end = PIPE_END(node);
+    pipe_t *pipe = end->pipe;
+    if(end->writer) {
+        return -1;
+    }
+    if(size == 0) {
+        return 0;
+    }
+    
+    for(;;) {
+        spin_lock(&pipe->lock);
+        uint32_t used = pipe_used(pipe);
+        if(used > 0) {
+            uint32_t len = used < size ? used : (uint32_t)size;
+            pipe_copy(pipe, pipe->head, buffer, len, 0);
+            pipe->head += len;
+            stats.bytes += len;
+            spin_unlock(&pipe->lock);
+            
+            wake_up(&pipe->write_wait);
+            return (int)len;
+        }
+        uint32_t writers = pipe->writers;
+        spin_unlock(&pipe->lock);
+        
+        if(writers == 0) {
+            return 0;
+        }
+        if(end->flags & O_NONBLOCK) {
+            return VFS_EAGAIN;
+        }
+        
+        stats.read_waits++;
+        if(wait_event(&pipe->read_wait, pipe_readable, pipe) != 0) {
+            return VFS_EAGAIN;
+        }
+    }
+}
+
+// Escreve tudo, esperando por espaço; escritas de até PIPE_BUF bytes só
+// começam quando cabem inteiras. Sem leitores retorna VFS_EPIPE (ou o
+// que já foi escrito)
+static int pipe_write(vnode_t *node, uint32_t offset, const void *buffer, size_t size) {
+    (void)offset;
+    pipe_end_t *end = PIPE_END(node);
+    pipe_t *pipe = end->pipe;
+    if(!end->writer) {
+        return -1;
+    }
+    if(size > 0x7FFFFFFF) {
+        size = 0x7FFFFFFF;
+    }
+    
+    const uint8_t *data = buffer;
+    uint32_t written = 0;
+    uint32_t atomic = size <= PIPE_BUF ? (uint32_t)size : 1;
+    
+    while(written < size) {
+        spin_lock(&pipe->lock);
+        if(pipe->readers == 0) {
+            spin_unlock(&pipe->lock);
+            return written ? (int)written : VFS_EPIPE;
+        }
+        
+        uint32_t space = PIPE_SIZE - pipe_used(pipe);
+        if(space >= atomic) {
+            uint32_t len = size - written;
+            if(len > space) {
+                len = space;
+            }
+            pipe_copy(pipe, pipe->tail, (uint8_t*)data + written, len, 1);
+            pipe->tail += len;
+            written += len;
+            spin_unlock(&pipe->lock);
+            
+            wake_up(&pipe->read_wait);
+            continue;
+        }
+        spin_unlock(&pipe->lock);
+        
+        if(end->flags & O_NONBLOCK) {
+            return written ? (int)written : VFS_EAGAIN;
+        }
+        
+        stats.write_waits++;
+        pipe_space_t wait = { pipe, atomic };
+        if(wait_event(&pipe->write_wait, pipe_writable, &wait) != 0) {
+            return written ? (int)written : VFS_EAGAIN;
+        }
+    }
+    
+    return (int)written;
+}
+
+static int pipe_open(vnode_t *node, int flags) {
+    pipe_end_t *end = PIPE_END(node);
+    pipe_t *pipe = end->pipe;
+    
+    end->flags = flags;
+    spin_lock(&pipe->lock);
+    if(end->writer) {
+        pipe->writers++;
+    } else {
+        pipe->readers++;
+    }
+    spin_unlock(&pipe->lock);
+    return 0;
+}
+
+static void pipe_destroy(pipe_t *pipe) {
+    for(int i = 0; i < PIPE_PAGES; i++) {
+        pmm_free_page(pipe->pages[i]);
+    }
+    free(pipe);
+    stats.active--;
+}
+
+// Libera um lado; o último leva o anel junto
+static void pipe_put_end(pipe_end_t *end) {
+    pipe_t *pipe = end->pipe;
+    free(end);
+    
+    spin_lock(&pipe->lock);
+    uint32_t ends = --pipe->ends;
+    spin_unlock(&pipe->lock);
+    if(ends == 0) {
+        pipe_destroy(pipe);
+    }
+}
+
+// Fechar um lado acorda o outro: leitores veem o fim e escritores VFS_EPIPE
+static int pipe_close(vnode_t *node) {
+    pipe_end_t *end = PIPE_END(node);
+    pipe_t *pipe = end->pipe;
+    
+    spin_lock(&pipe->lock);
+    if(end->writer) {
+        pipe->writers--;
+    } else {
+        pipe->readers--;
+    }
+    spin_unlock(&pipe->lock);
+    
+    wake_up(&pipe->read_wait);
+    wake_up(&pipe->write_wait);
+    pipe_put_end(end);
+    return 0;
+}
+
+static int pipe_stat(vnode_t *node, struct stat *st) {
+    st->st_ino = node->ino;
+    st->st_mode = node->mode;
+    st->st_size = pipe_used(PIPE_END(node)->pipe);
+    return 0;
+}
+
+// Sem registro nem ponto de montagem na árvore: os pipes só existem
+// pelos descritores
+static filesystem_t pipefs_operations = {
+    .name = "pipefs",
+    .open = pipe_open,
+    .close = pipe_close,
+    .read = pipe_read,
+    .write = pipe_write,
+    .stat = pipe_stat
+};
+
+static mountpoint_t pipe_mount = {
+    .path = "pipe:",
+    .fs = &pipefs_operations,
+    .mounted = 1
+};
+
+static pipe_end_t *pipe_new_end(pipe_t *pipe, uint32_t ino, int writer) {
+    pipe_end_t *end = malloc(sizeof(pipe_end_t));
+    if(!end) {
+        return NULL;
+    }
+    
+    memset(end, 0, sizeof(pipe_end_t));
+    end->vnode.ino = ino;
+    end->vnode.mode = S_IFIFO | (writer ? 0200 : 0400);
+    end->pipe = pipe;
+    end->writer = writer;
+    return end;
+}
+
+static pipe_t *pipe_create() {
+    pipe_t *pipe = malloc(sizeof(pipe_t));
+    if(!pipe) {
+        return NULL;
+    }
+    
+    memset(pipe, 0, sizeof(pipe_t));
+    for(int i = 0; i < PIPE_PAGES; i++) {
+        pipe->pages[i] = pmm_alloc_page();
+        if(!pipe->pages[i]) {
+            while(i-- > 0) {
+                pmm_free_page(pipe->pages[i]);
+            }
+            free(pipe);
+            return NULL;
+        }
+    }
+    
+    pipe->ends = 2;
+    spin_lock_init(&pipe->lock, NULL);
+    stats.created++;
+    stats.active++;
+    return pipe;
+}
+
+// Cria um pipe e instala os dois lados na tabela: fds[0] para leitura e
+// fds[1] para escrita. flags aceita O_NONBLOCK
+int vfs_pipe_files(fd_table_t *table, int fds[2], int flags) {
+    if(!table) {
+        return -1;
+    }
+    flags &= O_NONBLOCK;
+    
+    pipe_t *pipe = pipe_create();
+    if(!pipe) {
+        return -1;
+    }
+    
+    uint32_t ino = __atomic_fetch_add(&next_ino, 1, __ATOMIC_RELAXED);
+    pipe_end_t *reader = pipe_new_end(pipe, ino, 0);
+    pipe_end_t *writer = pipe_new_end(pipe, ino, 1);
+    dentry_t *read_dentry = reader ? dcache_alloc_anon(&pipe_mount, &reader->vnode) : NULL;
+    dentry_t *write_dentry = writer ? dcache_alloc_anon(&pipe_mount, &writer->vnode) : NULL;
+    if(!read_dentry || !write_dentry) {
+        if(read_dentry) {
+            dput(read_dentry);
+        }
+        if(write_dentry) {
+            dput(write_dentry);
+        }
+        free(reader);
+        free(writer);
+        pipe_destroy(pipe);
+        return -1;
+    }
+    
+    // Daqui em diante cada lado é liberado pelo próprio arquivo; um lado
+    // que não chegou a ser aberto é liberado à mão
+    fds[0] = vfs_open_dentry(table, read_dentry, O_RDONLY | flags);
+    if(fds[0] < 0) {
+        dput(write_dentry);
+        pipe_put_end(writer);
+        return -1;
+    }
+    
+    fds[1] = vfs_open_dentry(table, write_dentry, O_WRONLY | flags);
+    if(fds[1] < 0) {
+        vfs_close_files(table, fds[0]);
+        return -1;
+    }
+    
+    return 0;
+}
+
+int vfs_pipe(int fds[2]) {
+    return vfs_pipe_files(scheduler_current_files(), fds, 0);
+}
+
+const pipe_stats_t *pipe_get_stats() {
+    return &stats;
+}
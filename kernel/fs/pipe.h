@@ -0,0 +1,25 @@
+#ifndef PIPE_H
+#define PIPE_H
+
+#include <stdint.h>
+#include "vmm.h"
+
+// Pipe: anel de páginas físicas entre um lado de escrita e um de leitura.
+// Leitores esperam dados e escritores esperam espaço nas filas de espera
+// do escalonador; escritas de até PIPE_BUF bytes não se misturam com as
+// de outros escritores
+#define PIPE_PAGES 16                           // Potência de 2
+#define PIPE_SIZE  (PIPE_PAGES * PAGE_SIZE)
+#define PIPE_BUF   PAGE_SIZE
+
+typedef struct pipe_stats {
+    uint32_t created;
+    uint32_t active;
+    uint64_t bytes;         // Transferidos do escritor para o leitor
+    uint32_t read_waits;    // Leituras que dormiram com o anel vazio
+    uint32_t write_waits;   // Escritas que dormiram com o anel cheio
+} pipe_stats_t;
+
+const pipe_stats_t *pipe_get_stats(void);
+
+#endif
@@ -0,0 +1,516 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "vfs.h"
+#include "dcache.h"
+#include "pagecache.h"
+#include "pmm.h"
+#include "scheduler.h"
+#include "spinlock.h"
+#include "rcu.h"
+#include "pipe.h"
+#include "ipc.h"
+#include "exec.h"
+
+// Sistema de arquivos sintético com os contadores do kernel. Nada é
+// guardado: cada leitura gera o texto inteiro a partir dos contadores
+// (somando os por CPU) e copia o trecho pedido. Uma leitura com buffer de
+// PROCFS_BUFFER_SIZE bytes vê um retrato consistente; leituras em pedaços
+// podem juntar retratos de momentos diferentes
+//
+//   /proc/meminfo      páginas físicas, cache de páginas e de dentries
+//   /proc/stat         ticks, trocas de contexto e faults por CPU, exec
+//   /proc/interrupts   interrupções por linha de IRQ e por CPU
+//   /proc/caches       acertos dos caches de dentries e de páginas, RCU
+//   /proc/locks        estatísticas dos spinlocks registrados
+//   /proc/ipc          pipes e canais de mensagens
+//   /proc/<pid>/stat   contadores de um processo
+
+#define PROCFS_BUFFER_SIZE 8192
+
+// Números de inode: raiz, arquivos globais e dois por slot de processo
+#define PROCFS_ROOT_INO 1
+#define PROCFS_FILE_INO 2
+#define PROCFS_PID_INO  0x1000
+
+#define PROCFS_ROOT     0
+#define PROCFS_FILE     1
+#define PROCFS_PID_DIR  2
+#define PROCFS_PID_STAT 3
+
+// Texto em construção; o que não couber é descartado
+typedef struct procfs_buffer {
+    char *data;
+    size_t len;
+} procfs_buffer_t;
+
+typedef struct procfs_node {
+    vnode_t vnode;                  // Precisa ser o primeiro campo
+    uint32_t type;
+    uint32_t slot;                  // PROCFS_PID_*
+    void (*show)(procfs_buffer_t *buf);
+} procfs_node_t;
+
+#define PROCFS_NODE(v) ((procfs_node_t*)(v))
+
+static void procfs_putc(procfs_buffer_t *buf, char c) {
+    if(buf->len < PROCFS_BUFFER_SIZE) {
+        buf->data[buf->len++] = c;
+    }
+}
+
+static void procfs_puts(procfs_buffer_t *buf, const char *s) {
+    while(*s) {
+        procfs_putc(buf, *s++);
+    }
+}
+
+// Decimal alinhado à direita em width colunas. A divisão por 10 é feita
+// em pedaços de 16 bits: o i386 não tem divisão de 64 bits sem a libgcc
+static void procfs_dec(procfs_buffer_t *buf, uint64_t value, int width) {
+    char digits[20];
+    int count = 0;
+    
+    do {
+        uint32_t rest = 0;
+        uint64_t quotient = 0;
+        for(int shift = 48; shift >= 0; shift -= 16) {
+            uint32_t part = (rest << 16) | (uint32_t)((value >> shift) & 0xFFFF);
+            quotient |= (uint64_t)(part / 10) << shift;
+            rest = part % 10;
+        }
+        digits[count++] = '0' + rest;
+        value = quotient;
+    } while(value);
+    
+    for(int i = count; i < width; i++) {
+        procfs_putc(buf, ' ');
+    }
+    while(count > 0) {
+        procfs_putc(buf, digits[--count]);
+    }
+}
+
+// "nome:" com a coluna do valor alinhada
+static void procfs_name(procfs_buffer_t *buf, const char *name) {
+    procfs_puts(buf, name);
+    procfs_puts(buf, ":");
+    for(size_t i = strlen(name); i < 16; i++) {
+        procfs_putc(buf, ' ');
+    }
+}
+
+// Nome seguido de um valor, alinhados em colunas
+static void procfs_field(procfs_buffer_t *buf, const char *name, uint64_t value, const char *unit) {
+    procfs_name(buf, name);
+    procfs_dec(buf, value, 12);
+    if(unit) {
+        procfs_putc(buf, ' ');
+        procfs_puts(buf, unit);
+    }
+    procfs_putc(buf, '\n');
+}
+
+// Porcentagem de part em total; os dois são reduzidos até caber a
+// multiplicação por 100 em 32 bits
+static void procfs_percent(procfs_buffer_t *buf, uint32_t part, uint32_t total) {
+    while(total >= (1u << 25)) {
+        part >>= 1;
+        total >>= 1;
+    }
+    procfs_dec(buf, total ? part * 100 / total : 0, 11);
+    procfs_putc(buf, '%');
+}
+
+// Cabeçalho das colunas por CPU (e do total, se houver)
+static void procfs_cpu_header(procfs_buffer_t *buf, const char *first, int total) {
+    procfs_puts(buf, first);
+    for(uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+        procfs_puts(buf, "        CPU");
+        procfs_dec(buf, cpu, 1);
+    }
+    procfs_puts(buf, total ? "       total\n" : "\n");
+}
+
+static void show_meminfo(procfs_buffer_t *buf) {
+    uint32_t total = pmm_total_pages();
+    uint32_t used = pmm_used_pages();
+    const pagecache_stats_t *cache = pagecache_get_stats();
+    const dcache_stats_t *dcache = dcache_get_stats();
+    
+    procfs_field(buf, "MemTotal", (uint64_t)total * 4, "kB");
+    procfs_field(buf, "MemFree", (uint64_t)(total - used) * 4, "kB");
+    procfs_field(buf, "MemUsed", (uint64_t)used * 4, "kB");
+    procfs_field(buf, "PageCache", (uint64_t)cache->pages * 4, "kB");
+    procfs_field(buf, "Dirty", (uint64_t)cache->dirty * 4, "kB");
+    procfs_field(buf, "Dentries", dcache->entries, NULL);
+}
+
+// Uma linha por contador, uma coluna por CPU e o total
+static void procfs_cpu_row(procfs_buffer_t *buf, const char *name, size_t offset) {
+    uint64_t total = 0;
+    procfs_puts(buf, name);
+    for(size_t i = strlen(name); i < 16; i++) {
+        procfs_putc(buf, ' ');
+    }
+    for(uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+        uint32_t value = *(const volatile uint32_t*)((const uint8_t*)&cpus[cpu] + offset);
+        procfs_dec(buf, value, 12);
+        total += value;
+    }
+    procfs_dec(buf, total, 12);
+    procfs_putc(buf, '\n');
+}
+
+static void show_stat(procfs_buffer_t *buf) {
+    procfs_cpu_header(buf, "                ", 1);
+    procfs_cpu_row(buf, "ticks", offsetof(cpu_t, ticks));
+    procfs_cpu_row(buf, "ctxt", offsetof(cpu_t, context_switches));
+    procfs_cpu_row(buf, "page_faults", offsetof(cpu_t, page_faults));
+    
+    uint32_t processes = 0;
+    process_stats_t stats;
+    for(uint32_t slot = 0; slot < MAX_PROCESSES; slot++) {
+        if(scheduler_get_stats(slot, &stats) == 0) {
+            processes++;
+        }
+    }
+    procfs_field(buf, "processes", processes, NULL);
+    
+    const exec_stats_t *exec = exec_get_stats();
+    procfs_field(buf, "exec_loads", exec->loads, NULL);
+    procfs_field(buf, "exec_failures", exec->failures, NULL);
+    procfs_field(buf, "exec_tail_pages", exec->tail_pages, NULL);
+    procfs_field(buf, "exec_stack_pages", exec->stack_pages, NULL);
+}
+
+// Linhas sem nenhuma interrupção ficam de fora; o vetor 14 (page fault)
+// aparece como PF
+static void show_interrupts(procfs_buffer_t *buf) {
+    procfs_cpu_header(buf, "     ", 0);
+    for(uint32_t irq = 0; irq < NR_IRQS; irq++) {
+        uint64_t total = 0;
+        for(uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+            total += cpus[cpu].irqs[irq];
+        }
+        if(!total) {
+            continue;
+        }
+        
+        procfs_dec(buf, irq, 3);
+        procfs_puts(buf, ": ");
+        for(uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+            procfs_dec(buf, cpus[cpu].irqs[irq], 12);
+        }
+        procfs_puts(buf, "  vetor ");
+        procfs_dec(buf, 32 + irq, 1);
+        procfs_putc(buf, '\n');
+    }
+    
+    procfs_puts(buf, " PF: ");
+    for(uint32_t cpu = 0; cpu < cpu_count; cpu++) {
+        procfs_dec(buf, cpus[cpu].page_faults, 12);
+    }
+    procfs_puts(buf, "  vetor 14\n");
+}
+
+static void show_caches(procfs_buffer_t *buf) {
+    const dcache_stats_t *dcache = dcache_get_stats();
+    uint32_t lookups = dcache->hits + dcache->negative_hits + dcache->misses;
+    procfs_puts(buf, "dcache\n");
+    procfs_field(buf, "  hits", dcache->hits, NULL);
+    procfs_field(buf, "  negative_hits", dcache->negative_hits, NULL);
+    procfs_field(buf, "  misses", dcache->misses, NULL);
+    procfs_field(buf, "  evictions", dcache->evictions, NULL);
+    procfs_field(buf, "  entries", dcache->entries, NULL);
+    procfs_name(buf, "  hit_rate");
+    procfs_percent(buf, dcache->hits + dcache->negative_hits, lookups);
+    procfs_putc(buf, '\n');
+    
+    const pagecache_stats_t *cache = pagecache_get_stats();
+    procfs_puts(buf, "pagecache\n");
+    procfs_field(buf, "  hits", cache->hits, NULL);
+    procfs_field(buf, "  misses", cache->misses, NULL);
+    procfs_field(buf, "  readahead", cache->readahead, NULL);
+    procfs_field(buf, "  evictions", cache->evictions, NULL);
+    procfs_field(buf, "  writebacks", cache->writebacks, NULL);
+    procfs_field(buf, "  pages", cache->pages, NULL);
+    procfs_name(buf, "  hit_rate");
+    procfs_percent(buf, cache->hits, cache->hits + cache->misses);
+    procfs_putc(buf, '\n');
+    
+    rcu_stats_t rcu;
+    rcu_get_stats(&rcu);
+    procfs_puts(buf, "rcu\n");
+    procfs_field(buf, "  grace_periods", rcu.grace_periods, NULL);
+    procfs_field(buf, "  callbacks", rcu.callbacks, NULL);
+    procfs_field(buf, "  pending", rcu.pending, NULL);
+}
+
+// Em ciclos do TSC, como lock_stats_report()
+static void show_locks(procfs_buffer_t *buf) {
+    procfs_puts(buf, "nome                aquisicoes   com espera     esperando         posse       maxima\n");
+    for(lock_stats_t *stats = lock_stats_first(); stats; stats = stats->next) {
+        procfs_puts(buf, stats->name);
+        for(size_t i = strlen(stats->name); i < 14; i++) {
+            procfs_putc(buf, ' ');
+        }
+        procfs_dec(buf, stats->acquisitions, 16);
+        procfs_dec(buf, stats->contended, 13);
+        procfs_dec(buf, stats->wait_cycles, 14);
+        procfs_dec(buf, stats->hold_cycles, 14);
+        procfs_dec(buf, stats->max_hold_cycles, 13);
+        procfs_putc(buf, '\n');
+    }
+}
+
+static void show_ipc(procfs_buffer_t *buf) {
+    const pipe_stats_t *pipe = pipe_get_stats();
+    procfs_puts(buf, "pipe\n");
+    procfs_field(buf, "  created", pipe->created, NULL);
+    procfs_field(buf, "  active", pipe->active, NULL);
+    procfs_field(buf, "  bytes", pipe->bytes, NULL);
+    procfs_field(buf, "  read_waits", pipe->read_waits, NULL);
+    procfs_field(buf, "  write_waits", pipe->write_waits, NULL);
+    
+    const ipc_stats_t *ipc = ipc_get_stats();
+    procfs_puts(buf, "channels\n");
+    procfs_field(buf, "  open", ipc->channels, NULL);
+    procfs_field(buf, "  sent", ipc->sent, NULL);
+    procfs_field(buf, "  received", ipc->received, NULL);
+    procfs_field(buf, "  inline_bytes", ipc->inline_bytes, NULL);
+    procfs_field(buf, "  ool_pages", ipc->ool_pages, NULL);
+    procfs_field(buf, "  send_waits", ipc->send_waits, NULL);
+    procfs_field(buf, "  receive_waits", ipc->receive_waits, NULL);
+}
+
+static void show_process(procfs_buffer_t *buf, const process_stats_t *stats) {
+    static const char *states[] = { "none", "ready", "running", "blocked" };
+    procfs_field(buf, "pid", stats->pid, NULL);
+    procfs_field(buf, "slot", stats->slot, NULL);
+    const char *state = stats->state < 4 ? states[stats->state] : "?";
+    procfs_name(buf, "state");
+    for(size_t i = strlen(state); i < 12; i++) {
+        procfs_putc(buf, ' ');
+    }
+    procfs_puts(buf, state);
+    procfs_putc(buf, '\n');
+    procfs_field(buf, "priority", stats->priority, NULL);
+    procfs_field(buf, "ticks", stats->ticks, NULL);
+    procfs_field(buf, "switches", stats->switches, NULL);
+    procfs_field(buf, "page_faults", stats->faults, NULL);
+    procfs_field(buf, "rss", (uint64_t)stats->rss * 4, "kB");
+}
+
+// Arquivos globais, na ordem do readdir
+static procfs_node_t procfs_files[] = {
+    { .show = show_meminfo },
+    { .show = show_stat },
+    { .show = show_interrupts },
+    { .show = show_caches },
+    { .show = show_locks },
+    { .show = show_ipc },
+};
+static const char *procfs_file_names[] = { "meminfo", "stat", "interrupts", "caches", "locks", "ipc" };
+
+#define PROCFS_FILE_COUNT (sizeof(procfs_files) / sizeof(procfs_files[0]))
+
+static procfs_node_t procfs_root;
+
+// Nós de cada slot de processo: diretório e stat. Processos não terminam
+// (o slot não é reaproveitado), então o nó de um slot é sempre do mesmo PID
+static procfs_node_t pid_dirs[MAX_PROCESSES];
+static procfs_node_t pid_stats[MAX_PROCESSES];
+
+static void procfs_init_node(procfs_node_t *node, uint32_t ino, uint32_t mode, uint32_t type, uint32_t slot) {
+    node->vnode.ino = ino;
+    node->vnode.mode = mode;
+    node->vnode.size = 0;       // Desconhecido até gerar o conteúdo
+    node->vnode.mapping = NULL;
+    node->vnode.mmap_count = 0;
+    node->type = type;
+    node->slot = slot;
+}
+
+// Os nós são estáticos: montar de novo só os reinicializa
+static int procfs_mount(struct filesystem *fs, const char *device, vnode_t **root) {
+    (void)fs;
+    (void)device;
+    
+    procfs_init_node(&procfs_root, PROCFS_ROOT_INO, S_IFDIR, PROCFS_ROOT, 0);
+    for(uint32_t i = 0; i < PROCFS_FILE_COUNT; i++) {
+        procfs_init_node(&procfs_files[i], PROCFS_FILE_INO + i, S_IFREG, PROCFS_FILE, 0);
+    }
+    for(uint32_t slot = 0; slot < MAX_PROCESSES; slot++) {
+        procfs_init_node(&pid_dirs[slot], PROCFS_PID_INO + 2 * slot, S_IFDIR, PROCFS_PID_DIR, slot);
+        procfs_init_node(&pid_stats[slot], PROCFS_PID_INO + 2 * slot + 1, S_IFREG, PROCFS_PID_STAT, slot);
+    }
+    
+    *root = &procfs_root.vnode;
+    return 0;
+}
+
+static int procfs_unmount(vnode_t *root) {
+    (void)root;
+    return 0;
+}
+
+// Converte um nome só de dígitos; -1 se não for um número
+static int procfs_parse_pid(const char *name, size_t len, uint32_t *pid) {
+    if(len == 0 || len > 9) {
+        return -1;
+    }
+    
+    *pid = 0;
+    for(size_t i = 0; i < len; i++) {
+        if(name[i] < '0' || name[i] > '9') {
+            return -1;
+        }
+        *pid = *pid * 10 + (name[i] - '0');
+    }
+    return 0;
+}
+
+static int procfs_lookup(vnode_t *dir, const char *name, size_t len, vnode_t **result) {
+    procfs_node_t *node = PROCFS_NODE(dir);
+    
+    if(node->type == PROCFS_PID_DIR) {
+        if(len == 4 && memcmp(name, "stat", 4) == 0) {
+            *result = &pid_stats[node->slot].vnode;
+            return 0;
+        }
+        return -1;
+    }
+    if(node->type != PROCFS_ROOT) {
+        return -1;
+    }
+    
+    for(uint32_t i = 0; i < PROCFS_FILE_COUNT; i++) {
+        if(strlen(procfs_file_names[i]) == len && memcmp(procfs_file_names[i], name, len) == 0) {
+            *result = &procfs_files[i].vnode;
+            return 0;
+        }
+    }
+    
+    uint32_t pid;
+    int slot;
+    if(procfs_parse_pid(name, len, &pid) != 0 || (slot = scheduler_find_pid(pid)) < 0) {
+        return -1;
+    }
+    *result = &pid_dirs[slot].vnode;
+    return 0;
+}
+
+// Diretórios podem ser abertos (para o readdir); nada pode ser escrito
+static int procfs_open(vnode_t *node, int flags) {
+    (void)node;
+    return (flags & (O_WRONLY | O_RDWR | O_TRUNC)) ? -1 : 0;
+}
+
+static int procfs_close(vnode_t *node) {
+    (void)node;
+    return 0;
+}
+
+// Gera o conteúdo e copia [offset, offset + size)
+static int procfs_read(vnode_t *vnode, uint32_t offset, void *buffer, size_t size) {
+    procfs_node_t *node = PROCFS_NODE(vnode);
+    procfs_buffer_t buf;
+    process_stats_t stats;
+    
+    if(node->type == PROCFS_PID_STAT && scheduler_get_stats(node->slot, &stats) != 0) {
+        return -1;
+    }
+    
+    buf.data = malloc(PROCFS_BUFFER_SIZE);
+    buf.len = 0;
+    if(!buf.data) {
+        return -1;
+    }
+    
+    if(node->type == PROCFS_PID_STAT) {
+        show_process(&buf, &stats);
+    } else {
+        node->show(&buf);
+    }
+    
+    int result = 0;
+    if(offset < buf.len) {
+        result = buf.len - offset < size ? buf.len - offset : size;
+        memcpy(buffer, buf.data + offset, result);
+    }
+    
+    free(buf.data);
+    return result;
+}
+
+static int procfs_stat(vnode_t *node, struct stat *st) {
+    st->st_ino = node->ino;
+    st->st_mode = node->mode;
+    st->st_size = 0;
+    return 0;
+}
+
+// Raiz: arquivos globais e depois um diretório por processo, com o slot
+// como cursor; diretório de processo: só stat
+static int procfs_readdir(vnode_t *dir, uint32_t *position, struct dirent *entry) {
+    procfs_node_t *node = PROCFS_NODE(dir);
+    
+    if(node->type == PROCFS_PID_DIR) {
+        if(*position > 0) {
+            return 0;
+        }
+        entry->d_ino = pid_stats[node->slot].vnode.ino;
+        strcpy(entry->d_name, "stat");
+        *position = 1;
+        return 1;
+    }
+    
+    if(*position < PROCFS_FILE_COUNT) {
+        entry->d_ino = procfs_files[*position].vnode.ino;
+        strcpy(entry->d_name, procfs_file_names[*position]);
+        (*position)++;
+        return 1;
+    }
+    
+    process_stats_t stats;
+    for(uint32_t slot = *position - PROCFS_FILE_COUNT; slot < MAX_PROCESSES; slot++) {
+        if(scheduler_get_stats(slot, &stats) != 0) {
+            continue;
+        }
+        
+        // PID em decimal
+        char digits[10];
+        int count = 0;
+        uint32_t pid = stats.pid;
+        do {
+            digits[count++] = '0' + pid % 10;
+            pid /= 10;
+        } while(pid);
+        for(int i = 0; i < count; i++) {
+            entry->d_name[i] = digits[count - 1 - i];
+        }
+        entry->d_name[count] = '\0';
+        entry->d_ino = pid_dirs[slot].vnode.ino;
+        
+        *position = PROCFS_FILE_COUNT + slot + 1;
+        return 1;
+    }
+    
+    *position = PROCFS_FILE_COUNT + MAX_PROCESSES;
+    return 0;
+}
+
+// Operações do procfs
+filesystem_t procfs_operations = {
+    .name = "proc",
+    .flags = FS_NO_NEGATIVE,
+    .mount = procfs_mount,
+    .unmount = procfs_unmount,
+    .lookup = procfs_lookup,
+    .open = procfs_open,
+    .close = procfs_close,
+    .read = procfs_read,
+    .stat = procfs_stat,
+    .readdir = procfs_readdir
+};
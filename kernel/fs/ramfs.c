@@ -3,192 +3,516 @@
 #include <string.h>
 #include "vfs.h"
 #include "ramfs.h"
+#include "pmm.h"
+#include "radix.h"
 
-#define RAMFS_MAX_FILES 64
-#define RAMFS_MAX_FILENAME 64
-#define RAMFS_MAX_SIZE (1024 * 1024) // 1MB por arquivo
+#define RAMFS_PAGE_SIZE 4096
+#define RAMFS_DIR_MIN_BUCKETS 8      // Potência de 2
 
-// Estrutura para um arquivo no RAMFS
-typedef struct ramfs_file {
-    char name[RAMFS_MAX_FILENAME];
-    uint8_t *data;
-    size_t size;
-    size_t allocated;
-    int used;
-} ramfs_file_t;
+// Nó do RAMFS (arquivo ou diretório)
+typedef struct ramfs_node {
+    vnode_t vnode;                   // Precisa ser o primeiro campo
+    struct ramfs_node *parent;
+    struct ramfs_node *hash_next;    // Próximo nó no bucket do diretório pai
+    uint32_t hash;
+    
+    // Diretório: tabela hash de filhos
+    struct ramfs_node **buckets;
+    uint32_t bucket_count;
+    uint32_t entries;
+    
+    // Arquivo: páginas de conteúdo indexadas por offset / 4KB
+    // (buracos não ocupam memória e são lidos como zeros)
+    radix_tree_t pages;
+    uint32_t nr_pages;
+    
+    // Arquivo do initramfs: conteúdo original na memória do módulo.
+    // Páginas ainda não escritas são lidas de lá; a cópia só acontece
+    // na primeira escrita da página
+    const uint8_t *image;
+    uint32_t image_size;
+    
+    uint16_t name_len;
+    char name[];
+} ramfs_node_t;
 
-// Estrutura para o sistema de arquivos RAMFS
-typedef struct ramfs_data {
-    ramfs_file_t files[RAMFS_MAX_FILES];
-} ramfs_data_t;
+// Raiz do RAMFS montado
+static uint32_t ramfs_next_ino = 1;
 
-// Instância global do RAMFS
-static ramfs_data_t ramfs;
+#define RAMFS_NODE(v) ((ramfs_node_t*)(v))
 
-// Inicializa o RAMFS
-static int ramfs_mount(struct filesystem *fs, const char *device, const char *mountpoint) {
-    // Limpar tabela de arquivos
-    for(int i = 0; i < RAMFS_MAX_FILES; i++) {
-        ramfs.files[i].used = 0;
-        ramfs.files[i].data = NULL;
-        ramfs.files[i].size = 0;
-        ramfs.files[i].allocated = 0;
+// Aloca um nó
+static ramfs_node_t *ramfs_new_node(ramfs_node_t *parent, const char *name, size_t len, uint32_t mode) {
+    ramfs_node_t *node = malloc(sizeof(ramfs_node_t) + len + 1);
+    if(!node) {
+        return NULL;
     }
     
-    return 0;
+    node->vnode.ino = ramfs_next_ino++;
+    node->vnode.mode = mode;
+    node->vnode.size = 0;
+    node->vnode.mapping = NULL;
+    node->vnode.mmap_count = 0;
+    node->parent = parent;
+    node->hash_next = NULL;
+    node->hash = vfs_name_hash(name, len);
+    node->buckets = NULL;
+    node->bucket_count = 0;
+    node->entries = 0;
+    radix_init(&node->pages);
+    node->nr_pages = 0;
+    node->image = NULL;
+    node->image_size = 0;
+    node->name_len = len;
+    memcpy(node->name, name, len);
+    node->name[len] = '\0';
+    
+    // Diretórios começam com uma tabela pequena
+    if(S_ISDIR(mode)) {
+        node->buckets = malloc(RAMFS_DIR_MIN_BUCKETS * sizeof(ramfs_node_t*));
+        if(!node->buckets) {
+            free(node);
+            return NULL;
+        }
+        memset(node->buckets, 0, RAMFS_DIR_MIN_BUCKETS * sizeof(ramfs_node_t*));
+        node->bucket_count = RAMFS_DIR_MIN_BUCKETS;
+    }
+    
+    return node;
 }
 
-// Desmonta o RAMFS
-static int ramfs_unmount(const char *mountpoint) {
-    // Liberar memória de todos os arquivos
-    for(int i = 0; i < RAMFS_MAX_FILES; i++) {
-        if(ramfs.files[i].used && ramfs.files[i].data) {
-            free(ramfs.files[i].data);
-            ramfs.files[i].data = NULL;
-            ramfs.files[i].used = 0;
+// Preenche uma página nova com o conteúdo da imagem (ou zeros)
+static void ramfs_fill_page(ramfs_node_t *file, uint32_t index, uint8_t *page) {
+    uint32_t offset = index * RAMFS_PAGE_SIZE;
+    uint32_t bytes = 0;
+    
+    if(offset < file->image_size) {
+        bytes = file->image_size - offset;
+        if(bytes > RAMFS_PAGE_SIZE) {
+            bytes = RAMFS_PAGE_SIZE;
         }
+        memcpy(page, file->image + offset, bytes);
     }
     
-    return 0;
+    memset(page + bytes, 0, RAMFS_PAGE_SIZE - bytes);
 }
 
-// Encontra um arquivo pelo nome
-static ramfs_file_t *ramfs_find_file(const char *path) {
-    for(int i = 0; i < RAMFS_MAX_FILES; i++) {
-        if(ramfs.files[i].used && strcmp(ramfs.files[i].name, path) == 0) {
-            return &ramfs.files[i];
-        }
+// Libera as páginas a partir de um tamanho (truncamento)
+static void ramfs_truncate_pages(ramfs_node_t *file, uint32_t size) {
+    uint32_t first = (size + RAMFS_PAGE_SIZE - 1) / RAMFS_PAGE_SIZE;
+    uint32_t index;
+    void *page;
+    
+    // O que passar do novo tamanho deixa de vir da imagem
+    if(file->image_size > size) {
+        file->image_size = size;
     }
     
-    return NULL;
+    // Liberar todas as páginas inteiramente além do novo tamanho
+    while((page = radix_next(&file->pages, first, &index)) != NULL) {
+        radix_delete(&file->pages, index);
+        pmm_free_page(page);
+        file->nr_pages--;
+    }
+    
+    // Zerar o resto da última página para que uma extensão leia zeros
+    uint32_t tail = size % RAMFS_PAGE_SIZE;
+    if(tail) {
+        page = radix_lookup(&file->pages, size / RAMFS_PAGE_SIZE);
+        if(page) {
+            memset((uint8_t*)page + tail, 0, RAMFS_PAGE_SIZE - tail);
+        }
+    }
 }
 
-// Abre um arquivo no RAMFS
-static int ramfs_open(const char *path, int flags) {
-    ramfs_file_t *file = ramfs_find_file(path);
-    
-    // Se o arquivo não existe e estamos criando
-    if(!file && (flags & O_CREAT)) {
-        // Encontrar slot livre
-        int file_idx = -1;
-        for(int i = 0; i < RAMFS_MAX_FILES; i++) {
-            if(!ramfs.files[i].used) {
-                file_idx = i;
-                break;
+// Lê a partir de um offset; buracos são lidos como zeros
+static int ramfs_read_at(ramfs_node_t *file, uint32_t offset, void *buffer, size_t size) {
+    if(offset >= file->vnode.size) {
+        return 0;
+    }
+    
+    // Calcular quanto podemos ler
+    if(size > file->vnode.size - offset) {
+        size = file->vnode.size - offset;
+    }
+    
+    uint8_t *dst = buffer;
+    size_t remaining = size;
+    while(remaining > 0) {
+        uint32_t page_offset = offset % RAMFS_PAGE_SIZE;
+        size_t chunk = RAMFS_PAGE_SIZE - page_offset;
+        if(chunk > remaining) {
+            chunk = remaining;
+        }
+        
+        uint8_t *page = radix_lookup(&file->pages, offset / RAMFS_PAGE_SIZE);
+        if(page) {
+            memcpy(dst, page + page_offset, chunk);
+        } else if(offset < file->image_size) {
+            // Ainda não escrita: direto da imagem
+            size_t bytes = file->image_size - offset;
+            if(bytes > chunk) {
+                bytes = chunk;
             }
+            memcpy(dst, file->image + offset, bytes);
+            memset(dst + bytes, 0, chunk - bytes);
+        } else {
+            memset(dst, 0, chunk);
         }
         
-        if(file_idx == -1) {
-            return -1; // Sem slots disponíveis
+        dst += chunk;
+        offset += chunk;
+        remaining -= chunk;
+    }
+    
+    return size;
+}
+
+// Escreve a partir de um offset, alocando apenas as páginas tocadas;
+// dados existentes nunca são copiados
+static int ramfs_write_at(ramfs_node_t *file, uint32_t offset, const void *buffer, size_t size) {
+    // Limitar ao maior offset representável
+    if(size > 0xFFFFFFFF - offset) {
+        size = 0xFFFFFFFF - offset;
+    }
+    
+    const uint8_t *src = buffer;
+    size_t written = 0;
+    while(written < size) {
+        uint32_t index = offset / RAMFS_PAGE_SIZE;
+        uint32_t page_offset = offset % RAMFS_PAGE_SIZE;
+        size_t chunk = RAMFS_PAGE_SIZE - page_offset;
+        if(chunk > size - written) {
+            chunk = size - written;
         }
         
-        // Criar novo arquivo
-        strcpy(ramfs.files[file_idx].name, path);
-        ramfs.files[file_idx].size = 0;
-        ramfs.files[file_idx].allocated = 0;
-        ramfs.files[file_idx].data = NULL;
-        ramfs.files[file_idx].used = 1;
+        uint8_t *page = radix_lookup(&file->pages, index);
+        if(!page) {
+            page = pmm_alloc_page();
+            if(!page) {
+                break; // Sem memória
+            }
+            
+            // Página nova parcialmente escrita: o resto vem da imagem
+            // ou deve ler zeros
+            if(chunk != RAMFS_PAGE_SIZE) {
+                ramfs_fill_page(file, index, page);
+            }
+            
+            if(radix_insert(&file->pages, index, page) != 0) {
+                pmm_free_page(page);
+                break;
+            }
+            file->nr_pages++;
+        }
         
-        return file_idx;
+        memcpy(page + page_offset, src, chunk);
+        src += chunk;
+        offset += chunk;
+        written += chunk;
     }
     
-    // Se o arquivo não existe e não estamos criando
-    if(!file) {
-        return -1;
+    // Escrita vazia além do fim não estende o arquivo
+    if(written > 0 && offset > file->vnode.size) {
+        file->vnode.size = offset;
     }
     
-    // Encontrar índice do arquivo
-    for(int i = 0; i < RAMFS_MAX_FILES; i++) {
-        if(&ramfs.files[i] == file) {
-            return i;
+    return (written == 0 && size > 0) ? -1 : (int)written;
+}
+
+// Libera um nó e, recursivamente, seus filhos
+static void ramfs_free_node(ramfs_node_t *node) {
+    if(node->buckets) {
+        for(uint32_t i = 0; i < node->bucket_count; i++) {
+            ramfs_node_t *child = node->buckets[i];
+            while(child) {
+                ramfs_node_t *next = child->hash_next;
+                ramfs_free_node(child);
+                child = next;
+            }
         }
+        free(node->buckets);
     }
     
-    return -1; // Não deveria chegar aqui
+    ramfs_truncate_pages(node, 0);
+    
+    free(node);
 }
 
-// Lê de um arquivo no RAMFS
-static int ramfs_read(int fd, void *buffer, size_t size) {
-    if(fd < 0 || fd >= RAMFS_MAX_FILES || !ramfs.files[fd].used) {
-        return -1; // Descritor de arquivo inválido
+// Dobra a tabela de um diretório quando o fator de carga passa de 1
+static void ramfs_dir_grow(ramfs_node_t *dir) {
+    uint32_t new_count = dir->bucket_count * 2;
+    ramfs_node_t **new_buckets = malloc(new_count * sizeof(ramfs_node_t*));
+    if(!new_buckets) {
+        return; // Continua funcionando, só que com cadeias mais longas
     }
+    memset(new_buckets, 0, new_count * sizeof(ramfs_node_t*));
     
-    ramfs_file_t *file = &ramfs.files[fd];
+    for(uint32_t i = 0; i < dir->bucket_count; i++) {
+        ramfs_node_t *child = dir->buckets[i];
+        while(child) {
+            ramfs_node_t *next = child->hash_next;
+            uint32_t bucket = child->hash & (new_count - 1);
+            child->hash_next = new_buckets[bucket];
+            new_buckets[bucket] = child;
+            child = next;
+        }
+    }
     
-    // Verificar se há dados para ler
-    if(!file->data || file->size == 0) {
-        return 0;
+    free(dir->buckets);
+    dir->buckets = new_buckets;
+    dir->bucket_count = new_count;
+}
+
+// Insere um nó no diretório
+static void ramfs_dir_insert(ramfs_node_t *dir, ramfs_node_t *child) {
+    if(dir->entries >= dir->bucket_count) {
+        ramfs_dir_grow(dir);
     }
     
-    // Calcular quanto podemos ler
-    size_t bytes_to_read = size;
-    if(bytes_to_read > file->size) {
-        bytes_to_read = file->size;
+    uint32_t bucket = child->hash & (dir->bucket_count - 1);
+    child->hash_next = dir->buckets[bucket];
+    dir->buckets[bucket] = child;
+    dir->entries++;
+    dir->vnode.size = dir->entries;
+}
+
+// Procura um nome em um diretório
+static ramfs_node_t *ramfs_dir_find(ramfs_node_t *dir, const char *name, size_t len) {
+    uint32_t hash = vfs_name_hash(name, len);
+    ramfs_node_t *child = dir->buckets[hash & (dir->bucket_count - 1)];
+    
+    while(child) {
+        if(child->hash == hash && child->name_len == len &&
+           memcmp(child->name, name, len) == 0) {
+            return child;
+        }
+        child = child->hash_next;
     }
     
-    // Copiar dados
-    memcpy(buffer, file->data, bytes_to_read);
+    return NULL;
+}
+
+// Inicializa o RAMFS
+static int ramfs_mount(struct filesystem *fs, const char *device, vnode_t **root) {
+    (void)fs;
+    (void)device;
+    
+    ramfs_node_t *node = ramfs_new_node(NULL, "", 0, S_IFDIR);
+    if(!node) {
+        return -1;
+    }
+    node->parent = node;
     
-    return bytes_to_read;
+    *root = &node->vnode;
+    return 0;
+}
+
+// Desmonta o RAMFS
+static int ramfs_unmount(vnode_t *root) {
+    // Liberar memória de todos os arquivos e diretórios
+    ramfs_free_node(RAMFS_NODE(root));
+    return 0;
+}
+
+// Procura um componente dentro de um diretório
+static int ramfs_lookup(vnode_t *dir, const char *name, size_t len, vnode_t **result) {
+    if(!S_ISDIR(dir->mode)) {
+        return -1;
+    }
+    
+    ramfs_node_t *node = ramfs_dir_find(RAMFS_NODE(dir), name, len);
+    if(!node) {
+        return -1; // Não existe
+    }
+    
+    *result = &node->vnode;
+    return 0;
+}
+
+// Cria um nó em um diretório
+static int ramfs_create_node(vnode_t *dir, const char *name, size_t len, uint32_t mode, vnode_t **result) {
+    if(!S_ISDIR(dir->mode) || len == 0 || len > VFS_NAME_MAX) {
+        return -1;
+    }
+    
+    if(ramfs_dir_find(RAMFS_NODE(dir), name, len)) {
+        return -1; // Já existe
+    }
+    
+    ramfs_node_t *node = ramfs_new_node(RAMFS_NODE(dir), name, len, mode);
+    if(!node) {
+        return -1;
+    }
+    
+    ramfs_dir_insert(RAMFS_NODE(dir), node);
+    *result = &node->vnode;
+    return 0;
+}
+
+// Cria um arquivo regular
+static int ramfs_create(vnode_t *dir, const char *name, size_t len, int flags, vnode_t **result) {
+    (void)flags;
+    return ramfs_create_node(dir, name, len, S_IFREG, result);
+}
+
+// Cria um diretório
+static int ramfs_mkdir(vnode_t *dir, const char *name, size_t len, int mode, vnode_t **result) {
+    (void)mode;
+    return ramfs_create_node(dir, name, len, S_IFDIR, result);
+}
+
+// Abre um arquivo no RAMFS
+static int ramfs_open(vnode_t *node, int flags) {
+    (void)flags;
+    
+    // Diretórios não podem ser lidos como arquivos
+    if(S_ISDIR(node->mode)) {
+        return -1;
+    }
+    
+    return 0;
+}
+
+// Lê de um arquivo no RAMFS
+static int ramfs_read(vnode_t *vnode, uint32_t offset, void *buffer, size_t size) {
+    return ramfs_read_at(RAMFS_NODE(vnode), offset, buffer, size);
 }
 
 // Escreve em um arquivo no RAMFS
-static int ramfs_write(int fd, const void *buffer, size_t size) {
-    if(fd < 0 || fd >= RAMFS_MAX_FILES || !ramfs.files[fd].used) {
-        return -1; // Descritor de arquivo inválido
+static int ramfs_write(vnode_t *vnode, uint32_t offset, const void *buffer, size_t size) {
+    return ramfs_write_at(RAMFS_NODE(vnode), offset, buffer, size);
+}
+
+// Altera o tamanho de um arquivo; páginas além do fim são liberadas
+static int ramfs_truncate(vnode_t *vnode, uint32_t size) {
+    if(S_ISDIR(vnode->mode)) {
+        return -1;
     }
     
-    ramfs_file_t *file = &ramfs.files[fd];
+    if(size < vnode->size) {
+        ramfs_truncate_pages(RAMFS_NODE(vnode), size);
+    }
+    vnode->size = size;
     
-    // Verificar se precisamos alocar mais memória
-    if(file->size + size > file->allocated) {
-        size_t new_size = file->size + size;
-        
-        // Arredondar para múltiplo de 4KB
-        new_size = (new_size + 4095) & ~4095;
-        
-        // Limitar tamanho máximo
-        if(new_size > RAMFS_MAX_SIZE) {
-            new_size = RAMFS_MAX_SIZE;
+    return 0;
+}
+
+// Retorna a página que guarda index, alocando uma página (copiada da
+// imagem ou zerada) na primeira vez; o mmap mapeia essas páginas
+// diretamente, sem cópia
+static int ramfs_getpage(vnode_t *vnode, uint32_t index, void **result) {
+    ramfs_node_t *file = RAMFS_NODE(vnode);
+    if(S_ISDIR(vnode->mode)) {
+        return -1;
+    }
+    
+    void *page = radix_lookup(&file->pages, index);
+    if(!page) {
+        page = pmm_alloc_page();
+        if(!page) {
+            return -1;
         }
+        ramfs_fill_page(file, index, page);
         
-        // Realocar buffer
-        uint8_t *new_data = realloc(file->data, new_size);
-        if(!new_data) {
-            return -1; // Falha na alocação
+        if(radix_insert(&file->pages, index, page) != 0) {
+            pmm_free_page(page);
+            return -1;
         }
-        
-        file->data = new_data;
-        file->allocated = new_size;
+        file->nr_pages++;
     }
     
-    // Copiar dados
-    memcpy(file->data + file->size, buffer, size);
-    file->size += size;
-    
-    return size;
+    *result = page;
+    return 0;
 }
 
 // Fecha um arquivo no RAMFS
-static int ramfs_close(int fd) {
-    if(fd < 0 || fd >= RAMFS_MAX_FILES || !ramfs.files[fd].used) {
-        return -1; // Descritor de arquivo inválido
-    }
+static int ramfs_close(vnode_t *node) {
+    (void)node;
     
     // Não precisamos fazer nada especial para fechar
     return 0;
 }
 
+// Retorna informações sobre um nó
+static int ramfs_stat(vnode_t *node, struct stat *st) {
+    st->st_ino = node->ino;
+    st->st_mode = node->mode;
+    st->st_size = node->size;
+    return 0;
+}
+
 // Operações do sistema de arquivos RAMFS
 filesystem_t ramfs_operations = {
     .name = "ramfs",
     .mount = ramfs_mount,
     .unmount = ramfs_unmount,
+    .lookup = ramfs_lookup,
+    .create = ramfs_create,
     .open = ramfs_open,
     .close = ramfs_close,
     .read = ramfs_read,
     .write = ramfs_write,
-    .seek = NULL,  // Não implementado
-    .stat = NULL,  // Não implementado
-    .mkdir = NULL  // Não implementado
+    .stat = ramfs_stat,
+    .mkdir = ramfs_mkdir,
+    .truncate = ramfs_truncate,
+    .getpage = ramfs_getpage
 };
+
+// Cria um nó a partir da raiz de uma instância (ex.: "bin/sh"), criando
+// diretórios intermediários que faltarem. Arquivos regulares passam a ler
+// de data, que precisa continuar válido enquanto o nó existir (usado pelo
+// initramfs)
+int ramfs_create_image(vnode_t *root, const char *path, size_t len, uint32_t mode,
+                       const void *data, uint32_t size) {
+    if(!root || !S_ISDIR(root->mode)) {
+        return -1;
+    }
+    
+    ramfs_node_t *dir = RAMFS_NODE(root);
+    size_t pos = 0;
+    while(pos < len) {
+        // Próximo componente, ignorando "/" repetidas e "."; ".." não
+        // é aceito (sairia da raiz ou viraria um diretório com esse nome)
+        while(pos < len && path[pos] == '/') {
+            pos++;
+        }
+        size_t start = pos;
+        while(pos < len && path[pos] != '/') {
+            pos++;
+        }
+        size_t name_len = pos - start;
+        if(name_len == 0 || (name_len == 1 && path[start] == '.')) {
+            continue;
+        }
+        if(name_len == 2 && path[start] == '.' && path[start + 1] == '.') {
+            return -1;
+        }
+        
+        while(pos < len && path[pos] == '/') {
+            pos++;
+        }
+        int last = pos == len;
+        
+        ramfs_node_t *node = ramfs_dir_find(dir, path + start, name_len);
+        if(!node) {
+            vnode_t *created;
+            uint32_t node_mode = last ? mode : S_IFDIR;
+            if(ramfs_create_node(&dir->vnode, path + start, name_len, node_mode, &created) != 0) {
+                return -1;
+            }
+            node = RAMFS_NODE(created);
+            if(last && S_ISREG(mode)) {
+                node->image = data;
+                node->image_size = size;
+                node->vnode.size = size;
+            }
+        } else if(!S_ISDIR(node->vnode.mode) || (last && !S_ISDIR(mode))) {
+            return -1; // Já existe
+        }
+        
+        dir = node;
+    }
+    
+    return 0;
+}
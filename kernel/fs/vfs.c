@@ -1,65 +1,89 @@
 #include <stdint.h>
 #include <stddef.h>
+#include <string.h>
 #include "vfs.h"
+#include "dcache.h"
+#include "fdtable.h"
+#include "scheduler.h"
+#include "pagecache.h"
+#include "mmap.h"
+#include "vmm.h"
+#include "spinlock.h"
+#include "rcu.h"
+#include "trace.h"
 
 #define MAX_FILESYSTEMS 10
 #define MAX_MOUNTPOINTS 20
-#define MAX_OPEN_FILES 128
-
-// Estruturas para o VFS
-typedef struct filesystem {
-    char name[32];
-    // Operações do sistema de arquivos
-    int (*mount)(struct filesystem *fs, const char *device, const char *mountpoint);
-    int (*unmount)(const char *mountpoint);
-    int (*open)(const char *path, int flags);
-    int (*close)(int fd);
-    int (*read)(int fd, void *buffer, size_t size);
-    int (*write)(int fd, const void *buffer, size_t size);
-    int (*seek)(int fd, int offset, int whence);
-    int (*stat)(const char *path, struct stat *st);
-    int (*mkdir)(const char *path, int mode);
-} filesystem_t;
-
-typedef struct mountpoint {
-    char path[256];
-    char device[64];
-    filesystem_t *fs;
-    void *fs_data;
-    int mounted;
-} mountpoint_t;
 
+#define VFS_LOOKUP_CACHE_SIZE 64    // Potência de 2
+#define VFS_LOOKUP_CACHE_PATH 64
+
+// Arquivo aberto; compartilhado entre descritores duplicados
 typedef struct file {
-    int used;
-    char path[256];
     mountpoint_t *mount;
-    void *fs_data;
+    dentry_t *dentry;
+    vnode_t *node;
     uint32_t position;
     uint32_t flags;
+    uint32_t refcount;
 } file_t;
 
-// Tabelas globais
-static filesystem_t filesystems[MAX_FILESYSTEMS];
+// Tabelas globais. Sistemas de arquivos registrados nunca saem da tabela:
+// a busca por nome só lê ponteiros publicados com rcu_assign_pointer
+static filesystem_t *filesystems[MAX_FILESYSTEMS];
 static mountpoint_t mountpoints[MAX_MOUNTPOINTS];
-static file_t open_files[MAX_OPEN_FILES];
+
+// Montagem da raiz; as demais ficam penduradas nas dentries que cobrem.
+// Lidas sob RCU; alteradas com mount_lock, que também protege os slots
+// de mountpoints[]
+static mountpoint_t *root_mount = NULL;
+static spinlock_t filesystems_lock;
+static spinlock_t mount_lock;
+
+// Incrementado a cada montagem/desmontagem
+static volatile uint32_t mount_generation = 1;
+
+// Cache de caminhos completos já resolvidos; entradas de uma geração de
+// montagens anterior são descartadas quando encontradas
+typedef struct lookup_cache_entry {
+    uint32_t generation;    // 0 = vazia
+    uint32_t hash;
+    uint32_t len;
+    dentry_t *dentry;       // Referência mantida pelo cache
+    char path[VFS_LOOKUP_CACHE_PATH];
+} lookup_cache_entry_t;
+
+// Ordem dos locks: lookup_cache_lock antes do lock do dcache (dput)
+static lookup_cache_entry_t lookup_cache[VFS_LOOKUP_CACHE_SIZE];
+static spinlock_t lookup_cache_lock;
 
 // Inicializa o VFS
 void vfs_init() {
+    spin_lock_init(&filesystems_lock, "filesystems");
+    spin_lock_init(&mount_lock, "mounts");
+    spin_lock_init(&lookup_cache_lock, "lookup_cache");
+    
     // Limpar tabelas
     for(int i = 0; i < MAX_FILESYSTEMS; i++) {
-        filesystems[i].name[0] = '\0';
+        free(filesystems[i]);
+        filesystems[i] = NULL;
     }
     
     for(int i = 0; i < MAX_MOUNTPOINTS; i++) {
         mountpoints[i].mounted = 0;
     }
     
-    for(int i = 0; i < MAX_OPEN_FILES; i++) {
-        open_files[i].used = 0;
+    // Limpar caches de dentries e de caminhos
+    dcache_init();
+    for(int i = 0; i < VFS_LOOKUP_CACHE_SIZE; i++) {
+        lookup_cache[i].generation = 0;
     }
+    root_mount = NULL;
     
     // Registrar sistemas de arquivos padrão
     vfs_register_filesystem(&ramfs_operations);
+    vfs_register_filesystem(&ext2_operations);
+    vfs_register_filesystem(&procfs_operations);
     
     // Montar sistema de arquivos raiz
     vfs_mount("ramfs", NULL, "/");
@@ -67,219 +91,1038 @@ void vfs_init() {
 
 // Registra um sistema de arquivos
 int vfs_register_filesystem(filesystem_t *fs) {
+    // Copiar operações antes de publicar
+    filesystem_t *copy = malloc(sizeof(filesystem_t));
+    if(!copy) {
+        return -1;
+    }
+    *copy = *fs;
+    
+    spin_lock(&filesystems_lock);
     for(int i = 0; i < MAX_FILESYSTEMS; i++) {
-        if(filesystems[i].name[0] == '\0') {
-            // Copiar operações
-            filesystems[i] = *fs;
+        if(!filesystems[i]) {
+            rcu_assign_pointer(filesystems[i], copy);
+            spin_unlock(&filesystems_lock);
             return 0;
         }
     }
+    spin_unlock(&filesystems_lock);
+    
+    free(copy);
     return -1; // Sem slots disponíveis
 }
 
-// Monta um sistema de arquivos
-int vfs_mount(const char *fs_name, const char *device, const char *mountpoint) {
-    // Encontrar sistema de arquivos
-    filesystem_t *fs = NULL;
+// Procura um sistema de arquivos registrado pelo nome
+static filesystem_t *vfs_find_filesystem(const char *name) {
     for(int i = 0; i < MAX_FILESYSTEMS; i++) {
-        if(strcmp(filesystems[i].name, fs_name) == 0) {
-            fs = &filesystems[i];
+        filesystem_t *fs = rcu_dereference(filesystems[i]);
+        if(fs && strcmp(fs->name, name) == 0) {
+            return fs;
+        }
+    }
+    return NULL;
+}
+
+// Separa o próximo componente de *path (pulando barras repetidas)
+// Retorna o tamanho do componente; 0 indica fim do caminho
+static size_t vfs_next_component(const char **path, const char **name) {
+    const char *p = *path;
+    
+    while(*p == '/') {
+        p++;
+    }
+    
+    *name = p;
+    while(*p && *p != '/') {
+        p++;
+    }
+    
+    *path = p;
+    return p - *name;
+}
+
+// Atravessa as montagens penduradas em dentry
+static dentry_t *vfs_follow_mounts(dentry_t *dentry) {
+    mountpoint_t *mounted;
+    while(dentry && (mounted = rcu_dereference(dentry->mounted))) {
+        dentry = mounted->root;
+    }
+    return dentry;
+}
+
+// Resolve um componente dentro de dir, consultando o cache antes do
+// sistema de arquivos; nomes inexistentes viram entradas negativas.
+// Chamado sob rcu_read_lock(); a seção é interrompida (com dir
+// referenciado) enquanto o sistema de arquivos é consultado
+static dentry_t *vfs_lookup_component(dentry_t *dir, const char *name, size_t len) {
+    if(len == 1 && name[0] == '.') {
+        return dir;
+    }
+    if(len == 2 && name[0] == '.' && name[1] == '.') {
+        // Na raiz de uma montagem, subir para o sistema pai
+        while(dir == dir->mount->root && dir->mount->covered) {
+            dir = dir->mount->covered;
+        }
+        return dir->parent ? dir->parent : dir;
+    }
+    if(len > VFS_NAME_MAX) {
+        return NULL;
+    }
+    
+    uint32_t hash = vfs_name_hash(name, len);
+    dentry_t *dentry = dcache_lookup(dir, name, len, hash);
+    if(!dentry) {
+        // O lookup pode dormir (ext2 lê o disco)
+        if(!dget_rcu(dir)) {
+            return NULL;
+        }
+        rcu_read_unlock();
+        
+        vnode_t *node = NULL;
+        filesystem_t *fs = dir->mount->fs;
+        if(!fs->lookup || fs->lookup(dir->node, name, len, &node) != 0) {
+            node = NULL;
+        }
+        
+        rcu_read_lock();
+        if(!node && (fs->flags & FS_NO_NEGATIVE)) {
+            dput(dir);
+            return NULL;
+        }
+        dentry = dcache_add(dir, name, len, hash, node);
+        dput(dir);
+    }
+    
+    // Atravessar montagens em O(1): cada uma fica na dentry que cobre
+    return vfs_follow_mounts(dentry);
+}
+
+// Resolve um componente e devolve a dentry com uma referência
+static dentry_t *vfs_lookup_child(dentry_t *dir, const char *name, size_t len) {
+    rcu_read_lock();
+    dentry_t *dentry = vfs_lookup_component(dir, name, len);
+    if(dentry) {
+        dentry = dget_rcu(dentry);
+    }
+    rcu_read_unlock();
+    return dentry;
+}
+
+// Percorre o caminho sem tomar referências, sob rcu_read_lock()
+static int vfs_walk_parent_rcu(const char *path, dentry_t **parent,
+                               const char **last, size_t *last_len) {
+    mountpoint_t *root = rcu_dereference(root_mount);
+    if(!root) {
+        return -1; // Nada montado
+    }
+    
+    dentry_t *dir = vfs_follow_mounts(root->root);
+    const char *name;
+    size_t len = vfs_next_component(&path, &name);
+    
+    while(len > 0) {
+        const char *next_name;
+        const char *rest = path;
+        size_t next_len = vfs_next_component(&rest, &next_name);
+        
+        // Último componente
+        if(next_len == 0) {
             break;
         }
+        
+        dentry_t *dentry = vfs_lookup_component(dir, name, len);
+        vnode_t *node = dentry ? rcu_dereference(dentry->node) : NULL;
+        if(!node || !S_ISDIR(node->mode)) {
+            return -1; // Componente intermediário inexistente ou não é diretório
+        }
+        
+        dir = dentry;
+        name = next_name;
+        len = next_len;
+        path = rest;
+    }
+    
+    *parent = dir;
+    *last = name;
+    *last_len = len;
+    return 0;
+}
+
+// Percorre o caminho absoluto componente a componente até o diretório
+// pai do último componente, que é devolvido em last/last_len (vazio = raiz).
+// O pai volta com uma referência (dput)
+static int vfs_walk_parent(const char *path, dentry_t **parent,
+                           const char **last, size_t *last_len) {
+    rcu_read_lock();
+    int result = vfs_walk_parent_rcu(path, parent, last, last_len);
+    if(result == 0 && !dget_rcu(*parent)) {
+        result = -1;
+    }
+    rcu_read_unlock();
+    return result;
+}
+
+// Libera uma entrada do cache de caminhos (com lookup_cache_lock)
+static void lookup_cache_drop(lookup_cache_entry_t *entry) {
+    if(entry->generation) {
+        dput(entry->dentry);
+        entry->generation = 0;
+    }
+}
+
+// Esvazia o cache de caminhos (antes de descartar dentries)
+static void lookup_cache_flush() {
+    spin_lock(&lookup_cache_lock);
+    for(int i = 0; i < VFS_LOOKUP_CACHE_SIZE; i++) {
+        lookup_cache_drop(&lookup_cache[i]);
+    }
+    spin_unlock(&lookup_cache_lock);
+}
+
+// Procura um caminho completo no cache; a dentry volta referenciada
+static dentry_t *lookup_cache_get(const char *path, size_t len, uint32_t hash) {
+    if(len >= VFS_LOOKUP_CACHE_PATH) {
+        return NULL;
+    }
+    
+    spin_lock(&lookup_cache_lock);
+    lookup_cache_entry_t *entry = &lookup_cache[hash & (VFS_LOOKUP_CACHE_SIZE - 1)];
+    if(!entry->generation || entry->hash != hash || entry->len != len ||
+       memcmp(entry->path, path, len) != 0) {
+        spin_unlock(&lookup_cache_lock);
+        return NULL;
+    }
+    
+    // Montagens mudaram desde que o caminho foi resolvido
+    if(entry->generation != mount_generation) {
+        lookup_cache_drop(entry);
+        spin_unlock(&lookup_cache_lock);
+        return NULL;
+    }
+    
+    dentry_t *dentry = dget(entry->dentry);
+    spin_unlock(&lookup_cache_lock);
+    return dentry;
+}
+
+// Guarda um caminho resolvido (apenas entradas positivas); generation é
+// a de antes da busca, para não guardar o resultado de uma montagem que
+// foi desfeita no meio dela
+static void lookup_cache_put(const char *path, size_t len, uint32_t hash, dentry_t *dentry,
+                             uint32_t generation) {
+    if(len >= VFS_LOOKUP_CACHE_PATH || !dentry->node) {
+        return;
+    }
+    
+    spin_lock(&lookup_cache_lock);
+    if(generation != mount_generation) {
+        spin_unlock(&lookup_cache_lock);
+        return;
+    }
+    
+    lookup_cache_entry_t *entry = &lookup_cache[hash & (VFS_LOOKUP_CACHE_SIZE - 1)];
+    lookup_cache_drop(entry);
+    
+    memcpy(entry->path, path, len);
+    entry->hash = hash;
+    entry->len = len;
+    entry->dentry = dget(dentry);
+    entry->generation = generation;
+    spin_unlock(&lookup_cache_lock);
+}
+
+// Resolve um caminho absoluto até sua dentry, que volta com uma
+// referência (dput)
+static dentry_t *vfs_walk(const char *path) {
+    size_t path_len = strlen(path);
+    uint32_t path_hash = vfs_name_hash(path, path_len);
+    dentry_t *dentry = lookup_cache_get(path, path_len, path_hash);
+    if(dentry) {
+        return dentry;
+    }
+    
+    uint32_t generation = __atomic_load_n(&mount_generation, __ATOMIC_ACQUIRE);
+    dentry_t *dir;
+    const char *name;
+    size_t len;
+    rcu_read_lock();
+    if(vfs_walk_parent_rcu(path, &dir, &name, &len) != 0) {
+        rcu_read_unlock();
+        return NULL;
+    }
+    
+    dentry = len ? vfs_lookup_component(dir, name, len) : dir;
+    if(dentry) {
+        dentry = dget_rcu(dentry);
     }
+    rcu_read_unlock();
     
+    if(dentry) {
+        lookup_cache_put(path, path_len, path_hash, dentry, generation);
+    }
+    return dentry;
+}
+
+// Onde uma montagem fica pendurada: a dentry coberta ou a raiz
+static inline mountpoint_t **vfs_mount_link(dentry_t *covered) {
+    return covered ? &covered->mounted : &root_mount;
+}
+
+// Libera um slot reservado por vfs_mount
+static void vfs_mount_release(mountpoint_t *mount) {
+    spin_lock(&mount_lock);
+    mount->root = NULL;
+    mount->covered = NULL;
+    mount->parent = NULL;
+    mount->mounted = 0;
+    spin_unlock(&mount_lock);
+}
+
+// Monta um sistema de arquivos
+int vfs_mount(const char *fs_name, const char *device, const char *mountpoint) {
+    // Encontrar sistema de arquivos
+    filesystem_t *fs = vfs_find_filesystem(fs_name);
     if(!fs) {
         return -1; // Sistema de arquivos não encontrado
     }
     
-    // Encontrar slot de montagem livre
-    int mount_idx = -1;
+    // Resolver o diretório que será coberto (a primeira montagem é a raiz);
+    // a referência da busca passa a ser a da montagem
+    dentry_t *covered = NULL;
+    if(rcu_dereference(root_mount)) {
+        covered = vfs_walk(mountpoint);
+        if(!covered) {
+            return -1;
+        }
+        if(!covered->node || !S_ISDIR(covered->node->mode)) {
+            dput(covered);
+            return -1; // Ponto de montagem precisa ser um diretório existente
+        }
+    } else if(strcmp(mountpoint, "/") != 0) {
+        return -1;
+    }
+    
+    // Reservar slot de montagem livre; parent já vale para que o pai não
+    // seja desmontado enquanto esta montagem termina
+    spin_lock(&mount_lock);
+    mountpoint_t *mount = NULL;
     for(int i = 0; i < MAX_MOUNTPOINTS; i++) {
         if(!mountpoints[i].mounted) {
-            mount_idx = i;
+            mount = &mountpoints[i];
             break;
         }
     }
     
-    if(mount_idx == -1) {
+    if(!mount) {
+        spin_unlock(&mount_lock);
+        if(covered) {
+            dput(covered);
+        }
         return -1; // Sem slots disponíveis
     }
     
+    mount->mounted = 1;
+    mount->root = NULL;
+    mount->covered = covered;
+    mount->parent = covered ? covered->mount : NULL;
+    spin_unlock(&mount_lock);
+    
     // Configurar ponto de montagem
-    strcpy(mountpoints[mount_idx].path, mountpoint);
+    strcpy(mount->path, mountpoint);
     if(device) {
-        strcpy(mountpoints[mount_idx].device, device);
+        strcpy(mount->device, device);
     } else {
-        mountpoints[mount_idx].device[0] = '\0';
+        mount->device[0] = '\0';
+    }
+    
+    // Chamar operação de montagem do sistema de arquivos (pode dormir,
+    // fora dos locks)
+    vnode_t *root = NULL;
+    if(!fs->mount || fs->mount(fs, device, &root) != 0 || !root) {
+        vfs_mount_release(mount);
+        if(covered) {
+            dput(covered);
+        }
+        return -1;
     }
     
-    mountpoints[mount_idx].fs = fs;
-    mountpoints[mount_idx].mounted = 1;
+    mount->fs = fs;
+    mount->fs_data = root;
+    mount->root = dcache_alloc_root(mount, root);
+    if(!mount->root) {
+        if(fs->unmount) {
+            fs->unmount(root);
+        }
+        vfs_mount_release(mount);
+        if(covered) {
+            dput(covered);
+        }
+        return -1;
+    }
     
-    // Chamar operação de montagem do sistema de arquivos
-    if(fs->mount) {
-        return fs->mount(fs, device, mountpoint);
+    // Pendurar a montagem na dentry coberta, se ninguém montou ali antes
+    spin_lock(&mount_lock);
+    mountpoint_t **link = vfs_mount_link(covered);
+    if(*link) {
+        spin_unlock(&mount_lock);
+        if(fs->unmount) {
+            fs->unmount(root);
+        }
+        dcache_prune_mount(mount);
+        vfs_mount_release(mount);
+        if(covered) {
+            dput(covered);
+        }
+        return -1;
     }
+    rcu_assign_pointer(*link, mount);
+    mount_generation++;
+    spin_unlock(&mount_lock);
     
     return 0;
 }
 
 // Desmonta um sistema de arquivos
 int vfs_unmount(const char *mountpoint) {
-    // Encontrar ponto de montagem
+    // Encontrar ponto de montagem pela própria árvore de dentries
+    dentry_t *dentry = vfs_walk(mountpoint);
+    if(!dentry) {
+        return -1;
+    }
+    mountpoint_t *mount = dentry->mount;
+    int is_root = dentry == mount->root;
+    dput(dentry);
+    if(!is_root) {
+        return -1; // Ponto de montagem não encontrado
+    }
+    
+    // Ocupada: arquivos abertos ou mapeados apontam para nós que o
+    // sistema de arquivos liberaria. As referências do cache de caminhos
+    // não contam, ele é esvaziado antes
+    lookup_cache_flush();
+    if(dcache_mount_busy(mount)) {
+        return -1;
+    }
+    
+    spin_lock(&mount_lock);
+    
+    // Outra desmontagem pode ter chegado antes
+    mountpoint_t **link = vfs_mount_link(mount->covered);
+    if(*link != mount) {
+        spin_unlock(&mount_lock);
+        return -1;
+    }
+    
+    // Não desmontar enquanto houver montagens filhas
     for(int i = 0; i < MAX_MOUNTPOINTS; i++) {
-        if(mountpoints[i].mounted && strcmp(mountpoints[i].path, mountpoint) == 0) {
-            // Chamar operação de desmontagem do sistema de arquivos
-            if(mountpoints[i].fs->unmount) {
-                int result = mountpoints[i].fs->unmount(mountpoint);
-                if(result != 0) {
-                    return result;
-                }
-            }
-            
-            // Limpar ponto de montagem
-            mountpoints[i].mounted = 0;
-            return 0;
+        if(mountpoints[i].mounted && mountpoints[i].parent == mount) {
+            spin_unlock(&mount_lock);
+            return -1;
         }
     }
     
-    return -1; // Ponto de montagem não encontrado
-}
-
-// Encontra o ponto de montagem para um caminho
-mountpoint_t *vfs_find_mountpoint(const char *path) {
-    mountpoint_t *best_match = NULL;
-    size_t best_match_len = 0;
+    // Despendurar: buscas novas param na dentry coberta
+    rcu_assign_pointer(*link, NULL);
+    mount_generation++;
+    spin_unlock(&mount_lock);
     
-    for(int i = 0; i < MAX_MOUNTPOINTS; i++) {
-        if(mountpoints[i].mounted) {
-            size_t mount_len = strlen(mountpoints[i].path);
-            
-            // Verificar se este ponto de montagem é um prefixo do caminho
-            if(strncmp(path, mountpoints[i].path, mount_len) == 0) {
-                // Verificar se é o melhor match até agora
-                if(mount_len > best_match_len) {
-                    best_match = &mountpoints[i];
-                    best_match_len = mount_len;
-                }
-            }
+    // O cache de caminhos pode referenciar dentries desta montagem; depois
+    // do período de graça nenhuma busca ainda está dentro dela
+    lookup_cache_flush();
+    synchronize_rcu();
+    
+    // Um open pode ter entrado entre a verificação e o desligamento;
+    // agora nenhuma busca nova alcança a montagem
+    if(dcache_mount_busy(mount)) {
+        spin_lock(&mount_lock);
+        rcu_assign_pointer(*link, mount);
+        mount_generation++;
+        spin_unlock(&mount_lock);
+        return -1;
+    }
+    
+    // Escrever e descartar as páginas em cache antes que os nós sumam
+    pagecache_release_mount(mount);
+    
+    // Chamar operação de desmontagem do sistema de arquivos
+    if(mount->fs->unmount) {
+        int result = mount->fs->unmount(mount->root->node);
+        if(result != 0) {
+            // Continua montado
+            spin_lock(&mount_lock);
+            rcu_assign_pointer(*link, mount);
+            mount_generation++;
+            spin_unlock(&mount_lock);
+            return result;
         }
     }
     
-    return best_match;
+    // Soltar a dentry coberta
+    if(mount->covered) {
+        dput(mount->covered);
+    }
+    
+    // Descartar dentries e limpar ponto de montagem
+    dcache_prune_mount(mount);
+    vfs_mount_release(mount);
+    
+    return 0;
+}
+
+// Nó raiz do sistema montado em "/", se ele for do tipo fs_name (o
+// initramfs preenche o ramfs da raiz direto, sem passar pelos caminhos)
+vnode_t *vfs_root_node(const char *fs_name) {
+    vnode_t *node = NULL;
+    
+    rcu_read_lock();
+    mountpoint_t *root = rcu_dereference(root_mount);
+    if(root && strcmp(root->fs->name, fs_name) == 0) {
+        node = root->root->node;
+    }
+    rcu_read_unlock();
+    return node;
 }
 
 // Abre um arquivo
 int vfs_open(const char *path, int flags) {
-    // Encontrar ponto de montagem
-    mountpoint_t *mount = vfs_find_mountpoint(path);
-    if(!mount) {
-        return -1; // Caminho não montado
+    return vfs_open_files(scheduler_current_files(), path, flags);
+}
+
+// Abre um arquivo instalando o descritor em uma tabela dada (usado por
+// io_ring, que executa operações em nome de outro processo)
+int vfs_open_files(fd_table_t *table, const char *path, int flags) {
+    if(!table) {
+        return -1;
     }
     
-    // Calcular caminho relativo ao ponto de montagem
-    const char *rel_path = path + strlen(mount->path);
-    if(*rel_path == '/') rel_path++; // Pular barra inicial
-    
-    // Encontrar slot de arquivo livre
-    int fd = -1;
-    for(int i = 0; i < MAX_OPEN_FILES; i++) {
-        if(!open_files[i].used) {
-            fd = i;
-            break;
+    // Resolver o caminho; se não existir, criar pelo diretório pai
+    dentry_t *dentry = vfs_walk(path);
+    if(!dentry || !dentry->node) {
+        if(dentry) {
+            dput(dentry);
+        }
+        
+        dentry_t *dir;
+        const char *name;
+        size_t len;
+        if(!(flags & O_CREAT) || vfs_walk_parent(path, &dir, &name, &len) != 0) {
+            return -1;
+        }
+        
+        dentry = len ? vfs_lookup_child(dir, name, len) : NULL;
+        if(!dentry) {
+            dput(dir);
+            return -1;
         }
+        
+        // Entrada negativa: criar o arquivo
+        if(!dentry->node) {
+            vnode_t *node = NULL;
+            filesystem_t *fs = dir->mount->fs;
+            if(!fs->create || fs->create(dir->node, name, len, flags, &node) != 0) {
+                dput(dentry);
+                dput(dir);
+                return -1;
+            }
+            dcache_instantiate(dentry, node);
+        }
+        dput(dir);
     }
     
-    if(fd == -1) {
-        return -1; // Sem slots disponíveis
+    mountpoint_t *mount = dentry->mount;
+    
+    // Descartar o conteúdo se pedido
+    if((flags & O_TRUNC) && S_ISREG(dentry->node->mode)) {
+        if(dentry->node->mmap_count > 0) {
+            dput(dentry);
+            return -1; // Páginas mapeadas não podem ser liberadas
+        }
+        if(!mount->fs->truncate || mount->fs->truncate(dentry->node, 0) != 0) {
+            dput(dentry);
+            return -1;
+        }
+        pagecache_truncate(dentry->node, 0);
     }
     
+    return vfs_open_dentry(table, dentry, flags);
+}
+
+// Abre a dentry já resolvida (a referência passa para o arquivo, ou é
+// solta em caso de erro) e instala o arquivo na tabela. Também usado por
+// quem cria nós fora da árvore de diretórios, como os pipes
+int vfs_open_dentry(fd_table_t *table, dentry_t *dentry, int flags) {
+    mountpoint_t *mount = dentry->mount;
+    
     // Chamar operação de abertura do sistema de arquivos
-    int fs_fd = -1;
     if(mount->fs->open) {
-        fs_fd = mount->fs->open(rel_path, flags);
-        if(fs_fd < 0) {
-            return fs_fd;
+        int result = mount->fs->open(dentry->node, flags);
+        if(result < 0) {
+            dput(dentry);
+            return result;
         }
     }
     
     // Configurar arquivo aberto
-    open_files[fd].used = 1;
-    strcpy(open_files[fd].path, path);
-    open_files[fd].mount = mount;
-    open_files[fd].fs_data = (void*)(intptr_t)fs_fd;
-    open_files[fd].position = 0;
-    open_files[fd].flags = flags;
+    file_t *file = malloc(sizeof(file_t));
+    if(!file) {
+        if(mount->fs->close) {
+            mount->fs->close(dentry->node);
+        }
+        dput(dentry);
+        return -1;
+    }
+    
+    // A referência da busca passa a ser do arquivo
+    file->mount = mount;
+    file->dentry = dentry;
+    file->node = dentry->node;
+    file->position = 0;
+    file->flags = flags;
+    file->refcount = 1;
+    
+    // Menor descritor livre do processo
+    int fd = fd_alloc(table, file);
+    TRACE(TRACE_VFS_OPEN, fd, file->node->ino);
+    if(fd < 0) {
+        vfs_file_release(file);
+    }
     
     return fd;
 }
 
+// Cria um diretório
+int vfs_mkdir(const char *path, int mode) {
+    dentry_t *dir;
+    const char *name;
+    size_t len;
+    if(vfs_walk_parent(path, &dir, &name, &len) != 0) {
+        return -1;
+    }
+    
+    filesystem_t *fs = dir->mount->fs;
+    dentry_t *dentry = len && fs->mkdir ? vfs_lookup_child(dir, name, len) : NULL;
+    if(!dentry || dentry->node) {
+        if(dentry) {
+            dput(dentry);
+        }
+        dput(dir);
+        return -1; // Já existe
+    }
+    
+    vnode_t *node = NULL;
+    int result = fs->mkdir(dir->node, name, len, mode, &node);
+    if(result == 0) {
+        dcache_instantiate(dentry, node);
+    }
+    
+    dput(dentry);
+    dput(dir);
+    return result == 0 ? 0 : -1;
+}
+
+// Obtém informações sobre um caminho
+int vfs_stat(const char *path, struct stat *st) {
+    dentry_t *dentry = vfs_walk(path);
+    if(!dentry || !dentry->node) {
+        if(dentry) {
+            dput(dentry);
+        }
+        return -1;
+    }
+    
+    int result = 0;
+    filesystem_t *fs = dentry->mount->fs;
+    if(fs->stat) {
+        result = fs->stat(dentry->node, st);
+    } else {
+        st->st_ino = dentry->node->ino;
+        st->st_mode = dentry->node->mode;
+        st->st_size = dentry->node->size;
+    }
+    
+    dput(dentry);
+    return result;
+}
+
+// Altera o tamanho de um arquivo
+int vfs_truncate(const char *path, uint32_t size) {
+    dentry_t *dentry = vfs_walk(path);
+    if(!dentry || !dentry->node) {
+        if(dentry) {
+            dput(dentry);
+        }
+        return -1;
+    }
+    
+    // Páginas mapeadas não podem ser liberadas
+    int result = -1;
+    filesystem_t *fs = dentry->mount->fs;
+    if(fs->truncate && !(dentry->node->mmap_count > 0 && size < dentry->node->size)) {
+        result = fs->truncate(dentry->node, size);
+        if(result == 0) {
+            pagecache_truncate(dentry->node, size);
+        }
+    }
+    
+    dput(dentry);
+    return result;
+}
+
+// Valida um descritor do processo atual e retorna o arquivo aberto
+static file_t *vfs_get_file(int fd) {
+    fd_table_t *table = scheduler_current_files();
+    if(!table) {
+        return NULL;
+    }
+    
+    return fd_get(table, fd);
+}
+
+// Lê a partir de um offset sem alterar a posição do arquivo
+static int vfs_read_at(file_t *file, uint32_t offset, void *buffer, size_t size) {
+    filesystem_t *fs = file->mount->fs;
+    if(S_ISDIR(file->node->mode)) {
+        return -1; // Diretórios são lidos com vfs_readdir
+    }
+    
+    TRACE(TRACE_VFS_READ, file->node->ino, size);
+    int result = -1;
+    if(fs->readpage) {
+        result = pagecache_read(file->mount, file->node, offset, buffer, size);
+    } else if(fs->read) {
+        result = fs->read(file->node, offset, buffer, size);
+    }
+    TRACE(TRACE_VFS_READ_END, file->node->ino, result);
+    
+    return result;
+}
+
+// Escreve a partir de um offset sem alterar a posição do arquivo
+static int vfs_write_at(file_t *file, uint32_t offset, const void *buffer, size_t size) {
+    filesystem_t *fs = file->mount->fs;
+    TRACE(TRACE_VFS_WRITE, file->node->ino, size);
+    int result = -1;
+    if(fs->readpage && fs->writepage) {
+        result = pagecache_write(file->mount, file->node, offset, buffer, size);
+    } else if(fs->write) {
+        result = fs->write(file->node, offset, buffer, size);
+    }
+    TRACE(TRACE_VFS_WRITE_END, file->node->ino, result);
+    
+    return result;
+}
+
+// Offset da próxima escrita (fim do arquivo com O_APPEND)
+static uint32_t vfs_write_offset(file_t *file) {
+    return (file->flags & O_APPEND) ? file->node->size : file->position;
+}
+
 // Lê de um arquivo
 int vfs_read(int fd, void *buffer, size_t size) {
-    if(fd < 0 || fd >= MAX_OPEN_FILES || !open_files[fd].used) {
+    file_t *file = vfs_get_file(fd);
+    if(!file) {
         return -1; // Descritor de arquivo inválido
     }
     
     // Chamar operação de leitura do sistema de arquivos
-    if(open_files[fd].mount->fs->read) {
-        int bytes_read = open_files[fd].mount->fs->read(
-            (int)(intptr_t)open_files[fd].fs_data, 
-            buffer, 
-            size
-        );
-        
-        if(bytes_read > 0) {
-            open_files[fd].position += bytes_read;
-        }
-        
-        return bytes_read;
+    int bytes_read = vfs_read_at(file, file->position, buffer, size);
+    if(bytes_read > 0) {
+        file->position += bytes_read;
     }
     
-    return -1;
+    return bytes_read;
 }
 
 // Escreve em um arquivo
 int vfs_write(int fd, const void *buffer, size_t size) {
-    if(fd < 0 || fd >= MAX_OPEN_FILES || !open_files[fd].used) {
+    file_t *file = vfs_get_file(fd);
+    if(!file) {
         return -1; // Descritor de arquivo inválido
     }
     
     // Chamar operação de escrita do sistema de arquivos
-    if(open_files[fd].mount->fs->write) {
-        int bytes_written = open_files[fd].mount->fs->write(
-            (int)(intptr_t)open_files[fd].fs_data, 
-            buffer, 
-            size
-        );
+    uint32_t offset = vfs_write_offset(file);
+    int bytes_written = vfs_write_at(file, offset, buffer, size);
+    if(bytes_written > 0) {
+        file->position = offset + bytes_written;
+    }
+    
+    return bytes_written;
+}
+
+// Lê de um offset sem usar nem alterar a posição compartilhada
+int vfs_pread(int fd, void *buffer, size_t size, uint32_t offset) {
+    file_t *file = vfs_get_file(fd);
+    if(!file || S_ISFIFO(file->node->mode)) {
+        return -1;
+    }
+    
+    return vfs_read_at(file, offset, buffer, size);
+}
+
+// Escreve em um offset sem usar nem alterar a posição compartilhada
+int vfs_pwrite(int fd, const void *buffer, size_t size, uint32_t offset) {
+    file_t *file = vfs_get_file(fd);
+    if(!file || S_ISFIFO(file->node->mode)) {
+        return -1;
+    }
+    
+    return vfs_write_at(file, offset, buffer, size);
+}
+
+// Reposiciona um arquivo; retorna a nova posição
+int vfs_lseek(int fd, int offset, int whence) {
+    file_t *file = vfs_get_file(fd);
+    if(!file || S_ISFIFO(file->node->mode)) {
+        return -1;
+    }
+    
+    int64_t base;
+    switch(whence) {
+        case SEEK_SET: base = 0; break;
+        case SEEK_CUR: base = file->position; break;
+        case SEEK_END: base = file->node->size; break;
+        default: return -1;
+    }
+    
+    int64_t position = base + offset;
+    if(position < 0 || position > 0x7FFFFFFF) {
+        return -1; // Não cabe no valor de retorno
+    }
+    
+    file->position = (uint32_t)position;
+    return (int)position;
+}
+
+// Lê a próxima entrada de um diretório aberto; a posição do arquivo é
+// o cursor do sistema de arquivos. Retorna 1 com entrada, 0 no fim
+int vfs_readdir(int fd, struct dirent *entry) {
+    file_t *file = vfs_get_file(fd);
+    if(!file || !S_ISDIR(file->node->mode)) {
+        return -1;
+    }
+    
+    filesystem_t *fs = file->mount->fs;
+    if(!fs->readdir) {
+        return -1;
+    }
+    
+    return fs->readdir(file->node, &file->position, entry);
+}
+
+// Lê para vários buffers em uma única chamada
+int vfs_readv(int fd, const struct iovec *iov, int iovcnt) {
+    file_t *file = vfs_get_file(fd);
+    if(!file || iovcnt < 0) {
+        return -1;
+    }
+    
+    int total = 0;
+    for(int i = 0; i < iovcnt; i++) {
+        int bytes_read = vfs_read_at(file, file->position, iov[i].iov_base, iov[i].iov_len);
+        if(bytes_read < 0) {
+            return total ? total : bytes_read;
+        }
         
-        if(bytes_written > 0) {
-            open_files[fd].position += bytes_written;
+        file->position += bytes_read;
+        total += bytes_read;
+        
+        // Leitura curta: fim do arquivo
+        if((size_t)bytes_read < iov[i].iov_len) {
+            break;
+        }
+    }
+    
+    return total;
+}
+
+// Escreve de vários buffers em uma única chamada
+int vfs_writev(int fd, const struct iovec *iov, int iovcnt) {
+    file_t *file = vfs_get_file(fd);
+    if(!file || iovcnt < 0) {
+        return -1;
+    }
+    
+    uint32_t offset = vfs_write_offset(file);
+    int total = 0;
+    for(int i = 0; i < iovcnt; i++) {
+        int bytes_written = vfs_write_at(file, offset, iov[i].iov_base, iov[i].iov_len);
+        if(bytes_written < 0) {
+            if(total == 0) {
+                return bytes_written;
+            }
+            break;
         }
         
-        return bytes_written;
+        offset += bytes_written;
+        total += bytes_written;
+        
+        if((size_t)bytes_written < iov[i].iov_len) {
+            break;
+        }
     }
     
-    return -1;
+    file->position = offset;
+    return total;
+}
+
+// Solta uma referência a um arquivo aberto; a última fecha de fato
+void vfs_file_release(file_t *file) {
+    if(--file->refcount > 0) {
+        return;
+    }
+    
+    // Chamar operação de fechamento do sistema de arquivos
+    if(file->mount->fs->close) {
+        file->mount->fs->close(file->node);
+    }
+    
+    dput(file->dentry);
+    free(file);
 }
 
 // Fecha um arquivo
 int vfs_close(int fd) {
-    if(fd < 0 || fd >= MAX_OPEN_FILES || !open_files[fd].used) {
+    return vfs_close_files(scheduler_current_files(), fd);
+}
+
+// Fecha um descritor de uma tabela dada
+int vfs_close_files(fd_table_t *table, int fd) {
+    file_t *file = table ? fd_remove(table, fd) : NULL;
+    if(!file) {
         return -1; // Descritor de arquivo inválido
     }
     
-    // Chamar operação de fechamento do sistema de arquivos
-    if(open_files[fd].mount->fs->close) {
-        int result = open_files[fd].mount->fs->close(
-            (int)(intptr_t)open_files[fd].fs_data
-        );
-        
-        if(result != 0) {
-            return result;
-        }
+    vfs_file_release(file);
+    return 0;
+}
+
+// Escreve as páginas sujas de um arquivo aberto
+int vfs_fsync(int fd) {
+    return vfs_fsync_files(scheduler_current_files(), fd);
+}
+
+int vfs_fsync_files(fd_table_t *table, int fd) {
+    file_t *file = table ? fd_get(table, fd) : NULL;
+    if(!file) {
+        return -1;
     }
     
-    // Limpar slot de arquivo
-    open_files[fd].used = 0;
-    return 0;
+    return pagecache_sync(file->node);
+}
+
+// Lê de um descritor de uma tabela dada; com VFS_OFFSET_CURRENT usa e
+// avança a posição do arquivo, como vfs_read
+int vfs_read_files(fd_table_t *table, int fd, void *buffer, size_t size, uint32_t offset) {
+    file_t *file = table ? fd_get(table, fd) : NULL;
+    if(!file) {
+        return -1;
+    }
+    
+    if(offset != VFS_OFFSET_CURRENT) {
+        return vfs_read_at(file, offset, buffer, size);
+    }
+    
+    int bytes_read = vfs_read_at(file, file->position, buffer, size);
+    if(bytes_read > 0) {
+        file->position += bytes_read;
+    }
+    return bytes_read;
+}
+
+// Escreve em um descritor de uma tabela dada (ver vfs_read_files)
+int vfs_write_files(fd_table_t *table, int fd, const void *buffer, size_t size, uint32_t offset) {
+    file_t *file = table ? fd_get(table, fd) : NULL;
+    if(!file) {
+        return -1;
+    }
+    
+    if(offset != VFS_OFFSET_CURRENT) {
+        return vfs_write_at(file, offset, buffer, size);
+    }
+    
+    offset = vfs_write_offset(file);
+    int bytes_written = vfs_write_at(file, offset, buffer, size);
+    if(bytes_written > 0) {
+        file->position = offset + bytes_written;
+    }
+    return bytes_written;
+}
+
+// Mapeia um arquivo aberto no espaço de endereçamento do processo; com
+// MAP_ANONYMOUS fd e offset são ignorados
+void *vfs_mmap(void *addr, size_t length, int prot, int flags, int fd, uint32_t offset) {
+    mm_t *mm = scheduler_current_mm();
+    if(mm && (flags & MAP_ANONYMOUS)) {
+        return mmap_region(mm, (uintptr_t)addr, length, prot, flags, NULL, NULL, 0);
+    }
+    
+    file_t *file = vfs_get_file(fd);
+    if(!file || !mm || (offset & (PAGE_SIZE - 1))) {
+        return MAP_FAILED;
+    }
+    
+    // Permissões do mapeamento limitadas pelo modo de abertura
+    int access = file->flags & (O_WRONLY | O_RDWR);
+    if(access == O_WRONLY) {
+        return MAP_FAILED;
+    }
+    if((flags & MAP_SHARED) && (prot & PROT_WRITE) && access != O_RDWR) {
+        return MAP_FAILED;
+    }
+    
+    return mmap_region(mm, (uintptr_t)addr, length, prot, flags, file->mount,
+                       file->dentry, offset >> PAGE_SHIFT);
+}
+
+// Remove mapeamentos do processo atual
+int vfs_munmap(void *addr, size_t length) {
+    mm_t *mm = scheduler_current_mm();
+    return mm ? mmap_unmap(mm, (uintptr_t)addr, length) : -1;
+}
+
+// Escreve de volta as páginas modificadas de um mapeamento compartilhado
+int vfs_msync(void *addr, size_t length, int flags) {
+    mm_t *mm = scheduler_current_mm();
+    return mm ? mmap_sync(mm, (uintptr_t)addr, length, flags) : -1;
+}
+
+// Duplica um descritor no menor número livre
+int vfs_dup(int fd) {
+    file_t *file = vfs_get_file(fd);
+    if(!file) {
+        return -1;
+    }
+    
+    int new_fd = fd_alloc(scheduler_current_files(), file);
+    if(new_fd >= 0) {
+        file->refcount++;
+    }
+    
+    return new_fd;
+}
+
+// Duplica um descritor em um número específico, fechando o anterior
+int vfs_dup2(int fd, int new_fd) {
+    file_t *file = vfs_get_file(fd);
+    if(!file) {
+        return -1;
+    }
+    
+    if(fd == new_fd) {
+        return new_fd;
+    }
+    
+    fd_table_t *table = scheduler_current_files();
+    file_t *old = fd_remove(table, new_fd);
+    if(old) {
+        vfs_file_release(old);
+    }
+    
+    if(fd_install(table, new_fd, file) < 0) {
+        return -1;
+    }
+    
+    file->refcount++;
+    return new_fd;
 }
@@ -0,0 +1,168 @@
+#ifndef VFS_H
+#define VFS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Flags de abertura
+#define O_RDONLY 0x0000
+#define O_WRONLY 0x0001
+#define O_RDWR   0x0002
+#define O_CREAT  0x0040
+#define O_TRUNC  0x0200
+#define O_APPEND 0x0400
+#define O_NONBLOCK 0x0800
+
+// Retornos negativos além de -1 (valores do errno do Linux)
+#define VFS_EAGAIN (-11)    // O_NONBLOCK: a operação teria que esperar
+#define VFS_EPIPE  (-32)    // Escrita num pipe sem leitores
+
+// Origem de vfs_lseek
+#define SEEK_SET 0
+#define SEEK_CUR 1
+#define SEEK_END 2
+
+// Tipos de vnode (campo mode)
+#define S_IFMT   0xF000
+#define S_IFIFO  0x1000
+#define S_IFDIR  0x4000
+#define S_IFREG  0x8000
+#define S_ISFIFO(m) (((m) & S_IFMT) == S_IFIFO)
+#define S_ISDIR(m) (((m) & S_IFMT) == S_IFDIR)
+#define S_ISREG(m) (((m) & S_IFMT) == S_IFREG)
+
+// Offset de vfs_read_files/vfs_write_files que usa a posição do arquivo
+#define VFS_OFFSET_CURRENT 0xFFFFFFFFu
+
+// Tamanho máximo de um componente de caminho
+#define VFS_NAME_MAX 255
+
+struct stat {
+    uint32_t st_ino;
+    uint32_t st_mode;
+    uint32_t st_size;
+};
+
+// Entrada devolvida por vfs_readdir
+struct dirent {
+    uint32_t d_ino;
+    char d_name[VFS_NAME_MAX + 1];
+};
+
+// Buffer de E/S vetorizada
+struct iovec {
+    void *iov_base;
+    size_t iov_len;
+};
+
+// Nó genérico; cada sistema de arquivos embute um vnode_t como
+// primeiro campo do seu próprio nó
+typedef struct vnode {
+    uint32_t ino;
+    uint32_t mode;
+    uint32_t size;
+    struct page_mapping *mapping;   // Páginas em cache (mm/pagecache.c)
+    uint32_t mmap_count;            // Regiões mapeadas (mm/mmap.c)
+} vnode_t;
+
+// Flags de um sistema de arquivos
+#define FS_NO_NEGATIVE 0x1  // Nomes surgem sem create (procfs): não guardar entradas negativas
+
+// Operações de um sistema de arquivos (todas sobre nós, não caminhos;
+// a resolução de caminhos é feita pela VFS e pelo cache de dentries)
+typedef struct filesystem {
+    char name[32];
+    uint32_t flags;
+    int (*mount)(struct filesystem *fs, const char *device, vnode_t **root);
+    int (*unmount)(vnode_t *root);
+    int (*lookup)(vnode_t *dir, const char *name, size_t len, vnode_t **result);
+    int (*create)(vnode_t *dir, const char *name, size_t len, int flags, vnode_t **result);
+    int (*open)(vnode_t *node, int flags);
+    int (*close)(vnode_t *node);
+    int (*read)(vnode_t *node, uint32_t offset, void *buffer, size_t size);
+    int (*write)(vnode_t *node, uint32_t offset, const void *buffer, size_t size);
+    int (*stat)(vnode_t *node, struct stat *st);
+    int (*mkdir)(vnode_t *dir, const char *name, size_t len, int mode, vnode_t **result);
+    int (*truncate)(vnode_t *node, uint32_t size);
+    // Opcionais: com readpage, a VFS lê através do cache de páginas e
+    // read não é usado; writepage faz o writeback de páginas sujas
+    int (*readpage)(vnode_t *node, uint32_t index, void *page);
+    int (*writepage)(vnode_t *node, uint32_t index, const void *page);
+    // Opcional, para sistemas sem cache de páginas: página que guarda
+    // index, mapeada diretamente pelo mmap
+    int (*getpage)(vnode_t *node, uint32_t index, void **page);
+    // Opcional: próxima entrada a partir de *position (cursor opaco do
+    // sistema de arquivos); retorna 1 com uma entrada, 0 no fim
+    int (*readdir)(vnode_t *dir, uint32_t *position, struct dirent *entry);
+} filesystem_t;
+
+struct dentry;
+struct file;
+struct fd_table;
+
+typedef struct mountpoint {
+    char path[256];
+    char device[64];
+    filesystem_t *fs;
+    void *fs_data;
+    struct dentry *root;    // Dentry da raiz do sistema montado
+    struct dentry *covered; // Dentry coberta no sistema pai (NULL na raiz)
+    struct mountpoint *parent;
+    int mounted;
+} mountpoint_t;
+
+// Hash FNV-1a de um componente de caminho
+static inline uint32_t vfs_name_hash(const char *name, size_t len) {
+    uint32_t hash = 2166136261u;
+    for(size_t i = 0; i < len; i++) {
+        hash ^= (uint8_t)name[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+void vfs_init(void);
+int vfs_register_filesystem(filesystem_t *fs);
+int vfs_mount(const char *fs_name, const char *device, const char *mountpoint);
+int vfs_unmount(const char *mountpoint);
+int vfs_open(const char *path, int flags);
+int vfs_read(int fd, void *buffer, size_t size);
+int vfs_write(int fd, const void *buffer, size_t size);
+int vfs_close(int fd);
+int vfs_fsync(int fd);
+void *vfs_mmap(void *addr, size_t length, int prot, int flags, int fd, uint32_t offset);
+int vfs_munmap(void *addr, size_t length);
+int vfs_msync(void *addr, size_t length, int flags);
+int vfs_dup(int fd);
+int vfs_dup2(int fd, int new_fd);
+int vfs_pread(int fd, void *buffer, size_t size, uint32_t offset);
+int vfs_pwrite(int fd, const void *buffer, size_t size, uint32_t offset);
+int vfs_lseek(int fd, int offset, int whence);
+int vfs_readv(int fd, const struct iovec *iov, int iovcnt);
+int vfs_writev(int fd, const struct iovec *iov, int iovcnt);
+int vfs_readdir(int fd, struct dirent *entry);
+int vfs_mkdir(const char *path, int mode);
+int vfs_stat(const char *path, struct stat *st);
+int vfs_truncate(const char *path, uint32_t size);
+void vfs_file_release(struct file *file);
+
+// Variantes sobre uma tabela de descritores explícita
+int vfs_open_files(struct fd_table *table, const char *path, int flags);
+int vfs_close_files(struct fd_table *table, int fd);
+int vfs_read_files(struct fd_table *table, int fd, void *buffer, size_t size, uint32_t offset);
+int vfs_write_files(struct fd_table *table, int fd, const void *buffer, size_t size, uint32_t offset);
+int vfs_fsync_files(struct fd_table *table, int fd);
+int vfs_open_dentry(struct fd_table *table, struct dentry *dentry, int flags);
+vnode_t *vfs_root_node(const char *fs_name);
+
+// Pipe anônimo (fs/pipe.c): fds[0] lê e fds[1] escreve
+int vfs_pipe(int fds[2]);
+int vfs_pipe_files(struct fd_table *table, int fds[2], int flags);
+
+extern filesystem_t ramfs_operations;
+int ramfs_create_image(vnode_t *root, const char *path, size_t len, uint32_t mode,
+                       const void *data, uint32_t size);
+extern filesystem_t ext2_operations;
+extern filesystem_t procfs_operations;
+
+#endif
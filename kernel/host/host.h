@@ -0,0 +1,15 @@
+#ifndef HOST_H
+#define HOST_H
+
+#include <stdint.h>
+
+// Camada de stubs do build hospedado (host/stubs.c)
+extern int host_verbose;
+
+void host_boot(void);
+void host_pit_tick(void);
+uint64_t host_now_ns(void);
+void host_profile_timer(uint32_t hz);
+void *host_user_page(uintptr_t virt);
+
+#endif
@@ -0,0 +1,16 @@
+#ifndef HOSTED_H
+#define HOSTED_H
+
+// Incluído antes de cada fonte do build hospedado (-include): o heap do
+// kernel vira o malloc do sistema e o PIT é o falso de host/stubs.c
+#include <stddef.h>
+#include <stdint.h>
+
+void *malloc(size_t size);
+void *realloc(void *ptr, size_t size);
+void free(void *ptr);
+
+void pit_set_frequency(uint32_t hz);
+void pit_register_handler(void (*handler)(void));
+
+#endif
@@ -0,0 +1,17 @@
+#ifndef IO_H
+#define IO_H
+
+#include <stdint.h>
+
+// Portas de E/S não existem no build hospedado
+static inline void outb(uint16_t port, uint8_t value) {
+    (void)port;
+    (void)value;
+}
+
+static inline uint8_t inb(uint16_t port) {
+    (void)port;
+    return 0xFF;
+}
+
+#endif
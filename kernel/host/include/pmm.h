@@ -0,0 +1,25 @@
+#ifndef PMM_H
+#define PMM_H
+
+#include <stdint.h>
+#include "multiboot.h"
+
+// pmm.h do build hospedado: a "memória física" é uma região mapeada nos
+// mesmos endereços por host/stubs.c, então os endereços devolvidos pelo
+// pmm continuam sendo ponteiros válidos
+#define HOST_MEMORY_SIZE   (64 * 1024 * 1024)
+#define KERNEL_END_ADDRESS 0x400000
+
+extern uint32_t host_pmm_bitmap[];
+#define BITMAP_ADDRESS ((uintptr_t)host_pmm_bitmap)
+
+void pmm_init(multiboot_info_t *mbi);
+void pmm_mark_region_used(uint32_t first, uint32_t count);
+void *pmm_alloc_page(void);
+void pmm_free_page(void *page_addr);
+void *pmm_alloc_contiguous(uint32_t count);
+void pmm_free_contiguous(void *addr, uint32_t count);
+uint32_t pmm_total_pages(void);
+uint32_t pmm_used_pages(void);
+
+#endif
@@ -0,0 +1,7 @@
+#ifndef RAMFS_H
+#define RAMFS_H
+
+// A interface do RAMFS está em vfs.h (ramfs_operations, ramfs_create_image)
+#include "vfs.h"
+
+#endif
@@ -0,0 +1,1244 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "host.h"
+#include "pmm.h"
+#include "vfs.h"
+#include "pipe.h"
+#include "mmap.h"
+#include "scheduler.h"
+#include "ipc.h"
+#include "elf.h"
+#include "exec.h"
+#include "rcu.h"
+#include "trace.h"
+#include "profile.h"
+
+// Build hospedado: testes de estresse aleatórios contra um modelo simples
+// e benchmarks de pmm, ramfs/vfs, escalonador, pipes, IPC e exec.
+//
+//   kernel-host [stress|bench|all] [-s semente] [-n operações] [-v]
+//   kernel-host trace [-o dump] [-n operações]
+//   kernel-host proc [-n operações]
+//   kernel-host profile [-o dump] [-n operações]
+
+#define HOST_PAGES (HOST_MEMORY_SIZE / 4096)
+#define HOST_FIRST_PAGE (KERNEL_END_ADDRESS / 4096)
+
+static uint64_t rng_state;
+static int failures = 0;
+
+// xorshift64*: reproduzível a partir da semente impressa
+static uint32_t rng() {
+    rng_state ^= rng_state >> 12;
+    rng_state ^= rng_state << 25;
+    rng_state ^= rng_state >> 27;
+    return (uint32_t)((rng_state * 2685821657736338717ULL) >> 32);
+}
+
+#define CHECK(cond, ...) do { \
+    if(!(cond)) { \
+        fprintf(stderr, "FALHA %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        failures++; \
+        return; \
+    } \
+} while(0)
+
+// ---------------------------------------------------------------------
+// pmm: páginas e sequências contíguas contra um bitmap sombra; cada
+// página alocada guarda o próprio endereço para detectar sobreposição
+
+typedef struct pmm_alloc {
+    uint8_t *addr;
+    uint32_t count;
+} pmm_alloc_t;
+
+static void stress_pmm(uint32_t ops) {
+    static uint8_t shadow[HOST_PAGES];
+    static pmm_alloc_t allocs[8192];
+    uint32_t nallocs = 0;
+    
+    memset(shadow, 0, sizeof(shadow));
+    for(uint32_t op = 0; op < ops; op++) {
+        int do_alloc = nallocs == 0 || (nallocs < 8192 && rng() % 100 < 55);
+        if(do_alloc) {
+            uint32_t count = rng() % 8 == 0 ? 1 + rng() % 16 : 1;
+            uint8_t *addr = count == 1 ? pmm_alloc_page() : pmm_alloc_contiguous(count);
+            if(!addr) {
+                continue;
+            }
+            uint32_t page = (uintptr_t)addr / 4096;
+            CHECK(((uintptr_t)addr & 4095) == 0, "pmm: endereço desalinhado %p", (void*)addr);
+            CHECK(page >= HOST_FIRST_PAGE && page + count <= HOST_PAGES,
+                  "pmm: página %u fora da memória livre", page);
+            for(uint32_t i = 0; i < count; i++) {
+                CHECK(!shadow[page + i], "pmm: página %u alocada duas vezes", page + i);
+                shadow[page + i] = 1;
+                *(uintptr_t*)(addr + i * 4096) = (uintptr_t)(addr + i * 4096);
+            }
+            allocs[nallocs++] = (pmm_alloc_t){ addr, count };
+        } else {
+            uint32_t victim = rng() % nallocs;
+            pmm_alloc_t alloc = allocs[victim];
+            allocs[victim] = allocs[--nallocs];
+            uint32_t page = (uintptr_t)alloc.addr / 4096;
+            for(uint32_t i = 0; i < alloc.count; i++) {
+                uint8_t *p = alloc.addr + i * 4096;
+                CHECK(*(uintptr_t*)p == (uintptr_t)p, "pmm: página %p sobrescrita", (void*)p);
+                shadow[page + i] = 0;
+            }
+            if(alloc.count == 1) {
+                pmm_free_page(alloc.addr);
+            } else {
+                pmm_free_contiguous(alloc.addr, alloc.count);
+            }
+        }
+    }
+    
+    while(nallocs) {
+        pmm_alloc_t alloc = allocs[--nallocs];
+        pmm_free_contiguous(alloc.addr, alloc.count);
+    }
+    
+    // Tudo devolvido: a primeira página livre volta a ser a primeira da memória
+    uint8_t *first = pmm_alloc_page();
+    CHECK((uintptr_t)first / 4096 == HOST_FIRST_PAGE, "pmm: vazamento, primeira página livre %p", (void*)first);
+    pmm_free_page(first);
+}
+
+// ---------------------------------------------------------------------
+// ramfs/vfs: arquivos em alguns diretórios, escritas e truncamentos em
+// offsets aleatórios conferidos contra cópias em memória
+
+#define VFS_FILES 24
+#define VFS_MAX_SIZE (64 * 1024)
+
+typedef struct shadow_file {
+    char path[64];
+    uint8_t *data;
+    uint32_t size;
+    int exists;
+} shadow_file_t;
+
+static void stress_vfs(uint32_t ops) {
+    static shadow_file_t files[VFS_FILES];
+    static uint8_t buffer[VFS_MAX_SIZE];
+    
+    vfs_mkdir("/stress", 0);
+    vfs_mkdir("/stress/a", 0);
+    vfs_mkdir("/stress/a/b", 0);
+    for(int i = 0; i < VFS_FILES; i++) {
+        const char *dirs[] = { "/stress", "/stress/a", "/stress/a/b" };
+        snprintf(files[i].path, sizeof(files[i].path), "%s/f%d", dirs[i % 3], i);
+        files[i].data = calloc(1, VFS_MAX_SIZE);
+        files[i].size = 0;
+        files[i].exists = 0;
+    }
+    
+    for(uint32_t op = 0; op < ops; op++) {
+        shadow_file_t *file = &files[rng() % VFS_FILES];
+        uint32_t kind = rng() % 10;
+        
+        // Estado quiescente de vez em quando, como numa troca de contexto:
+        // libera as dentries despejadas
+        if(op % 64 == 0) {
+            rcu_note_context_switch();
+        }
+        
+        if(kind < 4) {
+            // Escrita em offset aleatório (pode criar buracos)
+            uint32_t offset = rng() % VFS_MAX_SIZE;
+            uint32_t length = rng() % (VFS_MAX_SIZE - offset + 1);
+            if(length > 9000) {
+                length = rng() % 9000;
+            }
+            for(uint32_t i = 0; i < length; i++) {
+                buffer[i] = rng();
+            }
+            int fd = vfs_open(file->path, O_CREAT | O_RDWR);
+            CHECK(fd >= 0, "vfs: open(%s, O_CREAT) = %d", file->path, fd);
+            int written = vfs_pwrite(fd, buffer, length, offset);
+            vfs_close(fd);
+            CHECK(written == (int)length, "vfs: pwrite %s %u@%u = %d", file->path, length, offset, written);
+            if(!file->exists) {
+                file->exists = 1;
+                file->size = 0;
+                memset(file->data, 0, VFS_MAX_SIZE);
+            }
+            memcpy(file->data + offset, buffer, length);
+            if(length && offset + length > file->size) {
+                file->size = offset + length;
+            }
+        } else if(kind < 8) {
+            // Leitura conferida byte a byte
+            int fd = vfs_open(file->path, O_RDONLY);
+            if(!file->exists) {
+                CHECK(fd < 0, "vfs: %s deveria não existir", file->path);
+                continue;
+            }
+            CHECK(fd >= 0, "vfs: open(%s) = %d", file->path, fd);
+            uint32_t offset = rng() % (file->size + 1);
+            uint32_t length = rng() % 12000;
+            int read = vfs_pread(fd, buffer, length, offset);
+            vfs_close(fd);
+            uint32_t expected = offset + length > file->size ? file->size - offset : length;
+            CHECK(read == (int)expected, "vfs: pread %s %u@%u = %d, esperado %u",
+                  file->path, length, offset, read, expected);
+            CHECK(memcmp(buffer, file->data + offset, expected) == 0,
+                  "vfs: conteúdo divergente em %s %u@%u", file->path, length, offset);
+        } else if(kind == 8 && file->exists) {
+            // Truncamento para menor ou maior
+            uint32_t size = rng() % VFS_MAX_SIZE;
+            CHECK(vfs_truncate(file->path, size) == 0, "vfs: truncate %s", file->path);
+            if(size < file->size) {
+                memset(file->data + size, 0, file->size - size);
+            }
+            file->size = size;
+        } else if(file->exists) {
+            struct stat st;
+            CHECK(vfs_stat(file->path, &st) == 0, "vfs: stat %s", file->path);
+            CHECK(st.st_size == file->size, "vfs: stat %s tamanho %u, esperado %u",
+                  file->path, (uint32_t)st.st_size, file->size);
+        }
+    }
+    
+    for(int i = 0; i < VFS_FILES; i++) {
+        if(files[i].exists) {
+            vfs_truncate(files[i].path, 0);
+        }
+        free(files[i].data);
+    }
+    
+    // Imagens do initramfs: "." é ignorado e ".." recusado
+    static const char image[] = "imagem";
+    struct stat st;
+    vnode_t *root = vfs_root_node("ramfs");
+    CHECK(root != NULL, "vfs: raiz não é ramfs");
+    CHECK(ramfs_create_image(root, "./stress/./img", 14, S_IFREG, image, 6) == 0, "vfs: imagem ./stress/./img");
+    CHECK(vfs_stat("/stress/img", &st) == 0 && st.st_size == 6, "vfs: stat /stress/img");
+    CHECK(ramfs_create_image(root, "stress/../evil", 14, S_IFREG, image, 6) != 0, "vfs: imagem com ..");
+    CHECK(ramfs_create_image(root, "..", 2, S_IFDIR, NULL, 0) != 0, "vfs: diretório ..");
+    CHECK(vfs_stat("/stress/..", &st) != 0 || S_ISDIR(st.st_mode), "vfs: .. criado como nó");
+    CHECK(vfs_stat("/evil", &st) != 0, "vfs: /evil criado fora de stress");
+    
+    // Montar e desmontar: a desmontagem espera um período de graça antes
+    // de descartar as dentries da montagem
+    vfs_mkdir("/stress/m", 0);
+    CHECK(vfs_mount("ramfs", NULL, "/stress/m") == 0, "vfs: mount /stress/m");
+    int fd = vfs_open("/stress/m/x", O_CREAT | O_RDWR);
+    CHECK(fd >= 0, "vfs: open /stress/m/x = %d", fd);
+    CHECK(vfs_pwrite(fd, "busy", 4, 0) == 4, "vfs: pwrite /stress/m/x");
+    
+    // Ocupada enquanto houver arquivo aberto ou mapeado: os nós continuam
+    // valendo e a montagem continua visível
+    char busy[4];
+    CHECK(vfs_unmount("/stress/m") != 0, "vfs: unmount com arquivo aberto");
+    CHECK(vfs_pread(fd, busy, 4, 0) == 4 && memcmp(busy, "busy", 4) == 0,
+          "vfs: pread depois da desmontagem recusada");
+    void *map = vfs_mmap(NULL, PAGE_SIZE, PROT_READ, MAP_PRIVATE, fd, 0);
+    CHECK(map != NULL, "vfs: mmap /stress/m/x");
+    vfs_close(fd);
+    CHECK(vfs_unmount("/stress/m") != 0, "vfs: unmount com arquivo mapeado");
+    CHECK(vfs_stat("/stress/m/x", &st) == 0, "vfs: stat /stress/m/x");
+    CHECK(mmap_unmap(scheduler_current_mm(), (uintptr_t)map, PAGE_SIZE) == 0, "vfs: munmap /stress/m/x");
+    CHECK(vfs_unmount("/stress/m") == 0, "vfs: unmount /stress/m");
+    CHECK(vfs_stat("/stress/m/x", &st) != 0, "vfs: /stress/m/x depois da desmontagem");
+}
+
+// ---------------------------------------------------------------------
+// Escalonador: bloqueios e despertares aleatórios contra um modelo do
+// round-robin (próximo slot pronto depois do atual)
+
+#define SCHED_TASKS 64
+
+static void sched_dummy_task() {
+}
+
+static int sched_model_next(const uint8_t *ready, uint32_t current) {
+    for(uint32_t i = 1; i < 256; i++) {
+        uint32_t slot = (current + i) % 256;
+        if(ready[slot]) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+static void stress_scheduler(uint32_t ops) {
+    static uint8_t ready[256];
+    static int created = 0;
+    
+    if(!created) {
+        for(int i = 0; i < SCHED_TASKS; i++) {
+            uint32_t pid = process_create(sched_dummy_task, 0);
+            CHECK(pid != 0, "scheduler: process_create falhou");
+        }
+        created = 1;
+    }
+    
+    // Os slots 1..SCHED_TASKS começam prontos; o slot 0 (kernel) roda
+    memset(ready, 0, sizeof(ready));
+    for(int i = 0; i <= SCHED_TASKS; i++) {
+        ready[i] = 1;
+    }
+    uint32_t current = scheduler_current();
+    
+    for(uint32_t op = 0; op < ops; op++) {
+        uint32_t kind = rng() % 4;
+        if(kind == 0) {
+            uint32_t slot = rng() % (SCHED_TASKS + 1);
+            scheduler_wake(slot);
+            ready[slot] = 1;
+        } else if(kind == 1) {
+            // Bloqueia o atual; com ninguém pronto ele continua no lugar
+            ready[current] = 0;
+            int next = sched_model_next(ready, current);
+            scheduler_block();
+            uint32_t now = scheduler_current();
+            if(next >= 0) {
+                CHECK(now == (uint32_t)next, "scheduler: block foi para %u, esperado %d", now, next);
+                current = now;
+            } else {
+                CHECK(now == current, "scheduler: sem prontos, saiu de %u", current);
+                // Acorda alguém para continuar
+                scheduler_wake(current);
+                ready[current] = 1;
+            }
+        } else if(kind == 2) {
+            int next = sched_model_next(ready, current);
+            scheduler_schedule();
+            uint32_t now = scheduler_current();
+            uint32_t expected = next >= 0 ? (uint32_t)next : current;
+            CHECK(now == expected, "scheduler: schedule foi para %u, esperado %u", now, expected);
+            current = now;
+        } else {
+            // Dez ticks do PIT esgotam o quantum
+            int next = sched_model_next(ready, current);
+            for(int i = 0; i < 10; i++) {
+                host_pit_tick();
+            }
+            uint32_t now = scheduler_current();
+            uint32_t expected = next >= 0 ? (uint32_t)next : current;
+            CHECK(now == expected, "scheduler: preempção foi para %u, esperado %u", now, expected);
+            current = now;
+        }
+    }
+    
+    // Deixa todos prontos para os benchmarks
+    for(int i = 0; i <= SCHED_TASKS; i++) {
+        scheduler_wake(i);
+    }
+    
+    // Bloqueio com prazo: volta a ficar pronto no tick do prazo, ou antes
+    // com scheduler_wake, que também cancela o prazo
+    process_stats_t st;
+    uint32_t sleeper = scheduler_current();
+    scheduler_block_timeout(3);
+    CHECK(scheduler_current() != sleeper, "scheduler: block_timeout não cedeu a CPU");
+    for(int i = 0; i < 2; i++) {
+        host_pit_tick();
+        CHECK(scheduler_get_stats(sleeper, &st) == 0 && st.state == PROCESS_BLOCKED,
+              "scheduler: slot %u acordou antes do prazo", sleeper);
+    }
+    host_pit_tick();
+    CHECK(scheduler_get_stats(sleeper, &st) == 0 && st.state != PROCESS_BLOCKED,
+          "scheduler: slot %u não acordou no prazo", sleeper);
+    
+    while(scheduler_current() != sleeper) {
+        scheduler_schedule();
+    }
+    scheduler_block_timeout(5);
+    scheduler_wake(sleeper);
+    CHECK(scheduler_get_stats(sleeper, &st) == 0 && st.state == PROCESS_READY,
+          "scheduler: wake antes do prazo");
+    while(scheduler_current() != sleeper) {
+        scheduler_schedule();
+    }
+    scheduler_block();
+    for(int i = 0; i < 10; i++) {
+        host_pit_tick();
+    }
+    CHECK(scheduler_get_stats(sleeper, &st) == 0 && st.state == PROCESS_BLOCKED,
+          "scheduler: prazo cancelado acordou o slot %u", sleeper);
+    scheduler_wake(sleeper);
+}
+
+// ---------------------------------------------------------------------
+// Pipes: escritas e leituras não bloqueantes contra um anel sombra;
+// escritas de até PIPE_BUF bytes entram inteiras ou nada
+
+static void stress_pipe(uint32_t ops) {
+    static uint8_t shadow[PIPE_SIZE];
+    static uint8_t buffer[PIPE_SIZE + PIPE_BUF];
+    uint32_t head = 0, tail = 0;
+    uint32_t active = pipe_get_stats()->active;
+    uint32_t used_pages = pmm_used_pages();
+    int fds[2];
+    
+    CHECK(vfs_pipe_files(scheduler_current_files(), fds, O_NONBLOCK) == 0, "pipe: criação falhou");
+    CHECK(pipe_get_stats()->active == active + 1, "pipe: active não contou o pipe novo");
+    CHECK(vfs_pread(fds[0], buffer, 1, 0) < 0, "pipe: pread deveria falhar");
+    CHECK(vfs_lseek(fds[1], 0, SEEK_SET) < 0, "pipe: lseek deveria falhar");
+    CHECK(vfs_write(fds[0], buffer, 1) < 0, "pipe: escrita no lado de leitura");
+    CHECK(vfs_read(fds[1], buffer, 1) < 0, "pipe: leitura no lado de escrita");
+    
+    for(uint32_t op = 0; op < ops; op++) {
+        uint32_t used = tail - head;
+        if(rng() % 2) {
+            // Tamanhos em volta de PIPE_BUF e do espaço livre
+            uint32_t length = rng() % 3 ? rng() % (PIPE_BUF + 1) : rng() % sizeof(buffer);
+            for(uint32_t i = 0; i < length; i++) {
+                buffer[i] = rng();
+            }
+            uint32_t space = PIPE_SIZE - used;
+            int expected;
+            if(length == 0) {
+                expected = 0;
+            } else if(length <= PIPE_BUF) {
+                expected = space >= length ? (int)length : VFS_EAGAIN;
+            } else {
+                expected = space ? (int)(length < space ? length : space) : VFS_EAGAIN;
+            }
+            int written = vfs_write(fds[1], buffer, length);
+            CHECK(written == expected, "pipe: write %u com %u livres = %d, esperado %d",
+                  length, space, written, expected);
+            for(int i = 0; i < written; i++) {
+                shadow[tail++ % PIPE_SIZE] = buffer[i];
+            }
+        } else {
+            uint32_t length = 1 + rng() % (2 * PIPE_BUF);
+            int expected = used ? (int)(length < used ? length : used) : VFS_EAGAIN;
+            int read = vfs_read(fds[0], buffer, length);
+            CHECK(read == expected, "pipe: read %u com %u ocupados = %d, esperado %d",
+                  length, used, read, expected);
+            for(int i = 0; i < read; i++) {
+                CHECK(buffer[i] == shadow[head++ % PIPE_SIZE], "pipe: byte %d divergente", i);
+            }
+        }
+    }
+    
+    // Fechar a escrita: o leitor esvazia o anel e depois vê o fim
+    int dup = vfs_dup(fds[1]);
+    CHECK(dup >= 0, "pipe: dup");
+    vfs_close(fds[1]);
+    CHECK(vfs_read(fds[0], buffer, 0) == 0, "pipe: leitura vazia");
+    vfs_close(dup);
+    while(tail != head) {
+        int read = vfs_read(fds[0], buffer, sizeof(buffer));
+        CHECK(read == (int)(tail - head), "pipe: esvaziar = %d, esperado %u", read, tail - head);
+        head = tail;
+    }
+    CHECK(vfs_read(fds[0], buffer, 1) == 0, "pipe: sem escritores deveria ser fim");
+    vfs_close(fds[0]);
+    
+    // Fechar a leitura: a escrita falha com VFS_EPIPE. Sem O_NONBLOCK o
+    // build hospedado não dorme e a leitura vazia volta com VFS_EAGAIN
+    CHECK(vfs_pipe(fds) == 0, "pipe: vfs_pipe falhou");
+    CHECK(vfs_read(fds[0], buffer, 1) == VFS_EAGAIN, "pipe: leitura bloqueante vazia");
+    vfs_close(fds[0]);
+    CHECK(vfs_write(fds[1], buffer, 1) == VFS_EPIPE, "pipe: escrita sem leitores");
+    vfs_close(fds[1]);
+    
+    CHECK(pipe_get_stats()->active == active, "pipe: %u pipes vazaram", pipe_get_stats()->active - active);
+    CHECK(pmm_used_pages() == used_pages, "pipe: %d páginas vazaram", (int)(pmm_used_pages() - used_pages));
+}
+
+// ---------------------------------------------------------------------
+// IPC: mensagens com regiões fora de linha. Páginas anônimas presentes
+// chegam ao destino sem cópia; as de arquivo são copiadas e as que nunca
+// foram tocadas chegam zeradas
+
+#define IPC_STRESS_PAGES 16
+
+typedef struct ipc_shadow {
+    uint32_t tag;
+    uint32_t len;
+    uint32_t pages;
+    uint32_t file;                      // Região mapeada de /ipc-file
+    uintptr_t phys[IPC_STRESS_PAGES];   // 0 = página não tocada
+} ipc_shadow_t;
+
+static uint8_t ipc_pattern(uint32_t tag, uint32_t page, uint32_t offset) {
+    return (uint8_t)(tag * 31 + page * 7 + offset);
+}
+
+static void stress_ipc(uint32_t ops) {
+    static ipc_shadow_t queue[IPC_QUEUE_LEN];
+    static uint8_t file_data[IPC_STRESS_PAGES * PAGE_SIZE];
+    static ipc_msg_t msg;
+    uint32_t head = 0, tail = 0;
+    uint32_t used_pages = pmm_used_pages();
+    mm_t *mm = scheduler_current_mm();
+    uint32_t rss = mm->rss;
+    
+    // Arquivo para o caminho da cópia
+    for(uint32_t i = 0; i < sizeof(file_data); i++) {
+        file_data[i] = ipc_pattern(0, i / PAGE_SIZE, i % PAGE_SIZE);
+    }
+    int file = vfs_open("/ipc-file", O_CREAT | O_RDWR);
+    CHECK(file >= 0, "ipc: open /ipc-file");
+    CHECK(vfs_pwrite(file, file_data, sizeof(file_data), 0) == (int)sizeof(file_data), "ipc: pwrite");
+    
+    int channel = ipc_channel_create();
+    CHECK(channel >= 0, "ipc: ipc_channel_create");
+    CHECK(ipc_receive(channel, &msg, IPC_NONBLOCK) == VFS_EAGAIN, "ipc: receive com a fila vazia");
+    
+    for(uint32_t op = 0; op < ops; op++) {
+        if(rng() % 2) {
+            ipc_shadow_t sent, *shadow = &sent;
+            memset(shadow, 0, sizeof(ipc_shadow_t));
+            shadow->tag = op;
+            shadow->len = rng() % (IPC_INLINE_MAX + 1);
+            shadow->pages = rng() % 2 ? 1 + rng() % IPC_STRESS_PAGES : 0;
+            shadow->file = shadow->pages && rng() % 4 == 0;
+            
+            msg.tag = shadow->tag;
+            msg.len = shadow->len;
+            for(uint32_t i = 0; i < msg.len; i++) {
+                msg.data[i] = ipc_pattern(op, 0, i);
+            }
+            msg.ool = NULL;
+            msg.ool_len = shadow->pages * PAGE_SIZE;
+            
+            if(shadow->file) {
+                msg.ool = vfs_mmap(NULL, msg.ool_len, PROT_READ, MAP_PRIVATE, file, 0);
+                CHECK(msg.ool != MAP_FAILED, "ipc: mmap do arquivo");
+            } else if(shadow->pages) {
+                // Toca algumas páginas; as outras ficam sem PTE
+                msg.ool = vfs_mmap(NULL, msg.ool_len, PROT_READ | PROT_WRITE,
+                                   MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                CHECK(msg.ool != MAP_FAILED, "ipc: mmap anônimo");
+                for(uint32_t p = 0; p < shadow->pages; p++) {
+                    if(rng() % 4 == 0) {
+                        continue;
+                    }
+                    uintptr_t virt = (uintptr_t)msg.ool + p * PAGE_SIZE;
+                    CHECK(mmap_fault(virt, PF_WRITE | PF_USER) == 0, "ipc: fault em %lx", (unsigned long)virt);
+                    uint8_t *page = host_user_page(virt);
+                    for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+                        page[i] = ipc_pattern(op, p, i);
+                    }
+                    shadow->phys[p] = PTE_ADDR(vmm_get_pte(virt));
+                }
+            }
+            
+            int result = ipc_send(channel, &msg, IPC_NONBLOCK);
+            if(tail - head == IPC_QUEUE_LEN) {
+                // Fila cheia: a região continua do remetente
+                CHECK(result == VFS_EAGAIN, "ipc: send com a fila cheia = %d", result);
+                if(msg.ool) {
+                    CHECK(vfs_munmap(msg.ool, msg.ool_len) == 0, "ipc: munmap da região recusada");
+                }
+                continue;
+            }
+            CHECK(result == 0, "ipc: send = %d", result);
+            for(uint32_t p = 0; p < shadow->pages; p++) {
+                uintptr_t virt = (uintptr_t)msg.ool + p * PAGE_SIZE;
+                CHECK(vmm_get_pte(virt) == 0, "ipc: %lx ficou mapeado no remetente", (unsigned long)virt);
+            }
+            queue[tail++ % IPC_QUEUE_LEN] = sent;
+        } else {
+            memset(&msg, 0, sizeof(msg));
+            int result = ipc_receive(channel, &msg, IPC_NONBLOCK);
+            if(tail == head) {
+                CHECK(result == VFS_EAGAIN, "ipc: receive com a fila vazia = %d", result);
+                continue;
+            }
+            
+            ipc_shadow_t *shadow = &queue[head++ % IPC_QUEUE_LEN];
+            CHECK(result == (int)shadow->len, "ipc: receive = %d, esperado %u", result, shadow->len);
+            CHECK(msg.tag == shadow->tag, "ipc: tag %u, esperado %u", msg.tag, shadow->tag);
+            for(uint32_t i = 0; i < msg.len; i++) {
+                CHECK(msg.data[i] == ipc_pattern(shadow->tag, 0, i), "ipc: byte %u em linha", i);
+            }
+            CHECK(msg.ool_len == shadow->pages * PAGE_SIZE, "ipc: ool_len %lu, esperado %u páginas",
+                  (unsigned long)msg.ool_len, shadow->pages);
+            if(!shadow->pages) {
+                CHECK(msg.ool == NULL, "ipc: região sem páginas");
+                continue;
+            }
+            
+            for(uint32_t p = 0; p < shadow->pages; p++) {
+                uintptr_t virt = (uintptr_t)msg.ool + p * PAGE_SIZE;
+                uintptr_t pte = vmm_get_pte(virt);
+                CHECK((pte & PTE_PRESENT) && (pte & PTE_WRITE), "ipc: página %u do destino sem PTE", p);
+                if(shadow->phys[p]) {
+                    CHECK(PTE_ADDR(pte) == shadow->phys[p], "ipc: página %u foi copiada", p);
+                }
+                
+                const uint8_t *page = host_user_page(virt);
+                for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+                    uint8_t expected = shadow->file ? ipc_pattern(0, p, i) :
+                                       shadow->phys[p] ? ipc_pattern(shadow->tag, p, i) : 0;
+                    CHECK(page[i] == expected, "ipc: página %u byte %u = %u, esperado %u",
+                          p, i, page[i], expected);
+                }
+            }
+            CHECK(vfs_munmap(msg.ool, msg.ool_len) == 0, "ipc: munmap da região recebida");
+        }
+    }
+    
+    // Destruir o canal libera as páginas que ficaram na fila
+    CHECK(ipc_channel_destroy(channel) == 0, "ipc: ipc_channel_destroy");
+    CHECK(ipc_send(channel, &msg, 0) < 0, "ipc: send num canal destruído");
+    vfs_close(file);
+    vfs_truncate("/ipc-file", 0);
+    
+    CHECK(mm->rss == rss, "ipc: rss %u, esperado %u", mm->rss, rss);
+    CHECK(pmm_used_pages() == used_pages, "ipc: %d páginas vazaram", (int)(pmm_used_pages() - used_pages));
+}
+
+// ---------------------------------------------------------------------
+// exec: executável sintético no ramfs. Texto (cabeçalhos incluídos) até
+// o meio de uma página, .data que termina no meio de uma página e bss;
+// nada além da última página do .data e da pilha pode ser lido na carga
+
+#define EXEC_TEXT_SIZE  0x2800
+#define EXEC_DATA_OFF   0x3123
+#define EXEC_DATA_VADDR 0x5123
+#define EXEC_DATA_SIZE  0x1000
+#define EXEC_BSS_SIZE   0x2000
+#define EXEC_ENTRY      0x1000
+#define EXEC_FILE_SIZE  (EXEC_DATA_OFF + EXEC_DATA_SIZE)
+
+static uint8_t exec_byte(uint32_t offset) {
+    return (uint8_t)(offset * 13 + (offset >> 8));
+}
+
+// Monta o executável em file; base = endereço de ligação (0 num ET_DYN)
+static void exec_build(uint8_t *file, uint16_t type, uintptr_t base) {
+    for(uint32_t i = 0; i < EXEC_FILE_SIZE; i++) {
+        file[i] = exec_byte(i);
+    }
+    
+    Elf_Ehdr *ehdr = (Elf_Ehdr*)file;
+    Elf_Phdr *phdrs = (Elf_Phdr*)(file + sizeof(Elf_Ehdr));
+    memset(ehdr, 0, sizeof(Elf_Ehdr) + 3 * sizeof(Elf_Phdr));
+    ehdr->e_ident[0] = ELFMAG0;
+    ehdr->e_ident[1] = ELFMAG1;
+    ehdr->e_ident[2] = ELFMAG2;
+    ehdr->e_ident[3] = ELFMAG3;
+    ehdr->e_ident[EI_CLASS] = ELF_CLASS;
+    ehdr->e_ident[EI_DATA] = ELFDATA2LSB;
+    ehdr->e_ident[EI_VERSION] = EV_CURRENT;
+    ehdr->e_type = type;
+    ehdr->e_machine = ELF_MACHINE;
+    ehdr->e_version = EV_CURRENT;
+    ehdr->e_entry = base + EXEC_ENTRY;
+    ehdr->e_phoff = sizeof(Elf_Ehdr);
+    ehdr->e_ehsize = sizeof(Elf_Ehdr);
+    ehdr->e_phentsize = sizeof(Elf_Phdr);
+    ehdr->e_phnum = 3;
+    
+    phdrs[0].p_type = PT_LOAD;
+    phdrs[0].p_flags = PF_R | PF_X;
+    phdrs[0].p_vaddr = base;
+    phdrs[0].p_filesz = EXEC_TEXT_SIZE;
+    phdrs[0].p_memsz = EXEC_TEXT_SIZE;
+    phdrs[1].p_type = PT_LOAD;
+    phdrs[1].p_flags = PF_R | PF_W;
+    phdrs[1].p_offset = EXEC_DATA_OFF;
+    phdrs[1].p_vaddr = base + EXEC_DATA_VADDR;
+    phdrs[1].p_filesz = EXEC_DATA_SIZE;
+    phdrs[1].p_memsz = EXEC_DATA_SIZE + EXEC_BSS_SIZE;
+    phdrs[2].p_type = PT_GNU_STACK;
+    phdrs[2].p_flags = PF_R | PF_W;
+}
+
+static int exec_write_file(const char *path, const uint8_t *data, uint32_t size) {
+    vfs_truncate(path, 0);
+    int fd = vfs_open(path, O_CREAT | O_RDWR);
+    if(fd < 0) {
+        return -1;
+    }
+    int written = vfs_pwrite(fd, data, size, 0);
+    vfs_close(fd);
+    return written == (int)size ? 0 : -1;
+}
+
+static uintptr_t exec_word(uintptr_t virt) {
+    uintptr_t *word = host_user_page(virt);
+    return word ? *word : (uintptr_t)-1;
+}
+
+static void stress_exec(uint32_t ops) {
+    static uint8_t file[EXEC_FILE_SIZE];
+    static uint8_t bad[EXEC_FILE_SIZE];
+    static char *const argv[] = { "prog", "-x", "hello world", NULL };
+    static char *const envp[] = { "A=1", "HOME=/", NULL };
+    const uintptr_t base = USER_MMAP_START + 0x100000;
+    exec_image_t image;
+    
+    uint32_t used_pages = pmm_used_pages();
+    mm_t *mm = scheduler_current_mm();
+    exec_build(file, ET_EXEC, base);
+    CHECK(exec_write_file("/exec-prog", file, EXEC_FILE_SIZE) == 0, "exec: escrita do programa");
+    
+    CHECK(exec_load("/exec-prog", argv, envp, &image) == 0, "exec: carga falhou");
+    CHECK(image.entry == base + EXEC_ENTRY && image.base == 0, "exec: entrada %lx", (unsigned long)image.entry);
+    uintptr_t end = base + ((EXEC_DATA_VADDR + EXEC_DATA_SIZE + EXEC_BSS_SIZE + PAGE_SIZE - 1) & PAGE_MASK);
+    CHECK(image.end == end, "exec: fim %lx, esperado %lx", (unsigned long)image.end, (unsigned long)end);
+    CHECK(mm->rss == 2, "exec: rss %u depois da carga (esperado fim do .data e pilha)", mm->rss);
+    
+    // Pilha: argc, argv, NULL, envp, NULL, auxv
+    uintptr_t sp = image.stack;
+    CHECK((sp & 15) == 0, "exec: pilha desalinhada %lx", (unsigned long)sp);
+    CHECK(exec_word(sp) == 3, "exec: argc %lu", (unsigned long)exec_word(sp));
+    for(int i = 0; i < 5; i++) {
+        const char *expected = i < 3 ? argv[i] : envp[i - 3];
+        uintptr_t at = sp + (1 + i + (i >= 3)) * sizeof(uintptr_t);
+        const char *s = host_user_page(exec_word(at));
+        CHECK(s && !strcmp(s, expected), "exec: string %d = %s, esperado %s", i, s ? s : "(null)", expected);
+    }
+    CHECK(exec_word(sp + 4 * sizeof(uintptr_t)) == 0 && exec_word(sp + 7 * sizeof(uintptr_t)) == 0,
+          "exec: argv/envp sem NULL");
+    uintptr_t auxv = sp + 8 * sizeof(uintptr_t);
+    uintptr_t expected_aux[] = { AT_PHDR, base + sizeof(Elf_Ehdr), AT_PHENT, sizeof(Elf_Phdr),
+                                 AT_PHNUM, 3, AT_PAGESZ, PAGE_SIZE, AT_ENTRY, base + EXEC_ENTRY, AT_NULL, 0 };
+    for(int i = 0; i < 12; i++) {
+        CHECK(exec_word(auxv + i * sizeof(uintptr_t)) == expected_aux[i], "exec: auxv[%d] = %lx", i,
+              (unsigned long)exec_word(auxv + i * sizeof(uintptr_t)));
+    }
+    
+    // Texto: página do próprio arquivo, só leitura
+    uintptr_t text = base + PAGE_SIZE;
+    CHECK(vmm_get_pte(text) == 0, "exec: texto lido na carga");
+    CHECK(mmap_fault(text, PF_USER) == 0, "exec: fault no texto");
+    uintptr_t pte = vmm_get_pte(text);
+    CHECK(!(pte & (PTE_WRITE | PTE_ANON)), "exec: texto com cópia privada");
+    uintptr_t text_phys = PTE_ADDR(pte);
+    const uint8_t *page = host_user_page(text);
+    for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+        CHECK(page[i] == exec_byte(PAGE_SIZE + i), "exec: texto byte %u", i);
+    }
+    CHECK(mmap_fault(text, PF_USER | PF_WRITE | PF_PRESENT) != 0, "exec: escrita no texto aceita");
+    
+    // .data: compartilhado até a primeira escrita, que não chega ao arquivo
+    uintptr_t data = base + (EXEC_DATA_VADDR & PAGE_MASK);
+    CHECK(mmap_fault(data, PF_USER) == 0, "exec: fault no .data");
+    CHECK(mmap_fault(data, PF_USER | PF_WRITE | PF_PRESENT) == 0, "exec: cópia na escrita do .data");
+    uint8_t *copy = host_user_page(data);
+    CHECK(copy[0x200] == exec_byte(0x3200), "exec: .data byte divergente");
+    copy[0x200] ^= 0xFF;
+    uint8_t byte;
+    int fd = vfs_open("/exec-prog", O_RDONLY);
+    CHECK(vfs_pread(fd, &byte, 1, 0x3200) == 1 && byte == exec_byte(0x3200), "exec: escrita chegou ao arquivo");
+    vfs_close(fd);
+    
+    // Fim do .data na página da carga; o resto dela e o bss zerados
+    uintptr_t tail = base + ((EXEC_DATA_VADDR + EXEC_DATA_SIZE) & PAGE_MASK);
+    page = host_user_page(tail);
+    CHECK(page && (vmm_get_pte(tail) & PTE_ANON), "exec: fim do .data sem cópia");
+    for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+        uint8_t expected = i < 0x123 ? exec_byte(0x4000 + i) : 0;
+        CHECK(page[i] == expected, "exec: fim do .data byte %x = %x, esperado %x", i, page[i], expected);
+    }
+    for(uintptr_t virt = tail + PAGE_SIZE; virt < image.end; virt += PAGE_SIZE) {
+        CHECK(mmap_fault(virt, PF_USER | PF_WRITE) == 0, "exec: fault no bss %lx", (unsigned long)virt);
+        page = host_user_page(virt);
+        for(uint32_t i = 0; i < PAGE_SIZE; i++) {
+            CHECK(page[i] == 0, "exec: bss não zerado");
+        }
+    }
+    CHECK(mmap_fault(image.end, PF_USER) != 0, "exec: fault depois do bss aceito");
+    
+    // Cargas repetidas: o texto é sempre a mesma página e cada instância
+    // custa só a página do fim do .data e a da pilha
+    for(uint32_t i = 0; i < ops; i++) {
+        uint32_t before = pmm_used_pages();
+        CHECK(exec_load("/exec-prog", argv, envp, &image) == 0, "exec: recarga %u", i);
+        CHECK(mmap_fault(text, PF_USER) == 0 && PTE_ADDR(vmm_get_pte(text)) == text_phys,
+              "exec: texto não compartilhado na recarga %u", i);
+        CHECK(pmm_used_pages() <= before + 2, "exec: recarga usou %u páginas", pmm_used_pages() - before);
+    }
+    
+    // Rejeitados sem tocar na imagem atual
+    struct {
+        const char *what;
+        size_t offset;
+        uintptr_t value;
+        size_t size;
+    } corrupt[] = {
+        { "magia", 0, 'X', 1 },
+        { "máquina", offsetof(Elf_Ehdr, e_machine), 0x1234, 2 },
+        { "classe", EI_CLASS, 3, 1 },
+        { "phentsize", offsetof(Elf_Ehdr, e_phentsize), 8, 2 },
+        { "entrada", offsetof(Elf_Ehdr, e_entry), 0, sizeof(uintptr_t) },
+        { "interp", sizeof(Elf_Ehdr) + 2 * sizeof(Elf_Phdr) + offsetof(Elf_Phdr, p_type), PT_INTERP, 4 },
+        { "filesz", sizeof(Elf_Ehdr) + sizeof(Elf_Phdr) + offsetof(Elf_Phdr, p_filesz), 0x100000, sizeof(uintptr_t) },
+        { "sobreposição", sizeof(Elf_Ehdr) + sizeof(Elf_Phdr) + offsetof(Elf_Phdr, p_vaddr), base + 0x2123,
+          sizeof(uintptr_t) },
+        { "alinhamento", sizeof(Elf_Ehdr) + sizeof(Elf_Phdr) + offsetof(Elf_Phdr, p_vaddr), base + 0x5124,
+          sizeof(uintptr_t) },
+    };
+    for(size_t i = 0; i < sizeof(corrupt) / sizeof(corrupt[0]); i++) {
+        memcpy(bad, file, EXEC_FILE_SIZE);
+        memcpy(bad + corrupt[i].offset, &corrupt[i].value, corrupt[i].size);
+        CHECK(exec_write_file("/exec-bad", bad, EXEC_FILE_SIZE) == 0, "exec: escrita do programa inválido");
+        CHECK(exec_load("/exec-bad", argv, envp, &image) != 0, "exec: %s inválido aceito", corrupt[i].what);
+    }
+    exec_build(bad, ET_EXEC, 0x400000);
+    exec_write_file("/exec-bad", bad, EXEC_FILE_SIZE);
+    CHECK(exec_load("/exec-bad", argv, envp, &image) != 0, "exec: ET_EXEC fora da faixa de usuário aceito");
+    CHECK(exec_load("/exec-bad", argv, envp, &image) != 0 && exec_load("/", argv, NULL, &image) != 0 &&
+          exec_load("/nada", argv, NULL, &image) != 0, "exec: caminho inválido aceito");
+    CHECK(exec_write_file("/exec-bad", bad, 100) == 0 && exec_load("/exec-bad", argv, NULL, &image) != 0,
+          "exec: arquivo truncado aceito");
+    CHECK(vmm_get_pte(text) & PTE_PRESENT, "exec: falha desfez a imagem");
+    
+    // ET_DYN vai para o início da faixa de usuário
+    exec_build(bad, ET_DYN, 0);
+    exec_write_file("/exec-bad", bad, EXEC_FILE_SIZE);
+    CHECK(exec_load("/exec-bad", NULL, NULL, &image) == 0, "exec: ET_DYN recusado");
+    CHECK(image.base == USER_MMAP_START && image.entry == USER_MMAP_START + EXEC_ENTRY,
+          "exec: ET_DYN em %lx", (unsigned long)image.base);
+    CHECK(exec_word(image.stack) == 0, "exec: argc sem argv");
+    
+    CHECK(mmap_unmap(mm, USER_MMAP_START, USER_MMAP_END - USER_MMAP_START) == 0, "exec: munmap");
+    CHECK(mm->rss == 0, "exec: rss %u depois de desfazer tudo", mm->rss);
+    vfs_truncate("/exec-prog", 0);
+    vfs_truncate("/exec-bad", 0);
+    CHECK(pmm_used_pages() == used_pages, "exec: %d páginas vazaram", (int)(pmm_used_pages() - used_pages));
+}
+
+// ---------------------------------------------------------------------
+// Benchmarks: mesma forma de linha que `make bench`, em nanossegundos
+
+static void bench_report(const char *name, uint32_t iterations, uint64_t ns) {
+    printf("BENCH name=%s iters=%u ns_per_op=%.1f\n", name, iterations, (double)ns / iterations);
+}
+
+static void bench_pmm() {
+    const uint32_t iterations = 1 << 16;
+    static void *held[HOST_PAGES];
+    
+    uint64_t start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        pmm_free_page(pmm_alloc_page());
+    }
+    bench_report("pmm_alloc_free_empty", iterations, host_now_ns() - start);
+    
+    // Memória 90% ocupada com buracos espalhados: a busca no bitmap cresce
+    uint32_t nheld = 0;
+    void *page;
+    while((page = pmm_alloc_page()) != NULL) {
+        held[nheld++] = page;
+    }
+    for(uint32_t i = 0; i < nheld; i += 10) {
+        pmm_free_page(held[i]);
+        held[i] = NULL;
+    }
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        pmm_free_page(pmm_alloc_page());
+    }
+    bench_report("pmm_alloc_free_90pct", iterations, host_now_ns() - start);
+    
+    start = host_now_ns();
+    for(uint32_t i = 0; i < 256; i++) {
+        void *run = pmm_alloc_contiguous(4);
+        if(run) {
+            pmm_free_contiguous(run, 4);
+        }
+    }
+    bench_report("pmm_contiguous4_90pct", 256, host_now_ns() - start);
+    
+    for(uint32_t i = 0; i < nheld; i++) {
+        if(held[i]) {
+            pmm_free_page(held[i]);
+        }
+    }
+}
+
+static void bench_vfs() {
+    const uint32_t iterations = 1 << 16;
+    static uint8_t buffer[4096];
+    char path[64];
+    
+    // Diretório com muitas entradas para a busca por nome
+    vfs_mkdir("/bench", 0);
+    for(int i = 0; i < 1024; i++) {
+        snprintf(path, sizeof(path), "/bench/file%d", i);
+        int fd = vfs_open(path, O_CREAT | O_RDWR);
+        if(fd >= 0) {
+            vfs_close(fd);
+        }
+    }
+    
+    struct stat st;
+    uint64_t start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        snprintf(path, sizeof(path), "/bench/file%u", i & 1023);
+        vfs_stat(path, &st);
+    }
+    bench_report("vfs_stat_1024_entries", iterations, host_now_ns() - start);
+    
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        int fd = vfs_open("/bench/file7", O_RDONLY);
+        vfs_close(fd);
+    }
+    bench_report("vfs_open_close", iterations, host_now_ns() - start);
+    
+    int fd = vfs_open("/bench/data", O_CREAT | O_RDWR);
+    for(uint32_t i = 0; i < 64; i++) {
+        vfs_pwrite(fd, buffer, sizeof(buffer), i * 4096);
+    }
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        vfs_pread(fd, buffer, sizeof(buffer), (i & 63) * 4096);
+    }
+    bench_report("vfs_pread_4k", iterations, host_now_ns() - start);
+    
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        vfs_pwrite(fd, buffer, sizeof(buffer), (i & 63) * 4096);
+    }
+    bench_report("vfs_pwrite_4k", iterations, host_now_ns() - start);
+    vfs_close(fd);
+    vfs_truncate("/bench/data", 0);
+}
+
+static void bench_scheduler() {
+    const uint32_t iterations = 1 << 18;
+    
+    // Todos prontos: o próximo é o slot seguinte
+    uint64_t start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        scheduler_schedule();
+    }
+    bench_report("scheduler_schedule_64_ready", iterations, host_now_ns() - start);
+    
+    // Só o atual pronto: a busca percorre a tabela inteira
+    uint32_t self = scheduler_current();
+    for(;;) {
+        scheduler_schedule();
+        if(scheduler_current() == self) {
+            break;
+        }
+        while(scheduler_current() != self) {
+            scheduler_block();
+        }
+    }
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        scheduler_schedule();
+    }
+    bench_report("scheduler_schedule_1_ready", iterations, host_now_ns() - start);
+}
+
+static void bench_pipe() {
+    const uint32_t iterations = 1 << 14;
+    static uint8_t buffer[PIPE_SIZE];
+    int fds[2];
+    
+    if(vfs_pipe_files(scheduler_current_files(), fds, O_NONBLOCK) != 0) {
+        return;
+    }
+    uint64_t start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        vfs_write(fds[1], buffer, PIPE_BUF);
+        vfs_read(fds[0], buffer, PIPE_BUF);
+    }
+    bench_report("pipe_write_read_4k", iterations, host_now_ns() - start);
+    
+    // Anel inteiro de uma vez: 64KB em cada sentido
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations / 16; i++) {
+        vfs_write(fds[1], buffer, PIPE_SIZE);
+        vfs_read(fds[0], buffer, PIPE_SIZE);
+    }
+    bench_report("pipe_write_read_64k", iterations / 16, host_now_ns() - start);
+    vfs_close(fds[0]);
+    vfs_close(fds[1]);
+}
+
+static void bench_ipc() {
+    const uint32_t iterations = 1 << 14;
+    static ipc_msg_t msg;
+    int channel = ipc_channel_create();
+    if(channel < 0) {
+        return;
+    }
+    
+    msg.len = IPC_INLINE_MAX;
+    uint64_t start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        ipc_send(channel, &msg, IPC_NONBLOCK);
+        ipc_receive(channel, &msg, IPC_NONBLOCK);
+    }
+    bench_report("ipc_send_receive_inline", iterations, host_now_ns() - start);
+    
+    // 64KB fora de linha, já presentes: a região recebida é reenviada, só
+    // as PTEs mudam de lugar
+    msg.ool_len = 16 * PAGE_SIZE;
+    msg.ool = vfs_mmap(NULL, msg.ool_len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if(msg.ool != MAP_FAILED) {
+        for(uint32_t p = 0; p < 16; p++) {
+            mmap_fault((uintptr_t)msg.ool + p * PAGE_SIZE, PF_WRITE | PF_USER);
+        }
+        start = host_now_ns();
+        for(uint32_t i = 0; i < iterations; i++) {
+            ipc_send(channel, &msg, IPC_NONBLOCK);
+            ipc_receive(channel, &msg, IPC_NONBLOCK);
+        }
+        bench_report("ipc_send_receive_64k_ool", iterations, host_now_ns() - start);
+        vfs_munmap(msg.ool, msg.ool_len);
+    }
+    ipc_channel_destroy(channel);
+}
+
+// Carga repetida do mesmo programa: cabeçalhos no cache, texto
+// compartilhado; cada iteração desfaz a imagem anterior
+static void bench_exec() {
+    const uint32_t iterations = 1 << 14;
+    static uint8_t file[EXEC_FILE_SIZE];
+    static char *const argv[] = { "prog", "-x", NULL };
+    static char *const envp[] = { "HOME=/", NULL };
+    exec_image_t image;
+    
+    exec_build(file, ET_EXEC, USER_MMAP_START + 0x100000);
+    if(exec_write_file("/exec-bench", file, EXEC_FILE_SIZE) != 0) {
+        return;
+    }
+    uint64_t start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        exec_load("/exec-bench", argv, envp, &image);
+    }
+    bench_report("exec_load", iterations, host_now_ns() - start);
+    
+    // Com o primeiro acesso ao texto (página do cache) e a primeira
+    // escrita no .data (cópia), como um programa que só começa a rodar
+    uintptr_t data = USER_MMAP_START + 0x100000 + (EXEC_DATA_VADDR & PAGE_MASK);
+    start = host_now_ns();
+    for(uint32_t i = 0; i < iterations; i++) {
+        exec_load("/exec-bench", argv, envp, &image);
+        mmap_fault(image.entry, PF_USER);
+        mmap_fault(data, PF_USER | PF_WRITE);
+    }
+    bench_report("exec_load_and_touch", iterations, host_now_ns() - start);
+    mmap_unmap(scheduler_current_mm(), USER_MMAP_START, USER_MMAP_END - USER_MMAP_START);
+    vfs_truncate("/exec-bench", 0);
+}
+
+// ---------------------------------------------------------------------
+// procfs: conteúdo gerado na leitura, diretórios de processos e nomes que
+// passam a existir depois de uma busca que falhou
+
+static int procfs_mounted = 0;
+
+static void procfs_mount_once() {
+    if(!procfs_mounted) {
+        vfs_mkdir("/proc", 0);
+        CHECK(vfs_mount("proc", NULL, "/proc") == 0, "procfs: mount falhou");
+        procfs_mounted = 1;
+    }
+}
+
+// Lê um arquivo inteiro em pedaços de chunk bytes; retorna o tamanho ou -1
+static int procfs_read_file(const char *path, char *buffer, size_t size, size_t chunk) {
+    int fd = vfs_open(path, O_RDONLY);
+    if(fd < 0) {
+        return -1;
+    }
+    
+    size_t total = 0;
+    int n;
+    while(total < size - 1 &&
+          (n = vfs_read(fd, buffer + total, chunk < size - 1 - total ? chunk : size - 1 - total)) > 0) {
+        total += n;
+    }
+    vfs_close(fd);
+    buffer[total] = '\0';
+    return total;
+}
+
+static void stress_procfs() {
+    static char whole[8192];
+    static char pieces[8192];
+    char path[VFS_NAME_MAX + 16];
+    
+    procfs_mount_once();
+    
+    // Sem alocações entre as duas leituras: pedaços pequenos montam o
+    // mesmo texto de uma leitura só
+    int len = procfs_read_file("/proc/meminfo", whole, sizeof(whole), sizeof(whole));
+    CHECK(len > 0, "procfs: meminfo vazio");
+    CHECK(procfs_read_file("/proc/meminfo", pieces, sizeof(pieces), 7) == len &&
+          !strcmp(whole, pieces), "procfs: leitura em pedaços difere");
+    
+    CHECK(!strncmp(whole, "MemTotal:", 9) && strtoul(whole + 9, NULL, 10) == pmm_total_pages() * 4,
+          "procfs: MemTotal diferente do pmm");
+    
+    static const char *others[] = { "stat", "interrupts", "caches", "locks", "ipc" };
+    for(size_t i = 0; i < sizeof(others) / sizeof(others[0]); i++) {
+        snprintf(path, sizeof(path), "/proc/%s", others[i]);
+        CHECK(procfs_read_file(path, whole, sizeof(whole), sizeof(whole)) > 0, "procfs: %s vazio", path);
+    }
+    CHECK(vfs_open("/proc/meminfo", O_WRONLY) < 0, "procfs: aberto para escrita");
+    CHECK(vfs_open("/proc/nada", O_RDONLY | O_CREAT) < 0, "procfs: arquivo criado");
+    
+    // Um diretório por processo no readdir
+    uint32_t processes = 0;
+    process_stats_t stats;
+    for(uint32_t slot = 0; slot < MAX_PROCESSES; slot++) {
+        processes += scheduler_get_stats(slot, &stats) == 0;
+    }
+    int fd = vfs_open("/proc", O_RDONLY);
+    CHECK(fd >= 0, "procfs: readdir da raiz");
+    struct dirent entry;
+    uint32_t files = 0, dirs = 0;
+    while(fd >= 0 && vfs_readdir(fd, &entry) == 1) {
+        if(entry.d_name[0] >= '0' && entry.d_name[0] <= '9') {
+            snprintf(path, sizeof(path), "/proc/%s/stat", entry.d_name);
+            CHECK(procfs_read_file(path, whole, sizeof(whole), sizeof(whole)) > 0,
+                  "procfs: %s ilegível", path);
+            dirs++;
+        } else {
+            files++;
+        }
+    }
+    if(fd >= 0) {
+        vfs_close(fd);
+    }
+    CHECK(files == 6 && dirs == processes, "procfs: readdir com %u arquivos e %u processos (esperado %u)",
+          files, dirs, processes);
+    
+    // PID que ainda não existe: a busca falha, mas não fica em cache
+    uint32_t slot = scheduler_current();
+    CHECK(scheduler_get_stats(slot, &stats) == 0, "procfs: slot atual livre");
+    uint32_t next_pid = 0;
+    for(uint32_t i = 0; i < MAX_PROCESSES; i++) {
+        if(scheduler_get_stats(i, &stats) == 0 && stats.pid >= next_pid) {
+            next_pid = stats.pid + 1;
+        }
+    }
+    snprintf(path, sizeof(path), "/proc/%u/stat", next_pid);
+    CHECK(vfs_open(path, O_RDONLY) < 0, "procfs: %s antes do processo", path);
+    uint32_t pid = process_create(sched_dummy_task, 0);
+    CHECK(pid == next_pid, "procfs: pid %u, esperado %u", pid, next_pid);
+    len = procfs_read_file(path, whole, sizeof(whole), sizeof(whole));
+    CHECK(len > 0 && !strncmp(whole, "pid:", 4), "procfs: %s depois do processo", path);
+}
+
+static void procfs_show(uint32_t ops) {
+    static const char *files[] = { "meminfo", "stat", "interrupts", "caches", "locks", "ipc" };
+    static char buffer[8192];
+    char path[64];
+    
+    stress_scheduler(ops / 4);
+    stress_vfs(ops);
+    procfs_mount_once();
+    
+    for(size_t i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        snprintf(path, sizeof(path), "/proc/%s", files[i]);
+        procfs_read_file(path, buffer, sizeof(buffer), sizeof(buffer));
+        printf("==> %s <==\n%s\n", path, buffer);
+    }
+    procfs_read_file("/proc/1/stat", buffer, sizeof(buffer), sizeof(buffer));
+    printf("==> /proc/1/stat <==\n%s", buffer);
+}
+
+// ---------------------------------------------------------------------
+// Trace: roda uma carga curta com todos os eventos ligados e grava o dump
+// binário (lido por tools/tracedec)
+
+static void trace_write_stdio(const void *data, size_t len, void *ctx) {
+    fwrite(data, 1, len, ctx);
+}
+
+static void trace_workload(uint32_t ops, const char *output) {
+    trace_reset();
+    trace_start(TRACE_ALL);
+    stress_scheduler(ops / 4);
+    stress_vfs(ops);
+    trace_stop();
+    
+    FILE *file = fopen(output, "wb");
+    CHECK(file != NULL, "trace: nao foi possivel criar %s", output);
+    trace_dump(trace_write_stdio, file);
+    fclose(file);
+    printf("trace: dump em %s\n", output);
+}
+
+// ---------------------------------------------------------------------
+// Profiler: amostras por SIGPROF durante os testes de estresse; o dump é
+// simbolizado por tools/kprof com o próprio kernel-host
+
+static void profile_workload(uint32_t ops, const char *output) {
+    uint32_t hz = profile_start(PROFILE_DEFAULT_HZ, PROFILE_MAX_DEPTH);
+    host_profile_timer(hz);
+    stress_pmm(ops);
+    stress_vfs(ops);
+    stress_scheduler(ops);
+    host_profile_timer(0);
+    profile_stop();
+    
+    FILE *file = fopen(output, "wb");
+    CHECK(file != NULL, "profile: nao foi possivel criar %s", output);
+    profile_dump(trace_write_stdio, file);
+    fclose(file);
+    printf("profile: dump em %s\n", output);
+}
+
+int main(int argc, char **argv) {
+    const char *mode = "all";
+    const char *output = "trace.bin";
+    uint64_t seed = host_now_ns();
+    uint32_t ops = 200000;
+    
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-s") && i + 1 < argc) {
+            seed = strtoull(argv[++i], NULL, 0);
+        } else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            ops = strtoul(argv[++i], NULL, 0);
+        } else if(!strcmp(argv[i], "-o") && i + 1 < argc) {
+            output = argv[++i];
+        } else if(!strcmp(argv[i], "-v")) {
+            host_verbose = 1;
+        } else {
+            mode = argv[i];
+        }
+    }
+    rng_state = seed ? seed : 1;
+    
+    host_boot();
+    
+    if(!strcmp(mode, "stress") || !strcmp(mode, "all")) {
+        printf("stress: semente %llu, %u operacoes\n", (unsigned long long)seed, ops);
+        stress_pmm(ops);
+        stress_vfs(ops);
+        stress_scheduler(ops);
+        stress_pipe(ops);
+        stress_ipc(ops / 4);
+        stress_exec(ops / 1000);
+        stress_procfs();
+        printf("stress: %s\n", failures ? "FALHOU" : "ok");
+    }
+    if(!strcmp(mode, "bench") || !strcmp(mode, "all")) {
+        bench_pmm();
+        bench_vfs();
+        if(!strcmp(mode, "bench")) {
+            stress_scheduler(0);
+        }
+        bench_scheduler();
+        bench_pipe();
+        bench_ipc();
+        bench_exec();
+    }
+    if(!strcmp(mode, "proc")) {
+        procfs_show(ops < 1000 ? ops : 1000);
+    }
+    if(!strcmp(mode, "profile")) {
+        profile_workload(ops, output);
+    }
+    if(!strcmp(mode, "trace")) {
+        trace_workload(ops < 1000 ? ops : 1000, output);
+    }
+    
+    return failures ? 1 : 0;
+}
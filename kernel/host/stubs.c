@@ -0,0 +1,237 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <signal.h>
+#include <ucontext.h>
+#include <sys/mman.h>
+#include <sys/time.h>
+#include "host.h"
+#include "pmm.h"
+#include "vmm.h"
+#include "vfs.h"
+#include "block.h"
+#include "scheduler.h"
+#include "pagecache.h"
+#include "multiboot.h"
+#include "trace.h"
+#include "profile.h"
+#include "ipc.h"
+#include "radix.h"
+
+// Stubs do build hospedado: substituem o hardware (console, PIT, tabelas
+// de páginas, discos) para que pmm, ramfs, vfs e escalonador rodem como
+// um programa comum
+
+int host_verbose = 0;
+
+uint32_t host_pmm_bitmap[HOST_MEMORY_SIZE / 4096 / 32];
+
+// Console: descartado, exceto com -v
+void console_init() {
+}
+
+void console_putchar(char c) {
+    if(host_verbose) {
+        putchar(c);
+    }
+}
+
+void console_write(const char *str) {
+    if(host_verbose) {
+        fputs(str, stdout);
+    }
+}
+
+void console_write_dec(uint64_t value) {
+    if(host_verbose) {
+        printf("%llu", (unsigned long long)value);
+    }
+}
+
+void console_write_hex(uint32_t value) {
+    if(host_verbose) {
+        printf("0x%08X", value);
+    }
+}
+
+void console_clear() {
+}
+
+// PIT falso: o handler registrado pelo escalonador roda em host_pit_tick()
+static void (*pit_handler)(void) = NULL;
+
+void pit_set_frequency(uint32_t hz) {
+    (void)hz;
+}
+
+void pit_register_handler(void (*handler)(void)) {
+    pit_handler = handler;
+}
+
+void host_pit_tick() {
+    if(pit_handler) {
+        pit_handler();
+    }
+}
+
+// Sem paginação: pilhas e heap do kernel vêm do malloc do sistema
+void *vmm_alloc_pages(uint32_t count) {
+    return aligned_alloc(PAGE_SIZE, count * PAGE_SIZE);
+}
+
+uintptr_t vmm_create_address_space() {
+    return 0;
+}
+
+// Tabela de páginas falsa das regiões de processos: guarda as PTEs
+// (endereço físico e flags) numa radix pelo índice da página, sem mapear
+// nada de verdade. Serve para exercitar mmap_fault e a troca de páginas
+// do IPC; os dados são acessados pelo endereço físico (host_user_page)
+static radix_tree_t host_ptes;
+
+// Os índices da radix têm 32 bits e a faixa de processos do x86_64 tem
+// 2^35 páginas: cabem os primeiros 8TB (metade de baixo dos índices) e os
+// últimos 8TB, onde fica a pilha dos programas (metade de cima)
+static int host_pte_index(uintptr_t virt, uint32_t *index) {
+    if(virt < USER_MMAP_START || virt >= USER_MMAP_END) {
+        return -1;
+    }
+    uint64_t page = (virt - USER_MMAP_START) >> PAGE_SHIFT;
+    uint64_t from_end = ((USER_MMAP_END - USER_MMAP_START) >> PAGE_SHIFT) - page;
+    if(page < 0x80000000ULL) {
+        *index = (uint32_t)page;
+    } else if(from_end <= 0x80000000ULL) {
+        *index = (uint32_t)(0x100000000ULL - from_end);
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+int vmm_map_page(uintptr_t virt, uintptr_t phys, uintptr_t flags) {
+    uint32_t index;
+    if(host_pte_index(virt, &index) != 0) {
+        return -1;
+    }
+    
+    uintptr_t pte = (phys & PAGE_MASK) | (flags & ~PAGE_MASK) | PTE_PRESENT;
+    radix_delete(&host_ptes, index);
+    return radix_insert(&host_ptes, index, (void*)pte);
+}
+
+uintptr_t vmm_unmap_page(uintptr_t virt) {
+    uint32_t index;
+    if(host_pte_index(virt, &index) != 0) {
+        return 0;
+    }
+    return (uintptr_t)radix_delete(&host_ptes, index);
+}
+
+uintptr_t vmm_get_pte(uintptr_t virt) {
+    uint32_t index;
+    if(host_pte_index(virt, &index) != 0) {
+        return 0;
+    }
+    return (uintptr_t)radix_lookup(&host_ptes, index);
+}
+
+void vmm_clear_pte_flags(uintptr_t virt, uintptr_t flags) {
+    uint32_t index;
+    if(host_pte_index(virt, &index) != 0) {
+        return;
+    }
+    
+    uintptr_t pte = (uintptr_t)radix_lookup(&host_ptes, index);
+    if(pte) {
+        radix_delete(&host_ptes, index);
+        radix_insert(&host_ptes, index, (void*)(pte & ~flags));
+    }
+}
+
+// Endereço de acesso a uma página de processo mapeada (NULL se ausente)
+void *host_user_page(uintptr_t virt) {
+    uintptr_t pte = vmm_get_pte(virt);
+    return pte ? (uint8_t*)PTE_ADDR(pte) + (virt & ~PAGE_MASK) : NULL;
+}
+
+// Nenhum disco: o ext2 nunca monta
+block_device_t *block_get(const char *name) {
+    (void)name;
+    return NULL;
+}
+
+block_device_t *block_get_index(int index) {
+    (void)index;
+    return NULL;
+}
+
+int block_read(block_device_t *dev, uint64_t sector, uint32_t count, void *buffer) {
+    (void)dev;
+    (void)sector;
+    (void)count;
+    (void)buffer;
+    return -1;
+}
+
+// O RTC do profiler vira o SIGPROF: o endereço e o frame pointer
+// interrompidos vêm do contexto do sinal
+static void host_profile_signal(int sig, siginfo_t *info, void *context) {
+    (void)sig;
+    (void)info;
+    ucontext_t *uc = context;
+    profile_sample(uc->uc_mcontext.gregs[REG_RIP], uc->uc_mcontext.gregs[REG_RBP]);
+}
+
+// hz em tempo de CPU do processo; 0 desliga
+void host_profile_timer(uint32_t hz) {
+    struct sigaction action = { 0 };
+    action.sa_sigaction = host_profile_signal;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigaction(SIGPROF, &action, NULL);
+    
+    struct itimerval timer = { 0 };
+    if(hz) {
+        timer.it_interval.tv_usec = 1000000 / hz;
+        timer.it_value = timer.it_interval;
+    }
+    setitimer(ITIMER_PROF, &timer, NULL);
+}
+
+uint64_t host_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Mapeia a memória "física" [KERNEL_END_ADDRESS, HOST_MEMORY_SIZE) nos
+// mesmos endereços, monta um mapa Multiboot falso no início dela e
+// inicializa os subsistemas na ordem de kernel_main()
+void host_boot() {
+    uint8_t *memory = mmap((void*)KERNEL_END_ADDRESS, HOST_MEMORY_SIZE - KERNEL_END_ADDRESS,
+                           PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED_NOREPLACE,
+                           -1, 0);
+    if(memory != (uint8_t*)KERNEL_END_ADDRESS) {
+        fprintf(stderr, "host: nao foi possivel mapear a memoria em 0x%x\n", KERNEL_END_ADDRESS);
+        exit(2);
+    }
+    
+    // Uma região disponível cobrindo tudo e uma reservada (ignorada)
+    multiboot_info_t *mbi = (multiboot_info_t*)memory;
+    memory_map_t *map = (memory_map_t*)(memory + sizeof(multiboot_info_t));
+    map[0] = (memory_map_t){ sizeof(memory_map_t) - 4, 0, 0, HOST_MEMORY_SIZE, 0, 1 };
+    map[1] = (memory_map_t){ sizeof(memory_map_t) - 4, 0xFFFC0000, 0, 0x40000, 0, 2 };
+    mbi->flags = MULTIBOOT_INFO_MEM_MAP;
+    mbi->mods_count = 0;
+    mbi->mmap_addr = (uint32_t)(uintptr_t)map;
+    mbi->mmap_length = 2 * sizeof(memory_map_t);
+    
+    pmm_init(mbi);
+    trace_init();
+    profile_init();
+    scheduler_init();
+    ipc_init();
+    vfs_init();
+    pagecache_init();
+}
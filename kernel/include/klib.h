@@ -0,0 +1,14 @@
+#ifndef KLIB_H
+#define KLIB_H
+
+#include <stdint.h>
+
+// Funcionalidades da CPU detectadas por klib_init()
+#define KLIB_CPU_SSE2 0x1
+#define KLIB_CPU_ERMS 0x2   // rep movsb/stosb rápidos
+
+void klib_init(void);
+uint32_t klib_cpu_features(void);
+void klib_bench_register(void);   // Entradas de `make bench`
+
+#endif
@@ -0,0 +1,46 @@
+#ifndef MULTIBOOT_H
+#define MULTIBOOT_H
+
+#include <stdint.h>
+
+// Valor de EAX entregue por um carregador Multiboot
+#define MULTIBOOT_BOOTLOADER_MAGIC 0x2BADB002
+
+// Bits de multiboot_info_t.flags
+#define MULTIBOOT_INFO_MEMORY  0x00000001
+#define MULTIBOOT_INFO_MODS    0x00000008
+#define MULTIBOOT_INFO_MEM_MAP 0x00000040
+
+// Informações passadas pelo bootloader
+typedef struct multiboot_info {
+    uint32_t flags;
+    uint32_t mem_lower;
+    uint32_t mem_upper;
+    uint32_t boot_device;
+    uint32_t cmdline;
+    uint32_t mods_count;
+    uint32_t mods_addr;
+    uint32_t syms[4];
+    uint32_t mmap_length;
+    uint32_t mmap_addr;
+} __attribute__((packed)) multiboot_info_t;
+
+// Módulo carregado pelo bootloader (ex.: initramfs)
+typedef struct multiboot_module {
+    uint32_t mod_start;
+    uint32_t mod_end;           // Primeiro byte depois do módulo
+    uint32_t cmdline;
+    uint32_t reserved;
+} __attribute__((packed)) multiboot_module_t;
+
+// Entrada do mapa de memória (size não inclui o próprio campo)
+typedef struct memory_map {
+    uint32_t size;
+    uint32_t base_addr_low;
+    uint32_t base_addr_high;
+    uint32_t length_low;
+    uint32_t length_high;
+    uint32_t type;
+} __attribute__((packed)) memory_map_t;
+
+#endif
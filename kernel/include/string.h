@@ -0,0 +1,18 @@
+#ifndef STRING_H
+#define STRING_H
+
+#include <stddef.h>
+
+// Biblioteca do kernel (lib/string.c); as cópias grandes usam a melhor
+// variante escolhida em klib_init()
+void *memcpy(void *dst, const void *src, size_t n);
+void *memmove(void *dst, const void *src, size_t n);
+void *memset(void *dst, int c, size_t n);
+int memcmp(const void *a, const void *b, size_t n);
+size_t strlen(const char *s);
+int strcmp(const char *a, const char *b);
+int strncmp(const char *a, const char *b, size_t n);
+char *strcpy(char *dst, const char *src);
+char *strncpy(char *dst, const char *src, size_t n);
+
+#endif
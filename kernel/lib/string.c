@@ -0,0 +1,530 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "klib.h"
+#include "pmm.h"
+#include "console.h"
+#include "bench.h"
+
+#define KLIB_SMALL        16            // Abaixo disso, laço de bytes
+#define KLIB_LARGE        256           // A partir disso, variante escolhida no boot
+#define KLIB_SSE_CHUNK    4096          // Bytes por trecho com interrupções desligadas
+#define KLIB_NT_THRESHOLD (512 * 1024)  // Cópias maiores não passam pelo cache
+
+// Palavra que pode apontar para qualquer tipo (leitura de 4 bytes de strings)
+typedef uint32_t __attribute__((may_alias)) klib_word_t;
+
+// Algum byte da palavra é zero
+#define KLIB_HAS_ZERO(w) (((w) - 0x01010101u) & ~(w) & 0x80808080u)
+
+static uint32_t cpu_features = 0;
+
+// Cópia base: dwords com rep movsl e o resto com rep movsb
+static void copy_movsd(void *dst, const void *src, size_t n) {
+    size_t count = n / 4;
+    asm volatile("rep movsl"
+                 : "+c"(count), "+D"(dst), "+S"(src)
+                 :
+                 : "memory");
+    count = n & 3;
+    asm volatile("rep movsb"
+                 : "+c"(count), "+D"(dst), "+S"(src)
+                 :
+                 : "memory");
+}
+
+// CPUs com ERMS copiam em blocos internamente com um único rep movsb
+static void copy_erms(void *dst, const void *src, size_t n) {
+    uintptr_t d0, d1, d2;
+    asm volatile("rep movsb"
+                 : "=&c"(d0), "=&D"(d1), "=&S"(d2)
+                 : "0"(n), "1"(dst), "2"(src)
+                 : "memory");
+}
+
+static void fill_stosd(void *dst, int c, size_t n) {
+    uint32_t value = (uint8_t)c * 0x01010101u;
+    size_t count = n / 4;
+    asm volatile("rep stosl"
+                 : "+c"(count), "+D"(dst)
+                 : "a"(value)
+                 : "memory");
+    count = n & 3;
+    asm volatile("rep stosb"
+                 : "+c"(count), "+D"(dst)
+                 : "a"(value)
+                 : "memory");
+}
+
+static void fill_erms(void *dst, int c, size_t n) {
+    uintptr_t d0, d1;
+    asm volatile("rep stosb"
+                 : "=&c"(d0), "=&D"(d1)
+                 : "a"(c), "0"(n), "1"(dst)
+                 : "memory");
+}
+
+// O escalonador não salva os registradores XMM: os trechos SSE rodam
+// com interrupções desligadas
+static inline uintptr_t klib_fpu_begin() {
+    uintptr_t flags;
+    asm volatile("pushf; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void klib_fpu_end(uintptr_t flags) {
+    if(flags & 0x200) {
+        asm volatile("sti" : : : "memory");
+    }
+}
+
+// Cópia SSE2 em blocos de 64 bytes com destino alinhado a 16; cópias
+// enormes usam escritas não temporais para não expulsar o cache inteiro
+__attribute__((target("sse2")))
+static void copy_sse2(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    
+    size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+    copy_movsd(d, s, head);
+    d += head;
+    s += head;
+    n -= head;
+    
+    int nontemporal = n >= KLIB_NT_THRESHOLD;
+    while(n >= 64) {
+        size_t blocks = n / 64;
+        if(blocks > KLIB_SSE_CHUNK / 64) {
+            blocks = KLIB_SSE_CHUNK / 64;
+        }
+        n -= blocks * 64;
+        
+        uintptr_t flags = klib_fpu_begin();
+        if(nontemporal) {
+            asm volatile("1:\n\t"
+                         "movdqu (%1), %%xmm0\n\t"
+                         "movdqu 16(%1), %%xmm1\n\t"
+                         "movdqu 32(%1), %%xmm2\n\t"
+                         "movdqu 48(%1), %%xmm3\n\t"
+                         "movntdq %%xmm0, (%0)\n\t"
+                         "movntdq %%xmm1, 16(%0)\n\t"
+                         "movntdq %%xmm2, 32(%0)\n\t"
+                         "movntdq %%xmm3, 48(%0)\n\t"
+                         "add $64, %0\n\t"
+                         "add $64, %1\n\t"
+                         "dec %2\n\t"
+                         "jnz 1b"
+                         : "+r"(d), "+r"(s), "+r"(blocks)
+                         :
+                         : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+        } else {
+            asm volatile("1:\n\t"
+                         "movdqu (%1), %%xmm0\n\t"
+                         "movdqu 16(%1), %%xmm1\n\t"
+                         "movdqu 32(%1), %%xmm2\n\t"
+                         "movdqu 48(%1), %%xmm3\n\t"
+                         "movdqa %%xmm0, (%0)\n\t"
+                         "movdqa %%xmm1, 16(%0)\n\t"
+                         "movdqa %%xmm2, 32(%0)\n\t"
+                         "movdqa %%xmm3, 48(%0)\n\t"
+                         "add $64, %0\n\t"
+                         "add $64, %1\n\t"
+                         "dec %2\n\t"
+                         "jnz 1b"
+                         : "+r"(d), "+r"(s), "+r"(blocks)
+                         :
+                         : "memory", "xmm0", "xmm1", "xmm2", "xmm3");
+        }
+        klib_fpu_end(flags);
+    }
+    
+    if(nontemporal) {
+        asm volatile("sfence" : : : "memory");
+    }
+    copy_movsd(d, s, n);
+}
+
+__attribute__((target("sse2")))
+static void fill_sse2(void *dst, int c, size_t n) {
+    uint8_t *d = dst;
+    
+    size_t head = (16 - ((uintptr_t)d & 15)) & 15;
+    fill_stosd(d, c, head);
+    d += head;
+    n -= head;
+    
+    uint32_t value = (uint8_t)c * 0x01010101u;
+    while(n >= 64) {
+        size_t blocks = n / 64;
+        if(blocks > KLIB_SSE_CHUNK / 64) {
+            blocks = KLIB_SSE_CHUNK / 64;
+        }
+        n -= blocks * 64;
+        
+        uintptr_t flags = klib_fpu_begin();
+        asm volatile("movd %2, %%xmm0\n\t"
+                     "pshufd $0, %%xmm0, %%xmm0\n\t"
+                     "1:\n\t"
+                     "movdqa %%xmm0, (%0)\n\t"
+                     "movdqa %%xmm0, 16(%0)\n\t"
+                     "movdqa %%xmm0, 32(%0)\n\t"
+                     "movdqa %%xmm0, 48(%0)\n\t"
+                     "add $64, %0\n\t"
+                     "dec %1\n\t"
+                     "jnz 1b"
+                     : "+r"(d), "+r"(blocks)
+                     : "r"(value)
+                     : "memory", "xmm0");
+        klib_fpu_end(flags);
+    }
+    
+    fill_stosd(d, c, n);
+}
+
+// Variantes para tamanhos >= KLIB_LARGE, trocadas em klib_init()
+static void (*copy_large)(void *dst, const void *src, size_t n) = copy_movsd;
+static void (*fill_large)(void *dst, int c, size_t n) = fill_stosd;
+
+void *memcpy(void *dst, const void *src, size_t n) {
+    if(n < KLIB_SMALL) {
+        uint8_t *d = dst;
+        const uint8_t *s = src;
+        while(n--) {
+            *d++ = *s++;
+        }
+    } else if(n < KLIB_LARGE) {
+        copy_movsd(dst, src, n);
+    } else {
+        copy_large(dst, src, n);
+    }
+    return dst;
+}
+
+void *memset(void *dst, int c, size_t n) {
+    if(n < KLIB_SMALL) {
+        uint8_t *d = dst;
+        while(n--) {
+            *d++ = (uint8_t)c;
+        }
+    } else if(n < KLIB_LARGE) {
+        fill_stosd(dst, c, n);
+    } else {
+        fill_large(dst, c, n);
+    }
+    return dst;
+}
+
+// Regiões sobrepostas com destino depois da origem são copiadas de trás
+// para frente (DF=1); o resto é um memcpy
+void *memmove(void *dst, const void *src, size_t n) {
+    uint8_t *d = dst;
+    const uint8_t *s = src;
+    if(d == s || n == 0) {
+        return dst;
+    }
+    if(d < s || d >= s + n) {
+        return memcpy(dst, src, n);
+    }
+    
+    // Bytes finais que não formam um dword
+    while(n & 3) {
+        n--;
+        d[n] = s[n];
+    }
+    
+    if(n) {
+        uintptr_t d0, d1, d2;
+        asm volatile("std\n\t"
+                     "rep movsl\n\t"
+                     "cld"
+                     : "=&c"(d0), "=&D"(d1), "=&S"(d2)
+                     : "0"(n / 4), "1"(d + n - 4), "2"(s + n - 4)
+                     : "memory");
+    }
+    return dst;
+}
+
+int memcmp(const void *a, const void *b, size_t n) {
+    const uint8_t *pa = a;
+    const uint8_t *pb = b;
+    
+    // Palavras iguais são puladas de 4 em 4 bytes
+    if((((uintptr_t)pa | (uintptr_t)pb) & 3) == 0) {
+        while(n >= 4 && *(const klib_word_t*)pa == *(const klib_word_t*)pb) {
+            pa += 4;
+            pb += 4;
+            n -= 4;
+        }
+    }
+    
+    while(n--) {
+        if(*pa != *pb) {
+            return *pa - *pb;
+        }
+        pa++;
+        pb++;
+    }
+    return 0;
+}
+
+// Leituras alinhadas de 4 bytes nunca cruzam uma página, então ler além
+// do terminador dentro da mesma palavra é seguro
+size_t strlen(const char *s) {
+    const char *p = s;
+    while((uintptr_t)p & 3) {
+        if(!*p) {
+            return p - s;
+        }
+        p++;
+    }
+    
+    const klib_word_t *w = (const klib_word_t*)p;
+    while(!KLIB_HAS_ZERO(*w)) {
+        w++;
+    }
+    
+    p = (const char*)w;
+    while(*p) {
+        p++;
+    }
+    return p - s;
+}
+
+int strcmp(const char *a, const char *b) {
+    if((((uintptr_t)a | (uintptr_t)b) & 3) == 0) {
+        const klib_word_t *wa = (const klib_word_t*)a;
+        const klib_word_t *wb = (const klib_word_t*)b;
+        while(*wa == *wb && !KLIB_HAS_ZERO(*wa)) {
+            wa++;
+            wb++;
+        }
+        a = (const char*)wa;
+        b = (const char*)wb;
+    }
+    
+    while(*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return (uint8_t)*a - (uint8_t)*b;
+}
+
+int strncmp(const char *a, const char *b, size_t n) {
+    if((((uintptr_t)a | (uintptr_t)b) & 3) == 0) {
+        const klib_word_t *wa = (const klib_word_t*)a;
+        const klib_word_t *wb = (const klib_word_t*)b;
+        while(n >= 4 && *wa == *wb && !KLIB_HAS_ZERO(*wa)) {
+            wa++;
+            wb++;
+            n -= 4;
+        }
+        a = (const char*)wa;
+        b = (const char*)wb;
+    }
+    
+    while(n && *a && *a == *b) {
+        a++;
+        b++;
+        n--;
+    }
+    return n ? (uint8_t)*a - (uint8_t)*b : 0;
+}
+
+char *strcpy(char *dst, const char *src) {
+    char *d = dst;
+    
+    if((((uintptr_t)d | (uintptr_t)src) & 3) == 0) {
+        klib_word_t *wd = (klib_word_t*)d;
+        const klib_word_t *ws = (const klib_word_t*)src;
+        while(!KLIB_HAS_ZERO(*ws)) {
+            *wd++ = *ws++;
+        }
+        d = (char*)wd;
+        src = (const char*)ws;
+    }
+    
+    while((*d++ = *src++) != '\0');
+    return dst;
+}
+
+char *strncpy(char *dst, const char *src, size_t n) {
+    size_t i = 0;
+    for(; i < n && src[i]; i++) {
+        dst[i] = src[i];
+    }
+    if(i < n) {
+        memset(dst + i, 0, n - i);
+    }
+    return dst;
+}
+
+static inline void cpuid(uint32_t leaf, uint32_t *a, uint32_t *b, uint32_t *c, uint32_t *d) {
+    asm volatile("cpuid" : "=a"(*a), "=b"(*b), "=c"(*c), "=d"(*d) : "a"(leaf), "c"(0));
+}
+
+// CPUID existe se o bit ID de EFLAGS puder ser alterado
+static int klib_has_cpuid() {
+    uintptr_t before, after;
+    asm volatile("pushf\n\t"
+                 "pop %0\n\t"
+                 "mov %0, %1\n\t"
+                 "xor $0x200000, %1\n\t"
+                 "push %1\n\t"
+                 "popf\n\t"
+                 "pushf\n\t"
+                 "pop %1\n\t"
+                 "push %0\n\t"
+                 "popf"
+                 : "=&r"(before), "=&r"(after));
+    return ((before ^ after) & 0x200000) != 0;
+}
+
+// Detecta SSE2/ERMS, habilita SSE e escolhe as variantes de cópias grandes
+void klib_init() {
+    uint32_t a, b, c, d;
+    if(!klib_has_cpuid()) {
+        return;
+    }
+    
+    cpuid(0, &a, &b, &c, &d);
+    uint32_t max_leaf = a;
+    
+    cpuid(1, &a, &b, &c, &d);
+    if((d & (1 << 26)) && (d & (1 << 24))) {   // SSE2 e FXSR
+        cpu_features |= KLIB_CPU_SSE2;
+    }
+    if(max_leaf >= 7) {
+        cpuid(7, &a, &b, &c, &d);
+        if(b & (1 << 9)) {
+            cpu_features |= KLIB_CPU_ERMS;
+        }
+    }
+    
+    if(cpu_features & KLIB_CPU_SSE2) {
+        // CR0: limpar EM, ligar MP; CR4: OSFXSR e OSXMMEXCPT
+        uintptr_t cr0, cr4;
+        asm volatile("mov %%cr0, %0" : "=r"(cr0));
+        cr0 = (cr0 & ~(1u << 2)) | (1u << 1);
+        asm volatile("mov %0, %%cr0" : : "r"(cr0));
+        asm volatile("mov %%cr4, %0" : "=r"(cr4));
+        cr4 |= (1u << 9) | (1u << 10);
+        asm volatile("mov %0, %%cr4" : : "r"(cr4));
+        asm volatile("fninit");
+    }
+    
+    const char *name = "movsd";
+    if(cpu_features & KLIB_CPU_ERMS) {
+        copy_large = copy_erms;
+        fill_large = fill_erms;
+        name = "erms";
+    } else if(cpu_features & KLIB_CPU_SSE2) {
+        copy_large = copy_sse2;
+        fill_large = fill_sse2;
+        name = "sse2";
+    }
+    
+    console_write("klib: copias grandes com ");
+    console_write(name);
+    console_write("\n");
+}
+
+uint32_t klib_cpu_features() {
+    return cpu_features;
+}
+
+// Origem e destino de 4KB dos benchmarks, alocados no registro
+static uint8_t *bench_src = NULL;
+static uint8_t *bench_dst = NULL;
+
+static void bench_copy_movsd(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        copy_movsd(bench_dst, bench_src, 4096);
+    }
+}
+
+static void bench_copy_erms(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        copy_erms(bench_dst, bench_src, 4096);
+    }
+}
+
+static void bench_copy_sse2(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        copy_sse2(bench_dst, bench_src, 4096);
+    }
+}
+
+static void bench_fill_stosd(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        fill_stosd(bench_dst, 0, 4096);
+    }
+}
+
+static void bench_fill_erms(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        fill_erms(bench_dst, 0, 4096);
+    }
+}
+
+static void bench_fill_sse2(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        fill_sse2(bench_dst, 0, 4096);
+    }
+}
+
+// Cópias pequenas ficam fora das variantes: mede o despacho de memcpy
+static void bench_memcpy_64(uint32_t iterations) {
+    for(uint32_t i = 0; i < iterations; i++) {
+        memcpy(bench_dst, bench_src, 64);
+    }
+}
+
+// strlen de 4095 bytes: palavras contra o laço de bytes
+static void bench_strlen_words(uint32_t iterations) {
+    volatile size_t length = 0;
+    for(uint32_t i = 0; i < iterations; i++) {
+        length = strlen((const char*)bench_src);
+    }
+    (void)length;
+}
+
+static void bench_strlen_bytes(uint32_t iterations) {
+    volatile size_t length = 0;
+    for(uint32_t i = 0; i < iterations; i++) {
+        const char *p = (const char*)bench_src;
+        while(*p) {
+            p++;
+        }
+        length = p - (const char*)bench_src;
+    }
+    (void)length;
+}
+
+// Registra uma entrada por variante disponível na CPU
+void klib_bench_register() {
+    bench_src = pmm_alloc_page();
+    bench_dst = pmm_alloc_page();
+    if(!bench_src || !bench_dst) {
+        return;
+    }
+    memset(bench_src, 'a', 4095);
+    bench_src[4095] = '\0';
+    
+    bench_register("memcpy_64", bench_memcpy_64, 14);
+    bench_register("memcpy_4k_movsd", bench_copy_movsd, 12);
+    if(cpu_features & KLIB_CPU_ERMS) {
+        bench_register("memcpy_4k_erms", bench_copy_erms, 12);
+    }
+    if(cpu_features & KLIB_CPU_SSE2) {
+        bench_register("memcpy_4k_sse2", bench_copy_sse2, 12);
+    }
+    bench_register("memset_4k_stosd", bench_fill_stosd, 12);
+    if(cpu_features & KLIB_CPU_ERMS) {
+        bench_register("memset_4k_erms", bench_fill_erms, 12);
+    }
+    if(cpu_features & KLIB_CPU_SSE2) {
+        bench_register("memset_4k_sse2", bench_fill_sse2, 12);
+    }
+    bench_register("strlen_4k", bench_strlen_words, 12);
+    bench_register("strlen_4k_bytes", bench_strlen_bytes, 12);
+}
@@ -1,24 +1,152 @@
 #include <stddef.h>
 #include <stdint.h>
+#include "multiboot.h"
+#include "initcall.h"
+#include "block.h"
+#include "initramfs.h"
+#include "trace.h"
+#include "profile.h"
+#include "ipc.h"
+#include "vfs.h"
+#include "exec.h"
+#if defined(KERNEL_BENCH) || defined(KERNEL_TRACE) || defined(KERNEL_PROFILE)
+#include "bench.h"
+#endif
+#ifdef __x86_64__
+#include "arch.h"
+#endif
 
-// Função principal do kernel
-void kernel_main() {
-    // Inicializar o console para saída básica
-    console_init();
+// Informações do bootloader, usadas por pmm_init
+static multiboot_info_t *boot_info;
+
+static void pmm_initcall() {
+    pmm_init(boot_info);
+}
+
+// O initramfs roda logo após o VFS, antes de qualquer busca de caminho
+// (entradas negativas no cache de dentries esconderiam os arquivos)
+static void initramfs_initcall() {
+    initramfs_init(boot_info);
+}
+
+// Anéis de trace alocados no heap; os eventos ficam desligados, exceto
+// na variante de `make trace`, que grava tudo desde aqui
+static void trace_initcall() {
+    trace_init();
+#ifdef KERNEL_TRACE
+    trace_start(TRACE_ALL);
+#endif
+}
+
+#ifdef KERNEL_TRACE
+// Último subsistema adiado: dump pela serial e saída do QEMU
+static void trace_finish() {
+    trace_stop();
+    trace_dump_serial();
+    bench_exit(0);
+}
+#endif
+
+// Tabelas do profiler; a variante de `make profile` amostra desde aqui
+static void profile_initcall() {
+    profile_init();
+#ifdef KERNEL_PROFILE
+    profile_start(PROFILE_DEFAULT_HZ, PROFILE_MAX_DEPTH);
+#endif
+}
+
+#ifdef KERNEL_PROFILE
+// Último subsistema adiado: dump pela serial e saída do QEMU
+static void profile_finish() {
+    profile_stop();
+    profile_dump_serial();
+    bench_exit(0);
+}
+#endif
+
+// Contadores do kernel em /proc
+static void procfs_initcall() {
+    vfs_mkdir("/proc", 0);
+    vfs_mount("proc", NULL, "/proc");
+}
+
+// Monta em /mnt o primeiro disco com um sistema ext2
+static void mount_disks() {
+    block_device_t *dev;
     
-    console_write("KakatsOS - Kernel inicializado\n");
+    vfs_mkdir("/mnt", 0);
+    for(int i = 0; (dev = block_get_index(i)) != NULL; i++) {
+        if(vfs_mount("ext2", dev->name, "/mnt") == 0) {
+            console_write("ext2: ");
+            console_write(dev->name);
+            console_write(" montado em /mnt\n");
+            return;
+        }
+    }
+}
+
+// Primeiro programa de usuário, se o initramfs trouxer um
+static void init_start() {
+    static char *const argv[] = { "init", NULL };
+    static char *const envp[] = { "PATH=/bin:/sbin", NULL };
+    struct stat st;
     
-    // Inicializar subsistemas do kernel
-    gdt_init();       // Tabela de Descritores Globais
-    idt_init();       // Tabela de Descritores de Interrupção
-    pmm_init();       // Gerenciador de Memória Física
-    vmm_init();       // Gerenciador de Memória Virtual
+    if(vfs_stat("/sbin/init", &st) == 0 && process_exec("/sbin/init", argv, envp, 1) == 0) {
+        console_write("init: falha ao criar /sbin/init\n");
+    }
+}
+
+// Função principal do kernel (chamada por _start em core/entry.asm)
+void kernel_main(uint32_t magic, multiboot_info_t *mbi) {
+    boot_info = mbi;
+    
+    // Registrar subsistemas do kernel, na ordem de inicialização
+    initcall_register("console", console_init, 0, 0);            // Console para saída básica
+    initcall_register("klib", klib_init, 0, 0);                  // memcpy/memset conforme a CPU
+    initcall_register("gdt", gdt_init, 0, 0);                    // Tabela de Descritores Globais
+    initcall_register("idt", idt_init, 0, 0);                    // Tabela de Descritores de Interrupção
+#ifdef __x86_64__
+    initcall_register("syscall", syscall_init, 0, 0);            // SYSCALL/SYSRET (MSRs)
+#endif
+    initcall_register("pmm", pmm_initcall, 0, 0);                // Gerenciador de Memória Física
+    initcall_register("vmm", vmm_init, 0, 0);                    // Gerenciador de Memória Virtual
+    initcall_register("trace", trace_initcall, 0, 0);            // Anéis de trace por CPU
+    initcall_register("scheduler", scheduler_init, 0, 0);        // Escalonador
+    initcall_register("ipc", ipc_init, 0, 0);                    // Canais de mensagens
+    initcall_register("vfs", vfs_init, 0, 0);                    // Sistema de arquivos
+    initcall_register("initramfs", initramfs_initcall, 0, 0);    // Arquivos do módulo de boot
+    initcall_register("pci", pci_init, 0, 0);                    // Enumeração PCI
+    initcall_register("ata", ata_init, 0, 0);                    // Discos IDE
+    initcall_register("virtio-blk", virtio_blk_init, 0, 0);      // Discos virtio
+    initcall_register("pagecache", pagecache_init, 0, 0);        // Cache de páginas
+    initcall_register("procfs", procfs_initcall, 0, 0);          // Estatísticas em /proc
+    initcall_register("profile", profile_initcall, 0, 0);        // Profiler por amostragem
+    initcall_register("mount", mount_disks, 0, 0);               // Discos em /mnt
+    initcall_register("flusher", pagecache_start_flusher, INITCALL_DEFERRED, 0);
+    initcall_register("keyboard", keyboard_init, INITCALL_DEFERRED, 0);
+    initcall_register("init", init_start, INITCALL_DEFERRED, 0); // /sbin/init no anel 3
+#ifdef KERNEL_PROFILE
+    initcall_register("profile-dump", profile_finish, INITCALL_DEFERRED, 0);
+#endif
+#ifdef KERNEL_TRACE
+    initcall_register("trace-dump", trace_finish, INITCALL_DEFERRED, 0);
+#endif
+#ifdef KERNEL_BENCH
+    // Variante de `make bench`: roda o registro de benchmarks e sai do QEMU
+    initcall_register("bench", bench_run_all, INITCALL_DEFERRED, 0);
+#endif
+
+    // Inicializar subsistemas críticos medindo cada um
+    initcall_run();
     
-    // Inicializar escalonador
-    scheduler_init();
+    console_write("KakatsOS - Kernel inicializado\n");
+    
+    if(magic != MULTIBOOT_BOOTLOADER_MAGIC) {
+        console_write("Bootloader desconhecido\n");
+    }
     
-    // Inicializar sistema de arquivos
-    vfs_init();
+    // Subsistemas adiados rodam depois do primeiro processo
+    initcall_start_deferred();
     
     // Loop infinito para manter o kernel ativo
     while(1) {
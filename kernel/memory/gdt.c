@@ -1,7 +1,24 @@
+#include <string.h>
 #include "gdt.h"
 
-struct gdt_entry gdt[5];
+// TSS de 32 bits: só ss0/esp0 (pilha do kernel ao entrar do anel 3) são
+// usados; a troca de tarefas por hardware não é
+struct tss_entry {
+    uint32_t prev_tss;
+    uint32_t esp0;
+    uint32_t ss0;
+    uint32_t unused[22];
+    uint16_t trap;
+    uint16_t iomap_base;
+} __attribute__((packed));
+
+struct gdt_entry gdt[6];
 struct gdt_ptr gp;
+struct tss_entry tss;
+
+// Pilha usada por interrupções do anel 3 até o escalonador trocar esp0
+// por processo
+static uint8_t ring0_stack[16384] __attribute__((aligned(16)));
 
 extern void gdt_flush(uint32_t);
 
@@ -17,8 +34,12 @@ void gdt_set_gate(int num, uint32_t base, uint32_t limit, uint8_t access, uint8_
     gdt[num].access = access;
 }
 
+void tss_set_kernel_stack(uintptr_t esp0) {
+    tss.esp0 = esp0;
+}
+
 void gdt_init(void) {
-    gp.limit = (sizeof(struct gdt_entry) * 5) - 1;
+    gp.limit = (sizeof(struct gdt_entry) * 6) - 1;
     gp.base = (uint32_t)&gdt;
 
     // NULL descriptor
@@ -36,5 +57,13 @@ void gdt_init(void) {
     // User Data Segment
     gdt_set_gate(4, 0, 0xFFFFFFFF, 0xF2, 0xCF);
 
+    // TSS disponível (tipo 0x9)
+    memset(&tss, 0, sizeof(tss));
+    tss.ss0 = GDT_KERNEL_DATA;
+    tss.esp0 = (uint32_t)ring0_stack + sizeof(ring0_stack);
+    tss.iomap_base = sizeof(tss);
+    gdt_set_gate(5, (uint32_t)&tss, sizeof(tss) - 1, 0x89, 0x00);
+
     gdt_flush((uint32_t)&gp);
+    asm volatile("ltr %w0" : : "r"(GDT_TSS));
 }
\ No newline at end of file
@@ -15,10 +15,21 @@ struct gdt_entry {
 
 struct gdt_ptr {
     uint16_t limit;
-    uint32_t base;
+    uintptr_t base;
 } __attribute__((packed));
 
+// Seletores da GDT de 32 bits (arch/x86_64/arch.h tem os do modo longo)
+#ifndef __x86_64__
+#define GDT_KERNEL_CODE 0x08
+#define GDT_KERNEL_DATA 0x10
+#define GDT_USER_CODE   0x18
+#define GDT_USER_DATA   0x20
+#define GDT_TSS         0x28
+#endif
+
 void gdt_init(void);
+// Pilha do kernel usada por interrupções (e SYSCALL) vindas do anel 3
+void tss_set_kernel_stack(uintptr_t stack);
 void gdt_set_gate(int num, uint32_t base, uint32_t limit, uint8_t access, uint8_t gran);
 
 #endif
\ No newline at end of file
@@ -0,0 +1,546 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "mmap.h"
+#include "vmm.h"
+#include "pmm.h"
+#include "pagecache.h"
+#include "dcache.h"
+#include "scheduler.h"
+
+// Cria um espaço de endereçamento sem regiões mapeadas
+mm_t *mm_create() {
+    mm_t *mm = malloc(sizeof(mm_t));
+    if(mm) {
+        mm->areas = NULL;
+        mm->rss = 0;
+        mm->faults = 0;
+    }
+    return mm;
+}
+
+// Desfaz todos os mapeamentos e libera o espaço de endereçamento
+void mm_destroy(mm_t *mm) {
+    mmap_unmap(mm, USER_MMAP_START, USER_MMAP_END - USER_MMAP_START);
+    free(mm);
+}
+
+// Procura a região que contém addr
+static vm_area_t *mmap_find(mm_t *mm, uintptr_t addr) {
+    for(vm_area_t *area = mm->areas; area && area->start <= addr; area = area->next) {
+        if(addr < area->end) {
+            return area;
+        }
+    }
+    return NULL;
+}
+
+// Verifica se [addr, addr + length) não intercepta nenhuma região
+static int mmap_range_free(mm_t *mm, uintptr_t addr, size_t length) {
+    if(addr < USER_MMAP_START || addr > USER_MMAP_END - length) {
+        return 0;
+    }
+    
+    for(vm_area_t *area = mm->areas; area; area = area->next) {
+        if(area->start < addr + length && addr < area->end) {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+// Primeiro intervalo livre com length bytes (0 se não houver)
+static uintptr_t mmap_find_free(mm_t *mm, size_t length) {
+    uintptr_t addr = USER_MMAP_START;
+    
+    for(vm_area_t *area = mm->areas; area; area = area->next) {
+        if(area->start - addr >= length) {
+            break;
+        }
+        addr = area->end;
+    }
+    
+    return (USER_MMAP_END - addr >= length) ? addr : 0;
+}
+
+// Insere uma região mantendo a lista ordenada por endereço
+static void mmap_insert(mm_t *mm, vm_area_t *area) {
+    vm_area_t **link = &mm->areas;
+    while(*link && (*link)->start < area->start) {
+        link = &(*link)->next;
+    }
+    area->next = *link;
+    *link = area;
+}
+
+// Nova região sobre o mesmo arquivo (pega uma referência; dentry NULL
+// nas anônimas)
+static vm_area_t *mmap_new_area(uintptr_t start, uintptr_t end, int prot, int flags,
+                                mountpoint_t *mount, dentry_t *dentry, uint32_t pgoff) {
+    vm_area_t *area = malloc(sizeof(vm_area_t));
+    if(!area) {
+        return NULL;
+    }
+    
+    area->start = start;
+    area->end = end;
+    area->prot = prot;
+    area->flags = flags;
+    area->mount = mount;
+    area->dentry = dentry ? dget(dentry) : NULL;
+    area->pgoff = pgoff;
+    area->next = NULL;
+    if(dentry) {
+        dentry->node->mmap_count++;
+    }
+    return area;
+}
+
+// Solta a referência ao arquivo e libera a região
+static void mmap_free_area(vm_area_t *area) {
+    if(area->dentry) {
+        area->dentry->node->mmap_count--;
+        dput(area->dentry);
+    }
+    free(area);
+}
+
+// Mapeia um arquivo (ou memória anônima, com MAP_ANONYMOUS e sem
+// arquivo); as páginas só são mapeadas no primeiro acesso
+void *mmap_region(mm_t *mm, uintptr_t addr, size_t length, int prot, int flags,
+                  mountpoint_t *mount, dentry_t *dentry, uint32_t pgoff) {
+    int type = flags & (MAP_SHARED | MAP_PRIVATE);
+    if(length == 0 || (type != MAP_SHARED && type != MAP_PRIVATE)) {
+        return MAP_FAILED;
+    }
+    
+    if(flags & MAP_ANONYMOUS) {
+        // Sem fork não há com quem compartilhar páginas anônimas
+        if(type != MAP_PRIVATE) {
+            return MAP_FAILED;
+        }
+        mount = NULL;
+        dentry = NULL;
+        pgoff = 0;
+        type |= MAP_ANONYMOUS;
+    } else {
+        vnode_t *node = dentry->node;
+        filesystem_t *fs = mount->fs;
+        if(!node || !S_ISREG(node->mode) || (!fs->getpage && !fs->readpage)) {
+            return MAP_FAILED;
+        }
+        
+        // Escrita compartilhada em cache de páginas precisa de writeback
+        if(type == MAP_SHARED && (prot & PROT_WRITE) && !fs->getpage && !fs->writepage) {
+            return MAP_FAILED;
+        }
+    }
+    
+    if(length > USER_MMAP_END - USER_MMAP_START) {
+        return MAP_FAILED;
+    }
+    size_t size = (length + PAGE_SIZE - 1) & PAGE_MASK;
+    
+    // Escolher o endereço
+    if(flags & MAP_FIXED) {
+        if(addr & ~PAGE_MASK) {
+            return MAP_FAILED;
+        }
+        if(addr < USER_MMAP_START || addr > USER_MMAP_END - size) {
+            return MAP_FAILED;
+        }
+        mmap_unmap(mm, addr, size);
+    } else if(!addr || (addr & ~PAGE_MASK) || !mmap_range_free(mm, addr, size)) {
+        addr = mmap_find_free(mm, size);
+        if(!addr) {
+            return MAP_FAILED;
+        }
+    }
+    
+    vm_area_t *area = mmap_new_area(addr, addr + size, prot, type, mount, dentry, pgoff);
+    if(!area) {
+        return MAP_FAILED;
+    }
+    
+    mmap_insert(mm, area);
+    return (void*)addr;
+}
+
+// Página do arquivo que guarda index (do sistema de arquivos ou do cache)
+static void *mmap_file_page(vm_area_t *area, uint32_t index) {
+    filesystem_t *fs = area->mount->fs;
+    vnode_t *node = area->dentry->node;
+    
+    if(fs->getpage) {
+        void *page;
+        return fs->getpage(node, index, &page) == 0 ? page : NULL;
+    }
+    
+    return pagecache_map_page(area->mount, node, index);
+}
+
+// Copia uma página para uma página anônima (cópia na escrita)
+static int mmap_copy_page(uintptr_t virt, const void *src, uintptr_t flags) {
+    void *copy = pmm_alloc_page();
+    if(!copy) {
+        return -1;
+    }
+    
+    memcpy(copy, src, PAGE_SIZE);
+    if(vmm_map_page(virt, (uintptr_t)copy, PTE_USER | PTE_ANON | flags) != 0) {
+        pmm_free_page(copy);
+        return -1;
+    }
+    return 0;
+}
+
+// Trata um page fault em uma região mapeada; -1 se o acesso for inválido
+int mmap_fault(uintptr_t addr, uint32_t error) {
+    mm_t *mm = scheduler_current_mm();
+    if(!mm) {
+        return -1;
+    }
+    mm->faults++;
+    
+    vm_area_t *area = mmap_find(mm, addr);
+    if(!area) {
+        return -1;
+    }
+    
+    int write = error & PF_WRITE;
+    if(write ? !(area->prot & PROT_WRITE) : !(area->prot & (PROT_READ | PROT_EXEC))) {
+        return -1;
+    }
+    
+    uintptr_t virt = addr & PAGE_MASK;
+    
+    // Anônima: página zerada no primeiro acesso
+    if(area->flags & MAP_ANONYMOUS) {
+        if(error & PF_PRESENT) {
+            return -1;
+        }
+        
+        void *page = pmm_alloc_page();
+        if(!page) {
+            return -1;
+        }
+        memset(page, 0, PAGE_SIZE);
+        
+        uint32_t pte_flags = PTE_USER | PTE_ANON;
+        if(area->prot & PROT_WRITE) {
+            pte_flags |= PTE_WRITE;
+        }
+        if(vmm_map_page(virt, (uintptr_t)page, pte_flags) != 0) {
+            pmm_free_page(page);
+            return -1;
+        }
+        mm->rss++;
+        return 0;
+    }
+    
+    uint32_t index = area->pgoff + ((virt - area->start) >> PAGE_SHIFT);
+    
+    // Acesso além do fim do arquivo
+    if(((uint64_t)index << PAGE_SHIFT) >= area->dentry->node->size) {
+        return -1;
+    }
+    
+    // Página presente: escrita em página privada ainda compartilhada
+    if(error & PF_PRESENT) {
+        if(!write || !(area->flags & MAP_PRIVATE)) {
+            return -1;
+        }
+        return mmap_copy_page(virt, (void*)PTE_ADDR(vmm_get_pte(virt)), PTE_WRITE);
+    }
+    
+    void *page = mmap_file_page(area, index);
+    if(!page) {
+        return -1;
+    }
+    
+    // Privada: mapear somente leitura até a primeira escrita
+    int result;
+    if(area->flags & MAP_PRIVATE) {
+        if(write) {
+            result = mmap_copy_page(virt, page, PTE_WRITE);
+        } else {
+            result = vmm_map_page(virt, (uintptr_t)page, PTE_USER);
+        }
+    } else {
+        uint32_t pte_flags = PTE_USER;
+        if(area->prot & PROT_WRITE) {
+            pte_flags |= PTE_WRITE;
+        }
+        result = vmm_map_page(virt, (uintptr_t)page, pte_flags);
+    }
+    
+    if(result == 0) {
+        mm->rss++;
+    }
+    return result;
+}
+
+// Zera de addr até o fim da página numa região privada de arquivo (bss que
+// começa no meio da última página com dados do arquivo). A página recebe
+// uma cópia privada já populada, com a proteção da região
+int mmap_zero_tail(mm_t *mm, uintptr_t addr) {
+    vm_area_t *area = mmap_find(mm, addr);
+    if(!area || !(area->flags & MAP_PRIVATE) || (area->flags & MAP_ANONYMOUS)) {
+        return -1;
+    }
+    
+    uintptr_t virt = addr & PAGE_MASK;
+    uintptr_t pte = vmm_get_pte(virt);
+    if(!(pte & PTE_PRESENT) || !(pte & PTE_ANON)) {
+        const void *src;
+        if(pte & PTE_PRESENT) {
+            src = (void*)PTE_ADDR(pte);
+        } else {
+            uint32_t index = area->pgoff + ((virt - area->start) >> PAGE_SHIFT);
+            if(((uint64_t)index << PAGE_SHIFT) >= area->dentry->node->size) {
+                return -1;
+            }
+            src = mmap_file_page(area, index);
+            if(!src) {
+                return -1;
+            }
+        }
+        
+        if(mmap_copy_page(virt, src, (area->prot & PROT_WRITE) ? PTE_WRITE : 0) != 0) {
+            return -1;
+        }
+        if(!(pte & PTE_PRESENT)) {
+            mm->rss++;
+        }
+    }
+    
+    uint8_t *page = (uint8_t*)PTE_ADDR(vmm_get_pte(virt));
+    memset(page + (addr & ~PAGE_MASK), 0, PAGE_SIZE - (addr & ~PAGE_MASK));
+    return 0;
+}
+
+// Propaga o bit dirty de uma PTE para o cache de páginas
+static void mmap_sync_pte(vm_area_t *area, uintptr_t virt, uintptr_t pte) {
+    if(!(area->flags & MAP_SHARED) || !(pte & PTE_DIRTY) || area->mount->fs->getpage) {
+        return; // Sistemas com getpage já escrevem direto no arquivo
+    }
+    
+    uint32_t index = area->pgoff + ((virt - area->start) >> PAGE_SHIFT);
+    pagecache_mark_dirty(area->dentry->node, index);
+}
+
+// Desfaz os mapeamentos das páginas em [start, end); retorna quantas
+// estavam presentes
+static uint32_t mmap_unmap_pages(vm_area_t *area, uintptr_t start, uintptr_t end) {
+    uint32_t unmapped = 0;
+    for(uintptr_t virt = start; virt < end; virt += PAGE_SIZE) {
+        uintptr_t pte = vmm_unmap_page(virt);
+        if(!pte) {
+            continue;
+        }
+        unmapped++;
+        
+        if(pte & PTE_ANON) {
+            pmm_free_page((void*)PTE_ADDR(pte));
+        } else {
+            mmap_sync_pte(area, virt, pte);
+        }
+    }
+    return unmapped;
+}
+
+// Remove os mapeamentos em [addr, addr + length), dividindo regiões
+int mmap_unmap(mm_t *mm, uintptr_t addr, size_t length) {
+    if((addr & ~PAGE_MASK) || length == 0 || length > UINTPTR_MAX - addr) {
+        return -1;
+    }
+    uintptr_t end = addr + length;
+    end = (end > USER_MMAP_END) ? USER_MMAP_END : ((end + PAGE_SIZE - 1) & PAGE_MASK);
+    
+    vm_area_t **link = &mm->areas;
+    while(*link) {
+        vm_area_t *area = *link;
+        if(area->end <= addr) {
+            link = &area->next;
+            continue;
+        }
+        if(area->start >= end) {
+            break;
+        }
+        
+        uintptr_t from = area->start > addr ? area->start : addr;
+        uintptr_t to = area->end < end ? area->end : end;
+        mm->rss -= mmap_unmap_pages(area, from, to);
+        
+        if(from == area->start && to == area->end) {
+            // Região inteira
+            *link = area->next;
+            mmap_free_area(area);
+            continue;
+        }
+        
+        if(from > area->start && to < area->end) {
+            // Buraco no meio: a parte de cima vira uma nova região
+            uint32_t pgoff = area->pgoff + ((to - area->start) >> PAGE_SHIFT);
+            vm_area_t *upper = mmap_new_area(to, area->end, area->prot, area->flags,
+                                             area->mount, area->dentry, pgoff);
+            if(!upper) {
+                return -1;
+            }
+            upper->next = area->next;
+            area->next = upper;
+            area->end = from;
+        } else if(from == area->start) {
+            area->pgoff += (to - area->start) >> PAGE_SHIFT;
+            area->start = to;
+        } else {
+            area->end = from;
+        }
+        link = &area->next;
+    }
+    
+    return 0;
+}
+
+// Escreve de volta as páginas modificadas através de mapeamentos compartilhados
+int mmap_sync(mm_t *mm, uintptr_t addr, size_t length, int flags) {
+    if((addr & ~PAGE_MASK) || length > UINTPTR_MAX - addr) {
+        return -1;
+    }
+    uintptr_t end = addr + length;
+    int found = 0;
+    int result = 0;
+    
+    for(vm_area_t *area = mm->areas; area && area->start < end; area = area->next) {
+        if(area->end <= addr) {
+            continue;
+        }
+        found = 1;
+        
+        if(!(area->flags & MAP_SHARED) || area->mount->fs->getpage) {
+            continue;
+        }
+        
+        uintptr_t from = area->start > addr ? area->start : addr;
+        uintptr_t to = area->end < end ? area->end : end;
+        for(uintptr_t virt = from; virt < to; virt += PAGE_SIZE) {
+            uintptr_t pte = vmm_get_pte(virt);
+            if((pte & PTE_PRESENT) && (pte & PTE_DIRTY)) {
+                mmap_sync_pte(area, virt, pte);
+                vmm_clear_pte_flags(virt, PTE_DIRTY);
+            }
+        }
+        
+        // MS_ASYNC deixa o writeback para o flusher
+        if((flags & MS_SYNC) && pagecache_sync(area->dentry->node) != 0) {
+            result = -1;
+        }
+    }
+    
+    return found ? result : -1;
+}
+
+// Página física com o conteúdo atual de virt, para quem não pode levar a
+// própria página: cópia da página presente, do arquivo ou zerada
+static void *mmap_snapshot_page(vm_area_t *area, uintptr_t virt, uintptr_t pte) {
+    void *copy = pmm_alloc_page();
+    if(!copy) {
+        return NULL;
+    }
+    
+    const void *src = NULL;
+    if(pte & PTE_PRESENT) {
+        src = (const void*)PTE_ADDR(pte);
+    } else if(!(area->flags & MAP_ANONYMOUS)) {
+        uint32_t index = area->pgoff + ((virt - area->start) >> PAGE_SHIFT);
+        if(((uint64_t)index << PAGE_SHIFT) < area->dentry->node->size) {
+            src = mmap_file_page(area, index);
+        }
+    }
+    
+    if(src) {
+        memcpy(copy, src, PAGE_SIZE);
+    } else {
+        memset(copy, 0, PAGE_SIZE);
+    }
+    return copy;
+}
+
+// Retira as páginas de [addr, addr + length), que precisam estar numa
+// mesma região legível, e desfaz os mapeamentos; páginas anônimas mudam
+// de dono sem cópia. Retorna o número de páginas em pages
+int mmap_detach_pages(mm_t *mm, uintptr_t addr, size_t length, uintptr_t *pages) {
+    if((addr & ~PAGE_MASK) || length == 0 || length > USER_MMAP_END - USER_MMAP_START) {
+        return -1;
+    }
+    uintptr_t end = addr + ((length + PAGE_SIZE - 1) & PAGE_MASK);
+    
+    vm_area_t *area = mmap_find(mm, addr);
+    if(!area || end > area->end || !(area->prot & PROT_READ)) {
+        return -1;
+    }
+    
+    // Primeiro as cópias, que podem falhar; depois nada mais falha
+    uint32_t count = 0;
+    for(uintptr_t virt = addr; virt < end; virt += PAGE_SIZE, count++) {
+        uintptr_t pte = vmm_get_pte(virt);
+        if((pte & PTE_PRESENT) && (pte & PTE_ANON)) {
+            pages[count] = 0;
+            continue;
+        }
+        
+        void *copy = mmap_snapshot_page(area, virt, pte);
+        if(!copy) {
+            while(count-- > 0) {
+                if(pages[count]) {
+                    pmm_free_page((void*)pages[count]);
+                }
+            }
+            return -1;
+        }
+        pages[count] = (uintptr_t)copy;
+    }
+    
+    count = 0;
+    for(uintptr_t virt = addr; virt < end; virt += PAGE_SIZE, count++) {
+        if(!pages[count]) {
+            pages[count] = PTE_ADDR(vmm_unmap_page(virt));
+            mm->rss--;
+        }
+    }
+    
+    // O que sobrou (páginas do arquivo) sai como num munmap
+    mmap_unmap(mm, addr, end - addr);
+    return count;
+}
+
+// Mapeia count páginas físicas numa região anônima nova; em caso de falha
+// as páginas continuam do chamador
+void *mmap_attach_pages(mm_t *mm, const uintptr_t *pages, uint32_t count, int prot) {
+    size_t size = (size_t)count << PAGE_SHIFT;
+    void *addr = mmap_region(mm, 0, size, prot, MAP_PRIVATE | MAP_ANONYMOUS, NULL, NULL, 0);
+    if(addr == MAP_FAILED) {
+        return MAP_FAILED;
+    }
+    
+    uintptr_t pte_flags = PTE_USER | PTE_ANON;
+    if(prot & PROT_WRITE) {
+        pte_flags |= PTE_WRITE;
+    }
+    
+    uintptr_t start = (uintptr_t)addr;
+    for(uint32_t i = 0; i < count; i++) {
+        if(vmm_map_page(start + ((uintptr_t)i << PAGE_SHIFT), pages[i], pte_flags) != 0) {
+            // Desfazer sem liberar as páginas já mapeadas
+            while(i-- > 0) {
+                vmm_unmap_page(start + ((uintptr_t)i << PAGE_SHIFT));
+                mm->rss--;
+            }
+            mmap_unmap(mm, start, size);
+            return MAP_FAILED;
+        }
+        mm->rss++;
+    }
+    
+    return addr;
+}
@@ -0,0 +1,65 @@
+#ifndef MMAP_H
+#define MMAP_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+
+// Proteção
+#define PROT_NONE  0x0
+#define PROT_READ  0x1
+#define PROT_WRITE 0x2
+#define PROT_EXEC  0x4
+
+// Tipo de mapeamento
+#define MAP_SHARED  0x01    // Páginas do arquivo mapeadas diretamente
+#define MAP_PRIVATE 0x02    // Cópia na escrita
+#define MAP_FIXED   0x10
+#define MAP_ANONYMOUS 0x20  // Sem arquivo: páginas zeradas no primeiro acesso
+
+#define MAP_FAILED ((void*)-1)
+
+// Flags de msync
+#define MS_ASYNC      0x1
+#define MS_INVALIDATE 0x2
+#define MS_SYNC       0x4
+
+struct dentry;
+
+// Região mapeada de um processo
+typedef struct vm_area {
+    uintptr_t start;            // Alinhado a página
+    uintptr_t end;              // Exclusivo
+    uint32_t prot;
+    uint32_t flags;
+    mountpoint_t *mount;        // NULL nas regiões anônimas
+    struct dentry *dentry;      // Referência ao arquivo mapeado (ou NULL)
+    uint32_t pgoff;             // Primeira página do arquivo
+    struct vm_area *next;       // Ordenada por endereço
+} vm_area_t;
+
+// Espaço de endereçamento de um processo
+typedef struct mm {
+    vm_area_t *areas;
+    uint32_t rss;               // Páginas mapeadas
+    uint32_t faults;            // Page faults tratados ou recusados
+} mm_t;
+
+mm_t *mm_create(void);
+void mm_destroy(mm_t *mm);
+void *mmap_region(mm_t *mm, uintptr_t addr, size_t length, int prot, int flags,
+                  mountpoint_t *mount, struct dentry *dentry, uint32_t pgoff);
+int mmap_unmap(mm_t *mm, uintptr_t addr, size_t length);
+int mmap_sync(mm_t *mm, uintptr_t addr, size_t length, int flags);
+int mmap_fault(uintptr_t addr, uint32_t error);
+int mmap_zero_tail(mm_t *mm, uintptr_t addr);
+
+// Transferência de páginas entre espaços de endereçamento (IPC): detach
+// tira as páginas de [addr, addr + length) do processo, que perde a
+// região, e devolve os endereços físicos (a cópia é feita só para páginas
+// que não são anônimas); attach mapeia páginas recebidas numa região
+// anônima nova, que passa a ser dona delas
+int mmap_detach_pages(mm_t *mm, uintptr_t addr, size_t length, uintptr_t *pages);
+void *mmap_attach_pages(mm_t *mm, const uintptr_t *pages, uint32_t count, int prot);
+
+#endif
@@ -0,0 +1,548 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "pagecache.h"
+#include "pmm.h"
+#include "scheduler.h"
+#include "console.h"
+
+#define PAGECACHE_MAX_PAGES  8192   // 32MB; acima disso, despejar
+#define PAGECACHE_DIRTY_HIGH 256    // Acordar o flusher a partir daqui
+#define PAGECACHE_WRITEBACK_TICKS 500 // Writeback periódico (5s a 100Hz)
+#define RA_MIN_PAGES 4              // Janela inicial de readahead
+#define RA_MAX_PAGES 64             // Janela máxima (256KB)
+
+// Todos os mapeamentos com páginas em cache
+static page_mapping_t *mappings = NULL;
+
+// Ponteiro do relógio; as páginas formam uma lista circular
+static cache_page_t *clock_hand = NULL;
+
+// Slot do processo de writeback (-1 = não está rodando)
+static volatile int32_t flusher_slot = -1;
+static volatile int flusher_sleeping = 0;
+
+static pagecache_stats_t stats;
+
+// Inicializa o cache de páginas
+void pagecache_init() {
+    mappings = NULL;
+    clock_hand = NULL;
+    memset(&stats, 0, sizeof(stats));
+}
+
+// Retorna (criando se preciso) o mapeamento de um vnode
+static page_mapping_t *pagecache_mapping(mountpoint_t *mount, vnode_t *node) {
+    if(node->mapping) {
+        return node->mapping;
+    }
+    
+    page_mapping_t *mapping = malloc(sizeof(page_mapping_t));
+    if(!mapping) {
+        return NULL;
+    }
+    
+    mapping->mount = mount;
+    mapping->node = node;
+    radix_init(&mapping->pages);
+    mapping->nr_pages = 0;
+    mapping->nr_dirty = 0;
+    mapping->ra_next = 0;
+    mapping->ra_size = 0;
+    
+    mapping->next = mappings;
+    mappings = mapping;
+    node->mapping = mapping;
+    return mapping;
+}
+
+// Insere uma página logo atrás do ponteiro do relógio
+static void clock_insert(cache_page_t *page) {
+    if(!clock_hand) {
+        page->clock_prev = page->clock_next = page;
+        clock_hand = page;
+        return;
+    }
+    
+    page->clock_next = clock_hand;
+    page->clock_prev = clock_hand->clock_prev;
+    clock_hand->clock_prev->clock_next = page;
+    clock_hand->clock_prev = page;
+}
+
+// Remove uma página da lista do relógio
+static void clock_remove(cache_page_t *page) {
+    if(page->clock_next == page) {
+        clock_hand = NULL;
+    } else {
+        page->clock_prev->clock_next = page->clock_next;
+        page->clock_next->clock_prev = page->clock_prev;
+        if(clock_hand == page) {
+            clock_hand = page->clock_next;
+        }
+    }
+    
+    page->clock_prev = page->clock_next = NULL;
+}
+
+// Escreve uma página suja de volta no sistema de arquivos
+static int pagecache_writepage(cache_page_t *page) {
+    page_mapping_t *mapping = page->mapping;
+    filesystem_t *fs = mapping->mount->fs;
+    
+    if(!(page->flags & PAGE_DIRTY)) {
+        return 0;
+    }
+    
+    if(!fs->writepage || fs->writepage(mapping->node, page->index, page->data) < 0) {
+        return -1;
+    }
+    
+    page->flags &= ~PAGE_DIRTY;
+    mapping->nr_dirty--;
+    stats.dirty--;
+    stats.writebacks++;
+    return 0;
+}
+
+// Remove uma página do cache sem escrevê-la
+static void pagecache_drop_page(cache_page_t *page) {
+    page_mapping_t *mapping = page->mapping;
+    
+    if(page->flags & PAGE_DIRTY) {
+        mapping->nr_dirty--;
+        stats.dirty--;
+    }
+    
+    radix_delete(&mapping->pages, page->index);
+    mapping->nr_pages--;
+    clock_remove(page);
+    stats.pages--;
+    
+    pmm_free_page(page->data);
+    free(page);
+}
+
+// Despeja uma página usando o algoritmo do relógio (segunda chance)
+static int pagecache_evict() {
+    // Duas voltas bastam: a primeira limpa os bits de referência
+    uint32_t budget = 2 * stats.pages;
+    
+    while(clock_hand && budget-- > 0) {
+        cache_page_t *page = clock_hand;
+        clock_hand = page->clock_next;
+        
+        if(page->flags & PAGE_REFERENCED) {
+            page->flags &= ~PAGE_REFERENCED;
+            continue;
+        }
+        
+        // Páginas de arquivos mapeados podem estar em tabelas de páginas
+        if(page->mapping->node->mmap_count > 0) {
+            continue;
+        }
+        
+        if(pagecache_writepage(page) != 0) {
+            continue; // Não dá para descartar sem perder dados
+        }
+        
+        pagecache_drop_page(page);
+        stats.evictions++;
+        return 0;
+    }
+    
+    return -1;
+}
+
+// Aloca uma página física para o cache, despejando se permitido
+static void *pagecache_alloc_data(int may_evict) {
+    if(stats.pages >= PAGECACHE_MAX_PAGES && (!may_evict || pagecache_evict() != 0)) {
+        return NULL;
+    }
+    
+    void *data = pmm_alloc_page();
+    if(!data && may_evict && pagecache_evict() == 0) {
+        data = pmm_alloc_page();
+    }
+    
+    return data;
+}
+
+// Cria a página de um índice; fill = ler do sistema de arquivos.
+// Readahead não despeja: sob pressão ele só expulsaria a própria janela
+static cache_page_t *pagecache_add(page_mapping_t *mapping, uint32_t index, int fill, int may_evict) {
+    cache_page_t *page = malloc(sizeof(cache_page_t));
+    if(!page) {
+        return NULL;
+    }
+    
+    page->data = pagecache_alloc_data(may_evict);
+    if(!page->data) {
+        free(page);
+        return NULL;
+    }
+    
+    // Ler do dispositivo; o que passar do fim do arquivo fica zerado
+    int bytes = 0;
+    uint64_t start = (uint64_t)index << PAGECACHE_PAGE_SHIFT;
+    if(fill && start < mapping->node->size) {
+        filesystem_t *fs = mapping->mount->fs;
+        bytes = fs->readpage(mapping->node, index, page->data);
+        if(bytes < 0) {
+            pmm_free_page(page->data);
+            free(page);
+            return NULL;
+        }
+    }
+    if(bytes < PAGECACHE_PAGE_SIZE) {
+        memset((uint8_t*)page->data + bytes, 0, PAGECACHE_PAGE_SIZE - bytes);
+    }
+    
+    if(radix_insert(&mapping->pages, index, page) != 0) {
+        pmm_free_page(page->data);
+        free(page);
+        return NULL;
+    }
+    
+    page->mapping = mapping;
+    page->index = index;
+    page->flags = PAGE_UPTODATE | PAGE_REFERENCED;
+    clock_insert(page);
+    
+    mapping->nr_pages++;
+    stats.pages++;
+    return page;
+}
+
+// Procura uma página em cache e marca o acesso
+static cache_page_t *pagecache_find(page_mapping_t *mapping, uint32_t index) {
+    cache_page_t *page = radix_lookup(&mapping->pages, index);
+    if(page) {
+        page->flags |= PAGE_REFERENCED;
+        stats.hits++;
+    }
+    return page;
+}
+
+// Lê antecipadamente a janela que começa em index; dobra a janela
+// a cada chamada enquanto o acesso continuar sequencial
+static void pagecache_readahead(page_mapping_t *mapping, uint32_t index) {
+    if(mapping->ra_size == 0) {
+        mapping->ra_size = RA_MIN_PAGES;
+    } else if(mapping->ra_size < RA_MAX_PAGES) {
+        mapping->ra_size *= 2;
+    }
+    
+    uint64_t end = mapping->node->size;
+    for(uint32_t i = 1; i < mapping->ra_size; i++) {
+        uint32_t ra_index = index + i;
+        if(((uint64_t)ra_index << PAGECACHE_PAGE_SHIFT) >= end) {
+            break;
+        }
+        
+        if(radix_lookup(&mapping->pages, ra_index)) {
+            continue;
+        }
+        
+        cache_page_t *page = pagecache_add(mapping, ra_index, 1, 0);
+        if(!page) {
+            // Sem memória livre: encolher a janela
+            mapping->ra_size = i > RA_MIN_PAGES ? i : RA_MIN_PAGES;
+            break;
+        }
+        
+        // Ainda não foi usada: primeira candidata a despejo se errarmos
+        page->flags &= ~PAGE_REFERENCED;
+        stats.readahead++;
+    }
+}
+
+// Lê de um arquivo através do cache de páginas
+int pagecache_read(mountpoint_t *mount, vnode_t *node, uint32_t offset, void *buffer, size_t size) {
+    if(offset >= node->size) {
+        return 0;
+    }
+    if(size > node->size - offset) {
+        size = node->size - offset;
+    }
+    if(size == 0) {
+        return 0;
+    }
+    
+    page_mapping_t *mapping = pagecache_mapping(mount, node);
+    if(!mapping) {
+        return -1;
+    }
+    
+    // Sequencial se continua onde a última leitura parou (mesma página ou a seguinte)
+    uint32_t first = offset >> PAGECACHE_PAGE_SHIFT;
+    int sequential = first == mapping->ra_next || first + 1 == mapping->ra_next;
+    if(!sequential) {
+        mapping->ra_size = 0;
+    }
+    
+    uint8_t *dst = buffer;
+    size_t done = 0;
+    
+    while(done < size) {
+        uint32_t index = offset >> PAGECACHE_PAGE_SHIFT;
+        uint32_t page_offset = offset & (PAGECACHE_PAGE_SIZE - 1);
+        size_t chunk = PAGECACHE_PAGE_SIZE - page_offset;
+        if(chunk > size - done) {
+            chunk = size - done;
+        }
+        
+        cache_page_t *page = pagecache_find(mapping, index);
+        if(!page) {
+            stats.misses++;
+            page = pagecache_add(mapping, index, 1, 1);
+            if(!page) {
+                break;
+            }
+            
+            memcpy(dst + done, (uint8_t*)page->data + page_offset, chunk);
+            
+            // Só depois da cópia: a janela pode despejar esta página
+            if(sequential) {
+                pagecache_readahead(mapping, index);
+            }
+        } else {
+            memcpy(dst + done, (uint8_t*)page->data + page_offset, chunk);
+        }
+        
+        done += chunk;
+        offset += chunk;
+    }
+    
+    if(done == 0) {
+        return -1;
+    }
+    
+    mapping->ra_next = (offset - 1) / PAGECACHE_PAGE_SIZE + 1;
+    return done;
+}
+
+// Escreve todas as páginas sujas de um mapeamento
+static int pagecache_sync_mapping(page_mapping_t *mapping) {
+    uint32_t index = 0;
+    int result = 0;
+    
+    while(mapping->nr_dirty > 0) {
+        cache_page_t *page = radix_next(&mapping->pages, index, &index);
+        if(!page) {
+            break;
+        }
+        if(pagecache_writepage(page) != 0) {
+            result = -1;
+        }
+        if(++index == 0) {
+            break;
+        }
+    }
+    
+    return result;
+}
+
+// Escreve as páginas sujas de todos os mapeamentos (usado pelo flusher)
+static void pagecache_sync_all() {
+    for(page_mapping_t *mapping = mappings; mapping; mapping = mapping->next) {
+        if(mapping->nr_dirty > 0) {
+            pagecache_sync_mapping(mapping);
+        }
+    }
+}
+
+// Escreve em um arquivo através do cache; o writeback fica para o flusher
+int pagecache_write(mountpoint_t *mount, vnode_t *node, uint32_t offset, const void *buffer, size_t size) {
+    page_mapping_t *mapping = pagecache_mapping(mount, node);
+    if(!mapping) {
+        return -1;
+    }
+    
+    // Não ultrapassar 4GB
+    if(size > 0xFFFFFFFFu - offset) {
+        size = 0xFFFFFFFFu - offset;
+    }
+    
+    const uint8_t *src = buffer;
+    size_t done = 0;
+    
+    while(done < size) {
+        uint32_t index = offset >> PAGECACHE_PAGE_SHIFT;
+        uint32_t page_offset = offset & (PAGECACHE_PAGE_SIZE - 1);
+        size_t chunk = PAGECACHE_PAGE_SIZE - page_offset;
+        if(chunk > size - done) {
+            chunk = size - done;
+        }
+        
+        cache_page_t *page = pagecache_find(mapping, index);
+        if(!page) {
+            stats.misses++;
+            
+            // Página inteira sobrescrita: não precisa ler do dispositivo
+            int fill = chunk < PAGECACHE_PAGE_SIZE;
+            page = pagecache_add(mapping, index, fill, 1);
+            if(!page) {
+                break;
+            }
+        }
+        
+        memcpy((uint8_t*)page->data + page_offset, src + done, chunk);
+        if(!(page->flags & PAGE_DIRTY)) {
+            page->flags |= PAGE_DIRTY;
+            mapping->nr_dirty++;
+            stats.dirty++;
+        }
+        
+        done += chunk;
+        offset += chunk;
+        if(offset > node->size) {
+            node->size = offset;
+        }
+    }
+    
+    if(flusher_slot < 0) {
+        // Sem flusher: writeback síncrono (write-through)
+        if(pagecache_sync_mapping(mapping) != 0) {
+            return -1;
+        }
+    } else if(stats.dirty >= PAGECACHE_DIRTY_HIGH && flusher_sleeping) {
+        scheduler_wake((uint32_t)flusher_slot);
+    }
+    
+    if(done == 0 && size > 0) {
+        return -1;
+    }
+    return done;
+}
+
+// Descarta as páginas além de size (após truncar o arquivo)
+void pagecache_truncate(vnode_t *node, uint32_t size) {
+    page_mapping_t *mapping = node->mapping;
+    if(!mapping) {
+        return;
+    }
+    
+    // Zerar o final da última página parcial
+    uint32_t tail = size & (PAGECACHE_PAGE_SIZE - 1);
+    uint32_t first = size >> PAGECACHE_PAGE_SHIFT;
+    if(tail) {
+        cache_page_t *page = radix_lookup(&mapping->pages, first);
+        if(page) {
+            memset((uint8_t*)page->data + tail, 0, PAGECACHE_PAGE_SIZE - tail);
+        }
+        first++;
+        if(first == 0) {
+            return;
+        }
+    }
+    
+    uint32_t index;
+    cache_page_t *page;
+    while((page = radix_next(&mapping->pages, first, &index)) != NULL) {
+        pagecache_drop_page(page);
+    }
+    
+    if(mapping->ra_next > first) {
+        mapping->ra_next = first;
+    }
+}
+
+// Escreve as páginas sujas de um vnode (fsync)
+int pagecache_sync(vnode_t *node) {
+    if(!node->mapping) {
+        return 0;
+    }
+    return pagecache_sync_mapping(node->mapping);
+}
+
+// Retorna a página em cache de index para mapeamento direto (mmap)
+void *pagecache_map_page(mountpoint_t *mount, vnode_t *node, uint32_t index) {
+    page_mapping_t *mapping = pagecache_mapping(mount, node);
+    if(!mapping) {
+        return NULL;
+    }
+    
+    cache_page_t *page = pagecache_find(mapping, index);
+    if(!page) {
+        stats.misses++;
+        page = pagecache_add(mapping, index, 1, 1);
+    }
+    
+    return page ? page->data : NULL;
+}
+
+// Marca uma página como suja (escrita através de um mapeamento)
+void pagecache_mark_dirty(vnode_t *node, uint32_t index) {
+    if(!node->mapping) {
+        return;
+    }
+    
+    cache_page_t *page = radix_lookup(&node->mapping->pages, index);
+    if(page && !(page->flags & PAGE_DIRTY)) {
+        page->flags |= PAGE_DIRTY;
+        node->mapping->nr_dirty++;
+        stats.dirty++;
+    }
+}
+
+// Escreve e descarta todas as páginas de uma montagem (antes de desmontar)
+void pagecache_release_mount(mountpoint_t *mount) {
+    page_mapping_t **link = &mappings;
+    
+    while(*link) {
+        page_mapping_t *mapping = *link;
+        if(mapping->mount != mount) {
+            link = &mapping->next;
+            continue;
+        }
+        
+        pagecache_sync_mapping(mapping);
+        
+        uint32_t index;
+        cache_page_t *page;
+        while((page = radix_next(&mapping->pages, 0, &index)) != NULL) {
+            pagecache_drop_page(page);
+        }
+        
+        *link = mapping->next;
+        mapping->node->mapping = NULL;
+        free(mapping);
+    }
+}
+
+// Processo de writeback: dorme até haver páginas sujas demais ou até o
+// próximo writeback periódico, que limita o tempo que uma escrita pequena
+// passa só na memória
+static void pagecache_flusher() {
+    flusher_slot = (int32_t)scheduler_current();
+    
+    for(;;) {
+        pagecache_sync_all();
+        
+        asm volatile("cli");
+        if(stats.dirty < PAGECACHE_DIRTY_HIGH) {
+            flusher_sleeping = 1;
+            scheduler_block_timeout(PAGECACHE_WRITEBACK_TICKS);
+            
+            // Nenhum outro processo pronto: esperar pela próxima interrupção
+            if(stats.dirty < PAGECACHE_DIRTY_HIGH) {
+                asm volatile("sti; hlt");
+            }
+            flusher_sleeping = 0;
+        }
+        asm volatile("sti");
+    }
+}
+
+// Inicia o flusher (chamado depois do escalonador)
+void pagecache_start_flusher() {
+    if(process_create(pagecache_flusher, 0) == 0) {
+        console_write("pagecache: flusher indisponivel, usando write-through\n");
+    }
+}
+
+// Retorna as estatísticas do cache
+const pagecache_stats_t *pagecache_get_stats() {
+    return &stats;
+}
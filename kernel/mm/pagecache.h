@@ -0,0 +1,59 @@
+#ifndef PAGECACHE_H
+#define PAGECACHE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vfs.h"
+#include "radix.h"
+
+#define PAGECACHE_PAGE_SIZE  4096
+#define PAGECACHE_PAGE_SHIFT 12
+
+// Flags de uma página em cache
+#define PAGE_UPTODATE   0x01    // Conteúdo lido do dispositivo
+#define PAGE_DIRTY      0x02    // Modificada, aguardando writeback
+#define PAGE_REFERENCED 0x04    // Acessada desde a última volta do relógio
+
+typedef struct cache_page {
+    struct page_mapping *mapping;
+    struct cache_page *clock_prev;  // Lista circular do algoritmo do relógio
+    struct cache_page *clock_next;
+    void *data;                     // Página física (pmm)
+    uint32_t index;                 // Offset no arquivo / PAGECACHE_PAGE_SIZE
+    uint32_t flags;
+} cache_page_t;
+
+// Páginas em cache de um vnode (vnode->mapping)
+typedef struct page_mapping {
+    mountpoint_t *mount;
+    vnode_t *node;
+    struct page_mapping *next;      // Lista global de mapeamentos
+    radix_tree_t pages;             // Índice da página -> cache_page_t
+    uint32_t nr_pages;
+    uint32_t nr_dirty;
+    uint32_t ra_next;               // Índice esperado de uma leitura sequencial
+    uint32_t ra_size;               // Janela de readahead atual (páginas)
+} page_mapping_t;
+
+typedef struct pagecache_stats {
+    uint32_t hits;
+    uint32_t misses;
+    uint32_t readahead;     // Páginas lidas antecipadamente
+    uint32_t evictions;
+    uint32_t writebacks;
+    uint32_t pages;         // Páginas em cache
+    uint32_t dirty;
+} pagecache_stats_t;
+
+void pagecache_init(void);
+void pagecache_start_flusher(void);
+int pagecache_read(mountpoint_t *mount, vnode_t *node, uint32_t offset, void *buffer, size_t size);
+int pagecache_write(mountpoint_t *mount, vnode_t *node, uint32_t offset, const void *buffer, size_t size);
+void pagecache_truncate(vnode_t *node, uint32_t size);
+int pagecache_sync(vnode_t *node);
+void *pagecache_map_page(mountpoint_t *mount, vnode_t *node, uint32_t index);
+void pagecache_mark_dirty(vnode_t *node, uint32_t index);
+void pagecache_release_mount(mountpoint_t *mount);
+const pagecache_stats_t *pagecache_get_stats(void);
+
+#endif
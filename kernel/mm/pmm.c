@@ -1,40 +1,95 @@
 #include <stdint.h>
 #include <stddef.h>
 #include "pmm.h"
+#include "trace.h"
 
 // Bitmap para rastrear páginas físicas (1 = usado, 0 = livre)
 static uint32_t *physical_memory_bitmap;
 static uint32_t total_pages;
 static uint32_t used_pages;
 
+// Marca count páginas a partir de first como usadas
+void pmm_mark_region_used(uint32_t first, uint32_t count) {
+    for(uint32_t page = first; page < first + count && page < total_pages; page++) {
+        if(!(physical_memory_bitmap[page / 32] & (1u << (page % 32)))) {
+            physical_memory_bitmap[page / 32] |= 1u << (page % 32);
+            used_pages++;
+        }
+    }
+}
+
+// Limite físico gerenciado: o i386 sem PAE só endereça 4GB
+#ifdef __x86_64__
+#define PMM_MAX_ADDRESS 0x0000010000000000ULL  // 1TB
+#else
+#define PMM_MAX_ADDRESS 0x100000000ULL
+#endif
+
 // Inicializa o gerenciador de memória física
 void pmm_init(multiboot_info_t *mbi) {
     // Obter informações de memória do bootloader
-    memory_map_t *mmap = (memory_map_t*)mbi->mmap_addr;
-    uint32_t total_memory = 0;
+    memory_map_t *mmap = (memory_map_t*)(uintptr_t)mbi->mmap_addr;
+    uintptr_t mmap_end = mbi->mmap_addr + mbi->mmap_length;
+    uint64_t memory_end = 0;
     
-    // Calcular memória total disponível
-    while((unsigned long)mmap < mbi->mmap_addr + mbi->mmap_length) {
+    // As páginas são indexadas pelo endereço físico: o bitmap cobre até o
+    // fim da última região disponível (bases e tamanhos de 64 bits)
+    while((uintptr_t)mmap < mmap_end) {
         if(mmap->type == 1) { // Memória disponível
-            total_memory += mmap->length_low;
+            uint64_t base = mmap->base_addr_low | ((uint64_t)mmap->base_addr_high << 32);
+            uint64_t length = mmap->length_low | ((uint64_t)mmap->length_high << 32);
+            if(base + length > memory_end) {
+                memory_end = base + length;
+            }
         }
-        mmap = (memory_map_t*)((unsigned int)mmap + mmap->size + sizeof(mmap->size));
+        mmap = (memory_map_t*)((uintptr_t)mmap + mmap->size + sizeof(mmap->size));
+    }
+    if(memory_end > PMM_MAX_ADDRESS) {
+        memory_end = PMM_MAX_ADDRESS;
     }
     
     // Calcular número total de páginas (4KB por página)
-    total_pages = total_memory / 4096;
-    used_pages = 0;
+    total_pages = memory_end >> 12;
     
     // Alocar bitmap para rastrear páginas
     physical_memory_bitmap = (uint32_t*)BITMAP_ADDRESS;
     
-    // Inicializar bitmap (0 = livre)
-    for(uint32_t i = 0; i < total_pages / 32; i++) {
-        physical_memory_bitmap[i] = 0;
+    // Tudo começa usado; buracos e regiões reservadas nunca são liberados
+    for(uint32_t i = 0; i < (total_pages + 31) / 32; i++) {
+        physical_memory_bitmap[i] = 0xFFFFFFFF;
+    }
+    used_pages = total_pages;
+    
+    mmap = (memory_map_t*)(uintptr_t)mbi->mmap_addr;
+    while((uintptr_t)mmap < mmap_end) {
+        if(mmap->type == 1) {
+            uint64_t base = mmap->base_addr_low | ((uint64_t)mmap->base_addr_high << 32);
+            uint64_t length = mmap->length_low | ((uint64_t)mmap->length_high << 32);
+            uint64_t first = (base + 4095) >> 12;
+            uint64_t last = (base + length) >> 12;
+            for(uint32_t page = first; page < last && page < total_pages; page++) {
+                // Regiões sobrepostas não liberam a mesma página duas vezes
+                if(physical_memory_bitmap[page / 32] & (1u << (page % 32))) {
+                    physical_memory_bitmap[page / 32] &= ~(1u << (page % 32));
+                    used_pages--;
+                }
+            }
+        }
+        mmap = (memory_map_t*)((uintptr_t)mmap + mmap->size + sizeof(mmap->size));
     }
     
     // Marcar páginas de baixa memória e do kernel como usadas
     pmm_mark_region_used(0, KERNEL_END_ADDRESS / 4096);
+    
+    // Módulos continuam em uso: o initramfs aponta direto para eles
+    if(mbi->flags & MULTIBOOT_INFO_MODS) {
+        multiboot_module_t *mods = (multiboot_module_t*)(uintptr_t)mbi->mods_addr;
+        for(uint32_t i = 0; i < mbi->mods_count; i++) {
+            uint32_t first = mods[i].mod_start / 4096;
+            uint32_t last = (mods[i].mod_end + 4095) / 4096;
+            pmm_mark_region_used(first, last - first);
+        }
+    }
 }
 
 // Aloca uma página física
@@ -48,7 +103,7 @@ void* pmm_alloc_page() {
         if(physical_memory_bitmap[i] != 0xFFFFFFFF) {
             // Encontrar bit livre
             for(uint8_t j = 0; j < 32; j++) {
-                uint32_t bit = 1 << j;
+                uint32_t bit = 1u << j;
                 if(!(physical_memory_bitmap[i] & bit)) {
                     // Marcar como usado
                     physical_memory_bitmap[i] |= bit;
@@ -56,7 +111,8 @@ void* pmm_alloc_page() {
                     
                     // Calcular endereço físico
                     uint32_t page = i * 32 + j;
-                    return (void*)(page * 4096);
+                    TRACE(TRACE_PMM_ALLOC, page, 1);
+                    return (void*)((uintptr_t)page * 4096);
                 }
             }
         }
@@ -67,13 +123,59 @@ void* pmm_alloc_page() {
 
 // Libera uma página física
 void pmm_free_page(void *page_addr) {
-    uint32_t page = (uint32_t)page_addr / 4096;
+    uint32_t page = (uintptr_t)page_addr / 4096;
     uint32_t index = page / 32;
-    uint32_t bit = 1 << (page % 32);
+    uint32_t bit = 1u << (page % 32);
     
     // Verificar se a página está realmente alocada
     if(physical_memory_bitmap[index] & bit) {
         physical_memory_bitmap[index] &= ~bit;
         used_pages--;
+        TRACE(TRACE_PMM_FREE, page, 1);
     }
 }
+
+// Aloca count páginas físicas contíguas (para DMA e anéis de dispositivos)
+void* pmm_alloc_contiguous(uint32_t count) {
+    if(count == 0 || used_pages + count > total_pages) {
+        return NULL;
+    }
+    
+    // Procurar uma sequência de count bits livres
+    uint32_t run = 0;
+    for(uint32_t page = 0; page < total_pages; page++) {
+        if(physical_memory_bitmap[page / 32] & (1u << (page % 32))) {
+            run = 0;
+            continue;
+        }
+        
+        if(++run == count) {
+            uint32_t first = page + 1 - count;
+            for(uint32_t i = first; i <= page; i++) {
+                physical_memory_bitmap[i / 32] |= 1u << (i % 32);
+            }
+            used_pages += count;
+            TRACE(TRACE_PMM_ALLOC, first, count);
+            return (void*)((uintptr_t)first * 4096);
+        }
+    }
+    
+    return NULL;
+}
+
+// Libera páginas alocadas com pmm_alloc_contiguous
+void pmm_free_contiguous(void *addr, uint32_t count) {
+    for(uint32_t i = 0; i < count; i++) {
+        pmm_free_page((uint8_t*)addr + i * 4096);
+    }
+}
+
+// Páginas em uso (alocadas, reservadas ou buracos do mapa de memória)
+uint32_t pmm_used_pages() {
+    return used_pages;
+}
+
+// Páginas cobertas pelo bitmap (até o fim da última região disponível)
+uint32_t pmm_total_pages() {
+    return total_pages;
+}
@@ -0,0 +1,177 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "radix.h"
+
+// Altura máxima para cobrir 32 bits de índice
+#define RADIX_MAX_HEIGHT ((32 + RADIX_SHIFT - 1) / RADIX_SHIFT)
+
+// Inicializa uma árvore vazia
+void radix_init(radix_tree_t *tree) {
+    tree->root = NULL;
+    tree->height = 0;
+}
+
+// Maior índice representável com a altura dada
+static uint32_t radix_max_index(uint32_t height) {
+    uint32_t bits = height * RADIX_SHIFT;
+    if(bits >= 32) {
+        return 0xFFFFFFFF;
+    }
+    return (1u << bits) - 1;
+}
+
+// Aloca um nó interno vazio
+static radix_node_t *radix_node_alloc() {
+    radix_node_t *node = malloc(sizeof(radix_node_t));
+    if(node) {
+        memset(node, 0, sizeof(radix_node_t));
+    }
+    return node;
+}
+
+// Procura o item de um índice
+void *radix_lookup(radix_tree_t *tree, uint32_t index) {
+    if(tree->height == 0 || index > radix_max_index(tree->height)) {
+        return NULL;
+    }
+    
+    radix_node_t *node = tree->root;
+    uint32_t shift = (tree->height - 1) * RADIX_SHIFT;
+    
+    while(node && shift > 0) {
+        node = node->slots[(index >> shift) & RADIX_MASK];
+        shift -= RADIX_SHIFT;
+    }
+    
+    return node ? node->slots[index & RADIX_MASK] : NULL;
+}
+
+// Insere (ou substitui) o item de um índice
+int radix_insert(radix_tree_t *tree, uint32_t index, void *item) {
+    // Aumentar a altura até o índice caber
+    while(tree->height == 0 || index > radix_max_index(tree->height)) {
+        radix_node_t *root = radix_node_alloc();
+        if(!root) {
+            return -1;
+        }
+        if(tree->root) {
+            root->slots[0] = tree->root;
+            root->count = 1;
+        }
+        tree->root = root;
+        tree->height++;
+    }
+    
+    radix_node_t *node = tree->root;
+    uint32_t shift = (tree->height - 1) * RADIX_SHIFT;
+    
+    while(shift > 0) {
+        uint32_t offset = (index >> shift) & RADIX_MASK;
+        if(!node->slots[offset]) {
+            node->slots[offset] = radix_node_alloc();
+            if(!node->slots[offset]) {
+                return -1;
+            }
+            node->count++;
+        }
+        node = node->slots[offset];
+        shift -= RADIX_SHIFT;
+    }
+    
+    uint32_t offset = index & RADIX_MASK;
+    if(!node->slots[offset]) {
+        node->count++;
+    }
+    node->slots[offset] = item;
+    
+    return 0;
+}
+
+// Remove o item de um índice, liberando nós que ficarem vazios
+void *radix_delete(radix_tree_t *tree, uint32_t index) {
+    radix_node_t *path[RADIX_MAX_HEIGHT];
+    uint32_t offsets[RADIX_MAX_HEIGHT];
+    
+    if(tree->height == 0 || index > radix_max_index(tree->height)) {
+        return NULL;
+    }
+    
+    // Descer guardando o caminho
+    radix_node_t *node = tree->root;
+    uint32_t shift = (tree->height - 1) * RADIX_SHIFT;
+    uint32_t level = 0;
+    
+    for(;;) {
+        path[level] = node;
+        offsets[level] = (index >> shift) & RADIX_MASK;
+        if(shift == 0) {
+            break;
+        }
+        node = node->slots[offsets[level]];
+        if(!node) {
+            return NULL;
+        }
+        shift -= RADIX_SHIFT;
+        level++;
+    }
+    
+    void *item = node->slots[offsets[level]];
+    if(!item) {
+        return NULL;
+    }
+    
+    // Subir liberando nós vazios
+    for(;;) {
+        path[level]->slots[offsets[level]] = NULL;
+        if(--path[level]->count > 0) {
+            break;
+        }
+        free(path[level]);
+        if(level == 0) {
+            tree->root = NULL;
+            tree->height = 0;
+            break;
+        }
+        level--;
+    }
+    
+    return item;
+}
+
+// Busca recursiva do primeiro item com índice >= start dentro de um nó
+static void *radix_next_in(radix_node_t *node, uint32_t height, uint32_t base,
+                           uint32_t start, uint32_t *index) {
+    uint32_t shift = (height - 1) * RADIX_SHIFT;
+    uint32_t offset = start > base ? (start - base) >> shift : 0;
+    
+    for(; offset < RADIX_SLOTS; offset++) {
+        void *slot = node->slots[offset];
+        if(!slot) {
+            continue;
+        }
+        
+        uint32_t slot_base = base + (offset << shift);
+        if(height == 1) {
+            *index = slot_base;
+            return slot;
+        }
+        
+        void *item = radix_next_in(slot, height - 1, slot_base,
+                                   start > slot_base ? start : slot_base, index);
+        if(item) {
+            return item;
+        }
+    }
+    
+    return NULL;
+}
+
+// Retorna o primeiro item com índice >= start (e seu índice)
+void *radix_next(radix_tree_t *tree, uint32_t start, uint32_t *index) {
+    if(tree->height == 0 || start > radix_max_index(tree->height)) {
+        return NULL;
+    }
+    
+    return radix_next_in(tree->root, tree->height, 0, start, index);
+}
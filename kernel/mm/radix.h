@@ -0,0 +1,27 @@
+#ifndef RADIX_H
+#define RADIX_H
+
+#include <stdint.h>
+
+// Árvore radix indexada por inteiros de 32 bits (ex.: índice de página)
+#define RADIX_SHIFT 6
+#define RADIX_SLOTS (1 << RADIX_SHIFT)
+#define RADIX_MASK  (RADIX_SLOTS - 1)
+
+typedef struct radix_node {
+    void *slots[RADIX_SLOTS];
+    uint32_t count;         // Slots ocupados
+} radix_node_t;
+
+typedef struct radix_tree {
+    radix_node_t *root;
+    uint32_t height;        // 0 = árvore vazia
+} radix_tree_t;
+
+void radix_init(radix_tree_t *tree);
+void *radix_lookup(radix_tree_t *tree, uint32_t index);
+int radix_insert(radix_tree_t *tree, uint32_t index, void *item);
+void *radix_delete(radix_tree_t *tree, uint32_t index);
+void *radix_next(radix_tree_t *tree, uint32_t start, uint32_t *index);
+
+#endif
@@ -0,0 +1,196 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "io.h"
+#include "vmm.h"
+#include "pmm.h"
+#include "mmap.h"
+#include "console.h"
+#include "percpu.h"
+
+#define PAGE_FAULT_VECTOR 14
+
+#define PDE_INDEX(virt) ((virt) >> 22)
+#define PTE_INDEX(virt) (((virt) >> 12) & 0x3FF)
+
+// Diretório do kernel; as entradas abaixo de USER_MMAP_START são
+// copiadas para todo espaço de endereçamento novo
+static uint32_t *kernel_directory;
+
+// Próximo endereço livre de vmm_alloc_pages
+static uint32_t heap_next = KERNEL_HEAP_START;
+
+// Diretório de páginas ativo (tabelas de páginas ficam no mapeamento identidade)
+static inline uint32_t *vmm_current_directory() {
+    uint32_t cr3;
+    asm volatile("mov %%cr3, %0" : "=r"(cr3));
+    return (uint32_t*)(cr3 & PAGE_MASK);
+}
+
+static inline void vmm_invlpg(uint32_t virt) {
+    asm volatile("invlpg (%0)" : : "r"(virt) : "memory");
+}
+
+// Aloca uma página física zerada para uma tabela de páginas
+static uint32_t *vmm_alloc_table() {
+    uint32_t *table = pmm_alloc_page();
+    if(table) {
+        memset(table, 0, PAGE_SIZE);
+    }
+    return table;
+}
+
+// Retorna a PTE de virt no diretório atual; create = alocar a tabela
+static uint32_t *vmm_walk(uint32_t virt, int create) {
+    uint32_t *directory = vmm_current_directory();
+    uint32_t pde = directory[PDE_INDEX(virt)];
+    
+    if(!(pde & PTE_PRESENT)) {
+        if(!create) {
+            return NULL;
+        }
+        
+        uint32_t *table = vmm_alloc_table();
+        if(!table) {
+            return NULL;
+        }
+        
+        // Permissões finais ficam na PTE
+        pde = (uint32_t)table | PTE_PRESENT | PTE_WRITE | PTE_USER;
+        directory[PDE_INDEX(virt)] = pde;
+    } else if(pde & PDE_LARGE) {
+        return NULL; // Região de 4MB do kernel
+    }
+    
+    uint32_t *table = (uint32_t*)(pde & PAGE_MASK);
+    return &table[PTE_INDEX(virt)];
+}
+
+// Mapeia uma página no espaço de endereçamento atual
+int vmm_map_page(uintptr_t virt, uintptr_t phys, uintptr_t flags) {
+    uint32_t *pte = vmm_walk(virt, 1);
+    if(!pte) {
+        return -1;
+    }
+    
+    *pte = (phys & PAGE_MASK) | (flags & ~PAGE_MASK) | PTE_PRESENT;
+    vmm_invlpg(virt);
+    return 0;
+}
+
+// Desfaz o mapeamento de uma página; retorna a PTE anterior (0 se vazia)
+uintptr_t vmm_unmap_page(uintptr_t virt) {
+    uint32_t *pte = vmm_walk(virt, 0);
+    if(!pte || !(*pte & PTE_PRESENT)) {
+        return 0;
+    }
+    
+    uint32_t old = *pte;
+    *pte = 0;
+    vmm_invlpg(virt);
+    return old;
+}
+
+// Retorna a PTE de uma página (0 se não mapeada)
+uintptr_t vmm_get_pte(uintptr_t virt) {
+    uint32_t *pte = vmm_walk(virt, 0);
+    return pte ? *pte : 0;
+}
+
+// Limpa bits de uma PTE presente (ex.: PTE_DIRTY depois do msync)
+void vmm_clear_pte_flags(uintptr_t virt, uintptr_t flags) {
+    uint32_t *pte = vmm_walk(virt, 0);
+    if(pte && (*pte & PTE_PRESENT)) {
+        *pte &= ~flags;
+        vmm_invlpg(virt);
+    }
+}
+
+// Cria um diretório de páginas que compartilha a metade do kernel
+uintptr_t vmm_create_address_space() {
+    uint32_t *directory = vmm_alloc_table();
+    if(!directory) {
+        return 0;
+    }
+    
+    for(uint32_t i = 0; i < PDE_INDEX(USER_MMAP_START); i++) {
+        directory[i] = kernel_directory[i];
+    }
+    
+    return (uintptr_t)directory;
+}
+
+// Aloca páginas contíguas no heap virtual do kernel
+void *vmm_alloc_pages(uint32_t count) {
+    if(count == 0 || count > (KERNEL_HEAP_END - heap_next) / PAGE_SIZE) {
+        return NULL;
+    }
+    
+    uint32_t base = heap_next;
+    for(uint32_t i = 0; i < count; i++) {
+        void *page = pmm_alloc_page();
+        if(!page) {
+            // Desfazer o que já foi mapeado
+            while(i-- > 0) {
+                pmm_free_page((void*)PTE_ADDR(vmm_unmap_page(base + i * PAGE_SIZE)));
+            }
+            return NULL;
+        }
+        vmm_map_page(base + i * PAGE_SIZE, (uintptr_t)page, PTE_WRITE);
+    }
+    
+    heap_next += count * PAGE_SIZE;
+    return (void*)base;
+}
+
+// Handler de page fault: regiões mapeadas são populadas sob demanda
+static void vmm_page_fault(registers_t *regs) {
+    this_cpu()->page_faults++;
+    
+    uint32_t addr;
+    asm volatile("mov %%cr2, %0" : "=r"(addr));
+    
+    if(mmap_fault(addr, regs->err_code) == 0) {
+        return;
+    }
+    
+    console_write("Page fault em 0x");
+    console_write_hex(addr);
+    console_write(" (erro 0x");
+    console_write_hex(regs->err_code);
+    console_write(")\n");
+    
+    asm volatile("cli");
+    for(;;) {
+        asm volatile("hlt");
+    }
+}
+
+// Inicializa a paginação: identidade em 4MB no primeiro 1GB e
+// tabelas pré-alocadas para o heap do kernel
+void vmm_init() {
+    kernel_directory = vmm_alloc_table();
+    
+    for(uint32_t i = 0; i < PDE_INDEX(KERNEL_IDENTITY_END); i++) {
+        kernel_directory[i] = (i << 22) | PDE_LARGE | PTE_PRESENT | PTE_WRITE;
+    }
+    
+    // Tabelas do heap compartilhadas por todos os espaços de endereçamento
+    for(uint32_t i = PDE_INDEX(KERNEL_HEAP_START); i < PDE_INDEX(KERNEL_HEAP_END); i++) {
+        uint32_t *table = vmm_alloc_table();
+        if(!table) {
+            break;
+        }
+        kernel_directory[i] = (uint32_t)table | PTE_PRESENT | PTE_WRITE;
+    }
+    
+    register_interrupt_handler(PAGE_FAULT_VECTOR, vmm_page_fault);
+    
+    // Habilitar PSE, carregar o diretório e ligar a paginação
+    uint32_t cr4, cr0;
+    asm volatile("mov %%cr4, %0" : "=r"(cr4));
+    asm volatile("mov %0, %%cr4" : : "r"(cr4 | 0x10));
+    asm volatile("mov %0, %%cr3" : : "r"(kernel_directory));
+    asm volatile("mov %%cr0, %0" : "=r"(cr0));
+    asm volatile("mov %0, %%cr0" : : "r"(cr0 | 0x80000000));
+}
@@ -0,0 +1,64 @@
+#ifndef VMM_H
+#define VMM_H
+
+#include <stdint.h>
+
+#define PAGE_SIZE  4096
+#define PAGE_SHIFT 12
+#define PAGE_MASK  (~(PAGE_SIZE - 1))
+
+// Bits de entradas de tabela de páginas (iguais no i386 sem PAE e no x86_64)
+#define PTE_PRESENT  0x001
+#define PTE_WRITE    0x002
+#define PTE_USER     0x004
+#define PTE_ACCESSED 0x020
+#define PTE_DIRTY    0x040
+#define PDE_LARGE    0x080      // Página de 4MB (PSE)
+#define PTE_ANON     0x200      // Bit livre: página anônima (cópia privada)
+
+// Código de erro do page fault
+#define PF_PRESENT 0x1
+#define PF_WRITE   0x2
+#define PF_USER    0x4
+
+// Layout do espaço de endereçamento
+#ifdef __x86_64__
+// x86_64 (paginação de 4 níveis): a metade baixa tem a identidade de toda
+// a memória física (só kernel) e as regiões de processos; a metade alta
+// tem o mapa direto, o heap do kernel e a imagem do kernel nos últimos 2GB
+#define KERNEL_IDENTITY_END 0x0000400000000000ULL  // 0-64TB: identidade do kernel
+#define USER_MMAP_START     0x0000400000000000ULL  // 64TB-128TB: regiões de processos
+#define USER_MMAP_END       0x00007FFFFFFFF000ULL
+#define DIRECT_MAP_BASE     0xFFFF800000000000ULL  // Toda a memória física
+#define KERNEL_HEAP_START   0xFFFFC00000000000ULL  // vmm_alloc_pages (compartilhado)
+#define KERNEL_HEAP_END     0xFFFFC08000000000ULL
+#define KERNEL_VIRT_BASE    0xFFFFFFFF80000000ULL  // Imagem do kernel (-2GB)
+
+#define PTE_NX       0x8000000000000000ULL
+#define PTE_ADDR_MASK 0x000FFFFFFFFFF000ULL
+#else
+#define KERNEL_IDENTITY_END 0x40000000  // 0-1GB: mapeamento identidade do kernel
+#define KERNEL_HEAP_START   0x40000000  // 1-2GB: vmm_alloc_pages (compartilhado)
+#define KERNEL_HEAP_END     0x80000000
+#define USER_MMAP_START     0x80000000  // 2GB-4GB: regiões de processos
+#define USER_MMAP_END       0xFFC00000
+#define DIRECT_MAP_BASE     0           // A identidade faz o papel do mapa direto
+#define PTE_ADDR_MASK       0xFFFFF000
+#endif
+
+// Endereço físico de uma PTE (sem flags nem o NX do x86_64)
+#define PTE_ADDR(pte) ((uintptr_t)(pte) & PTE_ADDR_MASK)
+
+// Endereço virtual de um endereço físico
+#define PHYS_TO_VIRT(phys) ((void*)((uintptr_t)(phys) + DIRECT_MAP_BASE))
+
+// Endereços e PTEs têm a largura da arquitetura (uintptr_t)
+void vmm_init(void);
+uintptr_t vmm_create_address_space(void);
+void *vmm_alloc_pages(uint32_t count);
+int vmm_map_page(uintptr_t virt, uintptr_t phys, uintptr_t flags);
+uintptr_t vmm_unmap_page(uintptr_t virt);
+uintptr_t vmm_get_pte(uintptr_t virt);
+void vmm_clear_pte_flags(uintptr_t virt, uintptr_t flags);
+
+#endif
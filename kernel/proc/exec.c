@@ -0,0 +1,398 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "exec.h"
+#include "elf.h"
+#include "vfs.h"
+#include "mmap.h"
+#include "vmm.h"
+#include "scheduler.h"
+#include "console.h"
+
+#ifndef KERNEL_HOSTED
+// core/cpu.asm e arch/x86_64/cpu.asm
+extern void user_enter(uintptr_t entry, uintptr_t stack) __attribute__((noreturn));
+#endif
+
+static exec_stats_t stats;
+
+// Programa a carregar por process_exec: um bloco só, com os vetores e as
+// strings logo depois da estrutura
+typedef struct exec_request {
+    char *path;
+    char **argv;
+    char **envp;
+} exec_request_t;
+
+static uint32_t exec_count(char *const vector[]) {
+    uint32_t count = 0;
+    while(vector && vector[count]) {
+        count++;
+    }
+    return count;
+}
+
+// Lê exatamente size bytes de offset
+static int exec_read(int fd, void *buffer, size_t size, uint64_t offset) {
+    if(offset > UINT32_MAX) {
+        return -1;
+    }
+    return vfs_pread(fd, buffer, size, (uint32_t)offset) == (int)size ? 0 : -1;
+}
+
+static uint32_t exec_prot(uint32_t flags) {
+    uint32_t prot = 0;
+    if(flags & PF_R) {
+        prot |= PROT_READ;
+    }
+    if(flags & PF_W) {
+        prot |= PROT_WRITE;
+    }
+    if(flags & PF_X) {
+        prot |= PROT_EXEC;
+    }
+    return prot;
+}
+
+static inline uint64_t exec_page_up(uint64_t addr) {
+    return (addr + PAGE_SIZE - 1) & ~(uint64_t)(PAGE_SIZE - 1);
+}
+
+// Confere o cabeçalho e os segmentos contra o arquivo e o espaço de
+// usuário; calcula o deslocamento de um ET_DYN. Nada é mapeado aqui
+static int exec_check(const Elf_Ehdr *ehdr, const Elf_Phdr *phdrs, uint64_t file_size, uintptr_t *bias) {
+    uint64_t low = UINT64_MAX;
+    uint64_t high = 0;
+    int loads = 0;
+    
+    for(uint32_t i = 0; i < ehdr->e_phnum; i++) {
+        const Elf_Phdr *ph = &phdrs[i];
+        if(ph->p_type == PT_INTERP) {
+            return -1; // Sem ligador dinâmico (um ET_DYN estático se reloca sozinho)
+        }
+        if(ph->p_type != PT_LOAD || ph->p_memsz == 0) {
+            continue;
+        }
+        
+        if(ph->p_filesz > ph->p_memsz || ph->p_offset > file_size || ph->p_filesz > file_size - ph->p_offset) {
+            return -1;
+        }
+        if((((uint64_t)ph->p_vaddr - ph->p_offset) & (PAGE_SIZE - 1)) || (uint64_t)ph->p_vaddr + ph->p_memsz < ph->p_vaddr) {
+            return -1;
+        }
+        
+        // Em ordem crescente e sem páginas em comum: cada um é uma região
+        uint64_t start = ph->p_vaddr & ~(uint64_t)(PAGE_SIZE - 1);
+        if(start < high) {
+            return -1;
+        }
+        if(start < low) {
+            low = start;
+        }
+        high = exec_page_up(ph->p_vaddr + ph->p_memsz);
+        loads++;
+    }
+    if(!loads) {
+        return -1;
+    }
+    
+    *bias = ehdr->e_type == ET_DYN ? (uintptr_t)(USER_MMAP_START - low) : 0;
+    low += *bias;
+    high += *bias;
+    if(low < USER_MMAP_START || high > USER_STACK_BASE || high < low) {
+        return -1;
+    }
+    
+    uint64_t entry = ehdr->e_entry + *bias;
+    return (entry >= low && entry < high) ? 0 : -1;
+}
+
+// Mapeia um PT_LOAD: a parte do arquivo é privada e sob demanda; o bss
+// começa no meio da última página do arquivo (zerada numa cópia privada)
+// e continua em páginas anônimas
+static int exec_map_segment(mm_t *mm, int fd, const Elf_Phdr *ph, uintptr_t bias) {
+    uintptr_t vaddr = ph->p_vaddr + bias;
+    uintptr_t start = vaddr & PAGE_MASK;
+    uintptr_t file_end = vaddr + ph->p_filesz;
+    uintptr_t mem_end = exec_page_up(vaddr + ph->p_memsz);
+    uint32_t prot = exec_prot(ph->p_flags);
+    
+    if(ph->p_filesz) {
+        void *addr = vfs_mmap((void*)start, file_end - start, prot, MAP_PRIVATE | MAP_FIXED,
+                              fd, ph->p_offset & PAGE_MASK);
+        if(addr == MAP_FAILED) {
+            return -1;
+        }
+        
+        if(ph->p_memsz > ph->p_filesz && (file_end & ~PAGE_MASK)) {
+            if(mmap_zero_tail(mm, file_end) != 0) {
+                return -1;
+            }
+            stats.tail_pages++;
+        }
+    }
+    
+    uintptr_t bss = ph->p_filesz ? exec_page_up(file_end) : start;
+    if(mem_end > bss) {
+        void *addr = vfs_mmap((void*)bss, mem_end - bss, prot, MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0);
+        if(addr == MAP_FAILED) {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Copia para o espaço do processo atual, populando as páginas da pilha
+static int exec_copy_out(uintptr_t virt, const void *src, size_t len) {
+    const uint8_t *data = src;
+    while(len > 0) {
+        uintptr_t pte = vmm_get_pte(virt);
+        if(!(pte & PTE_PRESENT)) {
+            if(mmap_fault(virt, PF_WRITE | PF_USER) != 0) {
+                return -1;
+            }
+            pte = vmm_get_pte(virt);
+            stats.stack_pages++;
+        }
+        
+        uint32_t offset = virt & ~PAGE_MASK;
+        uint32_t chunk = PAGE_SIZE - offset;
+        if(chunk > len) {
+            chunk = len;
+        }
+        memcpy((uint8_t*)PTE_ADDR(pte) + offset, data, chunk);
+        
+        virt += chunk;
+        data += chunk;
+        len -= chunk;
+    }
+    return 0;
+}
+
+// Pilha inicial: strings no topo e, abaixo delas, alinhados a 16 bytes,
+// argc, argv[], NULL, envp[], NULL e os pares do vetor auxiliar
+static int exec_build_stack(char *const argv[], uint32_t argc, char *const envp[], uint32_t envc,
+                            const uintptr_t *auxv, uint32_t auxc, uintptr_t *stack) {
+    uint32_t words = 1 + (argc + 1) + (envc + 1) + auxc;
+    uintptr_t *vector = malloc(words * sizeof(uintptr_t));
+    if(!vector) {
+        return -1;
+    }
+    
+    uintptr_t sp = USER_STACK_TOP;
+    uint32_t w = 0;
+    vector[w++] = argc;
+    for(uint32_t i = 0; i < argc + envc; i++) {
+        const char *s = i < argc ? argv[i] : envp[i - argc];
+        size_t len = strlen(s) + 1;
+        sp -= len;
+        if(exec_copy_out(sp, s, len) != 0) {
+            free(vector);
+            return -1;
+        }
+        
+        // NULL entre argv e envp
+        if(i == argc) {
+            vector[w++] = 0;
+        }
+        vector[w++] = sp;
+    }
+    if(envc == 0) {
+        vector[w++] = 0;
+    }
+    vector[w++] = 0;
+    memcpy(&vector[w], auxv, auxc * sizeof(uintptr_t));
+    
+    sp = (sp - words * sizeof(uintptr_t)) & ~(uintptr_t)15;
+    int result = exec_copy_out(sp, vector, words * sizeof(uintptr_t));
+    free(vector);
+    *stack = sp;
+    return result;
+}
+
+int exec_load(const char *path, char *const argv[], char *const envp[], exec_image_t *image) {
+    uint32_t argc = exec_count(argv);
+    uint32_t envc = exec_count(envp);
+    Elf_Phdr *phdrs = NULL;
+    Elf_Ehdr ehdr;
+    struct stat st;
+    
+    // Argumentos primeiro: depois de desfazer a imagem não há volta
+    size_t arg_size = (argc + envc + 16) * sizeof(uintptr_t) + 16;
+    if(argc + envc > EXEC_MAX_ARGS) {
+        stats.failures++;
+        return -1;
+    }
+    for(uint32_t i = 0; i < argc + envc; i++) {
+        arg_size += strlen(i < argc ? argv[i] : envp[i - argc]) + 1;
+    }
+    if(arg_size > EXEC_ARG_MAX) {
+        stats.failures++;
+        return -1;
+    }
+    
+    mm_t *mm = scheduler_current_mm();
+    int fd = vfs_open(path, O_RDONLY);
+    if(!mm || fd < 0 || vfs_stat(path, &st) != 0 || !S_ISREG(st.st_mode)) {
+        goto fail;
+    }
+    
+    if(exec_read(fd, &ehdr, sizeof(ehdr), 0) != 0) {
+        goto fail;
+    }
+    if(ehdr.e_ident[0] != ELFMAG0 || ehdr.e_ident[1] != ELFMAG1 ||
+       ehdr.e_ident[2] != ELFMAG2 || ehdr.e_ident[3] != ELFMAG3 ||
+       ehdr.e_ident[EI_CLASS] != ELF_CLASS || ehdr.e_ident[EI_DATA] != ELFDATA2LSB ||
+       ehdr.e_ident[EI_VERSION] != EV_CURRENT || ehdr.e_machine != ELF_MACHINE ||
+       (ehdr.e_type != ET_EXEC && ehdr.e_type != ET_DYN) ||
+       ehdr.e_phentsize != sizeof(Elf_Phdr) || ehdr.e_phnum == 0 || ehdr.e_phnum > EXEC_MAX_PHDRS) {
+        goto fail;
+    }
+    
+    size_t phdrs_size = ehdr.e_phnum * sizeof(Elf_Phdr);
+    phdrs = malloc(phdrs_size);
+    uintptr_t bias;
+    if(!phdrs || exec_read(fd, phdrs, phdrs_size, ehdr.e_phoff) != 0 ||
+       exec_check(&ehdr, phdrs, st.st_size, &bias) != 0) {
+        goto fail;
+    }
+    
+    // Ponto sem volta: regiões antigas desfeitas
+    mmap_unmap(mm, USER_MMAP_START, USER_MMAP_END - USER_MMAP_START);
+    
+    uintptr_t end = 0;
+    uintptr_t phdr_addr = 0;
+    for(uint32_t i = 0; i < ehdr.e_phnum; i++) {
+        const Elf_Phdr *ph = &phdrs[i];
+        if(ph->p_type == PT_PHDR) {
+            phdr_addr = ph->p_vaddr + bias;
+        }
+        if(ph->p_type != PT_LOAD || ph->p_memsz == 0) {
+            continue;
+        }
+        
+        if(exec_map_segment(mm, fd, ph, bias) != 0) {
+            goto fail;
+        }
+        if(!phdr_addr && ehdr.e_phoff >= ph->p_offset && ehdr.e_phoff - ph->p_offset < ph->p_filesz) {
+            phdr_addr = ph->p_vaddr + (ehdr.e_phoff - ph->p_offset) + bias;
+        }
+        end = exec_page_up(ph->p_vaddr + ph->p_memsz) + bias;
+    }
+    
+    if(vfs_mmap((void*)USER_STACK_BASE, USER_STACK_SIZE, PROT_READ | PROT_WRITE,
+                MAP_PRIVATE | MAP_ANONYMOUS | MAP_FIXED, -1, 0) == MAP_FAILED) {
+        goto fail;
+    }
+    
+    uintptr_t auxv[] = {
+        AT_PHDR, phdr_addr,
+        AT_PHENT, sizeof(Elf_Phdr),
+        AT_PHNUM, ehdr.e_phnum,
+        AT_PAGESZ, PAGE_SIZE,
+        AT_ENTRY, ehdr.e_entry + bias,
+        AT_NULL, 0
+    };
+    uintptr_t sp;
+    if(exec_build_stack(argv, argc, envp, envc, auxv, sizeof(auxv) / sizeof(auxv[0]), &sp) != 0) {
+        goto fail;
+    }
+    
+    // As regiões guardam referências ao arquivo; o descritor não é mais
+    // necessário
+    free(phdrs);
+    vfs_close(fd);
+    
+    image->entry = ehdr.e_entry + bias;
+    image->stack = sp;
+    image->base = bias;
+    image->end = end;
+    stats.loads++;
+    return 0;
+
+fail:
+    free(phdrs);
+    if(fd >= 0) {
+        vfs_close(fd);
+    }
+    stats.failures++;
+    return -1;
+}
+
+// Primeiro código do processo criado por process_exec, já no espaço de
+// endereçamento dele
+static void exec_start() {
+    exec_request_t *request = scheduler_current_arg();
+    exec_image_t image;
+    
+    int result = exec_load(request->path, request->argv, request->envp, &image);
+    if(result != 0) {
+        console_write("exec: falha ao carregar ");
+        console_write(request->path);
+        console_write("\n");
+    }
+    free(request);
+
+#ifndef KERNEL_HOSTED
+    if(result == 0) {
+        user_enter(image.entry, image.stack);
+    }
+    
+    // Processos não terminam: o slot fica bloqueado
+    for(;;) {
+        scheduler_block();
+        asm volatile("hlt");
+    }
+#endif
+}
+
+// Copia um vetor de strings para o bloco em *cursor
+static char **exec_pack(char *const vector[], uint32_t count, char ***slots, char **cursor) {
+    char **packed = *slots;
+    for(uint32_t i = 0; i < count; i++) {
+        size_t len = strlen(vector[i]) + 1;
+        memcpy(*cursor, vector[i], len);
+        packed[i] = *cursor;
+        *cursor += len;
+    }
+    packed[count] = NULL;
+    *slots += count + 1;
+    return packed;
+}
+
+uint32_t process_exec(const char *path, char *const argv[], char *const envp[], uint8_t priority) {
+    uint32_t argc = exec_count(argv);
+    uint32_t envc = exec_count(envp);
+    if(argc + envc > EXEC_MAX_ARGS) {
+        return 0;
+    }
+    
+    size_t size = sizeof(exec_request_t) + (argc + envc + 2) * sizeof(char*) + strlen(path) + 1;
+    for(uint32_t i = 0; i < argc + envc; i++) {
+        size += strlen(i < argc ? argv[i] : envp[i - argc]) + 1;
+    }
+    if(size > EXEC_ARG_MAX + sizeof(exec_request_t)) {
+        return 0;
+    }
+    
+    exec_request_t *request = malloc(size);
+    if(!request) {
+        return 0;
+    }
+    char **slots = (char**)(request + 1);
+    char *cursor = (char*)(slots + argc + envc + 2);
+    request->argv = exec_pack(argv, argc, &slots, &cursor);
+    request->envp = exec_pack(envp, envc, &slots, &cursor);
+    request->path = cursor;
+    strcpy(cursor, path);
+    
+    uint32_t pid = process_create_arg(exec_start, priority, request);
+    if(!pid) {
+        free(request);
+    }
+    return pid;
+}
+
+const exec_stats_t *exec_get_stats() {
+    return &stats;
+}
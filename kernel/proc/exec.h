@@ -0,0 +1,52 @@
+#ifndef EXEC_H
+#define EXEC_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "vmm.h"
+
+// Carregador de executáveis ELF estáticos (ET_EXEC ou ET_DYN sem
+// interpretador). Cada PT_LOAD vira uma região privada do arquivo: nada é
+// lido na carga, as páginas entram por page fault e o texto é a própria
+// página do cache (ou do ramfs), a mesma em todas as instâncias do
+// programa. Escritas ganham cópia privada; o bss é anônimo.
+//
+// ET_EXEC precisa estar ligado dentro de [USER_MMAP_START, USER_STACK_BASE);
+// ET_DYN é colocado em USER_MMAP_START
+
+#define EXEC_MAX_PHDRS  32
+#define EXEC_MAX_ARGS   256                     // argv + envp
+#define EXEC_ARG_MAX    (16 * PAGE_SIZE)        // Strings e vetores na pilha
+
+// Pilha inicial no topo das regiões de processos, populada sob demanda
+#define USER_STACK_SIZE (256 * PAGE_SIZE)
+#define USER_STACK_TOP  USER_MMAP_END
+#define USER_STACK_BASE (USER_STACK_TOP - USER_STACK_SIZE)
+
+typedef struct exec_image {
+    uintptr_t entry;
+    uintptr_t stack;            // Aponta para argc
+    uintptr_t base;             // Deslocamento aplicado (ET_DYN) ou 0
+    uintptr_t end;              // Fim do último segmento (início do heap)
+} exec_image_t;
+
+typedef struct exec_stats {
+    uint32_t loads;
+    uint32_t failures;
+    uint32_t tail_pages;        // Páginas copiadas na carga (fim do .data com bss)
+    uint32_t stack_pages;       // Páginas da pilha tocadas na carga (argv/envp)
+} exec_stats_t;
+
+// Substitui as regiões do processo atual pelo programa em path, com a
+// pilha no formato da ABI System V (argc, argv, envp, auxv). Os
+// cabeçalhos são validados antes de qualquer região ser desfeita; uma
+// falha depois disso deixa o processo sem imagem
+int exec_load(const char *path, char *const argv[], char *const envp[], exec_image_t *image);
+
+// Cria um processo que carrega path e desce para o anel 3; argv e envp
+// são copiados. Retorna o PID (0 em erro)
+uint32_t process_exec(const char *path, char *const argv[], char *const envp[], uint8_t priority);
+
+const exec_stats_t *exec_get_stats(void);
+
+#endif
@@ -0,0 +1,308 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include "ipc.h"
+#include "vfs.h"
+#include "mmap.h"
+#include "vmm.h"
+#include "pmm.h"
+#include "scheduler.h"
+#include "spinlock.h"
+
+// Mensagem na fila: a região fora de linha viaja como lista de páginas
+// físicas, que pertencem ao canal até alguém recebê-las
+typedef struct ipc_kmsg {
+    uint32_t tag;
+    uint32_t len;
+    uint8_t data[IPC_INLINE_MAX];
+    uintptr_t *pages;
+    uint32_t page_count;
+    size_t ool_len;
+} ipc_kmsg_t;
+
+// Anel de mensagens. Um remetente reserva a posição antes de retirar as
+// páginas do seu espaço (o que não pode ser desfeito) e só então publica
+typedef struct ipc_channel {
+    ipc_kmsg_t queue[IPC_QUEUE_LEN];
+    uint32_t head;
+    uint32_t tail;
+    uint32_t reserved;              // Posições reservadas ainda não publicadas
+    uint32_t refcount;              // Tabela + chamadas em andamento
+    int closed;
+    spinlock_t lock;
+    wait_queue_t send_wait;         // Esperando posição livre
+    wait_queue_t receive_wait;      // Esperando mensagem
+} ipc_channel_t;
+
+static ipc_channel_t *channels[IPC_MAX_CHANNELS];
+static spinlock_t channels_lock;
+static ipc_stats_t stats;
+
+static void ipc_free_pages(uintptr_t *pages, uint32_t count) {
+    for(uint32_t i = 0; i < count; i++) {
+        pmm_free_page((void*)pages[i]);
+    }
+    free(pages);
+}
+
+// Referência a um canal aberto (NULL se não existir)
+static ipc_channel_t *ipc_get(int id) {
+    if(id < 0 || id >= IPC_MAX_CHANNELS) {
+        return NULL;
+    }
+    
+    spin_lock(&channels_lock);
+    ipc_channel_t *channel = channels[id];
+    if(channel) {
+        channel->refcount++;
+    }
+    spin_unlock(&channels_lock);
+    return channel;
+}
+
+// A última referência de um canal fechado descarta o que ficou na fila
+static void ipc_put(ipc_channel_t *channel) {
+    spin_lock(&channels_lock);
+    uint32_t refs = --channel->refcount;
+    spin_unlock(&channels_lock);
+    if(refs > 0) {
+        return;
+    }
+    
+    for(uint32_t i = channel->head; i != channel->tail; i++) {
+        ipc_kmsg_t *kmsg = &channel->queue[i & (IPC_QUEUE_LEN - 1)];
+        ipc_free_pages(kmsg->pages, kmsg->page_count);
+    }
+    free(channel);
+}
+
+void ipc_init() {
+    spin_lock_init(&channels_lock, "ipc");
+}
+
+int ipc_channel_create() {
+    ipc_channel_t *channel = malloc(sizeof(ipc_channel_t));
+    if(!channel) {
+        return -1;
+    }
+    memset(channel, 0, sizeof(ipc_channel_t));
+    channel->refcount = 1;
+    spin_lock_init(&channel->lock, NULL);
+    
+    spin_lock(&channels_lock);
+    for(int id = 0; id < IPC_MAX_CHANNELS; id++) {
+        if(!channels[id]) {
+            channels[id] = channel;
+            stats.channels++;
+            spin_unlock(&channels_lock);
+            return id;
+        }
+    }
+    spin_unlock(&channels_lock);
+    
+    free(channel);
+    return -1;
+}
+
+// Fecha o canal: quem espera nele volta com -1 e as mensagens pendentes
+// são descartadas quando a última chamada em andamento sair
+int ipc_channel_destroy(int id) {
+    if(id < 0 || id >= IPC_MAX_CHANNELS) {
+        return -1;
+    }
+    
+    spin_lock(&channels_lock);
+    ipc_channel_t *channel = channels[id];
+    if(channel) {
+        channels[id] = NULL;
+        stats.channels--;
+    }
+    spin_unlock(&channels_lock);
+    if(!channel) {
+        return -1;
+    }
+    
+    spin_lock(&channel->lock);
+    channel->closed = 1;
+    spin_unlock(&channel->lock);
+    wake_up(&channel->send_wait);
+    wake_up(&channel->receive_wait);
+    ipc_put(channel);
+    return 0;
+}
+
+// Condições de wait_event
+static int ipc_can_send(void *arg) {
+    ipc_channel_t *channel = arg;
+    return channel->tail - channel->head + channel->reserved < IPC_QUEUE_LEN || channel->closed;
+}
+
+static int ipc_can_receive(void *arg) {
+    ipc_channel_t *channel = arg;
+    return channel->tail != channel->head || channel->closed;
+}
+
+// Reserva uma posição na fila, esperando se estiver cheia
+static int ipc_reserve(ipc_channel_t *channel, int flags) {
+    for(;;) {
+        spin_lock(&channel->lock);
+        if(channel->closed) {
+            spin_unlock(&channel->lock);
+            return -1;
+        }
+        if(channel->tail - channel->head + channel->reserved < IPC_QUEUE_LEN) {
+            channel->reserved++;
+            spin_unlock(&channel->lock);
+            return 0;
+        }
+        spin_unlock(&channel->lock);
+        
+        if(flags & IPC_NONBLOCK) {
+            return VFS_EAGAIN;
+        }
+        stats.send_waits++;
+        if(wait_event(&channel->send_wait, ipc_can_send, channel) != 0) {
+            return VFS_EAGAIN;
+        }
+    }
+}
+
+static void ipc_unreserve(ipc_channel_t *channel) {
+    spin_lock(&channel->lock);
+    channel->reserved--;
+    spin_unlock(&channel->lock);
+    wake_up(&channel->send_wait);
+}
+
+// Envia uma mensagem; a região fora de linha deixa de existir no
+// remetente (páginas anônimas presentes mudam de dono, as demais são
+// copiadas ou zeradas)
+int ipc_send(int id, const ipc_msg_t *msg, int flags) {
+    if(msg->len > IPC_INLINE_MAX) {
+        return -1;
+    }
+    
+    uint32_t page_count = 0;
+    if(msg->ool_len) {
+        if((uintptr_t)msg->ool & ~PAGE_MASK) {
+            return -1;
+        }
+        if(msg->ool_len > (size_t)IPC_MAX_PAGES * PAGE_SIZE) {
+            return -1;
+        }
+        page_count = (msg->ool_len + PAGE_SIZE - 1) >> PAGE_SHIFT;
+    }
+    
+    ipc_channel_t *channel = ipc_get(id);
+    if(!channel) {
+        return -1;
+    }
+    
+    int result = ipc_reserve(channel, flags);
+    if(result != 0) {
+        ipc_put(channel);
+        return result;
+    }
+    
+    uintptr_t *pages = NULL;
+    if(page_count) {
+        pages = malloc(page_count * sizeof(uintptr_t));
+        mm_t *mm = scheduler_current_mm();
+        if(!pages || !mm ||
+           mmap_detach_pages(mm, (uintptr_t)msg->ool, msg->ool_len, pages) != (int)page_count) {
+            free(pages);
+            ipc_unreserve(channel);
+            ipc_put(channel);
+            return -1;
+        }
+    }
+    
+    spin_lock(&channel->lock);
+    if(channel->closed) {
+        channel->reserved--;
+        spin_unlock(&channel->lock);
+        ipc_free_pages(pages, page_count);
+        ipc_put(channel);
+        return -1;
+    }
+    
+    ipc_kmsg_t *kmsg = &channel->queue[channel->tail & (IPC_QUEUE_LEN - 1)];
+    kmsg->tag = msg->tag;
+    kmsg->len = msg->len;
+    memcpy(kmsg->data, msg->data, msg->len);
+    kmsg->pages = pages;
+    kmsg->page_count = page_count;
+    kmsg->ool_len = msg->ool_len;
+    channel->tail++;
+    channel->reserved--;
+    
+    stats.sent++;
+    stats.inline_bytes += msg->len;
+    stats.ool_pages += page_count;
+    spin_unlock(&channel->lock);
+    
+    wake_up(&channel->receive_wait);
+    ipc_put(channel);
+    return 0;
+}
+
+// Recebe a próxima mensagem; a região fora de linha é mapeada numa região
+// anônima nova do processo atual (leitura e escrita). Se não houver
+// espaço de endereçamento para ela, a mensagem é descartada
+int ipc_receive(int id, ipc_msg_t *msg, int flags) {
+    ipc_channel_t *channel = ipc_get(id);
+    if(!channel) {
+        return -1;
+    }
+    
+    ipc_kmsg_t kmsg;
+    for(;;) {
+        spin_lock(&channel->lock);
+        if(channel->tail != channel->head) {
+            kmsg = channel->queue[channel->head & (IPC_QUEUE_LEN - 1)];
+            channel->head++;
+            stats.received++;
+            spin_unlock(&channel->lock);
+            wake_up(&channel->send_wait);
+            break;
+        }
+        int closed = channel->closed;
+        spin_unlock(&channel->lock);
+        
+        int result = closed ? -1 : VFS_EAGAIN;
+        if(!closed && !(flags & IPC_NONBLOCK)) {
+            stats.receive_waits++;
+            if(wait_event(&channel->receive_wait, ipc_can_receive, channel) == 0) {
+                continue;
+            }
+        }
+        ipc_put(channel);
+        return result;
+    }
+    ipc_put(channel);
+    
+    msg->tag = kmsg.tag;
+    msg->len = kmsg.len;
+    memcpy(msg->data, kmsg.data, kmsg.len);
+    msg->ool = NULL;
+    msg->ool_len = 0;
+    
+    if(kmsg.page_count) {
+        mm_t *mm = scheduler_current_mm();
+        void *addr = mm ? mmap_attach_pages(mm, kmsg.pages, kmsg.page_count, PROT_READ | PROT_WRITE)
+                        : MAP_FAILED;
+        if(addr == MAP_FAILED) {
+            ipc_free_pages(kmsg.pages, kmsg.page_count);
+            return -1;
+        }
+        free(kmsg.pages);
+        msg->ool = addr;
+        msg->ool_len = kmsg.ool_len;
+    }
+    
+    return (int)msg->len;
+}
+
+const ipc_stats_t *ipc_get_stats() {
+    return &stats;
+}
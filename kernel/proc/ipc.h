@@ -0,0 +1,50 @@
+#ifndef IPC_H
+#define IPC_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Troca de mensagens entre processos por canais. Cada mensagem tem uma
+// parte em linha (copiada) e, opcionalmente, uma região fora de linha:
+// as páginas dela saem do espaço de endereçamento do remetente e são
+// mapeadas no do destinatário, sem cópia dos dados
+#define IPC_MAX_CHANNELS 64
+#define IPC_QUEUE_LEN    16         // Mensagens pendentes por canal (potência de 2)
+#define IPC_INLINE_MAX   256
+#define IPC_MAX_PAGES    1024       // 4MB fora de linha por mensagem
+
+// Flags de ipc_send/ipc_receive
+#define IPC_NONBLOCK 0x1            // VFS_EAGAIN em vez de esperar
+
+typedef struct ipc_msg {
+    uint32_t tag;                   // Livre para a aplicação
+    uint32_t len;                   // Bytes usados de data
+    uint8_t data[IPC_INLINE_MAX];
+    // Região fora de linha (alinhada a página). No envio o remetente a
+    // perde, como num munmap; no recebimento é uma região anônima nova
+    void *ool;
+    size_t ool_len;
+} ipc_msg_t;
+
+typedef struct ipc_stats {
+    uint32_t channels;
+    uint32_t sent;
+    uint32_t received;
+    uint64_t inline_bytes;
+    uint64_t ool_pages;             // Páginas enviadas fora de linha
+    uint32_t send_waits;
+    uint32_t receive_waits;
+} ipc_stats_t;
+
+void ipc_init(void);
+int ipc_channel_create(void);
+int ipc_channel_destroy(int channel);
+
+// Retornam 0 / o tamanho da parte em linha; -1 em erro (canal fechado,
+// região inválida) e VFS_EAGAIN com IPC_NONBLOCK
+int ipc_send(int channel, const ipc_msg_t *msg, int flags);
+int ipc_receive(int channel, ipc_msg_t *msg, int flags);
+
+const ipc_stats_t *ipc_get_stats(void);
+
+#endif
@@ -1,18 +1,38 @@
 #include <stdint.h>
 #include "scheduler.h"
+#include "fdtable.h"
+#include "mmap.h"
+#include "vmm.h"
+#include "spinlock.h"
+#include "rcu.h"
+#include "irqstat.h"
+#ifndef KERNEL_HOSTED
+#include "gdt.h"
+#endif
 
-#define MAX_PROCESSES 256
+#if defined(__x86_64__) && !defined(KERNEL_HOSTED)
+// arch/x86_64/cpu.asm: salva rbx, rbp e r12-r15 na pilha atual, guarda
+// rsp em *old_rsp e retoma a pilha new_rsp
+extern void switch_context(uintptr_t *old_rsp, uintptr_t new_rsp);
+#endif
 
 // Estrutura para PCB (Process Control Block)
 typedef struct {
     uint32_t pid;
-    uint32_t esp;     // Stack pointer
-    uint32_t ebp;     // Base pointer
-    uint32_t eip;     // Instruction pointer
-    uint32_t cr3;     // Page directory
+    uintptr_t esp;    // Stack pointer
+    uintptr_t ebp;    // Base pointer
+    uintptr_t eip;    // Instruction pointer
+    uintptr_t cr3;    // Page directory (PML4 no x86_64)
     uint8_t state;    // RUNNING, READY, BLOCKED, etc.
     uint8_t priority;
     uint32_t quantum; // Tempo de execução restante
+    fd_table_t *files; // Descritores abertos (criada no primeiro uso)
+    mm_t *mm;          // Regiões mapeadas (criada no primeiro uso)
+    uint32_t ticks;    // Ticks do timer em execução
+    uint32_t switches; // Vezes que perdeu a CPU
+    uintptr_t kstack;  // Topo da pilha do kernel (TSS, ao entrar do anel 3)
+    void *arg;         // Argumento do ponto de entrada (process_create_arg)
+    uint32_t wake_tick; // Prazo de scheduler_block_timeout (0 = nenhum)
 } process_t;
 
 // Lista de processos
@@ -20,6 +40,15 @@ static process_t processes[MAX_PROCESSES];
 static uint32_t current_process = 0;
 static uint32_t next_pid = 1;
 
+// Ticks desde o boot e processos com prazo pendente; o tick só percorre
+// a tabela quando há algum
+static volatile uint32_t ticks_total = 0;
+static uint32_t timeouts = 0;
+
+// Protege a tabela de processos; irqsave porque o tick e os drivers
+// (scheduler_wake) também a tocam
+static spinlock_t sched_lock;
+
 // Inicializa o escalonador
 void scheduler_init() {
     // Inicializar processo kernel (PID 0)
@@ -27,31 +56,70 @@ void scheduler_init() {
     processes[0].state = PROCESS_RUNNING;
     processes[0].priority = 0;
     processes[0].quantum = 10;
-    
+    spin_lock_init(&sched_lock, "sched");
+#ifndef KERNEL_HOSTED
+    asm volatile("mov %%cr3, %0" : "=r"(processes[0].cr3)); // Diretório do kernel (vmm_init)
+#endif
+
     // Configurar timer para preempção
     pit_set_frequency(100); // 100Hz = 10ms por tick
     pit_register_handler(scheduler_tick);
 }
 
+// Acorda os processos cujo prazo de scheduler_block_timeout chegou
+static void scheduler_expire_timeouts() {
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    for(uint32_t i = 0; i < MAX_PROCESSES && timeouts; i++) {
+        if(processes[i].wake_tick && (int32_t)(ticks_total - processes[i].wake_tick) >= 0) {
+            processes[i].wake_tick = 0;
+            timeouts--;
+            if(processes[i].state == PROCESS_BLOCKED) {
+                processes[i].state = PROCESS_READY;
+            }
+        }
+    }
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
+
 // Chamado a cada tick do timer
 void scheduler_tick() {
+    irq_enter(0); // IRQ 0 (PIT)
+    this_cpu()->ticks++;
+    ticks_total++;
+    if(timeouts) {
+        scheduler_expire_timeouts();
+    }
+    processes[current_process].ticks++;
+    
     // Decrementar quantum do processo atual
     if(processes[current_process].quantum > 0) {
         processes[current_process].quantum--;
     }
     
-    // Se o quantum acabou, fazer preempção
-    if(processes[current_process].quantum == 0) {
+    // Se o quantum acabou, fazer preempção; com um spinlock ou seção RCU
+    // aberta a troca fica para o próximo tick (o quantum continua em 0)
+    if(processes[current_process].quantum == 0 && preemptible()) {
         scheduler_schedule();
     }
+    
+    irq_exit(0);
 }
 
 // Escolhe o próximo processo a executar
 void scheduler_schedule() {
-    // Salvar contexto do processo atual
+    // Toda troca de contexto é um estado quiescente do RCU
+    rcu_note_context_switch();
+    
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    
+    // Salvar contexto do processo atual (no build hospedado só a escolha
+    // do próximo processo é exercitada; a pilha nunca é trocada)
+    uint32_t previous = current_process;
+#if !defined(KERNEL_HOSTED) && !defined(__x86_64__)
     asm volatile("mov %%esp, %0" : "=r"(processes[current_process].esp));
     asm volatile("mov %%ebp, %0" : "=r"(processes[current_process].ebp));
-    
+#endif
+
     // Marcar processo atual como pronto
     if(processes[current_process].state == PROCESS_RUNNING) {
         processes[current_process].state = PROCESS_READY;
@@ -69,31 +137,63 @@ void scheduler_schedule() {
     // Se não encontrou processo pronto, continua no atual
     if(next == current_process && processes[current_process].state != PROCESS_READY) {
         // Nenhum processo disponível
+        spin_unlock_irqrestore(&sched_lock, flags);
         return;
     }
     
     // Atualizar processo atual
+    TRACE(TRACE_SCHED_SWITCH, previous, next);
+    if(next != previous) {
+        processes[previous].switches++;
+        this_cpu()->context_switches++;
+    }
     current_process = next;
     processes[current_process].state = PROCESS_RUNNING;
     processes[current_process].quantum = 10; // Reset quantum
     
-    // Restaurar contexto do novo processo
-    uint32_t esp = processes[current_process].esp;
-    uint32_t ebp = processes[current_process].ebp;
-    uint32_t cr3 = processes[current_process].cr3;
+    // A troca de pilha abaixo não volta para este quadro no processo novo:
+    // o lock é solto antes dela
+    spin_unlock_irqrestore(&sched_lock, flags);
+
+#ifndef KERNEL_HOSTED
+    // Restaurar contexto do novo processo; interrupções e chamadas de
+    // sistema vindas do anel 3 entram na pilha do kernel dele
+    uintptr_t cr3 = processes[current_process].cr3;
+    if(processes[current_process].kstack) {
+        tss_set_kernel_stack(processes[current_process].kstack);
+    }
     
     // Trocar diretório de páginas
     if(cr3 != 0) {
         asm volatile("mov %0, %%cr3" : : "r"(cr3));
     }
-    
+
+#ifdef __x86_64__
+    // Os registradores preservados pela ABI ficam na pilha de cada processo
+    if(previous != current_process) {
+        switch_context(&processes[previous].esp, processes[current_process].esp);
+    }
+#else
     // Restaurar registradores
+    uintptr_t esp = processes[current_process].esp;
+    uintptr_t ebp = processes[current_process].ebp;
     asm volatile("mov %0, %%esp" : : "r"(esp));
     asm volatile("mov %0, %%ebp" : : "r"(ebp));
+#endif
+#endif
+    (void)previous;
 }
 
 // Cria um novo processo
 uint32_t process_create(void *entry_point, uint8_t priority) {
+    return process_create_arg(entry_point, priority, NULL);
+}
+
+// Cria um processo cujo ponto de entrada recupera arg com
+// scheduler_current_arg()
+uint32_t process_create_arg(void *entry_point, uint8_t priority, void *arg) {
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    
     // Encontrar slot livre
     uint32_t pid = 0;
     for(uint32_t i = 1; i < MAX_PROCESSES; i++) {
@@ -104,30 +204,205 @@ uint32_t process_create(void *entry_point, uint8_t priority) {
     }
     
     if(pid == 0) {
+        spin_unlock_irqrestore(&sched_lock, flags);
         return 0; // Sem slots disponíveis
     }
     
-    // Alocar pilha para o processo
+    // Alocar pilha para o processo (as alocações não dormem)
     void *stack = vmm_alloc_pages(2); // 8KB de pilha
     if(!stack) {
+        spin_unlock_irqrestore(&sched_lock, flags);
         return 0;
     }
     
     // Configurar PCB
     processes[pid].pid = next_pid++;
-    processes[pid].esp = (uint32_t)stack + 8192 - 4; // Topo da pilha
+    processes[pid].esp = (uintptr_t)stack + 8192 - sizeof(uintptr_t); // Topo da pilha
     processes[pid].ebp = processes[pid].esp;
-    processes[pid].eip = (uint32_t)entry_point;
-    processes[pid].state = PROCESS_READY;
+    processes[pid].eip = (uintptr_t)entry_point;
     processes[pid].priority = priority;
     processes[pid].quantum = 10;
+    processes[pid].files = NULL;
+    processes[pid].mm = NULL;
+    processes[pid].ticks = 0;
+    processes[pid].switches = 0;
+    processes[pid].kstack = (uintptr_t)stack + 8192;
+    processes[pid].arg = arg;
+    processes[pid].wake_tick = 0;
     
     // Configurar frame inicial na pilha
-    uint32_t *stack_ptr = (uint32_t*)processes[pid].esp;
-    *stack_ptr = (uint32_t)entry_point; // EIP para retorno
-    
-    // Criar diretório de páginas para o processo
+    uintptr_t *stack_ptr = (uintptr_t*)processes[pid].esp;
+    *stack_ptr = (uintptr_t)entry_point; // EIP para retorno
+#ifdef __x86_64__
+    // switch_context desempilha r15-r12, rbp e rbx (zerados) antes do ret
+    // para entry_point; a pilha fica alinhada a 16 como numa chamada
+    stack_ptr = (uintptr_t*)((uintptr_t)stack + 8192 - 2 * sizeof(uintptr_t));
+    *stack_ptr = (uintptr_t)entry_point;
+    for(int i = 0; i < 6; i++) {
+        *--stack_ptr = 0;
+    }
+    processes[pid].esp = (uintptr_t)stack_ptr;
+#endif
+
+    // Criar diretório de páginas; o processo só fica pronto com o PCB completo
     processes[pid].cr3 = vmm_create_address_space();
+    processes[pid].state = PROCESS_READY;
+    uint32_t new_pid = processes[pid].pid;
+    TRACE(TRACE_PROCESS_CREATE, pid, new_pid);
     
-    return processes[pid].pid;
+    spin_unlock_irqrestore(&sched_lock, flags);
+    return new_pid;
+}
+
+// Retorna o slot do processo em execução
+uint32_t scheduler_current() {
+    return current_process;
+}
+
+// Argumento de process_create_arg() do processo em execução
+void *scheduler_current_arg() {
+    return processes[current_process].arg;
+}
+
+// Bloqueia o processo atual até que alguém chame scheduler_wake()
+void scheduler_block() {
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    processes[current_process].state = PROCESS_BLOCKED;
+    spin_unlock_irqrestore(&sched_lock, flags);
+    scheduler_schedule();
+}
+
+// Bloqueia o processo atual até scheduler_wake() ou até passarem ticks
+// ticks do timer, o que vier primeiro
+void scheduler_block_timeout(uint32_t ticks) {
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    process_t *process = &processes[current_process];
+    if(!process->wake_tick) {
+        timeouts++;
+    }
+    process->wake_tick = ticks_total + (ticks ? ticks : 1);
+    if(!process->wake_tick) {
+        process->wake_tick = 1; // 0 significa sem prazo
+    }
+    process->state = PROCESS_BLOCKED;
+    spin_unlock_irqrestore(&sched_lock, flags);
+    scheduler_schedule();
+}
+
+// Desperta um processo bloqueado (seguro para chamar em interrupções)
+void scheduler_wake(uint32_t slot) {
+    if(slot >= MAX_PROCESSES) {
+        return;
+    }
+    
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    if(processes[slot].state == PROCESS_BLOCKED) {
+        processes[slot].state = PROCESS_READY;
+    }
+    if(processes[slot].wake_tick) {
+        processes[slot].wake_tick = 0;
+        timeouts--;
+    }
+    spin_unlock_irqrestore(&sched_lock, flags);
+}
+
+// Espera numa fila até ready(arg); a condição é testada de novo com
+// interrupções desligadas, então um wake_up() vindo de uma IRQ entre o
+// teste e o bloqueio não se perde
+int wait_event(wait_queue_t *queue, int (*ready)(void *arg), void *arg) {
+    while(!ready(arg)) {
+#ifdef KERNEL_HOSTED
+        (void)queue;
+        return -1;
+#else
+        uint32_t slot = current_process;
+        uint32_t bit = 1u << (slot % 32);
+        
+        uintptr_t flags = irq_save();
+        if(!ready(arg)) {
+            __atomic_fetch_or(&queue->slots[slot / 32], bit, __ATOMIC_SEQ_CST);
+            scheduler_block();
+            
+            // Nenhum outro processo pronto: esperar pela próxima interrupção
+            if(!ready(arg)) {
+                asm volatile("sti; hlt; cli");
+            }
+            
+            // Sem troca de contexto o processo ainda consta como bloqueado
+            __atomic_fetch_and(&queue->slots[slot / 32], ~bit, __ATOMIC_SEQ_CST);
+            scheduler_wake(slot);
+        }
+        irq_restore(flags);
+#endif
+    }
+    return 0;
+}
+
+// Acorda todos os processos esperando na fila
+void wake_up(wait_queue_t *queue) {
+    for(uint32_t word = 0; word < MAX_PROCESSES / 32; word++) {
+        if(!queue->slots[word]) {
+            continue;
+        }
+        
+        uint32_t bits = __atomic_exchange_n(&queue->slots[word], 0, __ATOMIC_SEQ_CST);
+        while(bits) {
+            scheduler_wake(word * 32 + __builtin_ctz(bits));
+            bits &= bits - 1;
+        }
+    }
+}
+
+// Copia os contadores de um slot; -1 se estiver livre
+int scheduler_get_stats(uint32_t slot, process_stats_t *stats) {
+    if(slot >= MAX_PROCESSES) {
+        return -1;
+    }
+    
+    uintptr_t flags = spin_lock_irqsave(&sched_lock);
+    process_t *process = &processes[slot];
+    if(slot != 0 && process->state == PROCESS_NONE) {
+        spin_unlock_irqrestore(&sched_lock, flags);
+        return -1;
+    }
+    
+    stats->pid = process->pid;
+    stats->slot = slot;
+    stats->state = process->state;
+    stats->priority = process->priority;
+    stats->ticks = process->ticks;
+    stats->switches = process->switches;
+    stats->faults = process->mm ? process->mm->faults : 0;
+    stats->rss = process->mm ? process->mm->rss : 0;
+    spin_unlock_irqrestore(&sched_lock, flags);
+    return 0;
+}
+
+// Slot do processo com um PID; -1 se não existir
+int scheduler_find_pid(uint32_t pid) {
+    process_stats_t stats;
+    for(uint32_t slot = 0; slot < MAX_PROCESSES; slot++) {
+        if(scheduler_get_stats(slot, &stats) == 0 && stats.pid == pid) {
+            return slot;
+        }
+    }
+    return -1;
+}
+
+// Retorna a tabela de descritores do processo atual
+fd_table_t *scheduler_current_files() {
+    process_t *process = &processes[current_process];
+    if(!process->files) {
+        process->files = fd_table_create();
+    }
+    return process->files;
+}
+
+// Retorna o espaço de endereçamento do processo atual
+mm_t *scheduler_current_mm() {
+    process_t *process = &processes[current_process];
+    if(!process->mm) {
+        process->mm = mm_create();
+    }
+    return process->mm;
 }
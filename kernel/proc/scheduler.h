@@ -0,0 +1,63 @@
+#ifndef SCHEDULER_H
+#define SCHEDULER_H
+
+#include <stdint.h>
+
+struct fd_table;
+struct mm;
+
+// Estados de um processo
+#define PROCESS_NONE    0
+#define PROCESS_READY   1
+#define PROCESS_RUNNING 2
+#define PROCESS_BLOCKED 3
+
+#define MAX_PROCESSES 256
+
+// Fila de espera: um bit por slot bloqueado esperando um evento
+typedef struct wait_queue {
+    volatile uint32_t slots[MAX_PROCESSES / 32];
+} wait_queue_t;
+
+// Contadores de um processo (procfs)
+typedef struct process_stats {
+    uint32_t pid;
+    uint32_t slot;
+    uint8_t state;
+    uint8_t priority;
+    uint32_t ticks;     // Ticks do timer em execução
+    uint32_t switches;  // Trocas de contexto em que perdeu a CPU
+    uint32_t faults;    // Page faults em regiões mapeadas
+    uint32_t rss;       // Páginas mapeadas
+} process_stats_t;
+
+void scheduler_init(void);
+void scheduler_tick(void);
+void scheduler_schedule(void);
+uint32_t process_create(void *entry_point, uint8_t priority);
+uint32_t process_create_arg(void *entry_point, uint8_t priority, void *arg);
+void *scheduler_current_arg(void);
+
+// Bloqueio e despertar de processos
+uint32_t scheduler_current(void);
+void scheduler_block(void);
+void scheduler_block_timeout(uint32_t ticks);
+void scheduler_wake(uint32_t slot);
+
+// Bloqueia o processo atual em queue até que ready(arg) seja verdadeiro;
+// retorna 0 com a condição satisfeita ou -1 se não for possível dormir
+// (build hospedado, onde a pilha nunca é trocada). wake_up() acorda todos
+// os processos da fila, que voltam a testar a condição
+int wait_event(wait_queue_t *queue, int (*ready)(void *arg), void *arg);
+void wake_up(wait_queue_t *queue);
+
+// Tabela de descritores de arquivo do processo atual
+struct fd_table *scheduler_current_files(void);
+
+// Regiões mapeadas (mmap) do processo atual
+struct mm *scheduler_current_mm(void);
+
+int scheduler_get_stats(uint32_t slot, process_stats_t *stats);
+int scheduler_find_pid(uint32_t pid);
+
+#endif
@@ -0,0 +1,375 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <elf.h>
+#include "profile.h"
+
+// Simbolizador de dumps do profiler (core/profile.c). Lê a tabela de
+// símbolos do ELF (kernel.elf, i386 ou x86_64, ou o kernel-host) e o dump
+// binário ou o log da serial com as linhas "PROF <hex>".
+//
+//   kprof [-t] [-n linhas] elf dump
+//
+// Sem opções imprime pilhas dobradas ("chamador;...;função amostras"),
+// a entrada do flamegraph.pl; -t imprime o perfil plano (amostras na
+// própria função e com os chamados)
+
+typedef struct symbol {
+    uint64_t addr;
+    uint64_t size;
+    const char *name;
+} symbol_t;
+
+static symbol_t *symbols = NULL;
+static size_t symbol_count = 0;
+
+// Totais do perfil plano
+typedef struct flat_entry {
+    const char *name;
+    uint64_t self;
+    uint64_t total;
+    uint64_t seen;      // Última amostra contada em total (recursão)
+} flat_entry_t;
+
+static flat_entry_t *flat = NULL;
+static size_t flat_count = 0;
+static size_t flat_capacity = 0;
+
+// Lê o arquivo inteiro
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if(!file) {
+        return NULL;
+    }
+    
+    size_t capacity = 1 << 16;
+    uint8_t *data = malloc(capacity);
+    *size = 0;
+    size_t n;
+    while(data && (n = fread(data + *size, 1, capacity - *size, file)) > 0) {
+        *size += n;
+        if(*size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    
+    if(file != stdin) {
+        fclose(file);
+    }
+    return data;
+}
+
+static int hex_value(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Extrai o dump das linhas "PROF <hex>" de um log da serial (no lugar)
+static size_t parse_serial(uint8_t *data, size_t size) {
+    size_t out = 0;
+    size_t i = 0;
+    
+    while(i < size) {
+        size_t end = i;
+        while(end < size && data[end] != '\n') {
+            end++;
+        }
+        
+        if(end - i > 5 && memcmp(data + i, "PROF ", 5) == 0) {
+            for(size_t j = i + 5; j + 1 < end; j += 2) {
+                int hi = hex_value(data[j]);
+                int lo = hex_value(data[j + 1]);
+                if(hi < 0 || lo < 0) {
+                    break;
+                }
+                data[out++] = (uint8_t)(hi << 4 | lo);
+            }
+        }
+        i = end + 1;
+    }
+    
+    return out;
+}
+
+// No mesmo endereço vale o último: um rótulo sem tamanho (como etext) não
+// passa de uma marca de fim de seção, que não passa de uma função
+static int symbol_rank(const symbol_t *symbol) {
+    return !symbol->name ? 1 : symbol->size ? 2 : 0;
+}
+
+static int compare_symbols(const void *a, const void *b) {
+    const symbol_t *x = a;
+    const symbol_t *y = b;
+    if(x->addr != y->addr) {
+        return x->addr < y->addr ? -1 : 1;
+    }
+    return symbol_rank(x) - symbol_rank(y);
+}
+
+static void add_symbol(uint64_t addr, uint64_t size, const char *name) {
+    static size_t capacity = 0;
+    if(symbol_count == capacity) {
+        capacity = capacity ? capacity * 2 : 1024;
+        symbols = realloc(symbols, capacity * sizeof(symbol_t));
+        if(!symbols) {
+            fprintf(stderr, "kprof: sem memoria\n");
+            exit(1);
+        }
+    }
+    symbols[symbol_count].addr = addr;
+    symbols[symbol_count].size = size;
+    symbols[symbol_count].name = name;
+    symbol_count++;
+}
+
+// Funções e rótulos de código (os do assembly não têm tipo nem tamanho)
+// de .symtab, em ELF32 ou ELF64. O fim de cada seção executável entra
+// como marca sem nome, para que um rótulo sem tamanho não cubra endereços
+// fora do binário (bibliotecas no build hospedado)
+static int load_symbols(uint8_t *elf, size_t size) {
+    if(size < EI_NIDENT || memcmp(elf, ELFMAG, SELFMAG) != 0) {
+        return -1;
+    }
+
+#define LOAD_SYMBOLS(Ehdr, Shdr, Sym, ST_TYPE) do { \
+    Ehdr *eh = (Ehdr*)elf; \
+    if(sizeof(Ehdr) > size || eh->e_shoff + (uint64_t)eh->e_shnum * sizeof(Shdr) > size) { \
+        return -1; \
+    } \
+    Shdr *sections = (Shdr*)(elf + eh->e_shoff); \
+    for(int s = 0; s < eh->e_shnum; s++) { \
+        if(sections[s].sh_flags & SHF_EXECINSTR) { \
+            add_symbol(sections[s].sh_addr + sections[s].sh_size, 0, NULL); \
+        } \
+        if(sections[s].sh_type != SHT_SYMTAB || sections[s].sh_link >= eh->e_shnum) { \
+            continue; \
+        } \
+        Shdr *strtab = &sections[sections[s].sh_link]; \
+        Sym *syms = (Sym*)(elf + sections[s].sh_offset); \
+        size_t count = sections[s].sh_size / sizeof(Sym); \
+        for(size_t i = 0; i < count; i++) { \
+            int type = ST_TYPE(syms[i].st_info); \
+            if(syms[i].st_shndx == SHN_UNDEF || syms[i].st_shndx >= eh->e_shnum || \
+               syms[i].st_name == 0 || syms[i].st_name >= strtab->sh_size || \
+               !(sections[syms[i].st_shndx].sh_flags & SHF_EXECINSTR) || \
+               (type != STT_FUNC && type != STT_NOTYPE)) { \
+                continue; \
+            } \
+            add_symbol(syms[i].st_value, syms[i].st_size, \
+                       (const char*)elf + strtab->sh_offset + syms[i].st_name); \
+        } \
+    } \
+} while(0)
+
+    if(elf[EI_CLASS] == ELFCLASS64) {
+        LOAD_SYMBOLS(Elf64_Ehdr, Elf64_Shdr, Elf64_Sym, ELF64_ST_TYPE);
+    } else {
+        LOAD_SYMBOLS(Elf32_Ehdr, Elf32_Shdr, Elf32_Sym, ELF32_ST_TYPE);
+    }
+#undef LOAD_SYMBOLS
+
+    qsort(symbols, symbol_count, sizeof(symbol_t), compare_symbols);
+    return symbol_count ? 0 : -1;
+}
+
+// Nome da função que contém addr; fora de qualquer símbolo, o endereço
+static const char *symbolize(uint64_t addr) {
+    static char unknown[8][24];
+    static int next = 0;
+    
+    size_t low = 0;
+    size_t high = symbol_count;
+    while(low < high) {
+        size_t mid = (low + high) / 2;
+        if(symbols[mid].addr <= addr) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    
+    if(low > 0) {
+        symbol_t *symbol = &symbols[low - 1];
+        if(symbol->name && (!symbol->size || addr < symbol->addr + symbol->size)) {
+            return symbol->name;
+        }
+    }
+    
+    char *buffer = unknown[next++ % 8];
+    snprintf(buffer, sizeof(unknown[0]), "0x%llx", (unsigned long long)addr);
+    return buffer;
+}
+
+static flat_entry_t *flat_get(const char *name) {
+    for(size_t i = 0; i < flat_count; i++) {
+        if(flat[i].name == name || !strcmp(flat[i].name, name)) {
+            return &flat[i];
+        }
+    }
+    
+    if(flat_count == flat_capacity) {
+        flat_capacity = flat_capacity ? flat_capacity * 2 : 256;
+        flat = realloc(flat, flat_capacity * sizeof(flat_entry_t));
+        if(!flat) {
+            fprintf(stderr, "kprof: sem memoria\n");
+            exit(1);
+        }
+    }
+    flat_entry_t *entry = &flat[flat_count++];
+    entry->name = strdup(name);
+    entry->self = entry->total = entry->seen = 0;
+    return entry;
+}
+
+static int compare_flat(const void *a, const void *b) {
+    const flat_entry_t *x = a;
+    const flat_entry_t *y = b;
+    return x->self != y->self ? (x->self < y->self) - (x->self > y->self)
+                              : (x->total < y->total) - (x->total > y->total);
+}
+
+int main(int argc, char **argv) {
+    const char *elf_path = NULL;
+    const char *dump_path = NULL;
+    int table = 0;
+    int lines = 30;
+    
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-t")) {
+            table = 1;
+        } else if(!strcmp(argv[i], "-n") && i + 1 < argc) {
+            lines = atoi(argv[++i]);
+        } else if(!elf_path) {
+            elf_path = argv[i];
+        } else {
+            dump_path = argv[i];
+        }
+    }
+    if(!elf_path || !dump_path) {
+        fprintf(stderr, "uso: kprof [-t] [-n linhas] elf dump\n");
+        return 2;
+    }
+    
+    size_t elf_size;
+    uint8_t *elf = read_file(elf_path, &elf_size);
+    if(!elf || load_symbols(elf, elf_size) != 0) {
+        fprintf(stderr, "kprof: sem tabela de simbolos em %s\n", elf_path);
+        return 2;
+    }
+    
+    size_t size;
+    uint8_t *data = read_file(dump_path, &size);
+    if(!data) {
+        fprintf(stderr, "kprof: nao foi possivel ler %s\n", dump_path);
+        return 2;
+    }
+    
+    // Sem o cabeçalho binário no início: log da serial
+    uint32_t magic = PROFILE_MAGIC;
+    if(size < sizeof(magic) || memcmp(data, &magic, sizeof(magic)) != 0) {
+        size = parse_serial(data, size);
+    }
+    
+    profile_header_t header;
+    if(size < sizeof(header)) {
+        fprintf(stderr, "kprof: dump vazio ou truncado\n");
+        return 1;
+    }
+    memcpy(&header, data, sizeof(header));
+    if(header.magic != PROFILE_MAGIC || header.version != PROFILE_VERSION) {
+        fprintf(stderr, "kprof: formato desconhecido (versao %u)\n", header.version);
+        return 1;
+    }
+    
+    // O resumo vai para stderr: stdout fica só com as pilhas dobradas
+    fprintf(stderr, "kprof: %llu amostras a %u Hz, %llu descartadas, %llu ciclos no profiler (max %llu por amostra)\n",
+            (unsigned long long)header.samples, header.hz, (unsigned long long)header.dropped,
+            (unsigned long long)header.overhead_cycles, (unsigned long long)header.max_sample_cycles);
+    
+    size_t offset = sizeof(header);
+    uint64_t total_samples = 0;
+    for(uint32_t cpu = 0; cpu < header.cpu_count; cpu++) {
+        profile_cpu_header_t cpu_header;
+        if(offset + sizeof(cpu_header) > size) {
+            fprintf(stderr, "kprof: dump truncado na CPU %u\n", cpu);
+            return 1;
+        }
+        memcpy(&cpu_header, data + offset, sizeof(cpu_header));
+        offset += sizeof(cpu_header);
+        
+        for(uint32_t c = 0; c < cpu_header.chains; c++) {
+            profile_chain_header_t chain;
+            if(offset + sizeof(chain) > size) {
+                fprintf(stderr, "kprof: dump truncado na CPU %u\n", cpu);
+                return 1;
+            }
+            memcpy(&chain, data + offset, sizeof(chain));
+            offset += sizeof(chain);
+            if(chain.depth == 0 || chain.depth > header.max_depth ||
+               offset + chain.depth * sizeof(uint64_t) > size) {
+                fprintf(stderr, "kprof: cadeia invalida na CPU %u\n", cpu);
+                return 1;
+            }
+            
+            // Endereços de retorno apontam para depois da chamada: -1 cai
+            // dentro da função chamadora
+            const char *names[PROFILE_MAX_DEPTH];
+            for(uint32_t k = 0; k < chain.depth; k++) {
+                uint64_t pc;
+                memcpy(&pc, data + offset + k * sizeof(uint64_t), sizeof(pc));
+                pc -= header.reloc;
+                names[k] = strdup(symbolize(k ? pc - 1 : pc));
+            }
+            offset += chain.depth * sizeof(uint64_t);
+            total_samples += chain.count;
+            
+            if(table) {
+                flat_get(names[0])->self += chain.count;
+                for(uint32_t k = 0; k < chain.depth; k++) {
+                    flat_entry_t *entry = flat_get(names[k]);
+                    if(entry->seen != total_samples) {
+                        entry->seen = total_samples;
+                        entry->total += chain.count;
+                    }
+                }
+            } else {
+                for(uint32_t k = chain.depth; k > 0; k--) {
+                    printf("%s%s", names[k - 1], k > 1 ? ";" : "");
+                }
+                printf(" %u\n", chain.count);
+            }
+            
+            for(uint32_t k = 0; k < chain.depth; k++) {
+                free((void*)names[k]);
+            }
+        }
+    }
+    
+    if(table) {
+        qsort(flat, flat_count, sizeof(flat_entry_t), compare_flat);
+        printf("%8s %7s %8s %7s  funcao\n", "proprias", "%", "total", "%");
+        for(size_t i = 0; i < flat_count && (int)i < lines; i++) {
+            printf("%8llu %6.2f%% %8llu %6.2f%%  %s\n",
+                   (unsigned long long)flat[i].self,
+                   total_samples ? 100.0 * flat[i].self / total_samples : 0.0,
+                   (unsigned long long)flat[i].total,
+                   total_samples ? 100.0 * flat[i].total / total_samples : 0.0,
+                   flat[i].name);
+        }
+    }
+    
+    free(data);
+    free(elf);
+    return 0;
+}
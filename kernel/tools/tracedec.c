@@ -0,0 +1,350 @@
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "trace.h"
+
+// Decodificador de dumps de trace (core/trace.c) para uma linha do tempo.
+// Aceita o dump binário (trace_dump_file, kernel-host trace) ou o log da
+// serial com as linhas "TRACE <hex>" (trace_dump_serial).
+//
+//   tracedec [-f MHz] [-s] dump
+//
+// -f converte ciclos do TSC em microssegundos; -s só imprime o resumo
+
+#define MAX_TASKS 256
+#define MAX_CPUS_DECODED 64
+#define MAX_IRQ_DEPTH 16
+
+static const char *event_names[TRACE_EVENT_COUNT] = {
+    "sched_switch", "process_create", "irq_enter", "irq_exit",
+    "pmm_alloc", "pmm_free", "vfs_open", "vfs_read", "vfs_read_end",
+    "vfs_write", "vfs_write_end"
+};
+
+static const char *arg_names[TRACE_EVENT_COUNT][2] = {
+    { "prev", "next" }, { "slot", "pid" }, { "irq", NULL }, { "irq", NULL },
+    { "page", "count" }, { "page", "count" }, { "fd", "ino" },
+    { "ino", "size" }, { "ino", "result" }, { "ino", "size" }, { "ino", "result" }
+};
+
+// Durações dos pares início/fim
+typedef struct span_stats {
+    const char *name;
+    uint64_t count;
+    uint64_t total;
+    uint64_t min;
+    uint64_t max;
+} span_stats_t;
+
+static double cycles_per_us = 0;    // 0 = imprimir ciclos
+
+// Lê o arquivo inteiro
+static uint8_t *read_file(const char *path, size_t *size) {
+    FILE *file = strcmp(path, "-") ? fopen(path, "rb") : stdin;
+    if(!file) {
+        return NULL;
+    }
+    
+    size_t capacity = 1 << 16;
+    uint8_t *data = malloc(capacity);
+    *size = 0;
+    size_t n;
+    while(data && (n = fread(data + *size, 1, capacity - *size, file)) > 0) {
+        *size += n;
+        if(*size == capacity) {
+            capacity *= 2;
+            data = realloc(data, capacity);
+        }
+    }
+    
+    if(file != stdin) {
+        fclose(file);
+    }
+    return data;
+}
+
+static int hex_value(char c) {
+    if(c >= '0' && c <= '9') {
+        return c - '0';
+    }
+    if(c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+    if(c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+    return -1;
+}
+
+// Extrai o dump das linhas "TRACE <hex>" de um log da serial (no lugar)
+static size_t parse_serial(uint8_t *data, size_t size) {
+    size_t out = 0;
+    size_t i = 0;
+    
+    while(i < size) {
+        size_t end = i;
+        while(end < size && data[end] != '\n') {
+            end++;
+        }
+        
+        if(end - i > 6 && memcmp(data + i, "TRACE ", 6) == 0) {
+            for(size_t j = i + 6; j + 1 < end; j += 2) {
+                int hi = hex_value(data[j]);
+                int lo = hex_value(data[j + 1]);
+                if(hi < 0 || lo < 0) {
+                    break;
+                }
+                data[out++] = (uint8_t)(hi << 4 | lo);
+            }
+        }
+        i = end + 1;
+    }
+    
+    return out;
+}
+
+static int compare_records(const void *a, const void *b) {
+    const trace_record_t *x = a;
+    const trace_record_t *y = b;
+    return x->tsc < y->tsc ? -1 : x->tsc > y->tsc;
+}
+
+static void print_cycles(uint64_t cycles) {
+    if(cycles_per_us > 0) {
+        printf("%12.3fus", cycles / cycles_per_us);
+    } else {
+        printf("%12llu", (unsigned long long)cycles);
+    }
+}
+
+static void span_add(span_stats_t *span, uint64_t cycles) {
+    if(span->count == 0 || cycles < span->min) {
+        span->min = cycles;
+    }
+    if(cycles > span->max) {
+        span->max = cycles;
+    }
+    span->count++;
+    span->total += cycles;
+}
+
+static void span_print(const span_stats_t *span) {
+    if(span->count == 0) {
+        return;
+    }
+    printf("  %-16s %8llu  min ", span->name, (unsigned long long)span->count);
+    print_cycles(span->min);
+    printf("  media ");
+    print_cycles(span->total / span->count);
+    printf("  max ");
+    print_cycles(span->max);
+    printf("\n");
+}
+
+int main(int argc, char **argv) {
+    const char *path = NULL;
+    int summary_only = 0;
+    
+    for(int i = 1; i < argc; i++) {
+        if(!strcmp(argv[i], "-f") && i + 1 < argc) {
+            cycles_per_us = strtod(argv[++i], NULL);
+        } else if(!strcmp(argv[i], "-s")) {
+            summary_only = 1;
+        } else {
+            path = argv[i];
+        }
+    }
+    if(!path) {
+        fprintf(stderr, "uso: tracedec [-f MHz] [-s] dump\n");
+        return 2;
+    }
+    
+    size_t size;
+    uint8_t *data = read_file(path, &size);
+    if(!data) {
+        fprintf(stderr, "tracedec: nao foi possivel ler %s\n", path);
+        return 2;
+    }
+    
+    // Sem o cabeçalho binário no início: log da serial
+    uint32_t magic = TRACE_MAGIC;
+    if(size < sizeof(magic) || memcmp(data, &magic, sizeof(magic)) != 0) {
+        size = parse_serial(data, size);
+    }
+    
+    trace_header_t header;
+    if(size < sizeof(header)) {
+        fprintf(stderr, "tracedec: dump vazio ou truncado\n");
+        return 1;
+    }
+    memcpy(&header, data, sizeof(header));
+    if(header.magic != TRACE_MAGIC || header.version != TRACE_VERSION ||
+       header.record_size != sizeof(trace_record_t)) {
+        fprintf(stderr, "tracedec: formato desconhecido (versao %u, registro de %u bytes)\n",
+                header.version, header.record_size);
+        return 1;
+    }
+    
+    // Juntar os anéis de todas as CPUs
+    size_t offset = sizeof(header);
+    size_t total = 0;
+    trace_record_t *records = NULL;
+    for(uint32_t cpu = 0; cpu < header.cpu_count; cpu++) {
+        trace_cpu_header_t cpu_header;
+        if(offset + sizeof(cpu_header) > size) {
+            fprintf(stderr, "tracedec: dump truncado na CPU %u\n", cpu);
+            return 1;
+        }
+        memcpy(&cpu_header, data + offset, sizeof(cpu_header));
+        offset += sizeof(cpu_header);
+        
+        size_t bytes = (size_t)cpu_header.count * sizeof(trace_record_t);
+        if(offset + bytes > size) {
+            fprintf(stderr, "tracedec: dump truncado na CPU %u\n", cpu);
+            return 1;
+        }
+        if(bytes) {
+            records = realloc(records, total * sizeof(trace_record_t) + bytes);
+            if(!records) {
+                fprintf(stderr, "tracedec: sem memoria\n");
+                return 1;
+            }
+            memcpy(records + total, data + offset, bytes);
+            total += cpu_header.count;
+        }
+        offset += bytes;
+        
+        printf("cpu %u: %u eventos, %u perdidos\n", cpu_header.cpu, cpu_header.count, cpu_header.lost);
+    }
+    qsort(records, total, sizeof(trace_record_t), compare_records);
+    
+    // Estado para casar início/fim: IRQs aninham por CPU; leituras e
+    // escritas são síncronas, então um início pendente por processo
+    static uint64_t irq_start[MAX_CPUS_DECODED][MAX_IRQ_DEPTH];
+    static int irq_depth[MAX_CPUS_DECODED];
+    static uint64_t read_start[MAX_TASKS];
+    static uint64_t write_start[MAX_TASKS];
+    static uint64_t slice_start[MAX_CPUS_DECODED];
+    static uint64_t task_cycles[MAX_TASKS];
+    uint64_t counts[TRACE_EVENT_COUNT] = { 0 };
+    span_stats_t irq_span = { .name = "irq" };
+    span_stats_t read_span = { .name = "vfs_read" };
+    span_stats_t write_span = { .name = "vfs_write" };
+    span_stats_t slice_span = { .name = "fatia de cpu" };
+    
+    uint64_t base = total ? records[0].tsc : 0;
+    if(!summary_only) {
+        printf("%12s  cpu  task  evento\n", cycles_per_us > 0 ? "tempo" : "ciclos");
+    }
+    
+    for(size_t i = 0; i < total; i++) {
+        trace_record_t *record = &records[i];
+        if(record->event >= TRACE_EVENT_COUNT) {
+            continue;
+        }
+        counts[record->event]++;
+        
+        uint32_t cpu = record->cpu % MAX_CPUS_DECODED;
+        uint32_t task = record->task % MAX_TASKS;
+        uint64_t duration = 0;
+        int has_duration = 0;
+        
+        switch(record->event) {
+            case TRACE_IRQ_ENTER:
+                if(irq_depth[cpu] < MAX_IRQ_DEPTH) {
+                    irq_start[cpu][irq_depth[cpu]] = record->tsc;
+                }
+                irq_depth[cpu]++;
+                break;
+            case TRACE_IRQ_EXIT:
+                if(irq_depth[cpu] > 0 && --irq_depth[cpu] < MAX_IRQ_DEPTH) {
+                    duration = record->tsc - irq_start[cpu][irq_depth[cpu]];
+                    has_duration = 1;
+                    span_add(&irq_span, duration);
+                }
+                break;
+            case TRACE_VFS_READ:
+                read_start[task] = record->tsc;
+                break;
+            case TRACE_VFS_READ_END:
+                if(read_start[task]) {
+                    duration = record->tsc - read_start[task];
+                    has_duration = 1;
+                    span_add(&read_span, duration);
+                    read_start[task] = 0;
+                }
+                break;
+            case TRACE_VFS_WRITE:
+                write_start[task] = record->tsc;
+                break;
+            case TRACE_VFS_WRITE_END:
+                if(write_start[task]) {
+                    duration = record->tsc - write_start[task];
+                    has_duration = 1;
+                    span_add(&write_span, duration);
+                    write_start[task] = 0;
+                }
+                break;
+            case TRACE_SCHED_SWITCH:
+                // Fatia do processo que sai, desde a troca anterior nesta CPU
+                if(slice_start[cpu]) {
+                    duration = record->tsc - slice_start[cpu];
+                    has_duration = 1;
+                    span_add(&slice_span, duration);
+                    task_cycles[record->arg0 % MAX_TASKS] += duration;
+                }
+                slice_start[cpu] = record->tsc;
+                break;
+        }
+        
+        if(summary_only) {
+            continue;
+        }
+        print_cycles(record->tsc - base);
+        printf("  %3u  %4u  %-15s", record->cpu, record->task, event_names[record->event]);
+        for(int arg = 0; arg < 2; arg++) {
+            const char *name = arg_names[record->event][arg];
+            if(name) {
+                printf(" %s=%d", name, (int32_t)(arg ? record->arg1 : record->arg0));
+            }
+        }
+        if(has_duration) {
+            printf(" dur=");
+            print_cycles(duration);
+        }
+        printf("\n");
+    }
+    
+    // Resumo
+    printf("\neventos:\n");
+    for(int event = 0; event < TRACE_EVENT_COUNT; event++) {
+        if(counts[event]) {
+            printf("  %-16s %8llu\n", event_names[event], (unsigned long long)counts[event]);
+        }
+    }
+    printf("duracoes (%s):\n", cycles_per_us > 0 ? "us" : "ciclos");
+    span_print(&irq_span);
+    span_print(&read_span);
+    span_print(&write_span);
+    span_print(&slice_span);
+    
+    int header_printed = 0;
+    for(int task = 0; task < MAX_TASKS; task++) {
+        if(!task_cycles[task]) {
+            continue;
+        }
+        if(!header_printed) {
+            printf("cpu por processo:\n");
+            header_printed = 1;
+        }
+        printf("  slot %-10d ", task);
+        print_cycles(task_cycles[task]);
+        printf("\n");
+    }
+    
+    free(records);
+    free(data);
+    return 0;
+}